@@ -0,0 +1,384 @@
+#include "async.hpp"
+
+#ifdef WINDOWS_SOCKET_EPOLL
+#include <memory>
+#include <new>
+
+namespace winLib {
+	constexpr size_t FRAME_CLASSES = FramePool::MAX_POOLED / FramePool::FRAME_ALIGN;
+
+	struct FreeFrame {
+		FreeFrame* next;
+	};
+
+	// the free lists of one thread
+	struct FrameLists {
+		FreeFrame* heads[FRAME_CLASSES] = {};
+		size_t counts[FRAME_CLASSES] = {};
+
+		~FrameLists();
+	};
+
+	static thread_local FrameLists frame_lists;
+	// a frame freed after the lists of its thread (by the destructor of another thread local) goes to the heap
+	static thread_local bool frame_lists_closed = false;
+
+	FrameLists::~FrameLists() {
+		for (FreeFrame*& head : heads) {
+			while (head)
+				::operator delete(std::exchange(head, head->next));
+		}
+
+		frame_lists_closed = true;
+	}
+
+	void* FramePool::allocate(size_t size) {
+		if (size > MAX_POOLED || frame_lists_closed)
+			return ::operator new(size);
+
+		const size_t index = (size - 1) / FRAME_ALIGN;
+
+		if (FreeFrame* frame = frame_lists.heads[index]) {
+			frame_lists.heads[index] = frame->next;
+			frame_lists.counts[index]--;
+			return frame;
+		}
+
+		return ::operator new((index + 1) * FRAME_ALIGN);
+	}
+
+	void FramePool::deallocate(void* frame, size_t size) noexcept {
+		const size_t index = (size - 1) / FRAME_ALIGN;
+
+		if (size > MAX_POOLED || frame_lists_closed || frame_lists.counts[index] >= MAX_FREE) {
+			::operator delete(frame);
+			return;
+		}
+
+		frame_lists.heads[index] = new (frame) FreeFrame{ frame_lists.heads[index] };
+		frame_lists.counts[index]++;
+	}
+
+	void AsyncPromiseBase::report_detached(const std::exception_ptr& exception) noexcept {
+		try {
+			std::rethrow_exception(exception);
+		} catch (const std::exception& e) {
+			std::cout << "\nERROR: coroutine failed: " << e.what() << std::endl;
+		} catch (...) {
+			std::cout << "\nERROR: coroutine failed" << std::endl;
+		}
+	}
+
+	void spawn(Async<void> task) {
+		if (!task.handle)
+			return;
+
+		const Async<void>::Handle handle = std::exchange(task.handle, nullptr);
+
+		handle.promise().detached = true;
+		handle.resume();
+	}
+
+	AsyncSocket::AsyncSocket(EventLoop& loop, SocketHandle&& sock, bool nonblocking) noexcept : sock(std::move(sock)) {
+		this->event_loop = &loop;
+
+		if (this->sock && !nonblocking && !set_nonblocking(this->sock.get()))
+			std::cout << "\nERROR: set_nonblocking failed: " << last_socket_error() << std::endl;
+	}
+
+	AsyncSocket::AsyncSocket(AsyncSocket&& other) noexcept : sock(std::move(other.sock)) {
+		this->event_loop = other.event_loop;
+
+		// the callback of the watch points to other, watched again with the next wait
+		if (std::exchange(other.watched, false))
+			event_loop->remove(sock.get());
+	}
+
+	AsyncSocket& AsyncSocket::operator=(AsyncSocket&& other) noexcept {
+		if (this == &other)
+			return *this;
+
+		close();
+
+		sock = std::move(other.sock);
+		event_loop = other.event_loop;
+
+		if (std::exchange(other.watched, false))
+			event_loop->remove(sock.get());
+
+		return *this;
+	}
+
+	AsyncSocket::~AsyncSocket() {
+		if (destroyed)
+			*destroyed = true;
+
+		unwatch();
+	}
+
+	void AsyncSocket::close() noexcept {
+		unwatch();
+		sock.close();
+		cancel_pending();
+	}
+
+	AsyncSocket::Operation AsyncSocket::connect(const sockaddr* address, socklen_t length) noexcept {
+		Operation operation(this, Operation::CONNECT);
+
+		operation.address = address;
+		operation.address_length = length;
+
+		return operation;
+	}
+
+	bool AsyncSocket::watch() noexcept {
+		if (watched)
+			return true;
+
+		if (!event_loop || !sock)
+			return false;
+
+		// edge triggered: the add reports the readiness the socket already has
+		watched = event_loop->add(sock.get(), IO_READ | IO_WRITE, [this](unsigned int events) { ready(events); });
+
+		return watched;
+	}
+
+	void AsyncSocket::unwatch() noexcept {
+		if (std::exchange(watched, false))
+			event_loop->remove(sock.get());
+	}
+
+	void AsyncSocket::ready(unsigned int events) {
+		bool gone = false;
+		destroyed = &gone;
+
+		if (writing && (events & (IO_WRITE | IO_ERROR | IO_HANGUP)) && writing->attempt()) {
+			std::exchange(writing, nullptr)->waiting.resume();
+
+			if (gone)
+				return;
+		}
+
+		if (reading && (events & (IO_READ | IO_ERROR | IO_HANGUP)) && reading->attempt()) {
+			std::exchange(reading, nullptr)->waiting.resume();
+
+			if (gone)
+				return;
+		}
+
+		destroyed = nullptr;
+	}
+
+	// nothing resumes a coroutine that waits for a closed socket, its frame would never be freed
+	void AsyncSocket::cancel_pending() noexcept {
+		bool gone = false;
+		bool* const outer = std::exchange(destroyed, &gone);
+
+		for (Operation** pending : { &writing, &reading }) {
+			if (Operation* operation = std::exchange(*pending, nullptr)) {
+				operation->result = -ECANCELED;
+				operation->accepted.close();
+				operation->waiting.resume();
+
+				// destroyed by the resumed coroutine (inside of ready() as well)
+				if (gone) {
+					if (outer)
+						*outer = true;
+
+					return;
+				}
+			}
+		}
+
+		destroyed = outer;
+	}
+
+	AsyncSocket::Operation::Operation(AsyncSocket* socket, Kind kind, char* buffer, size_t length) noexcept {
+		this->socket = socket;
+		this->kind = kind;
+		this->buffer = buffer;
+		this->length = length;
+	}
+
+	bool AsyncSocket::Operation::await_suspend(std::coroutine_handle<> awaiting) noexcept {
+		if (!socket->watch()) {
+			result = -EBADF;
+			return false;
+		}
+
+		waiting = awaiting;
+
+		if (kind == RECV || kind == ACCEPT)
+			socket->reading = this;
+		else
+			socket->writing = this;
+
+		return true;
+	}
+
+	bool AsyncSocket::Operation::attempt() noexcept {
+		const SOCKET fd = socket->sock.get();
+
+		for (;;) {
+			switch (kind) {
+			case RECV: {
+				const ssize_t received = ::recv(fd, buffer, length, 0);
+
+				if (received >= 0) {
+					result = static_cast<int>(received);
+					return true;
+				}
+
+				break;
+			}
+			case SEND: {
+				ssize_t sent = 0;
+
+				while (done < length && (sent = ::send(fd, buffer + done, length - done, SEND_FLAGS)) > 0)
+					done += static_cast<size_t>(sent);
+
+				if (done == length) {
+					result = static_cast<int>(length);
+					return true;
+				}
+
+				break;
+			}
+			case ACCEPT:
+				accepted.reset(accept4(fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC));
+
+				if (accepted) {
+					result = 0;
+					return true;
+				}
+
+				break;
+			case CONNECT:
+				if (started) {
+					// writable: the connect completed, successfully or not
+					int error = 0;
+					socklen_t size = sizeof(error);
+
+					if (getsockopt(fd, SOL_SOCKET, SO_ERROR, &error, &size) == SOCKET_ERROR)
+						error = last_socket_error();
+
+					result = -error;
+					return true;
+				}
+
+				if (::connect(fd, address, address_length) == 0) {
+					result = 0;
+					return true;
+				}
+
+				if (last_socket_error() == EINPROGRESS) {
+					started = true;
+					return false;
+				}
+
+				break;
+			}
+
+			const int err = last_socket_error();
+
+			if (err == EINTR)
+				continue;
+
+			if (would_block(err))
+				return false;
+
+			result = -err;
+			return true;
+		}
+	}
+
+	AsyncServer::AsyncServer(EventLoop& loop, PCSTR port) : listener(port) {
+		this->event_loop = &loop;
+	}
+
+	int AsyncServer::start() {
+		if (const int r = listener.create_socket())
+			return r;
+
+		if (!listener.bind_socket())
+			return -1;
+
+		if (const int r = listener.listen_state())
+			return r;
+
+		acceptor = AsyncSocket(*event_loop, std::move(listener.sock));
+
+		return 0;
+	}
+
+	// one address after the other
+	static Async<AsyncSocket> connect_addresses(EventLoop& loop, const addrinfo* addresses, int* error) {
+		int last_error = 0;
+
+		for (const addrinfo* ptr = addresses; ptr; ptr = ptr->ai_next) {
+			AsyncSocket client(loop, SocketHandle(socket(ptr->ai_family, ptr->ai_socktype | SOCK_CLOEXEC, ptr->ai_protocol)));
+
+			if (!client.valid()) {
+				last_error = last_socket_error();
+				continue;
+			}
+
+			const int r = co_await client.connect(ptr->ai_addr, static_cast<socklen_t>(ptr->ai_addrlen));
+
+			if (r == 0) {
+				if (error)
+					*error = 0;
+
+				co_return std::move(client);
+			}
+
+			last_error = -r;
+		}
+
+		std::cout << "\nERROR: connect failed: " << last_error << std::endl;
+
+		if (error)
+			*error = last_error;
+
+		co_return AsyncSocket();
+	}
+
+	Async<AsyncSocket> connect(EventLoop& loop, PCSTR host, PCSTR port, int* error) {
+		addrinfo hints{};
+		hints.ai_family = AF_UNSPEC;
+		hints.ai_socktype = SOCK_STREAM;
+		hints.ai_protocol = IPPROTO_TCP;
+
+		addrinfo* result = nullptr;
+
+		if (const int r = getaddrinfo(host, port, &hints, &result)) {
+			std::cout << "\nERROR: getaddrinfo failed: " << r << std::endl;
+
+			if (error)
+				*error = r;
+
+			co_return AsyncSocket();
+		}
+
+		const std::unique_ptr<addrinfo, decltype(&freeaddrinfo)> addresses(result, freeaddrinfo);
+
+		co_return co_await connect_addresses(loop, result, error);
+	}
+
+	Async<AsyncSocket> connect(EventLoop& loop, Resolver& resolver, PCSTR host, PCSTR port, int* error) {
+		const AddressList addresses = co_await resolver.lookup(loop, host, port);
+
+		if (addresses->error) {
+			std::cout << "\nERROR: resolve failed: " << addresses->error << std::endl;
+
+			if (error)
+				*error = addresses->error;
+
+			co_return AsyncSocket();
+		}
+
+		co_return co_await connect_addresses(loop, addresses->get(), error);
+	}
+}
+#endif
\ No newline at end of file
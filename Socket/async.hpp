@@ -0,0 +1,289 @@
+#ifndef WINDOWS_SOCKET_ASYNC_HPP
+	#define WINDOWS_SOCKET_ASYNC_HPP
+
+	#include "event_loop.hpp"
+	#include "server.hpp"
+	#include "resolver.hpp"
+
+	#ifdef WINDOWS_SOCKET_EPOLL
+		#include <coroutine>
+		#include <exception>
+		#include <optional>
+		#include <system_error>
+		#include <utility>
+
+		// Coroutines on an EventLoop: a connection is written as straight line code that co_awaits its sockets,
+		//
+		//	Async<> echo(AsyncSocket client) {
+		//		char buffer[DEFAULT_BUFLEN];
+		//		while (const int n = co_await client.recv(buffer, sizeof(buffer)); n > 0)
+		//			co_await client.send(buffer, n);
+		//	}
+		//
+		//	spawn(echo(co_await server.accept()));
+		//
+		// and runs on the thread of the loop like a callback would. The awaiters live in the frame of the awaiting
+		// coroutine (no allocation per operation), the frames come from a pool of the thread.
+
+		namespace winLib {
+			// Recycles the coroutine frames of a thread, in size classes of FRAME_ALIGN bytes.
+			// A server starts the same few coroutines for every connection, so after the first ones every frame
+			// is taken from a free list.
+			class FramePool {
+			public:
+				static constexpr size_t FRAME_ALIGN = 64;
+				static constexpr size_t MAX_POOLED = 4096;		// bigger frames use the heap
+				static constexpr size_t MAX_FREE = 1024;		// per size class
+
+				static void* allocate(size_t size);
+				static void deallocate(void* frame, size_t size) noexcept;
+			};
+
+			template <class T = void>
+			class Async;
+
+			// the parts of a promise that don't depend on the result type
+			class AsyncPromiseBase {
+			public:
+				std::coroutine_handle<> continuation;	// awaits the result, resumed at the end
+				std::exception_ptr exception;
+				bool detached = false;					// spawn(): frees its own frame at the end
+
+				static void* operator new(size_t size) { return FramePool::allocate(size); }
+				static void operator delete(void* frame, size_t size) noexcept { FramePool::deallocate(frame, size); }
+
+				// lazy, runs when it's awaited or spawned
+				std::suspend_always initial_suspend() noexcept { return {}; }
+
+				struct FinalAwaiter {
+					bool await_ready() const noexcept { return false; }
+					void await_resume() const noexcept {}
+
+					template <class Promise>
+					std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) noexcept {
+						AsyncPromiseBase& promise = handle.promise();
+
+						if (promise.continuation)
+							return promise.continuation;
+
+						if (promise.detached) {
+							if (promise.exception)
+								report_detached(promise.exception);
+
+							handle.destroy();
+						}
+
+						return std::noop_coroutine();
+					}
+				};
+
+				FinalAwaiter final_suspend() noexcept { return {}; }
+				void unhandled_exception() noexcept { exception = std::current_exception(); }
+
+				// nobody awaits a spawned coroutine, its exception is printed
+				static void report_detached(const std::exception_ptr& exception) noexcept;
+			};
+
+			template <class T>
+			class AsyncPromise : public AsyncPromiseBase {
+			public:
+				std::optional<T> value;
+
+				template <class U>
+				void return_value(U&& result) { value.emplace(std::forward<U>(result)); }
+
+				T result() {
+					if (exception)
+						std::rethrow_exception(exception);
+
+					return std::move(*value);
+				}
+			};
+
+			template <>
+			class AsyncPromise<void> : public AsyncPromiseBase {
+			public:
+				void return_void() noexcept {}
+
+				void result() {
+					if (exception)
+						std::rethrow_exception(exception);
+				}
+			};
+
+			// A lazy coroutine: starts when it's co_awaited (the awaiting coroutine continues with its result) or
+			// given to spawn(). Move only, destroys the frame if it never ran.
+			template <class T>
+			class Async {
+			public:
+				struct promise_type : AsyncPromise<T> {
+					Async get_return_object() noexcept { return Async(std::coroutine_handle<promise_type>::from_promise(*this)); }
+				};
+
+				using Handle = std::coroutine_handle<promise_type>;
+
+				Async() noexcept = default;
+				Async(Async&& other) noexcept : handle(std::exchange(other.handle, nullptr)) {}
+				~Async() { if (handle) handle.destroy(); }
+
+				Async& operator=(Async&& other) noexcept {
+					if (this != &other) {
+						if (handle)
+							handle.destroy();
+						handle = std::exchange(other.handle, nullptr);
+					}
+					return *this;
+				}
+
+				Async(const Async&) = delete;
+				Async& operator=(const Async&) = delete;
+
+				bool valid() const noexcept { return static_cast<bool>(handle); }
+				bool done() const noexcept { return handle && handle.done(); }
+
+				struct Awaiter {
+					Handle handle;
+
+					bool await_ready() const noexcept { return !handle || handle.done(); }
+
+					// symmetric transfer: a chain of awaits doesn't grow the stack
+					std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept {
+						handle.promise().continuation = awaiting;
+						return handle;
+					}
+
+					T await_resume() {
+						// a moved from or default constructed Async has no coroutine to take the result of
+						if (!handle)
+							throw std::system_error(std::make_error_code(std::errc::invalid_argument), "co_await of an empty Async");
+
+						return handle.promise().result();
+					}
+				};
+
+				Awaiter operator co_await() && noexcept { return Awaiter{ handle }; }
+
+				// starts the coroutine on this thread, it runs until its first suspension
+				friend void spawn(Async<void> task);
+
+			private:
+				Handle handle;
+
+				explicit Async(Handle handle) noexcept : handle(handle) {}
+			};
+
+			void spawn(Async<void> task);
+
+			// A non-blocking socket on an EventLoop. recv, send and connect complete at once if the socket is ready and
+			// wait for its readiness otherwise. One recv and one send may be pending at the same time, the socket must
+			// not be moved or destroyed while one is.
+			class AsyncSocket {
+			public:
+				SocketHandle sock;
+
+				AsyncSocket() noexcept = default;
+				// switches the socket to the non-blocking mode (unless it already is)
+				AsyncSocket(EventLoop& loop, SocketHandle&& sock, bool nonblocking = false) noexcept;
+				AsyncSocket(AsyncSocket&& other) noexcept;
+				AsyncSocket& operator=(AsyncSocket&& other) noexcept;
+				~AsyncSocket();
+
+				// the operation of one co_await, its result is the one of await_resume
+				class Operation {
+				public:
+					bool await_ready() noexcept { return attempt(); }
+					bool await_suspend(std::coroutine_handle<> awaiting) noexcept;
+					int await_resume() const noexcept { return result; }
+
+				protected:
+					friend class AsyncSocket;
+
+					enum Kind { RECV, SEND, ACCEPT, CONNECT };
+
+					AsyncSocket* socket;
+					Kind kind;
+					char* buffer;
+					size_t length;
+					size_t done = 0;
+					const sockaddr* address = nullptr;
+					socklen_t address_length = 0;
+					bool started = false;
+					int result = 0;
+					SocketHandle accepted;
+					std::coroutine_handle<> waiting;
+
+					Operation(AsyncSocket* socket, Kind kind, char* buffer = nullptr, size_t length = 0) noexcept;
+
+					// true if it completed (result is set), false if it has to wait for the readiness
+					bool attempt() noexcept;
+				};
+
+				class AcceptOperation : public Operation {
+				public:
+					// invalid socket on error
+					AsyncSocket await_resume() noexcept { return accepted ? AsyncSocket(*socket->event_loop, std::move(accepted), true) : AsyncSocket(); }
+
+				private:
+					friend class AsyncSocket;
+					using Operation::Operation;
+				};
+
+				// received bytes (at least 1), 0 if the peer closed the connection or -error code
+				Operation recv(char* buffer, size_t length) noexcept { return Operation(this, Operation::RECV, buffer, length); }
+				// all of data, length or -error code
+				Operation send(const char* data, size_t length) noexcept { return Operation(this, Operation::SEND, const_cast<char*>(data), length); }
+				// on a listening socket
+				AcceptOperation accept() noexcept { return AcceptOperation(this, Operation::ACCEPT); }
+				// 0 or -error code, address has to live until it completed
+				Operation connect(const sockaddr* address, socklen_t length) noexcept;
+
+				// stops watching the socket and closes it, a pending recv, send or accept continues with -ECANCELED (an
+				// invalid socket for accept) before close returns
+				void close() noexcept;
+
+				bool valid() const noexcept { return sock.valid(); }
+				EventLoop& loop() const noexcept { return *event_loop; }
+
+			private:
+				EventLoop* event_loop = nullptr;
+				bool watched = false;
+				Operation* reading = nullptr;
+				Operation* writing = nullptr;
+				// set by the destructor, a resumed coroutine may destroy the socket inside of ready()
+				bool* destroyed = nullptr;
+
+				// watches the socket on its first wait, false on error
+				bool watch() noexcept;
+				void unwatch() noexcept;
+				void ready(unsigned int events);
+				void cancel_pending() noexcept;
+			};
+
+			// Listens like EventServer, but every accepted connection is handed to the coroutine that awaits accept().
+			class AsyncServer {
+			public:
+				ServerSocket listener;		// the settings (port, reuse_port), the socket moves to acceptor with start()
+				AsyncSocket acceptor;
+
+				AsyncServer(EventLoop& loop, PCSTR port = DEFAULT_PORT);
+
+				// creates the non-blocking listening socket, 0 or the error code
+				int start();
+				// a pending accept() continues with an invalid socket
+				void stop() noexcept { acceptor.close(); }
+
+				// the next connection, an invalid socket on error (or after stop())
+				AsyncSocket::AcceptOperation accept() noexcept { return acceptor.accept(); }
+
+			private:
+				EventLoop* event_loop;
+			};
+
+			// Resolves host (blocking) and connects to the first address that takes the connection.
+			// An invalid socket if none did, error (if not null) gets the last error code.
+			Async<AsyncSocket> connect(EventLoop& loop, PCSTR host, PCSTR port = DEFAULT_PORT, int* error = nullptr);
+			// The same with the addresses of resolver: the loop keeps running while host is looked up.
+			Async<AsyncSocket> connect(EventLoop& loop, Resolver& resolver, PCSTR host, PCSTR port = DEFAULT_PORT, int* error = nullptr);
+		}
+	#endif
+#endif
\ No newline at end of file
@@ -0,0 +1,455 @@
+#include "buffer.hpp"
+#include "platform.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <new>
+#include <utility>
+
+namespace winLib {
+	// the free slabs of one thread
+	struct SlabList {
+		Slab* head = nullptr;
+		size_t count = 0;
+
+		~SlabList();
+	};
+
+	// a free slab keeps the next one in its data
+	static Slab*& next_free(Slab* slab) noexcept {
+		return *reinterpret_cast<Slab**>(slab->data());
+	}
+
+	static thread_local SlabList free_slabs;
+	// a slab released after the list of its thread (by the destructor of another thread local) goes to the heap
+	static thread_local bool free_slabs_closed = false;
+
+	SlabList::~SlabList() {
+		while (head) {
+			Slab* slab = head;
+			head = next_free(slab);
+			slab->~Slab();
+			::operator delete(slab);
+		}
+
+		free_slabs_closed = true;
+	}
+
+	Slab* Slab::allocate() {
+		if (Slab* slab = free_slabs.head) {
+			free_slabs.head = next_free(slab);
+			free_slabs.count--;
+
+			slab->references.store(1, std::memory_order_relaxed);
+			slab->used = 0;
+
+			return slab;
+		}
+
+		return new (::operator new(sizeof(Slab) + SLAB_SIZE)) Slab();
+	}
+
+	void Slab::release() noexcept {
+		if (references.fetch_sub(1, std::memory_order_acq_rel) != 1)
+			return;
+
+		if (free_slabs_closed || free_slabs.count >= MAX_FREE) {
+			this->~Slab();
+			::operator delete(this);
+			return;
+		}
+
+		next_free(this) = free_slabs.head;
+		free_slabs.head = this;
+		free_slabs.count++;
+	}
+
+	BufferSlice::BufferSlice(Slab* slab, size_t offset, size_t length) noexcept {
+		this->slab = slab;
+		this->offset = static_cast<uint32_t>(offset);
+		this->length = static_cast<uint32_t>(length);
+
+		slab->acquire();
+	}
+
+	BufferSlice::BufferSlice(const BufferSlice& other) noexcept : slab(other.slab), offset(other.offset), length(other.length) {
+		if (slab)
+			slab->acquire();
+	}
+
+	BufferSlice::BufferSlice(BufferSlice&& other) noexcept : slab(std::exchange(other.slab, nullptr)), offset(other.offset), length(std::exchange(other.length, 0)) {}
+
+	BufferSlice& BufferSlice::operator=(BufferSlice other) noexcept {
+		std::swap(slab, other.slab);
+		std::swap(offset, other.offset);
+		std::swap(length, other.length);
+
+		return *this;
+	}
+
+	BufferSlice::~BufferSlice() {
+		if (slab)
+			slab->release();
+	}
+
+	BufferSlice BufferSlice::slice(size_t offset, size_t length) const noexcept {
+		if (!slab)
+			return {};
+
+		offset = std::min<size_t>(offset, this->length);
+		length = std::min<size_t>(length, this->length - offset);
+
+		return BufferSlice(slab, this->offset + offset, length);
+	}
+
+	BufferChain::BufferChain(const char* data, size_t length) {
+		append(data, length);
+	}
+
+	Slab* BufferChain::writable_tail() const noexcept {
+		if (parts.empty())
+			return nullptr;
+
+		const BufferSlice& tail = parts.back();
+		Slab* slab = tail.slab;
+
+		if (tail.offset + tail.length != slab->used || slab->references.load(std::memory_order_acquire) != 1 || slab->room() == 0)
+			return nullptr;
+
+		return slab;
+	}
+
+	void BufferChain::extend_tail(size_t count) noexcept {
+		BufferSlice& tail = parts.back();
+
+		tail.slab->used += count;
+		tail.length += static_cast<uint32_t>(count);
+		total += count;
+	}
+
+	void BufferChain::append_slab(Slab* slab, size_t length) {
+		slab->used = length;
+
+		BufferSlice slice;
+		slice.slab = slab;
+		slice.length = static_cast<uint32_t>(length);
+
+		parts.push_back(std::move(slice));
+		total += length;
+	}
+
+	void BufferChain::append(const char* data, size_t length) {
+		if (length == 0)
+			return;
+
+		if (Slab* tail = writable_tail()) {
+			const size_t count = std::min(length, tail->room());
+
+			std::memcpy(tail->data() + tail->used, data, count);
+			extend_tail(count);
+
+			data += count;
+			length -= count;
+		}
+
+		while (length > 0) {
+			Slab* slab = Slab::allocate();
+			const size_t count = std::min(length, SLAB_SIZE);
+
+			std::memcpy(slab->data(), data, count);
+			append_slab(slab, count);
+
+			data += count;
+			length -= count;
+		}
+	}
+
+	void BufferChain::append(const BufferSlice& slice) {
+		if (slice.empty())
+			return;
+
+		parts.push_back(slice);
+		total += slice.size();
+	}
+
+	void BufferChain::append(const BufferChain& chain) {
+		for (const BufferSlice& slice : chain.parts)
+			append(slice);
+	}
+
+	void BufferChain::append(BufferChain&& chain) {
+		for (BufferSlice& slice : chain.parts)
+			parts.push_back(std::move(slice));
+
+		total += chain.total;
+		chain.clear();
+	}
+
+	void BufferChain::consume(size_t count) noexcept {
+		count = std::min(count, total);
+		total -= count;
+
+		while (count > 0) {
+			BufferSlice& front = parts.front();
+
+			if (count < front.length) {
+				front.offset += static_cast<uint32_t>(count);
+				front.length -= static_cast<uint32_t>(count);
+				return;
+			}
+
+			count -= front.length;
+			parts.pop_front();
+		}
+	}
+
+	void BufferChain::clear() noexcept {
+		parts.clear();
+		total = 0;
+	}
+
+	BufferChain BufferChain::slice(size_t offset, size_t length) const {
+		BufferChain result;
+
+		for (const BufferSlice& part : parts) {
+			if (length == 0)
+				break;
+
+			if (offset >= part.size()) {
+				offset -= part.size();
+				continue;
+			}
+
+			BufferSlice shared = part.slice(offset, length);
+			length -= shared.size();
+			offset = 0;
+
+			result.append(shared);
+		}
+
+		return result;
+	}
+
+	size_t BufferChain::copy_to(char* out, size_t length, size_t offset) const noexcept {
+		size_t copied = 0;
+
+		for (const BufferSlice& part : parts) {
+			if (copied == length)
+				break;
+
+			if (offset >= part.size()) {
+				offset -= part.size();
+				continue;
+			}
+
+			const size_t count = std::min(part.size() - offset, length - copied);
+
+			std::memcpy(out + copied, part.data() + offset, count);
+			copied += count;
+			offset = 0;
+		}
+
+		return copied;
+	}
+
+	int send_chain(SOCKET sock, BufferChain& chain, int flags) {
+		const size_t count = std::min<size_t>(chain.slices(), MAX_IOV);
+
+		#ifdef WINDOWS_SOCKET_WINSOCK
+			WSABUF buffers[MAX_IOV];
+
+			for (size_t i = 0; i < count; i++) {
+				buffers[i].buf = const_cast<CHAR*>(chain.slice_at(i).data());
+				buffers[i].len = static_cast<ULONG>(chain.slice_at(i).size());
+			}
+
+			DWORD sent = 0;
+
+			if (WSASend(sock, buffers, static_cast<DWORD>(count), &sent, static_cast<DWORD>(flags), nullptr, nullptr) == SOCKET_ERROR)
+				return SOCKET_ERROR;
+		#else
+			iovec buffers[MAX_IOV];
+
+			for (size_t i = 0; i < count; i++) {
+				buffers[i].iov_base = const_cast<char*>(chain.slice_at(i).data());
+				buffers[i].iov_len = chain.slice_at(i).size();
+			}
+
+			msghdr message{};
+			message.msg_iov = buffers;
+			message.msg_iovlen = count;
+
+			const ssize_t sent = sendmsg(sock, &message, flags);
+
+			if (sent == SOCKET_ERROR)
+				return SOCKET_ERROR;
+		#endif
+
+		chain.consume(static_cast<size_t>(sent));
+
+		return static_cast<int>(sent);
+	}
+
+	int receive_chain(SOCKET sock, BufferChain& chain, size_t length) {
+		Slab* slabs[MAX_IOV];
+		size_t count = 0;
+		size_t prepared = 0;
+
+		// the free end of the last slab first
+		Slab* tail = chain.writable_tail();
+
+		if (tail) {
+			slabs[count++] = tail;
+			prepared += tail->room();
+		}
+
+		while (prepared < length && count < MAX_IOV) {
+			slabs[count++] = Slab::allocate();
+			prepared += SLAB_SIZE;
+		}
+
+		#ifdef WINDOWS_SOCKET_WINSOCK
+			WSABUF buffers[MAX_IOV];
+		#else
+			iovec buffers[MAX_IOV];
+		#endif
+
+		size_t left = length;
+
+		for (size_t i = 0; i < count; i++) {
+			const size_t room = std::min(slabs[i]->room(), left);
+			left -= room;
+
+			#ifdef WINDOWS_SOCKET_WINSOCK
+				buffers[i].buf = slabs[i]->data() + slabs[i]->used;
+				buffers[i].len = static_cast<ULONG>(room);
+			#else
+				buffers[i].iov_base = slabs[i]->data() + slabs[i]->used;
+				buffers[i].iov_len = room;
+			#endif
+		}
+
+		#ifdef WINDOWS_SOCKET_WINSOCK
+			DWORD received = 0;
+			DWORD receive_flags = 0;
+
+			const bool failed = WSARecv(sock, buffers, static_cast<DWORD>(count), &received, &receive_flags, nullptr, nullptr) == SOCKET_ERROR;
+		#else
+			msghdr message{};
+			message.msg_iov = buffers;
+			message.msg_iovlen = count;
+
+			const ssize_t received = recvmsg(sock, &message, 0);
+			const bool failed = received == SOCKET_ERROR;
+		#endif
+
+		const int error = failed ? last_socket_error() : 0;
+		size_t filled = failed ? 0 : static_cast<size_t>(received);
+
+		for (size_t i = 0; i < count; i++) {
+			Slab* slab = slabs[i];
+
+			#ifdef WINDOWS_SOCKET_WINSOCK
+				const size_t room = buffers[i].len;
+			#else
+				const size_t room = buffers[i].iov_len;
+			#endif
+
+			const size_t part = std::min(room, filled);
+			filled -= part;
+
+			if (slab == tail)
+				chain.extend_tail(part);
+			else if (part == 0)
+				slab->release();
+			else
+				chain.append_slab(slab, part);
+		}
+
+		if (failed) {
+			// the releases above may have changed it
+			#ifdef WINDOWS_SOCKET_WINSOCK
+				WSASetLastError(error);
+			#else
+				errno = error;
+			#endif
+
+			return SOCKET_ERROR;
+		}
+
+		return static_cast<int>(received);
+	}
+
+	#ifdef SO_EE_ORIGIN_ZEROCOPY
+		ZeroCopySender::ZeroCopySender(SOCKET sock) noexcept {
+			const int enable = 1;
+
+			this->sock = sock;
+			this->zerocopy = setsockopt(sock, SOL_SOCKET, SO_ZEROCOPY, &enable, sizeof(enable)) == 0;
+			this->next_id = 0;
+		}
+
+		int ZeroCopySender::send(BufferChain& chain, int flags) {
+			reap();
+
+			if (!zerocopy || chain.size() < ZEROCOPY_THRESHOLD)
+				return send_chain(sock, chain, flags);
+
+			// the kernel reads the slabs after sendmsg returned, they stay referenced until the notification
+			BufferChain held = chain.slice(0, chain.size());
+			const int sent = send_chain(sock, chain, flags | MSG_ZEROCOPY);
+
+			if (sent == SOCKET_ERROR) {
+				const int err = last_socket_error();
+
+				// the socket ran out of optmem for the notifications, this one is sent with a copy
+				if (err == ENOBUFS)
+					return send_chain(sock, chain, flags);
+
+				return SOCKET_ERROR;
+			}
+
+			in_flight.push_back({ next_id++, held.slice(0, static_cast<size_t>(sent)) });
+
+			return sent;
+		}
+
+		int ZeroCopySender::reap() {
+			int released = 0;
+
+			while (!in_flight.empty()) {
+				char control[CMSG_SPACE(sizeof(sock_extended_err))];
+
+				msghdr message{};
+				message.msg_control = control;
+				message.msg_controllen = sizeof(control);
+
+				if (recvmsg(sock, &message, MSG_ERRQUEUE | MSG_DONTWAIT) == SOCKET_ERROR)
+					break;
+
+				for (cmsghdr* header = CMSG_FIRSTHDR(&message); header; header = CMSG_NXTHDR(&message, header)) {
+					const sock_extended_err* error = reinterpret_cast<const sock_extended_err*>(CMSG_DATA(header));
+
+					if (error->ee_errno != 0 || error->ee_origin != SO_EE_ORIGIN_ZEROCOPY)
+						continue;
+
+					// the kernel had to copy: the pinning was for nothing, the next sends copy right away
+					if (error->ee_code & SO_EE_CODE_ZEROCOPY_COPIED)
+						zerocopy = false;
+
+					// the range [ee_info, ee_data] of sends is done
+					const uint32_t first = error->ee_info, last = error->ee_data;
+
+					const auto done = std::remove_if(in_flight.begin(), in_flight.end(), [&](const InFlight& send) {
+						return send.id - first <= last - first;
+					});
+
+					released += static_cast<int>(in_flight.end() - done);
+					in_flight.erase(done, in_flight.end());
+				}
+			}
+
+			return released;
+		}
+	#endif
+}
\ No newline at end of file
@@ -0,0 +1,161 @@
+#ifndef WINDOWS_SOCKET_BUFFER_HPP
+	#define WINDOWS_SOCKET_BUFFER_HPP
+
+	#include "util.hpp"
+
+	#include <atomic>
+	#include <cstdint>
+	#include <deque>
+
+	#ifdef __linux__
+		#include <linux/errqueue.h>
+	#endif
+
+	// Buffer chains: a message is a list of slices over reference counted slabs. A slice of received data, a
+	// header in front of a payload or the same payload for many connections share the memory instead of copying
+	// it, and send_chain / receive_chain move all slices of a chain with one sendmsg / recvmsg (WSASend / WSARecv).
+
+	namespace winLib {
+		constexpr size_t SLAB_SIZE = 16384;
+		// slices of one send_chain / receive_chain call
+		constexpr int MAX_IOV = 64;
+
+		// A block of SLAB_SIZE bytes with a reference count, from a pool of the thread that frees it.
+		class Slab {
+		public:
+			static constexpr size_t MAX_FREE = 256;	// pooled per thread, the rest goes back to the heap
+
+			std::atomic<unsigned int> references;
+			size_t used;							// written from the start, appends continue here
+
+			// one reference
+			static Slab* allocate();
+
+			void acquire() noexcept { references.fetch_add(1, std::memory_order_relaxed); }
+			// back to the pool with the last reference
+			void release() noexcept;
+
+			char* data() noexcept { return reinterpret_cast<char*>(this + 1); }
+			size_t room() const noexcept { return SLAB_SIZE - used; }
+
+		private:
+			Slab() noexcept : references(1), used(0) {}
+		};
+
+		// Shares (a part of) a slab. Copies share the same memory.
+		class BufferSlice {
+		public:
+			BufferSlice() noexcept = default;
+			// takes a new reference to slab
+			BufferSlice(Slab* slab, size_t offset, size_t length) noexcept;
+			BufferSlice(const BufferSlice& other) noexcept;
+			BufferSlice(BufferSlice&& other) noexcept;
+			BufferSlice& operator=(BufferSlice other) noexcept;
+			~BufferSlice();
+
+			const char* data() const noexcept { return slab->data() + offset; }
+			size_t size() const noexcept { return length; }
+			bool empty() const noexcept { return length == 0; }
+
+			// offset and length are clamped to this slice
+			BufferSlice slice(size_t offset, size_t length) const noexcept;
+
+		private:
+			friend class BufferChain;
+
+			Slab* slab = nullptr;
+			uint32_t offset = 0;
+			uint32_t length = 0;
+		};
+
+		// A byte sequence over slices, appending copies only new data and never moves what's already in the chain.
+		class BufferChain {
+		public:
+			BufferChain() = default;
+			// copies data
+			BufferChain(const char* data, size_t length);
+
+			size_t size() const noexcept { return total; }
+			bool empty() const noexcept { return total == 0; }
+			size_t slices() const noexcept { return parts.size(); }
+			const BufferSlice& slice_at(size_t index) const noexcept { return parts[index]; }
+
+			// copies data, into the free end of the last slab if this chain wrote it
+			void append(const char* data, size_t length);
+			// shares the slices, nothing is copied
+			void append(const BufferSlice& slice);
+			void append(const BufferChain& chain);
+			void append(BufferChain&& chain);
+
+			// removes count bytes from the front
+			void consume(size_t count) noexcept;
+			void clear() noexcept;
+
+			// shares length bytes from offset on (clamped)
+			BufferChain slice(size_t offset, size_t length) const;
+			// copies up to length bytes from offset on, returns the count
+			size_t copy_to(char* out, size_t length, size_t offset = 0) const noexcept;
+
+		private:
+			friend int receive_chain(SOCKET sock, BufferChain& chain, size_t length);
+
+			std::deque<BufferSlice> parts;
+			size_t total = 0;
+
+			// the slab of the last slice if the slice ends where the slab is written to and nobody else holds it
+			Slab* writable_tail() const noexcept;
+			// the last slice grows by count bytes written into its slab
+			void extend_tail(size_t count) noexcept;
+			// a slice over the first length bytes of slab, takes over the reference of the caller
+			void append_slab(Slab* slab, size_t length);
+		};
+
+		// Gathers up to MAX_IOV slices into one sendmsg / WSASend and consumes what was sent.
+		// Bytes sent or SOCKET_ERROR (the error in last_socket_error()).
+		int send_chain(SOCKET sock, BufferChain& chain, int flags = SEND_FLAGS);
+		// Scatters up to length received bytes into the end of chain (the free end of its last slab, then new slabs).
+		// Bytes received, 0 if the peer closed the connection or SOCKET_ERROR.
+		int receive_chain(SOCKET sock, BufferChain& chain, size_t length = SLAB_SIZE);
+
+		#ifdef SO_EE_ORIGIN_ZEROCOPY
+			// Sends big chains with MSG_ZEROCOPY (Linux 4.14): the kernel sends from the slabs instead of copying them,
+			// the sent slices are held until the kernel reports them done on the error queue of the socket. Pays off
+			// from about ZEROCOPY_THRESHOLD bytes on, below that the copy is cheaper than the page pinning and the
+			// notification.
+			// For sockets the application sends on itself: the notifications arrive as IO_ERROR, the loop has to
+			// call reap() then and only treat a pending SO_ERROR as a failure. EventServer and UringServer copy the
+			// output into the queue of the Connection and don't send with it.
+			class ZeroCopySender {
+			public:
+				static constexpr size_t ZEROCOPY_THRESHOLD = 16384;
+
+				// sets SO_ZEROCOPY, sends normally if that fails
+				explicit ZeroCopySender(SOCKET sock) noexcept;
+
+				ZeroCopySender(const ZeroCopySender&) = delete;
+				ZeroCopySender& operator=(const ZeroCopySender&) = delete;
+
+				// like send_chain, reaps the completions first
+				int send(BufferChain& chain, int flags = SEND_FLAGS);
+				// releases the sends the kernel is done with, returns their count
+				int reap();
+
+				// sends the kernel still holds slabs of
+				size_t pending() const noexcept { return in_flight.size(); }
+				// false after the kernel copied a zerocopy send (loopback, devices without scatter / gather)
+				bool enabled() const noexcept { return zerocopy; }
+
+			private:
+				struct InFlight {
+					uint32_t id;
+					BufferChain data;
+				};
+
+				SOCKET sock;
+				bool zerocopy;
+				uint32_t next_id;			// the kernel counts the zerocopy sends of the socket from 0
+				std::deque<InFlight> in_flight;
+			};
+		#endif
+	}
+#endif
\ No newline at end of file
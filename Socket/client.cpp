@@ -6,11 +6,27 @@ namespace winLib {
 	}
 
 	int ClientSocket::create_socket() {
-		ZeroMemory(&hints, sizeof(hints));
-		hints.ai_family = AF_INET;
+		hints = {};
+		// IPv6 and IPv4 addresses, open_connection() races them
+		hints.ai_family = AF_UNSPEC;
 		hints.ai_socktype = SOCK_STREAM;
 		hints.ai_protocol = IPPROTO_TCP;
 
+		// resolved again (a new address after a failover)
+		free_result();
+		addresses.reset();
+
+		if (resolver) {
+			addresses = resolver->resolve(host_name, port);
+
+			if (addresses->error) {
+				std::cout << "\nERROR: resolve failed: " << addresses->error << std::endl;
+				return addresses->error;
+			}
+
+			return 0;
+		}
+
 		// Resolve the server address and port
 		if (const int r = getaddrinfo(host_name, port, &hints, &result)) {
 			std::cout << "\nERROR: getaddrinfo failed: " << r << std::endl;
@@ -20,35 +36,21 @@ namespace winLib {
 		return 0;
 	}
 
+	SocketHandle ClientSocket::open_connection(int* error) const {
+		return connect_parallel(addresses ? addresses->get() : result, connect_options, error);
+	}
+
 	int ClientSocket::connect_socket() {
 
-		if (result == nullptr)
+		if (result == nullptr && !addresses)
 			std::cout << "(connect)result is nullptr";
 
-		for (ptr = result; ptr != nullptr; ptr = ptr->ai_next) {
-
-			sock = socket(ptr->ai_family, ptr->ai_socktype, ptr->ai_protocol);
+		// the result stays, so the client can connect again after disconnect()
+		int err = 0;
+		sock = open_connection(&err);
 
-			if (sock == INVALID_SOCKET) {
-				std::cout << "\nERROR: socket failed: " << WSAGetLastError() << std::endl;
-				freeaddrinfo(result);
-				return WSAGetLastError();
-			}
-
-			if (connect(sock, ptr->ai_addr, (int)ptr->ai_addrlen) == SOCKET_ERROR) {
-				closesocket(sock);
-				sock = INVALID_SOCKET;
-				continue;
-			}
-
-			break;
-		}
-
-		freeaddrinfo(result);
-
-		if (sock == INVALID_SOCKET) {
+		if (!sock) {
 			std::cout << "\nERROR: unable to connect to server!\n";
-			const int err = WSAGetLastError();
 			// return -1 if the result variable was a nullptr -> err == 0
 			return err == 0 ? -1 : err;
 		}
@@ -59,8 +61,8 @@ namespace winLib {
 	int ClientSocket::send_data(char* data, int length) {
 		int bytes_sent;
 
-		if ((bytes_sent = send(sock, data, length, 0)) == SOCKET_ERROR) {
-			std::cout << "\nERROR: send failed: " << WSAGetLastError() << std::endl;
+		if ((bytes_sent = static_cast<int>(send(sock.get(), data, length, SEND_FLAGS))) == SOCKET_ERROR) {
+			std::cout << "\nERROR: send failed: " << last_socket_error() << std::endl;
 			return SOCKET_ERROR;
 		}
 
@@ -70,8 +72,8 @@ namespace winLib {
 	int ClientSocket::receive_data(char* buffer, int length) {
 		int bytes_recv;
 
-		if ((bytes_recv = recv(sock, buffer, length, 0)) == SOCKET_ERROR) {
-			std::cout << "\nERROR: recive failed: " << WSAGetLastError() << std::endl;
+		if ((bytes_recv = static_cast<int>(recv(sock.get(), buffer, length, 0))) == SOCKET_ERROR) {
+			std::cout << "\nERROR: recive failed: " << last_socket_error() << std::endl;
 			return SOCKET_ERROR;
 		}
 
@@ -79,17 +81,15 @@ namespace winLib {
 	}
 
 	bool ClientSocket::stop() {
-		if (shutdown(sock, SD_SEND) == SOCKET_ERROR) {
-			std::cout << "\nERROR: shutdown failed: " << WSAGetLastError() << std::endl;
-			closesocket(sock);
+		if (shutdown(sock.get(), SD_SEND) == SOCKET_ERROR) {
+			std::cout << "\nERROR: shutdown failed: " << last_socket_error() << std::endl;
+			sock.close();
 			return false;
 		}
 		return true;
 	}
 
 	bool ClientSocket::disconnect() {
-		if (closesocket(sock) == SOCKET_ERROR)
-			return WSAGetLastError();
-		return 0;
+		return sock.close();
 	}
 }
\ No newline at end of file
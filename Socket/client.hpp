@@ -2,16 +2,28 @@
 	#define WINDOWS_SOCKET_CLIENT_HPP
 
 	#include "socket.hpp"
+	#include "connect.hpp"
+	#include "resolver.hpp"
 
 	namespace winLib {
 		class ClientSocket : public Socket {
 		public:
 			PCSTR host_name;
+			// how open_connection() races the addresses of host_name
+			ConnectOptions connect_options;
+			// create_socket() asks the resolver (cached, shared with other clients) instead of getaddrinfo
+			Resolver* resolver = nullptr;
+			AddressList addresses;		// the answer of the resolver
 
 			ClientSocket(PCSTR host_name, PCSTR port = DEFAULT_PORT);
 
+			// resolves host_name (again, if it was resolved before)
 			int create_socket() override;
+			// connects sock to the first address that answers, can be called again after disconnect()
 			int connect_socket();
+			// A new connection to the resolved addresses (connect_parallel), sock is not touched (thread safe).
+			// Invalid handle on error, the error code in error.
+			SocketHandle open_connection(int* error = nullptr) const;
 			int send_data(char* data, int length) override;
 			int receive_data(char* buffer, int length = DEFAULT_BUFLEN) override;
 			bool stop() override;
@@ -0,0 +1,190 @@
+#include "connect.hpp"
+
+#include <algorithm>
+#include <iostream>
+#include <utility>
+
+#ifdef WINDOWS_SOCKET_POSIX
+	#include <poll.h>
+#endif
+
+namespace winLib {
+	#ifdef WINDOWS_SOCKET_WINSOCK
+		// reports failed connects as POLLERR / POLLHUP since Windows 10, version 2004
+		using PollDescriptor = WSAPOLLFD;
+
+		static int wait_for(PollDescriptor* descriptors, size_t count, int timeout) noexcept {
+			return WSAPoll(descriptors, static_cast<ULONG>(count), timeout);
+		}
+
+		static bool in_progress(int error) noexcept {
+			return error == WSAEWOULDBLOCK;
+		}
+
+		constexpr int TIMED_OUT = WSAETIMEDOUT;
+	#else
+		using PollDescriptor = pollfd;
+
+		static int wait_for(PollDescriptor* descriptors, size_t count, int timeout) noexcept {
+			return poll(descriptors, static_cast<nfds_t>(count), timeout);
+		}
+
+		static bool in_progress(int error) noexcept {
+			return error == EINPROGRESS;
+		}
+
+		constexpr int TIMED_OUT = ETIMEDOUT;
+	#endif
+
+	using Clock = std::chrono::steady_clock;
+
+	// the result of a finished non-blocking connect, 0 if it is established
+	static int connect_error(SOCKET sock) noexcept {
+		int err = 0;
+		socklen_t length = sizeof(err);
+
+		if (getsockopt(sock, SOL_SOCKET, SO_ERROR, reinterpret_cast<char*>(&err), &length) == SOCKET_ERROR)
+			return last_socket_error();
+
+		return err;
+	}
+
+	std::vector<const addrinfo*> interleave_addresses(const addrinfo* addresses, int preferred_family) {
+		std::vector<const addrinfo*> preferred, other;
+
+		for (const addrinfo* address = addresses; address != nullptr; address = address->ai_next)
+			(address->ai_family == preferred_family ? preferred : other).push_back(address);
+
+		if (preferred.empty() || other.empty()) {
+			preferred.insert(preferred.end(), other.begin(), other.end());
+			return preferred;
+		}
+
+		std::vector<const addrinfo*> order;
+		order.reserve(preferred.size() + other.size());
+
+		for (size_t i = 0; i < preferred.size() || i < other.size(); i++) {
+			if (i < preferred.size())
+				order.push_back(preferred[i]);
+
+			if (i < other.size())
+				order.push_back(other[i]);
+		}
+
+		return order;
+	}
+
+	SocketHandle connect_parallel(const addrinfo* addresses, const ConnectOptions& options, int* error) {
+		const std::vector<const addrinfo*> order = interleave_addresses(addresses, options.preferred_family);
+
+		// the attempts in flight, pending[i] is polled with descriptors[i]
+		std::vector<SocketHandle> pending;
+		std::vector<PollDescriptor> descriptors;
+
+		const Clock::time_point deadline = options.timeout.count() > 0 ? Clock::now() + options.timeout : Clock::time_point::max();
+		Clock::time_point next_attempt = Clock::now();
+		size_t next = 0;
+		int last_error = 0;
+
+		// the winner goes back to blocking mode like the sockets of the other classes
+		const auto connected = [error](SocketHandle&& sock) {
+			set_nonblocking(sock.get(), false);
+
+			if (error)
+				*error = 0;
+
+			return std::move(sock);
+		};
+
+		for (;;) {
+			const Clock::time_point now = Clock::now();
+
+			if (now >= deadline) {
+				last_error = TIMED_OUT;
+				break;
+			}
+
+			// the next address starts when the last one had its head start or nothing is in flight any more
+			if (next < order.size() && (now >= next_attempt || pending.empty())) {
+				const addrinfo* address = order[next++];
+				SocketHandle sock(socket(address->ai_family, address->ai_socktype, address->ai_protocol));
+
+				if (!sock || !set_nonblocking(sock.get())) {
+					last_error = last_socket_error();
+					continue;
+				}
+
+				if (connect(sock.get(), address->ai_addr, static_cast<socklen_t>(address->ai_addrlen)) == 0)
+					return connected(std::move(sock));
+
+				const int err = last_socket_error();
+
+				// refused right away (no route, nobody listens on loopback): the next one starts at once
+				if (!in_progress(err)) {
+					last_error = err;
+					continue;
+				}
+
+				PollDescriptor descriptor{};
+				descriptor.fd = sock.get();
+				descriptor.events = POLLOUT;
+
+				pending.push_back(std::move(sock));
+				descriptors.push_back(descriptor);
+				next_attempt = now + options.attempt_delay;
+				continue;
+			}
+
+			if (pending.empty())
+				break;
+
+			Clock::time_point wake = deadline;
+
+			if (next < order.size())
+				wake = std::min(wake, next_attempt);
+
+			int timeout = -1;
+
+			if (wake != Clock::time_point::max())
+				timeout = static_cast<int>(std::chrono::ceil<std::chrono::milliseconds>(std::max(wake - now, Clock::duration::zero())).count());
+
+			const int ready = wait_for(descriptors.data(), descriptors.size(), timeout);
+
+			if (ready == SOCKET_ERROR) {
+				last_error = last_socket_error();
+
+				#ifdef WINDOWS_SOCKET_POSIX
+					if (last_error == EINTR)
+						continue;
+				#endif
+
+				break;
+			}
+
+			for (size_t i = 0; i < descriptors.size(); ) {
+				if (descriptors[i].revents == 0) {
+					i++;
+					continue;
+				}
+
+				const int err = connect_error(pending[i].get());
+
+				// the other attempts are closed with pending
+				if (err == 0)
+					return connected(std::move(pending[i]));
+
+				last_error = err;
+				pending.erase(pending.begin() + static_cast<std::ptrdiff_t>(i));
+				descriptors.erase(descriptors.begin() + static_cast<std::ptrdiff_t>(i));
+
+				// a failed attempt gives its turn to the next address
+				next_attempt = Clock::now();
+			}
+		}
+
+		if (error)
+			*error = last_error;
+
+		return SocketHandle();
+	}
+}
\ No newline at end of file
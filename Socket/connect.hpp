@@ -0,0 +1,33 @@
+#ifndef WINDOWS_SOCKET_CONNECT_HPP
+	#define WINDOWS_SOCKET_CONNECT_HPP
+
+	#include "util.hpp"
+	#include "platform.hpp"
+
+	#include <chrono>
+	#include <vector>
+
+	// Happy Eyeballs (RFC 8305): the addresses of a host are tried in parallel instead of one after the other.
+	// The families alternate (IPv6 first), every attempt gets attempt_delay to finish before the next one starts
+	// next to it, and the first connection that is established wins. An address that doesn't answer costs
+	// attempt_delay, not the whole TCP connect timeout.
+
+	namespace winLib {
+		struct ConnectOptions {
+			// head start of an attempt before the next address is tried (RFC 8305: 250 ms, at least 10 ms)
+			std::chrono::milliseconds attempt_delay{ 250 };
+			// for all attempts together, 0 waits as long as the system connect timeout
+			std::chrono::milliseconds timeout{ 0 };
+			// the family tried first, AF_UNSPEC keeps the order of getaddrinfo
+			int preferred_family = AF_INET6;
+		};
+
+		// the addresses in the order they are tried: the families alternate, starting with preferred_family
+		std::vector<const addrinfo*> interleave_addresses(const addrinfo* addresses, int preferred_family = AF_INET6);
+
+		// Races connects to the addresses, the winner is returned as a blocking socket and the other attempts are
+		// closed. Invalid handle if no address could be reached, the error of the last failed attempt in error.
+		// Thread safe.
+		SocketHandle connect_parallel(const addrinfo* addresses, const ConnectOptions& options = {}, int* error = nullptr);
+	}
+#endif
\ No newline at end of file
@@ -0,0 +1,145 @@
+#include "connection.hpp"
+
+#include <algorithm>
+
+namespace winLib {
+	Connection::Connection(ConnectionServer* server, SocketHandle&& sock) noexcept : sock(std::move(sock)) {
+		this->owner = server;
+		this->close_requested = false;
+		this->over_high_watermark = false;
+	}
+
+	bool Connection::send_data(const char* data, size_t length) {
+		if (!sock || close_requested)
+			return false;
+
+		return owner->send_connection(*this, data, length);
+	}
+
+	void InputBuffer::consume(size_t count) noexcept {
+		offset += std::min(count, size());
+
+		// all consumed: the next append starts at the front without a move
+		if (offset == bytes.size())
+			clear();
+	}
+
+	void InputBuffer::clear() noexcept {
+		bytes.clear();
+		offset = 0;
+	}
+
+	void InputBuffer::append(const char* data, size_t length) {
+		compact();
+		bytes.insert(bytes.end(), data, data + length);
+	}
+
+	char* InputBuffer::prepare(size_t count) {
+		compact();
+
+		const size_t size = bytes.size();
+
+		bytes.resize(size + count);
+		prepared = count;
+
+		return bytes.data() + size;
+	}
+
+	void InputBuffer::commit(size_t received) noexcept {
+		bytes.resize(bytes.size() - prepared + std::min(received, prepared));
+		prepared = 0;
+	}
+
+	void InputBuffer::compact() noexcept {
+		if (offset > 0 && offset >= bytes.size() / 2) {
+			bytes.erase(bytes.begin(), bytes.begin() + static_cast<std::ptrdiff_t>(offset));
+			offset = 0;
+		}
+	}
+
+	void Connection::consume(size_t count) noexcept {
+		input.consume(count);
+	}
+
+	void Connection::close() noexcept {
+		close_requested = true;
+
+		if (owner->dispatching != this)
+			owner->close_connection(this);
+	}
+
+	ConnectionServer::ConnectionServer(ConnectionHandlers handlers, PCSTR port) : listener(port), connection_count(0) {
+		this->handlers = std::move(handlers);
+		this->dispatching = nullptr;
+	}
+
+	int ConnectionServer::open_listener() {
+		if (const int r = listener.create_socket())
+			return r;
+
+		if (!listener.bind_socket())
+			return -1;
+
+		if (const int r = listener.listen_state())
+			return r;
+
+		if (!set_nonblocking(listener.sock.get())) {
+			const int err = last_socket_error();
+			std::cout << "\nERROR: set_nonblocking failed: " << err << std::endl;
+			listener.sock.close();
+			return err;
+		}
+
+		return 0;
+	}
+
+	void ConnectionServer::dispatch(const std::function<void(Connection&)>& handler, Connection* connection) {
+		if (!handler)
+			return;
+
+		Connection* const previous = dispatching;
+
+		dispatching = connection;
+		handler(*connection);
+		dispatching = previous;
+	}
+
+	void ConnectionServer::apply_send_options(SOCKET sock) const noexcept {
+		const int enable = 1;
+
+		if (send_options.no_delay)
+			setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char*>(&enable), sizeof(enable));
+	}
+
+	bool ConnectionServer::queue_output(Connection& connection, const char* data, size_t length) {
+		if (send_options.queue_limit > 0 && connection.output.size() + length > send_options.queue_limit) {
+			std::cout << "\nERROR: send queue limit exceeded: " << connection.output.size() + length << std::endl;
+			connection.close();
+			return false;
+		}
+
+		connection.output.insert(connection.output.end(), data, data + length);
+
+		if (!connection.over_high_watermark && connection.output.size() > send_options.high_watermark) {
+			connection.over_high_watermark = true;
+			dispatch(handlers.on_high_watermark, &connection);
+
+			// closed by the handler, which runs inside of a handler of another connection (or none)
+			if (connection.close_requested && dispatching != &connection)
+				close_connection(&connection);
+		}
+
+		return true;
+	}
+
+	void ConnectionServer::output_sent(Connection& connection) {
+		if (!connection.over_high_watermark || connection.output.size() > send_options.low_watermark)
+			return;
+
+		connection.over_high_watermark = false;
+		dispatch(handlers.on_low_watermark, &connection);
+
+		if (connection.close_requested && dispatching != &connection)
+			close_connection(&connection);
+	}
+}
\ No newline at end of file
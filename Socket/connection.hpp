@@ -0,0 +1,160 @@
+#ifndef WINDOWS_SOCKET_CONNECTION_HPP
+	#define WINDOWS_SOCKET_CONNECTION_HPP
+
+	#include "server.hpp"
+
+	#include <any>
+	#include <atomic>
+	#include <chrono>
+	#include <functional>
+	#include <vector>
+
+	// The connection API of the non-blocking servers. EventServer (epoll) and UringServer (io_uring) run the same
+	// handlers on the same Connection type, so an application can switch between them.
+
+	namespace winLib {
+		class ConnectionServer;
+
+		// The received bytes of a connection. consume() only moves a read offset, the consumed bytes are dropped
+		// when new ones are appended and they are at least half of the buffer, so a handler that takes one small
+		// message after the other doesn't move the rest every time.
+		class InputBuffer {
+		public:
+			char* data() noexcept { return bytes.data() + offset; }
+			const char* data() const noexcept { return bytes.data() + offset; }
+			size_t size() const noexcept { return bytes.size() - offset; }
+			bool empty() const noexcept { return size() == 0; }
+
+			char& operator[](size_t index) noexcept { return data()[index]; }
+			const char& operator[](size_t index) const noexcept { return data()[index]; }
+
+			char* begin() noexcept { return data(); }
+			char* end() noexcept { return bytes.data() + bytes.size(); }
+			const char* begin() const noexcept { return data(); }
+			const char* end() const noexcept { return bytes.data() + bytes.size(); }
+
+			// removes the first count bytes (clamped)
+			void consume(size_t count) noexcept;
+			void clear() noexcept;
+
+			void append(const char* data, size_t length);
+			// count writable bytes behind the data for a recv, commit(received) keeps the received part
+			char* prepare(size_t count);
+			void commit(size_t received) noexcept;
+
+		private:
+			std::vector<char> bytes;
+			size_t offset = 0;		// consumed bytes in front
+			size_t prepared = 0;	// writable bytes of the last prepare()
+
+			// drops the consumed bytes if they are worth the move
+			void compact() noexcept;
+		};
+
+		class Connection {
+		public:
+			SocketHandle sock;
+			InputBuffer input;			// received and not consumed yet
+			std::vector<char> output;	// queued, not sent yet (the backend takes it from the front)
+			std::any state;				// of the application
+
+			Connection(ConnectionServer* server, SocketHandle&& sock) noexcept;
+
+			// queues data, the queue is sent with the end of the current loop iteration (see SendOptions)
+			// false if the connection is closed (or was closed because the queue passed the queue_limit)
+			bool send_data(const char* data, size_t length);
+			// removes the first count bytes of input
+			void consume(size_t count) noexcept;
+			// closed after the current handler returns
+			void close() noexcept;
+
+			bool closing() const noexcept { return close_requested; }
+			ConnectionServer& server() const noexcept { return *owner; }
+
+			size_t queued() const noexcept { return output.size(); }
+			// the queue passed the high watermark and didn't drain below the low one yet, producers should wait
+			bool paused() const noexcept { return over_high_watermark; }
+
+		private:
+			friend class ConnectionServer;
+
+			ConnectionServer* owner;
+			bool close_requested;
+			bool over_high_watermark;
+		};
+
+		struct ConnectionHandlers {
+			std::function<void(Connection&)> on_open;
+			std::function<void(Connection&)> on_data;			// input got new bytes
+			std::function<void(Connection&)> on_writable;		// the output the kernel didn't take at once was sent completely
+			std::function<void(Connection&)> on_close;			// the socket is still open
+			std::function<void(Connection&)> on_high_watermark;	// paused(): stop producing for this connection
+			std::function<void(Connection&)> on_low_watermark;	// resumed
+		};
+
+		// How the servers send the queued output of the connections.
+		struct SendOptions {
+			// TCP_NODELAY on every connection: the queue batches the small sends, Nagle would only delay them
+			bool no_delay = true;
+			// TCP_CORK while a queue is written (Linux, EventServer): no half full segment between two sends of one flush
+			bool cork = false;
+			// 0: the sends of one loop iteration go out together at its end, otherwise they wait up to this long for
+			// more (EventServer, UringServer always submits with the next iteration)
+			std::chrono::milliseconds coalesce_window{ 0 };
+			// a queue this big is sent at once
+			size_t flush_threshold = 64 * 1024;
+			// backpressure: on_high_watermark when a queue grows past high_watermark, on_low_watermark when it
+			// drained to low_watermark again
+			size_t high_watermark = 1024 * 1024;
+			size_t low_watermark = 256 * 1024;
+			// a connection that would queue more is closed (a client that doesn't read), 0: no limit
+			size_t queue_limit = 64 * 1024 * 1024;
+		};
+
+		class ConnectionServer {
+		public:
+			ServerSocket listener;
+			SendOptions send_options;	// set before start()
+
+			ConnectionServer(ConnectionHandlers handlers, PCSTR port);
+			virtual ~ConnectionServer() = default;
+
+			ConnectionServer(const ConnectionServer&) = delete;
+			ConnectionServer& operator=(const ConnectionServer&) = delete;
+
+			// creates the non-blocking listening socket, 0 or the error code
+			virtual int start() = 0;
+			// closes the listening socket and all connections (on the thread of the server)
+			virtual void stop() noexcept = 0;
+
+			// thread safe
+			size_t connections() const noexcept { return connection_count.load(std::memory_order_relaxed); }
+
+		protected:
+			friend class Connection;
+
+			ConnectionHandlers handlers;
+			std::atomic<size_t> connection_count;
+			// the connection of the running handler, closing it is deferred until the handler returns
+			Connection* dispatching;
+
+			virtual bool send_connection(Connection& connection, const char* data, size_t length) = 0;
+			virtual void close_connection(Connection* connection) noexcept = 0;
+
+			// create_socket, bind_socket, listen_state and the non-blocking mode, 0 or the error code
+			int open_listener();
+			// calls handler with connection as the dispatching one
+			void dispatch(const std::function<void(Connection&)>& handler, Connection* connection);
+
+			// the send options that are set per socket (TCP_NODELAY)
+			void apply_send_options(SOCKET sock) const noexcept;
+			// appends to the output and signals the high watermark, false if that passed the queue_limit (closed)
+			bool queue_output(Connection& connection, const char* data, size_t length);
+			// after a part of the output was sent, signals the low watermark
+			void output_sent(Connection& connection);
+
+			static bool close_requested(const Connection& connection) noexcept { return connection.close_requested; }
+			static void request_close(Connection& connection) noexcept { connection.close_requested = true; }
+		};
+	}
+#endif
\ No newline at end of file
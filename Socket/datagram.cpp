@@ -0,0 +1,469 @@
+#include "datagram.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+#ifdef WINDOWS_SOCKET_MMSG
+	#include <netinet/udp.h>
+#endif
+
+namespace winLib {
+	#ifdef WINDOWS_SOCKET_MMSG
+		// messages of one sendmmsg call (UIO_MAXIOV)
+		constexpr size_t MAX_MMSG = 1024;
+		// the kernel cuts at most 64 datagrams of one send (UDP_MAX_SEGMENTS), and it has to fit into one
+		// IP packet before it is cut
+		constexpr size_t GSO_MAX_SEGMENTS = 64;
+		constexpr size_t GSO_MAX_BYTES = 65000;
+		constexpr size_t GRO_CONTROL_SIZE = CMSG_SPACE(sizeof(int));
+	#endif
+
+	DatagramBatch::DatagramBatch(size_t capacity, size_t slot_size) : memory(capacity * slot_size), datagrams(capacity) {
+		this->slot = slot_size;
+		this->count = 0;
+
+		for (size_t i = 0; i < capacity; i++)
+			datagrams[i].data = memory.data() + i * slot_size;
+
+		#ifdef WINDOWS_SOCKET_MMSG
+			headers.resize(capacity);
+			vectors.resize(capacity);
+			controls.resize(capacity * GRO_CONTROL_SIZE);
+		#endif
+	}
+
+	bool DatagramBatch::add(const char* data, size_t length, const sockaddr* to, socklen_t to_length) noexcept {
+		if (full() || length > slot)
+			return false;
+
+		Datagram& datagram = datagrams[count++];
+
+		std::memcpy(datagram.data, data, length);
+		datagram.size = length;
+		datagram.segment_size = 0;
+		datagram.truncated = false;
+		datagram.address_length = 0;
+
+		if (to && static_cast<size_t>(to_length) <= sizeof(datagram.address)) {
+			std::memcpy(&datagram.address, to, static_cast<size_t>(to_length));
+			datagram.address_length = to_length;
+		}
+
+		return true;
+	}
+
+	DatagramSocket::DatagramSocket(PCSTR host_name, PCSTR port) : Socket(port) {
+		this->host_name = host_name;
+	}
+
+	int DatagramSocket::create_socket() {
+		// a receiver tries one IPv6 socket for both families first, a sender takes the family of host_name
+		for (int attempt = !host_name && dual_stack ? 0 : 1; attempt < 2; attempt++) {
+			free_result();
+
+			hints = {};
+			hints.ai_family = attempt == 0 ? AF_INET6 : host_name ? AF_UNSPEC : AF_INET;
+			hints.ai_socktype = SOCK_DGRAM;
+			hints.ai_protocol = IPPROTO_UDP;
+			hints.ai_flags = host_name ? 0 : AI_PASSIVE;
+
+			if (const int r = getaddrinfo(host_name, port, &hints, &result)) {
+				if (attempt == 0)
+					continue;
+
+				std::cout << "\nERROR: getaddrinfo failed: " << r << std::endl;
+				return r;
+			}
+
+			sock.reset(socket(result->ai_family, result->ai_socktype, result->ai_protocol));
+
+			if (!sock) {
+				const int err = last_socket_error();
+				free_result();
+
+				if (attempt == 0)
+					continue;
+
+				std::cout << "\nERROR: socket failed: " << err << std::endl;
+				return err;
+			}
+
+			if (attempt == 0) {
+				const int v6_only = 0;
+
+				if (setsockopt(sock.get(), IPPROTO_IPV6, IPV6_V6ONLY, reinterpret_cast<const char*>(&v6_only), sizeof(v6_only)) == SOCKET_ERROR) {
+					free_result();
+					sock.close();
+					continue;
+				}
+			}
+
+			break;
+		}
+
+		return 0;
+	}
+
+	bool DatagramSocket::bind_socket() {
+		if (bind(sock.get(), result->ai_addr, static_cast<socklen_t>(result->ai_addrlen)) == SOCKET_ERROR) {
+			std::cout << "\nERROR: bind failed: " << last_socket_error() << std::endl;
+			free_result();
+			sock.close();
+			return false;
+		}
+
+		free_result();
+
+		return true;
+	}
+
+	int DatagramSocket::connect_socket() {
+		// no handshake: the first address is the peer
+		if (connect(sock.get(), result->ai_addr, static_cast<socklen_t>(result->ai_addrlen)) == SOCKET_ERROR) {
+			const int err = last_socket_error();
+			std::cout << "\nERROR: connect failed: " << err << std::endl;
+			return err;
+		}
+
+		return 0;
+	}
+
+	int DatagramSocket::send_data(char* data, int length) {
+		int bytes_sent;
+
+		if ((bytes_sent = static_cast<int>(send(sock.get(), data, length, SEND_FLAGS))) == SOCKET_ERROR) {
+			std::cout << "\nERROR: send failed: " << last_socket_error() << std::endl;
+			return SOCKET_ERROR;
+		}
+
+		return bytes_sent;
+	}
+
+	int DatagramSocket::receive_data(char* buffer, int length) {
+		int bytes_recv;
+
+		if ((bytes_recv = static_cast<int>(recv(sock.get(), buffer, length, 0))) == SOCKET_ERROR) {
+			std::cout << "\nERROR: recive failed: " << last_socket_error() << std::endl;
+			return SOCKET_ERROR;
+		}
+
+		return bytes_recv;
+	}
+
+	int DatagramSocket::send_to(const char* data, size_t length, const sockaddr* to, socklen_t to_length) {
+		const int sent = static_cast<int>(sendto(sock.get(), data, static_cast<int>(length), SEND_FLAGS, to, to_length));
+
+		if (sent == SOCKET_ERROR && !would_block(last_socket_error()))
+			std::cout << "\nERROR: sendto failed: " << last_socket_error() << std::endl;
+
+		return sent;
+	}
+
+	int DatagramSocket::receive_from(char* buffer, size_t length, sockaddr_storage* from, socklen_t* from_length) {
+		const int received = static_cast<int>(recvfrom(sock.get(), buffer, static_cast<int>(length), 0, reinterpret_cast<sockaddr*>(from), from_length));
+
+		if (received == SOCKET_ERROR && !would_block(last_socket_error()))
+			std::cout << "\nERROR: recvfrom failed: " << last_socket_error() << std::endl;
+
+		return received;
+	}
+
+	int DatagramSocket::send_batch(DatagramBatch& batch) {
+		size_t sent = 0;
+
+		#ifdef WINDOWS_SOCKET_MMSG
+			for (size_t i = 0; i < batch.count; i++) {
+				Datagram& datagram = batch.datagrams[i];
+				msghdr& message = batch.headers[i].msg_hdr;
+
+				batch.vectors[i].iov_base = datagram.data;
+				batch.vectors[i].iov_len = datagram.size;
+
+				message = {};
+				message.msg_iov = &batch.vectors[i];
+				message.msg_iovlen = 1;
+
+				if (datagram.address_length > 0) {
+					message.msg_name = &datagram.address;
+					message.msg_namelen = datagram.address_length;
+				}
+			}
+
+			while (sent < batch.count) {
+				const int r = sendmmsg(sock.get(), &batch.headers[sent], static_cast<unsigned int>(std::min(batch.count - sent, MAX_MMSG)), SEND_FLAGS);
+
+				if (r == SOCKET_ERROR)
+					break;
+
+				sent += static_cast<size_t>(r);
+			}
+		#else
+			for (; sent < batch.count; sent++) {
+				const Datagram& datagram = batch.datagrams[sent];
+				const sockaddr* to = datagram.address_length > 0 ? reinterpret_cast<const sockaddr*>(&datagram.address) : nullptr;
+
+				if (sendto(sock.get(), datagram.data, static_cast<int>(datagram.size), SEND_FLAGS, to, datagram.address_length) == SOCKET_ERROR)
+					break;
+			}
+		#endif
+
+		if (sent == 0 && batch.count > 0) {
+			const int err = last_socket_error();
+
+			if (!would_block(err))
+				std::cout << "\nERROR: send batch failed: " << err << std::endl;
+
+			return SOCKET_ERROR;
+		}
+
+		return static_cast<int>(sent);
+	}
+
+	int DatagramSocket::receive_batch(DatagramBatch& batch) {
+		batch.count = 0;
+
+		#ifdef WINDOWS_SOCKET_MMSG
+			const size_t capacity = batch.capacity();
+
+			for (size_t i = 0; i < capacity; i++) {
+				Datagram& datagram = batch.datagrams[i];
+				msghdr& message = batch.headers[i].msg_hdr;
+
+				batch.vectors[i].iov_base = datagram.data;
+				batch.vectors[i].iov_len = batch.slot;
+
+				message = {};
+				message.msg_name = &datagram.address;
+				message.msg_namelen = sizeof(datagram.address);
+				message.msg_iov = &batch.vectors[i];
+				message.msg_iovlen = 1;
+
+				if (gro) {
+					message.msg_control = batch.controls.data() + i * GRO_CONTROL_SIZE;
+					message.msg_controllen = GRO_CONTROL_SIZE;
+				}
+			}
+
+			// MSG_WAITFORONE: waits for the first datagram, takes the others only if they are there already
+			const int r = recvmmsg(sock.get(), batch.headers.data(), static_cast<unsigned int>(std::min(capacity, MAX_MMSG)), MSG_WAITFORONE, nullptr);
+
+			if (r == SOCKET_ERROR) {
+				const int err = last_socket_error();
+
+				if (!would_block(err))
+					std::cout << "\nERROR: receive batch failed: " << err << std::endl;
+
+				return SOCKET_ERROR;
+			}
+
+			for (size_t i = 0; i < static_cast<size_t>(r); i++) {
+				Datagram& datagram = batch.datagrams[i];
+				msghdr& message = batch.headers[i].msg_hdr;
+
+				datagram.size = batch.headers[i].msg_len;
+				datagram.address_length = message.msg_namelen;
+				datagram.truncated = (message.msg_flags & MSG_TRUNC) != 0;
+				datagram.segment_size = 0;
+
+				#ifdef UDP_GRO
+					for (cmsghdr* header = CMSG_FIRSTHDR(&message); header; header = CMSG_NXTHDR(&message, header)) {
+						if (header->cmsg_level == IPPROTO_UDP && header->cmsg_type == UDP_GRO) {
+							int segment_size = 0;
+							std::memcpy(&segment_size, CMSG_DATA(header), sizeof(segment_size));
+							datagram.segment_size = static_cast<size_t>(segment_size);
+						}
+					}
+				#endif
+			}
+
+			batch.count = static_cast<size_t>(r);
+		#else
+			while (!batch.full()) {
+				Datagram& datagram = batch.datagrams[batch.count];
+				int flags = 0;
+
+				// only the first receive waits
+				if (batch.count > 0) {
+					#ifdef WINDOWS_SOCKET_WINSOCK
+						u_long waiting = 0;
+
+						if (ioctlsocket(sock.get(), FIONREAD, &waiting) == SOCKET_ERROR || waiting == 0)
+							break;
+					#else
+						flags = MSG_DONTWAIT;
+					#endif
+				}
+
+				datagram.address_length = sizeof(datagram.address);
+				datagram.segment_size = 0;
+				datagram.truncated = false;
+
+				const int r = static_cast<int>(recvfrom(sock.get(), datagram.data, static_cast<int>(batch.slot), flags, reinterpret_cast<sockaddr*>(&datagram.address), &datagram.address_length));
+
+				if (r == SOCKET_ERROR) {
+					const int err = last_socket_error();
+
+					#ifdef WINDOWS_SOCKET_WINSOCK
+						// the slot is filled, the rest of the datagram is lost
+						if (err == WSAEMSGSIZE) {
+							datagram.size = batch.slot;
+							datagram.truncated = true;
+							batch.count++;
+							continue;
+						}
+					#endif
+
+					if (batch.count > 0)
+						break;
+
+					if (!would_block(err))
+						std::cout << "\nERROR: receive batch failed: " << err << std::endl;
+
+					return SOCKET_ERROR;
+				}
+
+				datagram.size = static_cast<size_t>(r);
+				batch.count++;
+			}
+		#endif
+
+		return static_cast<int>(batch.count);
+	}
+
+	int DatagramSocket::send_segmented(const char* data, size_t length, size_t segment_size, const sockaddr* to, socklen_t to_length) {
+		if (segment_size == 0) {
+			std::cout << "\nERROR: segment size 0" << std::endl;
+			return SOCKET_ERROR;
+		}
+
+		size_t offset = 0;
+		size_t sent = 0;
+
+		#if defined(WINDOWS_SOCKET_MMSG) && defined(UDP_SEGMENT)
+			const size_t per_send = std::max<size_t>(1, std::min(GSO_MAX_SEGMENTS, GSO_MAX_BYTES / segment_size)) * segment_size;
+
+			while (gso && offset < length) {
+				const size_t chunk = std::min(length - offset, per_send);
+
+				iovec vector{ const_cast<char*>(data + offset), chunk };
+				alignas(cmsghdr) char control[CMSG_SPACE(sizeof(uint16_t))] = {};
+
+				msghdr message{};
+				message.msg_name = const_cast<sockaddr*>(to);
+				message.msg_namelen = to ? to_length : 0;
+				message.msg_iov = &vector;
+				message.msg_iovlen = 1;
+
+				// one segment is a plain datagram
+				if (chunk > segment_size) {
+					message.msg_control = control;
+					message.msg_controllen = sizeof(control);
+
+					cmsghdr* header = CMSG_FIRSTHDR(&message);
+					header->cmsg_level = IPPROTO_UDP;
+					header->cmsg_type = UDP_SEGMENT;
+					header->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+
+					const uint16_t size = static_cast<uint16_t>(segment_size);
+					std::memcpy(CMSG_DATA(header), &size, sizeof(size));
+				}
+
+				if (sendmsg(sock.get(), &message, SEND_FLAGS) == SOCKET_ERROR) {
+					const int err = last_socket_error();
+
+					// no checksum offload on the route (EIO) or a kernel without UDP_SEGMENT: the rest is cut here
+					if (err == EIO || err == EINVAL || err == ENOPROTOOPT || err == EOPNOTSUPP) {
+						gso = false;
+						break;
+					}
+
+					if (!would_block(err))
+						std::cout << "\nERROR: segmented send failed: " << err << std::endl;
+
+					return sent > 0 ? static_cast<int>(sent) : SOCKET_ERROR;
+				}
+
+				offset += chunk;
+				sent += (chunk + segment_size - 1) / segment_size;
+			}
+		#endif
+
+		// without GSO: a datagram per segment, DATAGRAM_BATCH of them per sendmmsg
+		while (offset < length) {
+			#ifdef WINDOWS_SOCKET_MMSG
+				mmsghdr headers[DATAGRAM_BATCH] = {};
+				iovec vectors[DATAGRAM_BATCH];
+				size_t count = 0;
+
+				for (size_t position = offset; count < DATAGRAM_BATCH && position < length; count++, position += segment_size) {
+					vectors[count].iov_base = const_cast<char*>(data + position);
+					vectors[count].iov_len = std::min(segment_size, length - position);
+
+					headers[count].msg_hdr.msg_name = const_cast<sockaddr*>(to);
+					headers[count].msg_hdr.msg_namelen = to ? to_length : 0;
+					headers[count].msg_hdr.msg_iov = &vectors[count];
+					headers[count].msg_hdr.msg_iovlen = 1;
+				}
+
+				const int r = sendmmsg(sock.get(), headers, static_cast<unsigned int>(count), SEND_FLAGS);
+			#else
+				const int r = sendto(sock.get(), data + offset, static_cast<int>(std::min(segment_size, length - offset)), SEND_FLAGS, to, to ? to_length : 0) == SOCKET_ERROR ? SOCKET_ERROR : 1;
+			#endif
+
+			if (r == SOCKET_ERROR) {
+				const int err = last_socket_error();
+
+				if (!would_block(err))
+					std::cout << "\nERROR: segmented send failed: " << err << std::endl;
+
+				return sent > 0 ? static_cast<int>(sent) : SOCKET_ERROR;
+			}
+
+			sent += static_cast<size_t>(r);
+			offset = std::min(length, offset + static_cast<size_t>(r) * segment_size);
+		}
+
+		return static_cast<int>(sent);
+	}
+
+	bool DatagramSocket::enable_gro() {
+		#if defined(WINDOWS_SOCKET_MMSG) && defined(UDP_GRO)
+			const int enable = 1;
+
+			if (setsockopt(sock.get(), IPPROTO_UDP, UDP_GRO, &enable, sizeof(enable)) == SOCKET_ERROR) {
+				std::cout << "\nERROR: UDP_GRO failed: " << last_socket_error() << std::endl;
+				return false;
+			}
+
+			gro = true;
+			return true;
+		#else
+			return false;
+		#endif
+	}
+
+	bool DatagramSocket::set_buffer_sizes(int receive, int send) {
+		if (receive > 0 && setsockopt(sock.get(), SOL_SOCKET, SO_RCVBUF, reinterpret_cast<const char*>(&receive), sizeof(receive)) == SOCKET_ERROR) {
+			std::cout << "\nERROR: SO_RCVBUF failed: " << last_socket_error() << std::endl;
+			return false;
+		}
+
+		if (send > 0 && setsockopt(sock.get(), SOL_SOCKET, SO_SNDBUF, reinterpret_cast<const char*>(&send), sizeof(send)) == SOCKET_ERROR) {
+			std::cout << "\nERROR: SO_SNDBUF failed: " << last_socket_error() << std::endl;
+			return false;
+		}
+
+		return true;
+	}
+
+	bool DatagramSocket::stop() {
+		// no connection to shut down, but a thread blocked in a receive wakes up (Linux)
+		shutdown(sock.get(), SD_BOTH);
+		return true;
+	}
+
+	bool DatagramSocket::disconnect() {
+		return sock.close();
+	}
+}
\ No newline at end of file
@@ -0,0 +1,117 @@
+#ifndef WINDOWS_SOCKET_DATAGRAM_HPP
+	#define WINDOWS_SOCKET_DATAGRAM_HPP
+
+	#include "socket.hpp"
+
+	#include <vector>
+
+	// UDP sockets for many small datagrams. A DatagramBatch holds preallocated slots for up to capacity()
+	// datagrams, send_batch / receive_batch move a whole batch with one sendmmsg / recvmmsg. With GSO the kernel
+	// cuts one buffer into equal datagrams (send_segmented), with GRO it hands over many datagrams of a flow as
+	// one (Datagram::segment_size). Without sendmmsg (Windows, BSD) the same calls loop over sendto / recvfrom.
+
+	namespace winLib {
+		constexpr size_t DATAGRAM_BATCH = 64;
+		// a slot for a datagram within an Ethernet MTU
+		constexpr size_t DATAGRAM_SLOT = 2048;
+		// a slot for the datagrams GRO merges (up to 64 KiB)
+		constexpr size_t GRO_SLOT = 65536;
+
+		struct Datagram {
+			char* data = nullptr;					// the slot of the batch
+			size_t size = 0;
+			sockaddr_storage address{};				// the sender of a received datagram, the receiver of a sent one
+			socklen_t address_length = 0;			// 0: the peer of a connected socket
+			size_t segment_size = 0;				// GRO: size holds datagrams of segment_size (the last one may be shorter)
+			bool truncated = false;					// longer than the slot, the rest is lost
+
+			// the datagrams that arrived as this one
+			size_t segments() const noexcept { return segment_size == 0 || size == 0 ? 1 : (size + segment_size - 1) / segment_size; }
+		};
+
+		class DatagramBatch {
+		public:
+			// capacity slots of slot_size bytes, allocated once
+			explicit DatagramBatch(size_t capacity = DATAGRAM_BATCH, size_t slot_size = DATAGRAM_SLOT);
+
+			DatagramBatch(const DatagramBatch&) = delete;
+			DatagramBatch& operator=(const DatagramBatch&) = delete;
+
+			size_t capacity() const noexcept { return datagrams.size(); }
+			size_t slot_size() const noexcept { return slot; }
+			// the datagrams added or received
+			size_t size() const noexcept { return count; }
+			bool empty() const noexcept { return count == 0; }
+			bool full() const noexcept { return count == datagrams.size(); }
+
+			Datagram& operator[](size_t i) noexcept { return datagrams[i]; }
+			const Datagram& operator[](size_t i) const noexcept { return datagrams[i]; }
+
+			// copies data into the next slot for send_batch, to is nullptr on a connected socket
+			// false if the batch is full or data is longer than a slot
+			bool add(const char* data, size_t length, const sockaddr* to = nullptr, socklen_t to_length = 0) noexcept;
+			void clear() noexcept { count = 0; }
+
+		private:
+			friend class DatagramSocket;
+
+			std::vector<char> memory;
+			std::vector<Datagram> datagrams;
+			size_t slot;
+			size_t count;
+
+			#ifdef WINDOWS_SOCKET_MMSG
+				// the headers of sendmmsg / recvmmsg, they point into the slots
+				std::vector<mmsghdr> headers;
+				std::vector<iovec> vectors;
+				std::vector<char> controls;			// a cmsg for the GRO segment size per datagram
+			#endif
+		};
+
+		class DatagramSocket : public Socket {
+		public:
+			// nullptr: a socket that is bound to port and receives, otherwise connect_socket() sets the peer
+			PCSTR host_name;
+			// UDP_SEGMENT is tried by send_segmented, off once the kernel refused it (no checksum offload)
+			bool gso = true;
+			// set by enable_gro()
+			bool gro = false;
+			// a receiver binds to :: and gets IPv4 datagrams as well, like ServerSocket
+			bool dual_stack = true;
+
+			DatagramSocket(PCSTR host_name = nullptr, PCSTR port = DEFAULT_PORT);
+
+			// resolves host_name:port (or the local port) and creates the socket
+			int create_socket() override;
+			bool bind_socket();
+			// the default peer of send_data / send_batch and the only sender receive_data takes
+			int connect_socket();
+
+			// one datagram: bytes or SOCKET_ERROR
+			int send_data(char* data, int length) override;
+			int receive_data(char* buffer, int length = DEFAULT_BUFLEN) override;
+			int send_to(const char* data, size_t length, const sockaddr* to, socklen_t to_length);
+			int receive_from(char* buffer, size_t length, sockaddr_storage* from, socklen_t* from_length);
+
+			// Sends the datagrams of batch, with one sendmmsg per 1024 (UIO_MAXIOV). The number sent, fewer if a
+			// non-blocking socket is full, SOCKET_ERROR if none was sent.
+			int send_batch(DatagramBatch& batch);
+			// Fills batch with the datagrams that are waiting, blocks (a blocking socket) for the first one only.
+			// The number received or SOCKET_ERROR (would_block(last_socket_error()) on a non-blocking socket).
+			int receive_batch(DatagramBatch& batch);
+
+			// Sends data as datagrams of segment_size (the last one may be shorter): with GSO one sendmsg per
+			// 64 datagrams, the kernel (or the NIC) cuts them. The number of datagrams sent or SOCKET_ERROR.
+			int send_segmented(const char* data, size_t length, size_t segment_size, const sockaddr* to = nullptr, socklen_t to_length = 0);
+
+			// UDP_GRO: receive_batch may return many datagrams in one, the batch needs slots of GRO_SLOT bytes.
+			// false if the kernel doesn't support it.
+			bool enable_gro();
+			// SO_RCVBUF / SO_SNDBUF, a burst of datagrams is dropped if the receive buffer is full (0: unchanged)
+			bool set_buffer_sizes(int receive, int send);
+
+			bool stop() override;
+			bool disconnect() override;
+		};
+	}
+#endif
\ No newline at end of file
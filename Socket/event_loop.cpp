@@ -0,0 +1,265 @@
+#include "event_loop.hpp"
+
+#ifdef WINDOWS_SOCKET_EPOLL
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+
+#include <system_error>
+
+namespace winLib {
+	// events of one epoll_wait call
+	constexpr int EVENT_BATCH = 256;
+
+	static unsigned int to_epoll(unsigned int events) noexcept {
+		unsigned int result = EPOLLET | EPOLLRDHUP;
+
+		if (events & IO_READ)  result |= EPOLLIN;
+		if (events & IO_WRITE) result |= EPOLLOUT;
+
+		return result;
+	}
+
+	static unsigned int from_epoll(unsigned int events) noexcept {
+		unsigned int result = 0;
+
+		if (events & (EPOLLIN | EPOLLRDHUP)) result |= IO_READ;
+		if (events & EPOLLOUT)               result |= IO_WRITE;
+		if (events & EPOLLERR)               result |= IO_ERROR;
+		if (events & (EPOLLHUP | EPOLLRDHUP)) result |= IO_HANGUP;
+
+		return result;
+	}
+
+	// the descriptor in the low and the generation in the high 32 bits
+	static unsigned long long watch_key(SOCKET sock, unsigned int generation) noexcept {
+		return static_cast<unsigned long long>(generation) << 32 | static_cast<unsigned int>(sock);
+	}
+
+	EventLoop::EventLoop() : stop_requested(false), is_running(false), generation(0), next_timer(1), has_posted(false) {
+		epoll_handle = epoll_create1(EPOLL_CLOEXEC);
+
+		if (epoll_handle == -1) {
+			const int err = last_socket_error();
+			std::cout << "\nERROR: epoll_create1 failed: " << err << std::endl;
+			throw std::system_error(err, std::system_category());
+		}
+
+		wake_handle.reset(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC));
+
+		// drains the counter, the wake up itself was the point
+		if (!wake_handle || !add(wake_handle.get(), IO_READ, [this](unsigned int) {
+			unsigned long long count;
+			while (read(wake_handle.get(), &count, sizeof(count)) > 0) {}
+		})) {
+			const int err = last_socket_error();
+			std::cout << "\nERROR: eventfd failed: " << err << std::endl;
+			close(epoll_handle);
+			throw std::system_error(err, std::system_category());
+		}
+	}
+
+	EventLoop::~EventLoop() {
+		close(epoll_handle);
+	}
+
+	bool EventLoop::add(SOCKET sock, unsigned int events, IoCallback callback) {
+		if (sock < 0 || watching(sock))
+			return false;
+
+		if (static_cast<size_t>(sock) >= watches.size())
+			watches.resize(static_cast<size_t>(sock) + 1);
+
+		auto watch = std::make_unique<Watch>(Watch{ std::move(callback), events, ++generation });
+
+		epoll_event event{};
+		event.events = to_epoll(events);
+		event.data.u64 = watch_key(sock, watch->generation);
+
+		if (epoll_ctl(epoll_handle, EPOLL_CTL_ADD, sock, &event) == -1) {
+			std::cout << "\nERROR: epoll_ctl(add) failed: " << last_socket_error() << std::endl;
+			return false;
+		}
+
+		watches[sock] = std::move(watch);
+
+		return true;
+	}
+
+	bool EventLoop::modify(SOCKET sock, unsigned int events) noexcept {
+		if (!watching(sock))
+			return false;
+
+		Watch& watch = *watches[sock];
+
+		epoll_event event{};
+		event.events = to_epoll(events);
+		event.data.u64 = watch_key(sock, watch.generation);
+
+		if (epoll_ctl(epoll_handle, EPOLL_CTL_MOD, sock, &event) == -1)
+			return false;
+
+		watch.events = events;
+
+		return true;
+	}
+
+	bool EventLoop::remove(SOCKET sock) noexcept {
+		if (!watching(sock))
+			return false;
+
+		// fails if the socket is already closed, it left the epoll set with it in that case
+		epoll_ctl(epoll_handle, EPOLL_CTL_DEL, sock, nullptr);
+
+		retired.push_back(std::move(watches[sock]));
+
+		return true;
+	}
+
+	bool EventLoop::watching(SOCKET sock) const noexcept {
+		return sock >= 0 && static_cast<size_t>(sock) < watches.size() && watches[sock];
+	}
+
+	EventLoop::TimerId EventLoop::add_timer(std::chrono::milliseconds delay, TimerCallback callback, std::chrono::milliseconds interval) {
+		const TimerId id = next_timer++;
+
+		timers.emplace(id, Timer{ std::move(callback), interval });
+		timer_queue.push({ Clock::now() + delay, id });
+
+		return id;
+	}
+
+	bool EventLoop::cancel_timer(TimerId id) noexcept {
+		// the queue entry is skipped when it's due
+		return timers.erase(id) != 0;
+	}
+
+	int EventLoop::timeout_until_timer(int timeout_ms) const noexcept {
+		if (timer_queue.empty())
+			return timeout_ms;
+
+		const auto left = std::chrono::ceil<std::chrono::milliseconds>(timer_queue.top().deadline - Clock::now()).count();
+		const int until_timer = left > 0 ? static_cast<int>(std::min<long long>(left, 0x7FFFFFFF)) : 0;
+
+		return timeout_ms < 0 ? until_timer : std::min(timeout_ms, until_timer);
+	}
+
+	int EventLoop::run_timers() {
+		const Clock::time_point time = Clock::now();
+		int called = 0;
+
+		while (!timer_queue.empty() && timer_queue.top().deadline <= time) {
+			const TimerEntry entry = timer_queue.top();
+			timer_queue.pop();
+
+			auto timer = timers.find(entry.id);
+
+			// cancelled
+			if (timer == timers.end())
+				continue;
+
+			if (timer->second.interval.count() > 0) {
+				timer_queue.push({ entry.deadline + timer->second.interval, entry.id });
+				// the callback may cancel itself, so it runs from a copy
+				const TimerCallback callback = timer->second.callback;
+				callback();
+			} else {
+				const TimerCallback callback = std::move(timer->second.callback);
+				timers.erase(timer);
+				callback();
+			}
+
+			called++;
+		}
+
+		return called;
+	}
+
+	int EventLoop::run_once(int timeout_ms) {
+		epoll_event events[EVENT_BATCH];
+
+		const int count = epoll_wait(epoll_handle, events, EVENT_BATCH, timeout_until_timer(timeout_ms));
+
+		if (count == -1) {
+			if (errno == EINTR)
+				return 0;
+
+			std::cout << "\nERROR: epoll_wait failed: " << last_socket_error() << std::endl;
+			return -1;
+		}
+
+		int called = 0;
+
+		for (int i = 0; i < count; i++) {
+			const SOCKET sock = static_cast<SOCKET>(events[i].data.u64 & 0xFFFFFFFF);
+			const unsigned int watch_generation = static_cast<unsigned int>(events[i].data.u64 >> 32);
+
+			// removed (and maybe added again) by an earlier callback of this batch
+			if (!watching(sock) || watches[sock]->generation != watch_generation)
+				continue;
+
+			watches[sock]->callback(from_epoll(events[i].events));
+			called++;
+		}
+
+		retired.clear();
+
+		return called + run_posted() + run_timers();
+	}
+
+	void EventLoop::run() {
+		is_running = true;
+
+		while (!stop_requested.exchange(false)) {
+			if (run_once() == -1)
+				break;
+		}
+
+		is_running = false;
+	}
+
+	void EventLoop::stop() noexcept {
+		stop_requested = true;
+		wake();
+	}
+
+	void EventLoop::post(Task task) {
+		bool was_empty;
+
+		{
+			std::lock_guard<std::mutex> lock(post_mutex);
+			was_empty = posted.empty();
+			posted.push_back(std::move(task));
+		}
+
+		has_posted = true;
+
+		if (was_empty)
+			wake();
+	}
+
+	int EventLoop::run_posted() {
+		if (!has_posted.exchange(false))
+			return 0;
+
+		std::vector<Task> tasks;
+
+		{
+			std::lock_guard<std::mutex> lock(post_mutex);
+			tasks.swap(posted);
+		}
+
+		for (Task& task : tasks)
+			task();
+
+		return static_cast<int>(tasks.size());
+	}
+
+	void EventLoop::wake() noexcept {
+		const unsigned long long one = 1;
+
+		if (write(wake_handle.get(), &one, sizeof(one)) == -1) {
+			// the counter is full: the loop is going to wake up anyway
+		}
+	}
+}
+#endif
\ No newline at end of file
@@ -0,0 +1,118 @@
+#ifndef WINDOWS_SOCKET_EVENT_LOOP_HPP
+	#define WINDOWS_SOCKET_EVENT_LOOP_HPP
+
+	#include "util.hpp"
+	#include "platform.hpp"
+
+	#ifdef WINDOWS_SOCKET_EPOLL
+		#include <atomic>
+		#include <chrono>
+		#include <functional>
+		#include <memory>
+		#include <mutex>
+		#include <queue>
+		#include <unordered_map>
+		#include <vector>
+
+		// Single threaded reactor on an edge triggered epoll instance: sockets are watched for readiness and the
+		// callbacks run on the thread that calls run(). A callback has to read / write until would_block(...),
+		// otherwise it won't be called again. Timers run on the same thread.
+
+		namespace winLib {
+			// readiness flags of the callbacks
+			enum IoEvent : unsigned int {
+				IO_READ   = 1,
+				IO_WRITE  = 2,
+				IO_ERROR  = 4,
+				IO_HANGUP = 8
+			};
+
+			class EventLoop {
+			public:
+				using IoCallback    = std::function<void(unsigned int events)>;
+				using TimerCallback = std::function<void()>;
+				using TimerId       = unsigned long long;
+				using Task          = std::function<void()>;
+				using Clock         = std::chrono::steady_clock;
+
+				// throws std::system_error if the epoll instance can't be created
+				EventLoop();
+				~EventLoop();
+
+				EventLoop(const EventLoop&) = delete;
+				EventLoop& operator=(const EventLoop&) = delete;
+
+				// events: IO_READ | IO_WRITE, false on error (the socket is not watched)
+				bool add(SOCKET sock, unsigned int events, IoCallback callback);
+				bool modify(SOCKET sock, unsigned int events) noexcept;
+				// safe inside of the socket's own callback
+				bool remove(SOCKET sock) noexcept;
+				bool watching(SOCKET sock) const noexcept;
+
+				// calls callback after delay (and every interval afterwards, if it isn't 0)
+				TimerId add_timer(std::chrono::milliseconds delay, TimerCallback callback, std::chrono::milliseconds interval = std::chrono::milliseconds(0));
+				// false if the timer already ran (and doesn't repeat) or was cancelled
+				bool cancel_timer(TimerId id) noexcept;
+
+				// waits for events up to timeout_ms (-1: until an event or timer), returns the number of callbacks called or -1
+				int run_once(int timeout_ms = -1);
+				// until stop()
+				void run();
+				// thread safe, run() returns after the current iteration (at once if it's called before run())
+				void stop() noexcept;
+				bool running() const noexcept { return is_running; }
+
+				// wakes up a run_once() waiting in another thread
+				void wake() noexcept;
+
+				// Thread safe: runs task on the thread of the loop (in the order of the posts), for work that belongs
+				// to a connection of this loop. Wakes the loop up only if nothing was queued before.
+				void post(Task task);
+
+				Clock::time_point now() const noexcept { return Clock::now(); }
+
+			private:
+				struct Watch {
+					IoCallback callback;
+					unsigned int events;
+					unsigned int generation;
+				};
+
+				struct Timer {
+					TimerCallback callback;
+					std::chrono::milliseconds interval;
+				};
+
+				struct TimerEntry {
+					Clock::time_point deadline;
+					TimerId id;
+
+					// min heap
+					bool operator<(const TimerEntry& other) const noexcept { return deadline > other.deadline; }
+				};
+
+				int epoll_handle;
+				SocketHandle wake_handle;	// eventfd of wake()
+				std::atomic<bool> stop_requested, is_running;
+
+				// indexed by the file descriptor, the generation tells apart a reused descriptor inside of one batch
+				std::vector<std::unique_ptr<Watch>> watches;
+				// removed during the dispatch, freed after the batch (a callback may remove its own watch)
+				std::vector<std::unique_ptr<Watch>> retired;
+				unsigned int generation;
+
+				std::priority_queue<TimerEntry> timer_queue;
+				std::unordered_map<TimerId, Timer> timers;
+				TimerId next_timer;
+
+				std::mutex post_mutex;
+				std::vector<Task> posted;
+				std::atomic<bool> has_posted;
+
+				int timeout_until_timer(int timeout_ms) const noexcept;
+				int run_timers();
+				int run_posted();
+			};
+		}
+	#endif
+#endif
\ No newline at end of file
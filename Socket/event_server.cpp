@@ -0,0 +1,326 @@
+#include "event_server.hpp"
+
+#include <fcntl.h>
+
+#ifdef WINDOWS_SOCKET_EPOLL
+namespace winLib {
+	// bytes of one recv call
+	constexpr size_t READ_CHUNK = 16384;
+	// accept is tried again after this if the descriptors ran out and no reserve was left
+	constexpr std::chrono::milliseconds ACCEPT_RETRY{ 100 };
+
+	// EPOLLERR comes with a pending error and with entries on the error queue (MSG_ZEROCOPY notifications,
+	// IP_RECVERR), only the first one ends the connection
+	static bool socket_failed(SOCKET sock) noexcept {
+		int error = 0;
+		socklen_t size = sizeof(error);
+
+		if (getsockopt(sock, SOL_SOCKET, SO_ERROR, &error, &size) == SOCKET_ERROR)
+			return true;
+
+		return error != 0;
+	}
+
+	// false if the connection failed or was closed by the peer
+	// reads until would_block: a short read doesn't mean the buffer is empty, the FIN of a peer that sends and
+	// closes comes with the same edge and is only seen by the next recv
+	static bool read_available(Connection& connection) {
+		for (;;) {
+			char* buffer = connection.input.prepare(READ_CHUNK);
+
+			const ssize_t bytes_recv = recv(connection.sock.get(), buffer, READ_CHUNK, 0);
+
+			connection.input.commit(bytes_recv > 0 ? static_cast<size_t>(bytes_recv) : 0);
+
+			if (bytes_recv > 0)
+				continue;
+
+			// closed by the peer
+			if (bytes_recv == 0)
+				return false;
+
+			const int err = last_socket_error();
+
+			if (would_block(err))
+				return true;
+
+			if (err != EINTR)
+				return false;
+		}
+	}
+
+	// a descriptor kept free for accept_clients: without any the listener can't take the connections out of the backlog
+	static SocketHandle open_reserve() noexcept {
+		return SocketHandle(open("/dev/null", O_RDONLY | O_CLOEXEC));
+	}
+
+	// holds back partial segments until the cork is removed (Linux, TCP_NOPUSH on BSD is not the same)
+	static void set_cork(SOCKET sock, bool enable) noexcept {
+		#ifdef TCP_CORK
+			const int value = enable ? 1 : 0;
+			setsockopt(sock, IPPROTO_TCP, TCP_CORK, &value, sizeof(value));
+		#endif
+	}
+
+	static bool write_pending(Connection& connection) {
+		size_t sent = 0;
+
+		while (sent < connection.output.size()) {
+			const ssize_t bytes_sent = send(connection.sock.get(), connection.output.data() + sent, connection.output.size() - sent, SEND_FLAGS);
+
+			if (bytes_sent > 0) {
+				sent += static_cast<size_t>(bytes_sent);
+				continue;
+			}
+
+			const int err = last_socket_error();
+
+			if (would_block(err))
+				break;
+
+			if (err != EINTR)
+				return false;
+		}
+
+		connection.output.erase(connection.output.begin(), connection.output.begin() + static_cast<std::ptrdiff_t>(sent));
+
+		return true;
+	}
+
+	EventServer::EventServer(EventLoop& loop, ConnectionHandlers handlers, PCSTR port) : ConnectionServer(std::move(handlers), port) {
+		this->event_loop = &loop;
+		this->flush_timer = 0;
+		this->accept_timer = 0;
+	}
+
+	EventServer::~EventServer() {
+		stop();
+	}
+
+	int EventServer::start() {
+		if (const int r = open_listener())
+			return r;
+
+		reserve = open_reserve();
+
+		if (!event_loop->add(listener.sock.get(), IO_READ, [this](unsigned int) { accept_clients(); })) {
+			listener.sock.close();
+			return -1;
+		}
+
+		return 0;
+	}
+
+	void EventServer::stop() noexcept {
+		if (listener.sock) {
+			event_loop->remove(listener.sock.get());
+			listener.sock.close();
+		}
+
+		if (flush_timer) {
+			event_loop->cancel_timer(flush_timer);
+			flush_timer = 0;
+		}
+
+		if (accept_timer) {
+			event_loop->cancel_timer(accept_timer);
+			accept_timer = 0;
+		}
+
+		reserve.close();
+		flush_list.clear();
+
+		// none is freed here: stop() may run inside of a handler ("shutdown" command) that still holds its
+		// connection, they go with the next event or the destructor
+		for (auto& connection : connection_table) {
+			if (connection)
+				close_connection(connection.get());
+		}
+	}
+
+	bool EventServer::send_connection(Connection& connection, const char* data, size_t length) {
+		// a queue that wasn't empty is either in the flush list already or waits for the socket to be writable
+		const bool was_empty = connection.output.empty();
+
+		if (!queue_output(connection, data, length))
+			return false;
+
+		if (connection.output.size() >= send_options.flush_threshold)
+			return flush(connection);
+
+		if (!was_empty)
+			return true;
+
+		flush_list.push_back(connection.sock.get());
+
+		// one flush for all connections of the iteration: a timer without delay runs after all callbacks
+		if (!flush_timer)
+			flush_timer = event_loop->add_timer(send_options.coalesce_window, [this] { flush_all(); });
+
+		return true;
+	}
+
+	bool EventServer::flush(Connection& connection) {
+		const SOCKET fd = connection.sock.get();
+
+		if (send_options.cork)
+			set_cork(fd, true);
+
+		const bool alive = write_pending(connection);
+
+		// sends the last partial segment
+		if (send_options.cork && alive)
+			set_cork(fd, false);
+
+		if (!alive) {
+			connection.close();
+			return false;
+		}
+
+		output_sent(connection);
+
+		return true;
+	}
+
+	void EventServer::flush_all() {
+		flush_timer = 0;
+		flushing.swap(flush_list);
+
+		for (const SOCKET fd : flushing) {
+			if (static_cast<size_t>(fd) >= connection_table.size() || !connection_table[fd])
+				continue;
+
+			Connection& connection = *connection_table[fd];
+
+			if (!close_requested(connection) && !connection.output.empty())
+				flush(connection);
+		}
+
+		flushing.clear();
+	}
+
+	void EventServer::accept_clients() {
+		closed.clear();
+
+		for (;;) {
+			SocketHandle client(accept4(listener.sock.get(), nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC));
+
+			if (!client) {
+				const int err = last_socket_error();
+
+				if (would_block(err))
+					return;
+
+				// the client gave up while it was waiting in the backlog
+				if (err == EINTR || err == ECONNABORTED)
+					continue;
+
+				if ((err == EMFILE || err == ENFILE) && reserve) {
+					// out of descriptors: the reserve makes room to take the oldest client out of the backlog and
+					// close it, otherwise the edge is gone and the backlog waits for the next connection
+					reserve.close();
+					SocketHandle rejected(accept4(listener.sock.get(), nullptr, nullptr, SOCK_CLOEXEC));
+					const int rejected_err = rejected ? 0 : last_socket_error();
+
+					rejected.close();
+					reserve = open_reserve();
+
+					if (rejected_err == 0)
+						continue;
+
+					// the backlog is empty (accept reports EMFILE before it looks at the backlog)
+					if (would_block(rejected_err))
+						return;
+				}
+
+				std::cout << "\nERROR: accept failed: " << err << std::endl;
+
+				// no reserve either: tries again later, the edge of the listener won't come back by itself
+				if (!accept_timer)
+					accept_timer = event_loop->add_timer(ACCEPT_RETRY, [this] { accept_timer = 0; accept_clients(); });
+
+				return;
+			}
+
+			const SOCKET fd = client.get();
+
+			if (static_cast<size_t>(fd) >= connection_table.size())
+				connection_table.resize(static_cast<size_t>(fd) + 1);
+
+			apply_send_options(fd);
+
+			connection_table[fd] = std::make_unique<Connection>(this, std::move(client));
+			Connection* connection = connection_table[fd].get();
+
+			if (!event_loop->add(fd, IO_READ | IO_WRITE, [this, connection](unsigned int events) { connection_event(connection, events); })) {
+				connection_table[fd].reset();
+				continue;
+			}
+
+			connection_count.fetch_add(1, std::memory_order_relaxed);
+
+			dispatch(handlers.on_open, connection);
+
+			if (close_requested(*connection))
+				close_connection(connection);
+
+			// on_open stopped the server
+			if (!listener.sock)
+				return;
+		}
+	}
+
+	void EventServer::connection_event(Connection* connection, unsigned int events) {
+		closed.clear();
+
+		bool alive = !(events & IO_ERROR) || !socket_failed(connection->sock.get());
+
+		if (alive && (events & IO_WRITE) && !connection->output.empty()) {
+			alive = write_pending(*connection);
+
+			if (alive) {
+				output_sent(*connection);
+
+				if (connection->output.empty())
+					dispatch(handlers.on_writable, connection);
+			}
+		}
+
+		// a hang up without IO_READ (EPOLLHUP) is read as well, recv returns the bytes in front of it and then 0
+		if (alive && (events & (IO_READ | IO_HANGUP)) && !close_requested(*connection)) {
+			const size_t size = connection->input.size();
+
+			// the bytes in front of a hang up are still handled
+			alive = read_available(*connection);
+
+			if (connection->input.size() > size)
+				dispatch(handlers.on_data, connection);
+		}
+
+		if (!alive || close_requested(*connection))
+			close_connection(connection);
+	}
+
+	void EventServer::close_connection(Connection* connection) noexcept {
+		if (!connection->sock)
+			return;
+
+		request_close(*connection);
+
+		// its handler is running, the caller of the handler closes it when it returns (like Connection::close)
+		if (connection == dispatching)
+			return;
+
+		const SOCKET fd = connection->sock.get();
+
+		event_loop->remove(fd);
+
+		if (handlers.on_close)
+			handlers.on_close(*connection);
+
+		connection->sock.close();
+		closed.push_back(std::move(connection_table[fd]));
+		connection_count.fetch_sub(1, std::memory_order_relaxed);
+	}
+}
+#endif
\ No newline at end of file
@@ -0,0 +1,55 @@
+#ifndef WINDOWS_SOCKET_EVENT_SERVER_HPP
+	#define WINDOWS_SOCKET_EVENT_SERVER_HPP
+
+	#include "event_loop.hpp"
+	#include "connection.hpp"
+
+	#ifdef WINDOWS_SOCKET_EPOLL
+		// Non-blocking server on an EventLoop: one thread serves all connections.
+		// Every connection is watched for read and write readiness, the handlers get the received bytes.
+		// The sends of a connection are queued and written with one send at the end of the loop iteration (or
+		// after the coalesce_window), what doesn't fit into the socket buffer waits until it is writable again.
+
+		namespace winLib {
+			class EventServer : public ConnectionServer {
+			public:
+				EventServer(EventLoop& loop, ConnectionHandlers handlers, PCSTR port = DEFAULT_PORT);
+				~EventServer() override;
+
+				// creates the non-blocking listening socket and watches it, 0 or the error code
+				int start() override;
+				// closes the listening socket and all connections
+				void stop() noexcept override;
+
+				EventLoop& loop() const noexcept { return *event_loop; }
+
+			protected:
+				// queues, sends at once only past the flush_threshold
+				bool send_connection(Connection& connection, const char* data, size_t length) override;
+				void close_connection(Connection* connection) noexcept override;
+
+			private:
+				EventLoop* event_loop;
+
+				// indexed by the file descriptor
+				std::vector<std::unique_ptr<Connection>> connection_table;
+				// closed, freed with the next event (a handler may still hold a reference)
+				std::vector<std::unique_ptr<Connection>> closed;
+
+				// connections whose queue got data since the last flush, by descriptor (a closed one is skipped)
+				std::vector<SOCKET> flush_list, flushing;
+				EventLoop::TimerId flush_timer;
+
+				// an open descriptor given up when accept runs out of them (EMFILE), see accept_clients()
+				SocketHandle reserve;
+				EventLoop::TimerId accept_timer;
+
+				void accept_clients();
+				void connection_event(Connection* connection, unsigned int events);
+				// writes the queue of connection, closes it on error (false)
+				bool flush(Connection& connection);
+				void flush_all();
+			};
+		}
+	#endif
+#endif
\ No newline at end of file
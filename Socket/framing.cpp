@@ -0,0 +1,211 @@
+#include "framing.hpp"
+#include "platform.hpp"
+
+#include <algorithm>
+#include <iostream>
+#include <utility>
+
+namespace winLib {
+	// smaller payload chains are copied behind their prefix, a shared slice costs more than the copy
+	constexpr size_t SHARE_THRESHOLD = 1024;
+	// bytes of one flush, the count is returned as an int
+	constexpr size_t MAX_FLUSH = 1 << 30;
+
+	size_t encode_prefix(FramePrefix prefix, size_t length, char* out) noexcept {
+		if (prefix == PREFIX_FIXED32) {
+			if (length > 0xFFFFFFFF)
+				return 0;
+
+			out[0] = static_cast<char>(length >> 24);
+			out[1] = static_cast<char>(length >> 16);
+			out[2] = static_cast<char>(length >> 8);
+			out[3] = static_cast<char>(length);
+			return 4;
+		}
+
+		size_t size = 0;
+
+		while (length >= 0x80) {
+			out[size++] = static_cast<char>(length | 0x80);
+			length >>= 7;
+		}
+
+		out[size++] = static_cast<char>(length);
+
+		return size;
+	}
+
+	int decode_prefix(FramePrefix prefix, const char* data, size_t size, size_t& length) noexcept {
+		const unsigned char* bytes = reinterpret_cast<const unsigned char*>(data);
+
+		if (prefix == PREFIX_FIXED32) {
+			if (size < 4)
+				return 0;
+
+			length = static_cast<size_t>(bytes[0]) << 24 | static_cast<size_t>(bytes[1]) << 16 | static_cast<size_t>(bytes[2]) << 8 | bytes[3];
+			return 4;
+		}
+
+		unsigned long long value = 0;
+
+		for (size_t i = 0; i < size && i < MAX_PREFIX_SIZE; i++) {
+			// the 10th byte holds the last bit of 64
+			if (i == MAX_PREFIX_SIZE - 1 && bytes[i] > 1)
+				return SOCKET_ERROR;
+
+			value |= static_cast<unsigned long long>(bytes[i] & 0x7F) << (7 * i);
+
+			if (!(bytes[i] & 0x80)) {
+				length = static_cast<size_t>(value);
+				return static_cast<int>(i + 1);
+			}
+		}
+
+		return size >= MAX_PREFIX_SIZE ? SOCKET_ERROR : 0;
+	}
+
+	FrameWriter::FrameWriter(FramePrefix prefix) {
+		this->prefix = prefix;
+	}
+
+	bool FrameWriter::write(const char* data, size_t length) {
+		char header[MAX_PREFIX_SIZE];
+		const size_t header_size = encode_prefix(prefix, length, header);
+
+		if (header_size == 0) {
+			std::cout << "\nERROR: frame of " << length << " bytes is too long for the prefix" << std::endl;
+			return false;
+		}
+
+		// both go into the free end of the last slab, many small frames fill one slab
+		pending.append(header, header_size);
+		pending.append(data, length);
+
+		return true;
+	}
+
+	bool FrameWriter::write(const BufferChain& payload) {
+		char header[MAX_PREFIX_SIZE];
+		const size_t header_size = encode_prefix(prefix, payload.size(), header);
+
+		if (header_size == 0) {
+			std::cout << "\nERROR: frame of " << payload.size() << " bytes is too long for the prefix" << std::endl;
+			return false;
+		}
+
+		pending.append(header, header_size);
+
+		if (payload.size() >= SHARE_THRESHOLD) {
+			pending.append(payload);
+			return true;
+		}
+
+		for (size_t i = 0; i < payload.slices(); i++)
+			pending.append(payload.slice_at(i).data(), payload.slice_at(i).size());
+
+		return true;
+	}
+
+	int FrameWriter::flush(SOCKET sock) {
+		size_t sent = 0;
+
+		while (!pending.empty() && sent < MAX_FLUSH) {
+			const int r = send_chain(sock, pending);
+
+			if (r == SOCKET_ERROR) {
+				// the rest waits for the socket to be writable again
+				if (sent > 0 && would_block(last_socket_error()))
+					break;
+
+				return SOCKET_ERROR;
+			}
+
+			sent += static_cast<size_t>(r);
+		}
+
+		return static_cast<int>(sent);
+	}
+
+	FrameReader::FrameReader(FramePrefix prefix, size_t max_frame, size_t capacity) : buffer(capacity) {
+		this->prefix = prefix;
+		this->max_frame = max_frame;
+		this->max_buffer = 2 * (max_frame + MAX_PREFIX_SIZE);
+		this->taken = 0;
+		this->needed = 0;
+		this->invalid = false;
+	}
+
+	int FrameReader::receive(SOCKET sock) {
+		buffer.consume(std::exchange(taken, 0));
+
+		// a frame that doesn't fit, or the buffer is full of frames nobody took yet
+		size_t capacity = 0;
+
+		if (needed > buffer.capacity())
+			capacity = needed;
+		else if (buffer.room() == 0) {
+			if (buffer.capacity() >= max_buffer) {
+				std::cout << "\nERROR: frame buffer limit of " << max_buffer << " bytes reached" << std::endl;
+				return SOCKET_ERROR;
+			}
+
+			capacity = std::min(2 * buffer.capacity(), max_buffer);
+		}
+
+		if (capacity > 0 && !buffer.reserve(capacity)) {
+			std::cout << "\nERROR: frame buffer of " << capacity << " bytes failed" << std::endl;
+			return SOCKET_ERROR;
+		}
+
+		return buffer.receive(sock);
+	}
+
+	bool FrameReader::next(std::string_view& frame) {
+		buffer.consume(std::exchange(taken, 0));
+
+		if (invalid)
+			return false;
+
+		size_t length = 0;
+		const int prefix_size = decode_prefix(prefix, buffer.data(), buffer.size(), length);
+
+		if (prefix_size == SOCKET_ERROR || (prefix_size > 0 && length > max_frame)) {
+			std::cout << "\nERROR: invalid frame prefix" << std::endl;
+			invalid = true;
+			return false;
+		}
+
+		if (prefix_size == 0) {
+			needed = 0;
+			return false;
+		}
+
+		const size_t size = static_cast<size_t>(prefix_size) + length;
+
+		if (buffer.size() < size) {
+			needed = size;
+			return false;
+		}
+
+		frame = std::string_view(buffer.data() + prefix_size, length);
+		taken = size;
+		needed = 0;
+
+		return true;
+	}
+
+	int FrameReader::read(SOCKET sock, std::string_view& frame) {
+		for (;;) {
+			if (next(frame))
+				return 1;
+
+			if (invalid)
+				return SOCKET_ERROR;
+
+			const int r = receive(sock);
+
+			if (r <= 0)
+				return r;
+		}
+	}
+}
\ No newline at end of file
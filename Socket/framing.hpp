@@ -0,0 +1,84 @@
+#ifndef WINDOWS_SOCKET_FRAMING_HPP
+	#define WINDOWS_SOCKET_FRAMING_HPP
+
+	#include "buffer.hpp"
+	#include "ring_buffer.hpp"
+
+	#include <string_view>
+
+	// Length prefixed messages over a stream socket. A frame is the length of the payload (a varint or 4 bytes
+	// big endian) followed by the payload.
+	//  - FrameWriter encodes any number of frames into one BufferChain, flush() sends all of them with as few
+	//    sendmsg calls as the kernel allows (the payload chains are shared, not copied)
+	//  - FrameReader receives into a RingBuffer and returns the frames as views into it, a frame split over many
+	//    receives is parsed when its last byte arrived
+
+	namespace winLib {
+		enum FramePrefix {
+			PREFIX_VARINT,		// 7 bits per byte, little endian, the high bit marks a following byte
+			PREFIX_FIXED32		// 4 bytes, big endian
+		};
+
+		constexpr size_t MAX_FRAME_SIZE = 16 * 1024 * 1024;
+		constexpr size_t MAX_PREFIX_SIZE = 10;
+
+		// writes the prefix for length into out (MAX_PREFIX_SIZE bytes), returns its size
+		// 0 if the prefix can't hold length (PREFIX_FIXED32 and 4 GiB or more)
+		size_t encode_prefix(FramePrefix prefix, size_t length, char* out) noexcept;
+		// Reads a prefix from data: its size and the payload length in length, 0 if more bytes are needed,
+		// SOCKET_ERROR if it is invalid (or longer than MAX_PREFIX_SIZE).
+		int decode_prefix(FramePrefix prefix, const char* data, size_t size, size_t& length) noexcept;
+
+		class FrameWriter {
+		public:
+			BufferChain pending;	// encoded, not sent yet
+			FramePrefix prefix;
+
+			FrameWriter(FramePrefix prefix = PREFIX_VARINT);
+
+			// copies data behind the prefix, false (nothing written) if the prefix can't hold the length
+			bool write(const char* data, size_t length);
+			bool write(std::string_view data) { return write(data.data(), data.size()); }
+			// shares the slices of payload
+			bool write(const BufferChain& payload);
+
+			// Sends the pending frames. A blocking socket returns when all are sent, a non-blocking one when the
+			// kernel takes no more (would_block(last_socket_error())). Bytes sent or SOCKET_ERROR.
+			// One call sends up to 1 GiB, pending isn't empty then.
+			int flush(SOCKET sock);
+		};
+
+		class FrameReader {
+		public:
+			RingBuffer buffer;
+			FramePrefix prefix;
+			size_t max_frame;
+			// the buffer doesn't grow past this when it is full of frames nobody took with next()
+			// (a frame of max_frame always fits), default: two frames of max_frame
+			size_t max_buffer;
+
+			// throws std::system_error like RingBuffer
+			FrameReader(FramePrefix prefix = PREFIX_VARINT, size_t max_frame = MAX_FRAME_SIZE, size_t capacity = RING_CAPACITY);
+
+			// One recv: bytes received, 0 if the peer closed the connection or SOCKET_ERROR.
+			// The buffer grows if a frame doesn't fit into it, SOCKET_ERROR if it would grow past max_buffer.
+			int receive(SOCKET sock);
+
+			// The next complete frame of the buffer, false if it needs more bytes (or failed()).
+			// The view points into the buffer and is valid until the next call of next() or receive().
+			bool next(std::string_view& frame);
+
+			// Blocks until a frame is complete: 1, 0 if the peer closed the connection (a frame may be left
+			// incomplete) or SOCKET_ERROR (a socket error or failed()).
+			int read(SOCKET sock, std::string_view& frame);
+
+			// an invalid prefix or a frame longer than max_frame, the stream can't be parsed any further
+			bool failed() const noexcept { return invalid; }
+
+		private:
+			size_t taken;	// the size of the frame returned last, consumed with the next call
+			size_t needed;	// the size of the incomplete frame in front (0: unknown)
+			bool invalid;
+		};
+	}
+#endif
\ No newline at end of file
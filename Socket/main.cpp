@@ -3,9 +3,6 @@
 #include "client.hpp"
 #include "server.hpp"
 
-// TODO: Dual-Stack Sockets
-// https://learn.microsoft.com/en-gb/windows/win32/winsock/dual-stack-sockets
-
 int main() {
 	winLib::ClientSocket client("www.google.com");
 
@@ -0,0 +1,84 @@
+#include "multi_server.hpp"
+
+#ifdef WINDOWS_SOCKET_EPOLL
+#include <pthread.h>
+#include <sched.h>
+
+namespace winLib {
+	MultiServer::MultiServer(ConnectionHandlers handlers, PCSTR port, unsigned int threads) {
+		if (threads == 0)
+			threads = std::max(std::thread::hardware_concurrency(), 1u);
+
+		for (unsigned int i = 0; i < threads; i++) {
+			loops.push_back(std::make_unique<EventLoop>());
+			// every server gets its own copy of the handlers, they run on its thread only
+			servers.push_back(std::make_unique<EventServer>(*loops.back(), handlers, port));
+			servers.back()->listener.reuse_port = true;
+		}
+	}
+
+	MultiServer::~MultiServer() {
+		stop();
+	}
+
+	int MultiServer::start() {
+		if (!threads.empty())
+			return 0;
+
+		for (auto& server : servers) {
+			if (const int r = server->start()) {
+				for (auto& started : servers)
+					started->stop();
+
+				return r;
+			}
+		}
+
+		const unsigned int cores = std::max(std::thread::hardware_concurrency(), 1u);
+
+		for (size_t i = 0; i < loops.size(); i++) {
+			threads.emplace_back([loop = loops[i].get()] { loop->run(); });
+
+			if (pin_threads) {
+				cpu_set_t set;
+				CPU_ZERO(&set);
+				CPU_SET(i % cores, &set);
+
+				// only a hint for the scheduler, the server works without it
+				pthread_setaffinity_np(threads.back().native_handle(), sizeof(set), &set);
+			}
+		}
+
+		return 0;
+	}
+
+	void MultiServer::stop() noexcept {
+		if (!threads.empty()) {
+			for (auto& loop : loops)
+				loop->stop();
+
+			for (auto& thread : threads)
+				thread.join();
+		}
+
+		threads.clear();
+
+		// the threads are gone, so the servers can be closed from here
+		for (auto& server : servers)
+			server->stop();
+	}
+
+	void MultiServer::post(size_t index, EventLoop::Task task) {
+		loops[index]->post(std::move(task));
+	}
+
+	size_t MultiServer::connections() const noexcept {
+		size_t count = 0;
+
+		for (const auto& server : servers)
+			count += server->connections();
+
+		return count;
+	}
+}
+#endif
\ No newline at end of file
@@ -0,0 +1,48 @@
+#ifndef WINDOWS_SOCKET_MULTI_SERVER_HPP
+	#define WINDOWS_SOCKET_MULTI_SERVER_HPP
+
+	#include "event_server.hpp"
+
+	#ifdef WINDOWS_SOCKET_EPOLL
+		#include <thread>
+
+		// One EventLoop thread per core, each with its own SO_REUSEPORT listener on the same port, so the kernel
+		// spreads new connections over the threads. A connection stays on the thread that accepted it: the handlers
+		// of one connection always run on the same thread and EventLoop::post moves work between the threads.
+
+		namespace winLib {
+			class MultiServer {
+			public:
+				// pin thread i to core i % cores (set before start())
+				bool pin_threads = true;
+
+				// threads == 0: one per core
+				MultiServer(ConnectionHandlers handlers, PCSTR port = DEFAULT_PORT, unsigned int threads = 0);
+				~MultiServer();
+
+				MultiServer(const MultiServer&) = delete;
+				MultiServer& operator=(const MultiServer&) = delete;
+
+				// binds all listeners and starts the threads, 0 or the error code (nothing runs in that case)
+				int start();
+				// stops the loops, joins the threads and closes all connections
+				void stop() noexcept;
+
+				size_t size() const noexcept { return loops.size(); }
+				EventLoop& loop(size_t index) const noexcept { return *loops[index]; }
+				EventServer& server(size_t index) const noexcept { return *servers[index]; }
+
+				// thread safe, runs task on the thread of loop index
+				void post(size_t index, EventLoop::Task task);
+
+				// thread safe, the sum of all threads
+				size_t connections() const noexcept;
+
+			private:
+				std::vector<std::unique_ptr<EventLoop>> loops;
+				std::vector<std::unique_ptr<EventServer>> servers;
+				std::vector<std::thread> threads;
+			};
+		}
+	#endif
+#endif
\ No newline at end of file
@@ -0,0 +1,115 @@
+#include "platform.hpp"
+
+#include <mutex>
+#include <system_error>
+
+namespace winLib {
+	static std::mutex network_mutex;
+	static int network_users = 0;
+
+	#ifdef WINDOWS_SOCKET_WINSOCK
+		static WSADATA wsa_data;
+	#endif
+
+	int last_socket_error() noexcept {
+		#ifdef WINDOWS_SOCKET_WINSOCK
+			return WSAGetLastError();
+		#else
+			return errno;
+		#endif
+	}
+
+	int close_socket(SOCKET sock) noexcept {
+		#ifdef WINDOWS_SOCKET_WINSOCK
+			if (closesocket(sock) == SOCKET_ERROR)
+				return last_socket_error();
+		#else
+			if (::close(sock) == SOCKET_ERROR)
+				return last_socket_error();
+		#endif
+
+		return 0;
+	}
+
+	bool set_nonblocking(SOCKET sock, bool enable) noexcept {
+		#ifdef WINDOWS_SOCKET_WINSOCK
+			u_long mode = enable ? 1 : 0;
+			return ioctlsocket(sock, FIONBIO, &mode) != SOCKET_ERROR;
+		#else
+			const int flags = fcntl(sock, F_GETFL, 0);
+
+			if (flags == -1)
+				return false;
+
+			return fcntl(sock, F_SETFL, enable ? flags | O_NONBLOCK : flags & ~O_NONBLOCK) != -1;
+		#endif
+	}
+
+	bool would_block(int error) noexcept {
+		#ifdef WINDOWS_SOCKET_WINSOCK
+			return error == WSAEWOULDBLOCK;
+		#else
+			return error == EAGAIN || error == EWOULDBLOCK;
+		#endif
+	}
+
+	NetworkGuard::NetworkGuard() {
+		std::lock_guard<std::mutex> lock(network_mutex);
+
+		#ifdef WINDOWS_SOCKET_WINSOCK
+			if (network_users == 0) {
+				if (const int result = WSAStartup(WINSOCK_VERSION, &wsa_data)) {
+					std::cout << "\nERROR: WSAStartup failed: " << result << std::endl;
+					throw std::system_error(result, std::system_category());
+				}
+			}
+		#endif
+
+		network_users++;
+	}
+
+	NetworkGuard::~NetworkGuard() {
+		std::lock_guard<std::mutex> lock(network_mutex);
+
+		network_users--;
+
+		#ifdef WINDOWS_SOCKET_WINSOCK
+			if (network_users == 0)
+				WSACleanup();
+		#endif
+	}
+
+	int NetworkGuard::users() noexcept {
+		std::lock_guard<std::mutex> lock(network_mutex);
+		return network_users;
+	}
+
+	SocketHandle& SocketHandle::operator=(SocketHandle&& other) noexcept {
+		if (this != &other)
+			reset(other.release());
+
+		return *this;
+	}
+
+	SocketHandle::~SocketHandle() {
+		close();
+	}
+
+	SOCKET SocketHandle::release() noexcept {
+		const SOCKET released = handle;
+		handle = INVALID_SOCKET;
+		return released;
+	}
+
+	void SocketHandle::reset(SOCKET handle) noexcept {
+		close();
+		this->handle = handle;
+	}
+
+	int SocketHandle::close() noexcept {
+		if (handle == INVALID_SOCKET)
+			return 0;
+
+		return close_socket(release());
+	}
+}
\ No newline at end of file
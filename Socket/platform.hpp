@@ -0,0 +1,60 @@
+#ifndef WINDOWS_SOCKET_PLATFORM_HPP
+	#define WINDOWS_SOCKET_PLATFORM_HPP
+
+	#include "util.hpp"
+
+	// Everything the socket classes need that differs between Winsock and BSD sockets.
+
+	namespace winLib {
+		// error code of the last failed socket function (WSAGetLastError or errno)
+		int last_socket_error() noexcept;
+		// closesocket or close, 0 or the error code
+		int close_socket(SOCKET sock) noexcept;
+		// non-blocking mode for the event loop, false on error
+		bool set_nonblocking(SOCKET sock, bool enable = true) noexcept;
+		// the error of a non-blocking call that has to wait for readiness
+		bool would_block(int error) noexcept;
+
+		// Reference counted initialization of the network stack for the whole process.
+		// The first guard calls WSAStartup, the last one WSACleanup (BSD sockets need neither).
+		class NetworkGuard {
+		public:
+			// throws std::system_error if the network stack can't be initialized
+			NetworkGuard();
+			~NetworkGuard();
+
+			NetworkGuard(const NetworkGuard&) = delete;
+			NetworkGuard& operator=(const NetworkGuard&) = delete;
+
+			// number of guards alive
+			static int users() noexcept;
+		};
+
+		// Owns a socket and closes it on destruction. Move only.
+		class SocketHandle {
+		public:
+			SocketHandle() noexcept = default;
+			explicit SocketHandle(SOCKET handle) noexcept : handle(handle) {}
+			SocketHandle(SocketHandle&& other) noexcept : handle(other.release()) {}
+			SocketHandle& operator=(SocketHandle&& other) noexcept;
+			~SocketHandle();
+
+			SocketHandle(const SocketHandle&) = delete;
+			SocketHandle& operator=(const SocketHandle&) = delete;
+
+			SOCKET get() const noexcept { return handle; }
+			bool valid() const noexcept { return handle != INVALID_SOCKET; }
+			explicit operator bool() const noexcept { return valid(); }
+
+			// gives up the ownership without closing
+			SOCKET release() noexcept;
+			// closes the current socket and owns handle
+			void reset(SOCKET handle = INVALID_SOCKET) noexcept;
+			// 0 or the error code, the handle is invalid afterwards in both cases
+			int close() noexcept;
+
+		private:
+			SOCKET handle = INVALID_SOCKET;
+		};
+	}
+#endif
\ No newline at end of file
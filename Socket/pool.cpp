@@ -0,0 +1,370 @@
+#include "pool.hpp"
+#include "platform.hpp"
+
+#include <cassert>
+#include <cstdint>
+#include <iostream>
+#include <utility>
+#include <vector>
+
+#ifdef WINDOWS_SOCKET_POSIX
+	#include <poll.h>
+#endif
+
+namespace winLib {
+	// An idle connection has nothing to read: a readable socket was closed by the peer (or got bytes nobody asked
+	// for), either way the next request can't use it.
+	static bool healthy(SOCKET sock) noexcept {
+		#ifdef WINDOWS_SOCKET_WINSOCK
+			WSAPOLLFD fd{};
+			fd.fd = sock;
+			fd.events = POLLIN;
+
+			const int r = WSAPoll(&fd, 1, 0);
+		#else
+			pollfd fd{};
+			fd.fd = sock;
+			fd.events = POLLIN;
+
+			const int r = poll(&fd, 1, 0);
+		#endif
+
+		return r == 0;
+	}
+
+	PooledConnection::PooledConnection(HostPool* pool, SocketHandle&& sock, bool was_idle) noexcept : sock(std::move(sock)) {
+		this->pool = pool;
+		this->was_idle = was_idle;
+	}
+
+	PooledConnection::PooledConnection(PooledConnection&& other) noexcept : sock(std::move(other.sock)) {
+		pool = std::exchange(other.pool, nullptr);
+		was_idle = other.was_idle;
+	}
+
+	PooledConnection& PooledConnection::operator=(PooledConnection&& other) noexcept {
+		if (this != &other) {
+			release();
+
+			pool = std::exchange(other.pool, nullptr);
+			sock = std::move(other.sock);
+			was_idle = other.was_idle;
+		}
+
+		return *this;
+	}
+
+	PooledConnection::~PooledConnection() {
+		release();
+	}
+
+	void PooledConnection::discard() noexcept {
+		if (pool && sock)
+			pool->close_counted(sock);
+
+		pool = nullptr;
+	}
+
+	void PooledConnection::release() noexcept {
+		if (pool && sock)
+			pool->release(std::move(sock));
+
+		pool = nullptr;
+	}
+
+	HostPool::HostPool(PCSTR host, PCSTR port, const PoolOptions& options) : host_name(host), port_name(port), client(host_name.c_str(), port_name.c_str()) {
+		this->options = options;
+		this->client.connect_options = options.connect;
+
+		size_t capacity = 2;
+
+		while (capacity < options.max_idle)
+			capacity <<= 1;
+
+		cells = std::make_unique<Cell[]>(capacity);
+		mask = capacity - 1;
+
+		for (size_t i = 0; i < capacity; i++)
+			cells[i].sequence.store(i, std::memory_order_relaxed);
+
+		enqueue_position.store(0, std::memory_order_relaxed);
+		dequeue_position.store(0, std::memory_order_relaxed);
+		idle_count.store(0, std::memory_order_relaxed);
+		open_count.store(0, std::memory_order_relaxed);
+
+		if (!options.resolver)
+			resolved.store(client.create_socket() == 0, std::memory_order_release);
+		else
+			resolved.store(false, std::memory_order_relaxed);
+	}
+
+	HostPool::~HostPool() {
+		IdleConnection connection;
+
+		// the connections in use have to be gone already, they return into this pool
+		while (pop(connection))
+			close_counted(connection.sock);
+
+		assert(open() == 0 && "a PooledConnection outlived its HostPool");
+	}
+
+	PooledConnection HostPool::acquire() {
+		IdleConnection connection;
+
+		while (pop(connection)) {
+			idle_count.fetch_sub(1, std::memory_order_relaxed);
+
+			if (Clock::now() - connection.since < options.idle_timeout && healthy(connection.sock.get()))
+				return PooledConnection(this, std::move(connection.sock), true);
+
+			close_counted(connection.sock);
+		}
+
+		SocketHandle sock = connect_new();
+
+		if (!sock)
+			return {};
+
+		return PooledConnection(this, std::move(sock), false);
+	}
+
+	size_t HostPool::maintain() {
+		const Clock::time_point now = Clock::now();
+		size_t closed = 0;
+
+		// every connection that is idle right now is checked once, the healthy ones go back behind the others
+		for (size_t i = idle(); i > 0; i--) {
+			IdleConnection connection;
+
+			if (!pop(connection))
+				break;
+
+			idle_count.fetch_sub(1, std::memory_order_relaxed);
+
+			if (now - connection.since >= options.idle_timeout || !healthy(connection.sock.get())) {
+				close_counted(connection.sock);
+				closed++;
+				continue;
+			}
+
+			idle_count.fetch_add(1, std::memory_order_relaxed);
+
+			if (!push(std::move(connection))) {
+				idle_count.fetch_sub(1, std::memory_order_relaxed);
+				close_counted(connection.sock);
+				closed++;
+			}
+		}
+
+		while (idle() < options.min_idle) {
+			IdleConnection connection{ connect_new(), Clock::now() };
+
+			if (!connection.sock)
+				break;
+
+			idle_count.fetch_add(1, std::memory_order_relaxed);
+
+			if (!push(std::move(connection))) {
+				idle_count.fetch_sub(1, std::memory_order_relaxed);
+				close_counted(connection.sock);
+				break;
+			}
+		}
+
+		return closed;
+	}
+
+	bool HostPool::push(IdleConnection&& connection) noexcept {
+		size_t position = enqueue_position.load(std::memory_order_relaxed);
+		Cell* cell;
+
+		for (;;) {
+			cell = &cells[position & mask];
+
+			const size_t sequence = cell->sequence.load(std::memory_order_acquire);
+			const intptr_t difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+
+			if (difference == 0) {
+				if (enqueue_position.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+					break;
+			}
+			// full: the cell still holds the connection of the previous round
+			else if (difference < 0)
+				return false;
+			else
+				position = enqueue_position.load(std::memory_order_relaxed);
+		}
+
+		cell->value = std::move(connection);
+		cell->sequence.store(position + 1, std::memory_order_release);
+
+		return true;
+	}
+
+	bool HostPool::pop(IdleConnection& connection) noexcept {
+		size_t position = dequeue_position.load(std::memory_order_relaxed);
+		Cell* cell;
+
+		for (;;) {
+			cell = &cells[position & mask];
+
+			const size_t sequence = cell->sequence.load(std::memory_order_acquire);
+			const intptr_t difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position + 1);
+
+			if (difference == 0) {
+				if (dequeue_position.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+					break;
+			}
+			// empty: nothing was pushed into the cell in this round
+			else if (difference < 0)
+				return false;
+			else
+				position = dequeue_position.load(std::memory_order_relaxed);
+		}
+
+		connection = std::move(cell->value);
+		cell->sequence.store(position + mask + 1, std::memory_order_release);
+
+		return true;
+	}
+
+	SocketHandle HostPool::connect_new() {
+		AddressList addresses;
+
+		if (options.resolver) {
+			addresses = options.resolver->resolve(host_name.c_str(), port_name.c_str());
+
+			if (addresses->error)
+				return SocketHandle();
+		}
+		else if (!resolved.load(std::memory_order_acquire)) {
+			std::lock_guard<std::mutex> lock(resolve_mutex);
+
+			if (!resolved.load(std::memory_order_relaxed) && client.create_socket() == 0)
+				resolved.store(true, std::memory_order_release);
+
+			if (!resolved.load(std::memory_order_relaxed))
+				return SocketHandle();
+		}
+
+		if (open_count.fetch_add(1, std::memory_order_relaxed) >= options.max_connections) {
+			open_count.fetch_sub(1, std::memory_order_relaxed);
+			std::cout << "\nERROR: connection limit of " << host_name << ":" << port_name << " reached: " << options.max_connections << std::endl;
+			return SocketHandle();
+		}
+
+		// the addresses don't change after the resolve, any number of threads connect at the same time
+		int err = 0;
+		SocketHandle sock = addresses ? connect_parallel(addresses->get(), options.connect, &err) : client.open_connection(&err);
+
+		if (!sock) {
+			open_count.fetch_sub(1, std::memory_order_relaxed);
+			std::cout << "\nERROR: connect to " << host_name << ":" << port_name << " failed: " << err << std::endl;
+			return sock;
+		}
+
+		const int enable = 1;
+
+		if (options.no_delay)
+			setsockopt(sock.get(), IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char*>(&enable), sizeof(enable));
+
+		if (options.keep_alive)
+			setsockopt(sock.get(), SOL_SOCKET, SO_KEEPALIVE, reinterpret_cast<const char*>(&enable), sizeof(enable));
+
+		return sock;
+	}
+
+	void HostPool::release(SocketHandle&& sock) noexcept {
+		IdleConnection connection{ std::move(sock), Clock::now() };
+
+		// counted first, a pop right after the push must not take the count below 0
+		idle_count.fetch_add(1, std::memory_order_relaxed);
+
+		if (!push(std::move(connection))) {
+			// more idle connections than max_idle: the load went down, this one isn't needed
+			idle_count.fetch_sub(1, std::memory_order_relaxed);
+			close_counted(connection.sock);
+		}
+	}
+
+	void HostPool::close_counted(SocketHandle& sock) noexcept {
+		sock.close();
+		open_count.fetch_sub(1, std::memory_order_relaxed);
+	}
+
+	ConnectionPool::ConnectionPool(const PoolOptions& options) {
+		this->options = options;
+		this->maintenance_stop = false;
+	}
+
+	ConnectionPool::~ConnectionPool() {
+		stop_maintenance();
+	}
+
+	HostPool& ConnectionPool::host(PCSTR host, PCSTR port) {
+		const std::string key = std::string(host) + ":" + port;
+
+		{
+			std::shared_lock<std::shared_mutex> lock(hosts_mutex);
+			const auto found = hosts.find(key);
+
+			if (found != hosts.end())
+				return *found->second;
+		}
+
+		// resolves outside of the lock, the other hosts are not held up by it
+		auto pool = std::make_unique<HostPool>(host, port, options);
+
+		std::unique_lock<std::shared_mutex> lock(hosts_mutex);
+
+		// another thread may have added the host in the meantime, its pool is kept
+		return *hosts.try_emplace(key, std::move(pool)).first->second;
+	}
+
+	size_t ConnectionPool::maintain() {
+		std::vector<HostPool*> pools;
+
+		// the pools live as long as this, the connects of maintain() don't hold up host() for new hosts
+		{
+			std::shared_lock<std::shared_mutex> lock(hosts_mutex);
+			pools.reserve(hosts.size());
+
+			for (const auto& entry : hosts)
+				pools.push_back(entry.second.get());
+		}
+
+		size_t closed = 0;
+
+		for (HostPool* pool : pools)
+			closed += pool->maintain();
+
+		return closed;
+	}
+
+	void ConnectionPool::start_maintenance(std::chrono::milliseconds interval) {
+		stop_maintenance();
+
+		maintenance_stop = false;
+		maintenance = std::thread([this, interval] {
+			std::unique_lock<std::mutex> lock(maintenance_mutex);
+
+			while (!maintenance_wake.wait_for(lock, interval, [this] { return maintenance_stop; })) {
+				lock.unlock();
+				maintain();
+				lock.lock();
+			}
+		});
+	}
+
+	void ConnectionPool::stop_maintenance() {
+		{
+			std::lock_guard<std::mutex> lock(maintenance_mutex);
+			maintenance_stop = true;
+		}
+
+		maintenance_wake.notify_all();
+
+		if (maintenance.joinable())
+			maintenance.join();
+	}
+}
\ No newline at end of file
@@ -0,0 +1,167 @@
+#ifndef WINDOWS_SOCKET_POOL_HPP
+	#define WINDOWS_SOCKET_POOL_HPP
+
+	#include "client.hpp"
+
+	#include <atomic>
+	#include <chrono>
+	#include <condition_variable>
+	#include <memory>
+	#include <mutex>
+	#include <shared_mutex>
+	#include <string>
+	#include <thread>
+	#include <unordered_map>
+
+	// Keeps connections to backends open between requests. A HostPool per host:port resolves the name once (or
+	// asks a Resolver for every new connection) and holds the idle connections in a lock-free queue, so any number
+	// of threads take and return connections without a lock and a request only pays for the connect if no warm
+	// connection is left.
+
+	namespace winLib {
+		struct PoolOptions {
+			size_t max_idle = 16;					// idle connections per host (rounded up to a power of 2)
+			size_t min_idle = 0;					// opened ahead by maintain()
+			size_t max_connections = 64;			// per host, idle and in use
+			std::chrono::milliseconds idle_timeout{ 30000 };	// an idle connection is closed after this
+			bool no_delay = true;					// TCP_NODELAY: requests are written in one piece
+			bool keep_alive = true;					// SO_KEEPALIVE: the kernel notices a dead peer of an idle connection
+			ConnectOptions connect;					// how a new connection races the addresses of the host
+			// Looks up the host for every new connection (cached for its ttl), a pool follows a changed DNS record.
+			// Without one the host is resolved once.
+			Resolver* resolver = nullptr;
+		};
+
+		class HostPool;
+
+		// A connection of a HostPool, goes back into the pool when it is destroyed. Move only.
+		// The HostPool (and the ConnectionPool it belongs to) has to outlive it, checked by an assert.
+		class PooledConnection {
+		public:
+			PooledConnection() noexcept = default;
+			PooledConnection(PooledConnection&& other) noexcept;
+			PooledConnection& operator=(PooledConnection&& other) noexcept;
+			~PooledConnection();
+
+			PooledConnection(const PooledConnection&) = delete;
+			PooledConnection& operator=(const PooledConnection&) = delete;
+
+			SOCKET get() const noexcept { return sock.get(); }
+			bool valid() const noexcept { return sock.valid(); }
+			explicit operator bool() const noexcept { return valid(); }
+
+			// taken from the idle connections: it can still have been closed by the peer since the health check,
+			// a request that fails on it is worth one retry on a new connection
+			bool reused() const noexcept { return was_idle; }
+
+			// broken, or in a state of the protocol the next user can't continue from (half a response read):
+			// closed instead of going back into the pool
+			void discard() noexcept;
+			// back into the pool now
+			void release() noexcept;
+
+		private:
+			friend class HostPool;
+
+			HostPool* pool = nullptr;
+			SocketHandle sock;
+			bool was_idle = false;
+
+			PooledConnection(HostPool* pool, SocketHandle&& sock, bool was_idle) noexcept;
+		};
+
+		class HostPool {
+		public:
+			// resolves host (blocking) without options.resolver, acquire() tries again if that failed
+			HostPool(PCSTR host, PCSTR port, const PoolOptions& options = {});
+			~HostPool();
+
+			HostPool(const HostPool&) = delete;
+			HostPool& operator=(const HostPool&) = delete;
+
+			// Thread safe: a healthy idle connection or a new one. An invalid connection if the host can't be
+			// reached or max_connections are open already.
+			PooledConnection acquire();
+
+			// Thread safe: closes the idle connections that expired or were closed by the peer and opens new ones
+			// up to min_idle. Returns the number of closed connections.
+			size_t maintain();
+
+			size_t idle() const noexcept { return idle_count.load(std::memory_order_relaxed); }
+			size_t open() const noexcept { return open_count.load(std::memory_order_relaxed); }
+
+		private:
+			friend class PooledConnection;
+
+			using Clock = std::chrono::steady_clock;
+
+			struct IdleConnection {
+				SocketHandle sock;
+				Clock::time_point since;
+			};
+
+			// bounded multi producer / multi consumer queue (D. Vyukov): every cell has a sequence number that tells
+			// whether it is free for the producer or filled for the consumer of a position
+			struct Cell {
+				std::atomic<size_t> sequence;
+				IdleConnection value;
+			};
+
+			std::string host_name, port_name;
+			PoolOptions options;
+
+			ClientSocket client;			// the resolved addresses
+			std::mutex resolve_mutex;
+			std::atomic<bool> resolved;
+
+			std::unique_ptr<Cell[]> cells;
+			size_t mask;
+			alignas(64) std::atomic<size_t> enqueue_position;
+			alignas(64) std::atomic<size_t> dequeue_position;
+			alignas(64) std::atomic<size_t> idle_count;
+			std::atomic<size_t> open_count;
+
+			bool push(IdleConnection&& connection) noexcept;
+			bool pop(IdleConnection& connection) noexcept;
+
+			// a new connection counted in open_count, invalid on error
+			SocketHandle connect_new();
+			// the connection of a PooledConnection is done
+			void release(SocketHandle&& sock) noexcept;
+			void close_counted(SocketHandle& sock) noexcept;
+		};
+
+		// The HostPools of all backends, by host:port.
+		class ConnectionPool {
+		public:
+			PoolOptions options;	// for the hosts used after it is set
+
+			ConnectionPool(const PoolOptions& options = {});
+			~ConnectionPool();
+
+			ConnectionPool(const ConnectionPool&) = delete;
+			ConnectionPool& operator=(const ConnectionPool&) = delete;
+
+			// Thread safe: the pool of host:port, created on the first use. The lookup takes a shared lock, a
+			// caller that keeps the reference uses the pool without any lock. Lives as long as the ConnectionPool.
+			HostPool& host(PCSTR host, PCSTR port = DEFAULT_PORT);
+			PooledConnection acquire(PCSTR host_name, PCSTR port = DEFAULT_PORT) { return host(host_name, port).acquire(); }
+
+			// HostPool::maintain() of all hosts
+			size_t maintain();
+
+			// a thread that calls maintain() every interval until stop_maintenance() (or the destructor)
+			void start_maintenance(std::chrono::milliseconds interval);
+			void stop_maintenance();
+
+		private:
+			std::shared_mutex hosts_mutex;
+			std::unordered_map<std::string, std::unique_ptr<HostPool>> hosts;
+
+			std::thread maintenance;
+			std::mutex maintenance_mutex;
+			std::condition_variable maintenance_wake;
+			bool maintenance_stop;
+		};
+	}
+#endif
\ No newline at end of file
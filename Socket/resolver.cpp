@@ -0,0 +1,322 @@
+#include "resolver.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <fstream>
+#include <future>
+#include <iostream>
+#include <sstream>
+#include <utility>
+
+namespace winLib {
+	static std::string lowercase(PCSTR name) {
+		std::string result(name ? name : "");
+
+		std::transform(result.begin(), result.end(), result.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+
+		return result;
+	}
+
+	void Addresses::append(const addrinfo* list) {
+		for (const addrinfo* address = list; address != nullptr; address = address->ai_next) {
+			if (address->ai_addrlen > sizeof(sockaddr_storage))
+				continue;
+
+			sockaddr_storage& copy = storage.emplace_back();
+			std::memcpy(&copy, address->ai_addr, address->ai_addrlen);
+
+			addrinfo& info = infos.emplace_back();
+			info.ai_flags = address->ai_flags;
+			info.ai_family = address->ai_family;
+			info.ai_socktype = address->ai_socktype;
+			info.ai_protocol = address->ai_protocol;
+			info.ai_addrlen = address->ai_addrlen;
+			info.ai_addr = reinterpret_cast<sockaddr*>(&copy);
+
+			// a deque doesn't move its elements on emplace_back
+			if (infos.size() > 1)
+				infos[infos.size() - 2].ai_next = &info;
+		}
+	}
+
+	Resolver::Resolver(const ResolverOptions& options) {
+		this->options = options;
+		this->lookup_count.store(0, std::memory_order_relaxed);
+
+		for (size_t i = 0; i < std::max<size_t>(options.threads, 1); i++)
+			workers.emplace_back(&Resolver::work_loop, this);
+	}
+
+	Resolver::~Resolver() {
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			stopping = true;
+		}
+
+		work.notify_all();
+
+		for (std::thread& worker : workers)
+			worker.join();
+
+		// the lookups nobody started
+		auto failed = std::make_shared<Addresses>();
+		failed->error = EAI_AGAIN;
+
+		for (const Lookup& lookup : queue) {
+			for (Callback& callback : cache[lookup.key].waiting)
+				callback(failed);
+		}
+	}
+
+	bool Resolver::add_host(const std::string& name, const std::vector<std::string>& addresses) {
+		addrinfo hints{};
+		hints.ai_flags = AI_NUMERICHOST;
+
+		for (const std::string& address : addresses) {
+			addrinfo* result = nullptr;
+
+			if (const int r = getaddrinfo(address.c_str(), nullptr, &hints, &result)) {
+				std::cout << "\nERROR: invalid host address " << address << ": " << r << std::endl;
+				return false;
+			}
+
+			freeaddrinfo(result);
+		}
+
+		std::lock_guard<std::mutex> lock(mutex);
+		hosts[lowercase(name.c_str())] = addresses;
+
+		return true;
+	}
+
+	void Resolver::remove_host(const std::string& name) {
+		std::lock_guard<std::mutex> lock(mutex);
+		hosts.erase(lowercase(name.c_str()));
+	}
+
+	bool Resolver::load_hosts(const char* path) {
+		std::ifstream file(path);
+
+		if (!file) {
+			std::cout << "\nERROR: hosts file " << path << " can't be read" << std::endl;
+			return false;
+		}
+
+		std::unordered_map<std::string, std::vector<std::string>> entries;
+		std::string line;
+
+		while (std::getline(file, line)) {
+			std::istringstream fields(line.substr(0, line.find('#')));
+			std::string address, name;
+
+			if (!(fields >> address))
+				continue;
+
+			// a name may be listed for IPv4 and IPv6 in two lines
+			while (fields >> name)
+				entries[lowercase(name.c_str())].push_back(address);
+		}
+
+		for (const auto& entry : entries) {
+			if (!add_host(entry.first, entry.second))
+				return false;
+		}
+
+		return true;
+	}
+
+	void Resolver::resolve(PCSTR host, PCSTR port, Callback callback) {
+		const std::string name = lowercase(host);
+		std::vector<std::string> numeric;
+		AddressList addresses;
+
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+
+			const auto known = hosts.find(name);
+
+			if (known != hosts.end())
+				numeric = known->second;
+			else {
+				const std::string key = name + ":" + port;
+				const Clock::time_point now = Clock::now();
+				auto found = cache.find(key);
+
+				if (found != cache.end() && found->second.pending) {
+					found->second.waiting.push_back(std::move(callback));
+					return;
+				}
+
+				if (found != cache.end() && found->second.expires > now)
+					addresses = found->second.addresses;
+				else {
+					if (found == cache.end()) {
+						evict(now);
+						found = cache.emplace(key, Entry()).first;
+					}
+
+					found->second.pending = true;
+					found->second.waiting.push_back(std::move(callback));
+
+					queue.push_back({ key, host, port });
+					work.notify_one();
+					return;
+				}
+			}
+		}
+
+		if (!addresses)
+			addresses = numeric_addresses(numeric, port);
+
+		callback(addresses);
+	}
+
+	AddressList Resolver::resolve(PCSTR host, PCSTR port) {
+		std::promise<AddressList> result;
+		std::future<AddressList> addresses = result.get_future();
+
+		resolve(host, port, [&result](const AddressList& addresses) { result.set_value(addresses); });
+
+		return addresses.get();
+	}
+
+	#ifdef WINDOWS_SOCKET_EPOLL
+		void Resolver::resolve(EventLoop& loop, PCSTR host, PCSTR port, Callback callback) {
+			resolve(host, port, [&loop, callback = std::move(callback)](const AddressList& addresses) {
+				loop.post([callback, addresses] { callback(addresses); });
+			});
+		}
+
+		Resolver::LookupOperation::LookupOperation(Resolver& resolver, EventLoop& loop, PCSTR host, PCSTR port) : host(host), port(port) {
+			this->resolver = &resolver;
+			this->loop = &loop;
+		}
+
+		void Resolver::LookupOperation::await_suspend(std::coroutine_handle<> awaiting) {
+			// posted to the loop, the coroutine is never resumed inside of await_suspend
+			resolver->resolve(*loop, host.c_str(), port.c_str(), [this, awaiting](const AddressList& addresses) {
+				this->addresses = addresses;
+				awaiting.resume();
+			});
+		}
+	#endif
+
+	void Resolver::clear() {
+		std::lock_guard<std::mutex> lock(mutex);
+
+		// the running lookups still have callbacks waiting for them
+		for (auto entry = cache.begin(); entry != cache.end(); ) {
+			if (entry->second.pending)
+				++entry;
+			else
+				entry = cache.erase(entry);
+		}
+	}
+
+	size_t Resolver::cached() {
+		std::lock_guard<std::mutex> lock(mutex);
+		return cache.size();
+	}
+
+	void Resolver::work_loop() {
+		std::unique_lock<std::mutex> lock(mutex);
+
+		for (;;) {
+			work.wait(lock, [this] { return stopping || !queue.empty(); });
+
+			// the destructor answers the lookups left in the queue
+			if (stopping)
+				return;
+
+			const Lookup lookup = std::move(queue.front());
+			queue.pop_front();
+
+			lock.unlock();
+
+			addrinfo hints{};
+			hints.ai_family = options.family;
+			hints.ai_socktype = options.socktype;
+			hints.ai_protocol = options.protocol;
+
+			auto addresses = std::make_shared<Addresses>();
+			addrinfo* result = nullptr;
+
+			lookup_count.fetch_add(1, std::memory_order_relaxed);
+
+			if (const int r = getaddrinfo(lookup.host.c_str(), lookup.port.c_str(), &hints, &result)) {
+				std::cout << "\nERROR: getaddrinfo of " << lookup.host << " failed: " << r << std::endl;
+				addresses->error = r;
+			}
+			else {
+				addresses->append(result);
+				freeaddrinfo(result);
+			}
+
+			lock.lock();
+
+			Entry& entry = cache[lookup.key];
+			entry.addresses = addresses;
+			entry.expires = Clock::now() + (addresses->error ? options.negative_ttl : options.ttl);
+			entry.pending = false;
+
+			std::vector<Callback> waiting = std::move(entry.waiting);
+			entry.waiting.clear();
+
+			lock.unlock();
+
+			for (Callback& callback : waiting)
+				callback(addresses);
+
+			lock.lock();
+		}
+	}
+
+	AddressList Resolver::numeric_addresses(const std::vector<std::string>& numeric, PCSTR port) const {
+		addrinfo hints{};
+		hints.ai_family = options.family;
+		hints.ai_socktype = options.socktype;
+		hints.ai_protocol = options.protocol;
+		hints.ai_flags = AI_NUMERICHOST;
+
+		auto addresses = std::make_shared<Addresses>();
+
+		for (const std::string& address : numeric) {
+			addrinfo* result = nullptr;
+
+			// an IPv6 address doesn't match options.family = AF_INET and is skipped
+			if (const int r = getaddrinfo(address.c_str(), port, &hints, &result)) {
+				addresses->error = r;
+				continue;
+			}
+
+			addresses->append(result);
+			freeaddrinfo(result);
+		}
+
+		if (!addresses->empty())
+			addresses->error = 0;
+
+		return addresses;
+	}
+
+	void Resolver::evict(Clock::time_point now) {
+		if (cache.size() < options.max_entries)
+			return;
+
+		for (auto entry = cache.begin(); entry != cache.end(); ) {
+			if (!entry->second.pending && entry->second.expires <= now)
+				entry = cache.erase(entry);
+			else
+				++entry;
+		}
+
+		// all of them are fresh: any answer that isn't waited for goes
+		for (auto entry = cache.begin(); entry != cache.end() && cache.size() >= options.max_entries; ) {
+			if (entry->second.pending)
+				++entry;
+			else
+				entry = cache.erase(entry);
+		}
+	}
+}
\ No newline at end of file
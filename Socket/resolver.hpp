@@ -0,0 +1,156 @@
+#ifndef WINDOWS_SOCKET_RESOLVER_HPP
+	#define WINDOWS_SOCKET_RESOLVER_HPP
+
+	#include "util.hpp"
+	#include "platform.hpp"
+	#include "event_loop.hpp"
+
+	#include <atomic>
+	#include <chrono>
+	#include <condition_variable>
+	#include <deque>
+	#include <functional>
+	#include <memory>
+	#include <mutex>
+	#include <string>
+	#include <thread>
+	#include <unordered_map>
+	#include <vector>
+
+	#ifdef WINDOWS_SOCKET_EPOLL
+		#include <coroutine>
+	#endif
+
+	// Name resolution off the I/O threads. getaddrinfo blocks for as long as the DNS server takes to answer,
+	// the Resolver runs it on its own threads and caches the answers:
+	//  - a name that is looked up while a lookup of it is running waits for that one (one getaddrinfo per name)
+	//  - answers are kept for ttl, failures for negative_ttl (a name that doesn't exist isn't asked for again
+	//    on every connect)
+	//  - names of the static table (add_host, load_hosts) are answered without any lookup, in tests no DNS
+	//    server is needed
+
+	namespace winLib {
+		// The addresses of one lookup as an addrinfo list that owns its memory, shared by everyone who asked.
+		class Addresses {
+		public:
+			int error = 0;		// the getaddrinfo error of a failed lookup, 0 on success
+
+			Addresses() = default;
+			Addresses(const Addresses&) = delete;
+			Addresses& operator=(const Addresses&) = delete;
+
+			// the first address (a list linked with ai_next), nullptr if there is none
+			const addrinfo* get() const noexcept { return infos.empty() ? nullptr : &infos.front(); }
+			size_t size() const noexcept { return infos.size(); }
+			bool empty() const noexcept { return infos.empty(); }
+
+			// copies the addresses of a getaddrinfo result
+			void append(const addrinfo* list);
+
+		private:
+			std::deque<sockaddr_storage> storage;	// a deque, the infos point into it
+			std::deque<addrinfo> infos;
+		};
+
+		using AddressList = std::shared_ptr<const Addresses>;
+
+		struct ResolverOptions {
+			size_t threads = 2;							// lookups at the same time
+			std::chrono::seconds ttl{ 60 };				// getaddrinfo doesn't tell the TTL of the records
+			std::chrono::seconds negative_ttl{ 5 };
+			size_t max_entries = 4096;					// cached names, expired ones are dropped first
+			int family = AF_UNSPEC;
+			int socktype = SOCK_STREAM;
+			int protocol = IPPROTO_TCP;
+		};
+
+		class Resolver {
+		public:
+			using Callback = std::function<void(const AddressList& addresses)>;
+
+			NetworkGuard network;	// first member: getaddrinfo needs WSAStartup
+			ResolverOptions options;
+
+			Resolver(const ResolverOptions& options = {});
+			// waits for the running lookups, the callbacks of the queued ones are called with an error
+			~Resolver();
+
+			Resolver(const Resolver&) = delete;
+			Resolver& operator=(const Resolver&) = delete;
+
+			// Static table, takes precedence over the cache and DNS. addresses are numeric (IPv4 or IPv6).
+			// Thread safe.
+			bool add_host(const std::string& name, const std::vector<std::string>& addresses);
+			void remove_host(const std::string& name);
+			// adds the entries of a hosts file ("address name aliases... # comment"), false if it can't be read
+			bool load_hosts(const char* path);
+
+			// Thread safe: calls callback with the addresses of host:port, right away if they are known (static or
+			// cached) and on a thread of the resolver after a lookup. Never nullptr, error is set on failure.
+			void resolve(PCSTR host, PCSTR port, Callback callback);
+			// Blocks the calling thread until the addresses are known.
+			AddressList resolve(PCSTR host, PCSTR port = DEFAULT_PORT);
+
+			#ifdef WINDOWS_SOCKET_EPOLL
+				// the callback runs on the thread of loop (posted, even if the addresses are known already)
+				void resolve(EventLoop& loop, PCSTR host, PCSTR port, Callback callback);
+
+				// co_await resolver.lookup(loop, host, port): the coroutine continues on the thread of loop
+				class LookupOperation {
+				public:
+					bool await_ready() const noexcept { return false; }
+					void await_suspend(std::coroutine_handle<> awaiting);
+					AddressList await_resume() noexcept { return std::move(addresses); }
+
+				private:
+					friend class Resolver;
+
+					Resolver* resolver;
+					EventLoop* loop;
+					std::string host, port;
+					AddressList addresses;
+
+					LookupOperation(Resolver& resolver, EventLoop& loop, PCSTR host, PCSTR port);
+				};
+
+				LookupOperation lookup(EventLoop& loop, PCSTR host, PCSTR port = DEFAULT_PORT) { return LookupOperation(*this, loop, host, port); }
+			#endif
+
+			// drops the cached answers (not the static table)
+			void clear();
+			size_t cached();
+			// getaddrinfo calls so far
+			size_t lookups() const noexcept { return lookup_count.load(std::memory_order_relaxed); }
+
+		private:
+			using Clock = std::chrono::steady_clock;
+
+			struct Entry {
+				AddressList addresses;
+				Clock::time_point expires;
+				bool pending = false;				// a lookup is running, the callbacks wait for it
+				std::vector<Callback> waiting;
+			};
+
+			struct Lookup {
+				std::string key, host, port;
+			};
+
+			std::mutex mutex;
+			std::condition_variable work;
+			bool stopping = false;
+
+			std::unordered_map<std::string, Entry> cache;			// by host:port
+			std::unordered_map<std::string, std::vector<std::string>> hosts;	// the static table, by lowercase name
+			std::deque<Lookup> queue;
+			std::vector<std::thread> workers;
+			std::atomic<size_t> lookup_count;
+
+			void work_loop();
+			// the static addresses of a name with port
+			AddressList numeric_addresses(const std::vector<std::string>& addresses, PCSTR port) const;
+			// makes room for one more entry (mutex locked)
+			void evict(Clock::time_point now);
+		};
+	}
+#endif
\ No newline at end of file
@@ -0,0 +1,211 @@
+#include "ring_buffer.hpp"
+#include "platform.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <system_error>
+#include <utility>
+
+#ifdef WINDOWS_SOCKET_WINSOCK
+	// VirtualAlloc2 and MapViewOfFile3 (Windows 10, version 1803)
+	#pragma comment(lib, "onecore.lib")
+#else
+	#include <sys/mman.h>
+#endif
+
+namespace winLib {
+	RingBuffer::RingBuffer(size_t capacity) {
+		const size_t unit = granularity();
+
+		length = (capacity + unit - 1) / unit * unit;
+		memory = map(length);
+
+		if (!memory) {
+			#ifdef WINDOWS_SOCKET_WINSOCK
+				const int err = static_cast<int>(GetLastError());
+			#else
+				const int err = errno;
+			#endif
+
+			std::cout << "\nERROR: ring buffer mapping failed: " << err << std::endl;
+			throw std::system_error(err, std::system_category());
+		}
+	}
+
+	RingBuffer::RingBuffer(RingBuffer&& other) noexcept {
+		memory = std::exchange(other.memory, nullptr);
+		length = std::exchange(other.length, 0);
+		head = std::exchange(other.head, 0);
+		count = std::exchange(other.count, 0);
+	}
+
+	RingBuffer& RingBuffer::operator=(RingBuffer&& other) noexcept {
+		if (this != &other) {
+			if (memory)
+				unmap(memory, length);
+
+			memory = std::exchange(other.memory, nullptr);
+			length = std::exchange(other.length, 0);
+			head = std::exchange(other.head, 0);
+			count = std::exchange(other.count, 0);
+		}
+
+		return *this;
+	}
+
+	RingBuffer::~RingBuffer() {
+		if (memory)
+			unmap(memory, length);
+	}
+
+	void RingBuffer::commit(size_t written) noexcept {
+		count += std::min(written, room());
+	}
+
+	void RingBuffer::consume(size_t read) noexcept {
+		read = std::min(read, count);
+
+		head = (head + read) % length;
+		count -= read;
+
+		// an empty buffer starts over, the next receive gets the whole room in one piece of the first mapping
+		if (count == 0)
+			head = 0;
+	}
+
+	bool RingBuffer::reserve(size_t capacity) {
+		if (capacity <= length)
+			return true;
+
+		const size_t unit = granularity();
+		const size_t new_length = (capacity + unit - 1) / unit * unit;
+
+		char* new_memory = map(new_length);
+
+		if (!new_memory)
+			return false;
+
+		std::memcpy(new_memory, data(), count);
+		unmap(memory, length);
+
+		memory = new_memory;
+		length = new_length;
+		head = 0;
+
+		return true;
+	}
+
+	int RingBuffer::receive(SOCKET sock) {
+		if (room() == 0)
+			return 0;
+
+		const int received = static_cast<int>(recv(sock, write_position(), static_cast<int>(std::min<size_t>(room(), 0x7FFFFFFF)), 0));
+
+		if (received > 0)
+			commit(static_cast<size_t>(received));
+
+		return received;
+	}
+
+	#ifdef WINDOWS_SOCKET_WINSOCK
+		size_t RingBuffer::granularity() noexcept {
+			SYSTEM_INFO info;
+			GetSystemInfo(&info);
+
+			return info.dwAllocationGranularity;
+		}
+
+		char* RingBuffer::map(size_t length) {
+			// two adjacent placeholders, each one is replaced by a view of the same section
+			char* placeholder = static_cast<char*>(VirtualAlloc2(nullptr, nullptr, 2 * length, MEM_RESERVE | MEM_RESERVE_PLACEHOLDER, PAGE_NOACCESS, nullptr, 0));
+
+			if (!placeholder)
+				return nullptr;
+
+			VirtualFree(placeholder, length, MEM_RELEASE | MEM_PRESERVE_PLACEHOLDER);
+
+			HANDLE section = CreateFileMappingW(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, static_cast<DWORD>(static_cast<unsigned long long>(length) >> 32), static_cast<DWORD>(length), nullptr);
+
+			if (!section) {
+				VirtualFree(placeholder, 0, MEM_RELEASE);
+				VirtualFree(placeholder + length, 0, MEM_RELEASE);
+				return nullptr;
+			}
+
+			void* first = MapViewOfFile3(section, nullptr, placeholder, 0, length, MEM_REPLACE_PLACEHOLDER, PAGE_READWRITE, nullptr, 0);
+			void* second = first ? MapViewOfFile3(section, nullptr, placeholder + length, 0, length, MEM_REPLACE_PLACEHOLDER, PAGE_READWRITE, nullptr, 0) : nullptr;
+
+			// the views keep the section alive
+			CloseHandle(section);
+
+			if (!second) {
+				if (first)
+					UnmapViewOfFile(first);
+				else
+					VirtualFree(placeholder, 0, MEM_RELEASE);
+
+				VirtualFree(placeholder + length, 0, MEM_RELEASE);
+				return nullptr;
+			}
+
+			return placeholder;
+		}
+
+		void RingBuffer::unmap(char* memory, size_t length) noexcept {
+			UnmapViewOfFile(memory);
+			UnmapViewOfFile(memory + length);
+		}
+	#else
+		size_t RingBuffer::granularity() noexcept {
+			return static_cast<size_t>(sysconf(_SC_PAGESIZE));
+		}
+
+		char* RingBuffer::map(size_t length) {
+			#ifdef __linux__
+				const int file = memfd_create("winlib-ring", MFD_CLOEXEC);
+			#else
+				// an anonymous shared memory object: the name is gone right after the open
+				char name[64];
+				std::snprintf(name, sizeof(name), "/winlib-ring-%ld-%p", static_cast<long>(getpid()), static_cast<void*>(&name));
+
+				const int file = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+
+				if (file != -1)
+					shm_unlink(name);
+			#endif
+
+			if (file == -1)
+				return nullptr;
+
+			void* memory = MAP_FAILED;
+
+			// reserves 2 * length, then maps the file over both halves
+			if (ftruncate(file, static_cast<off_t>(length)) == 0)
+				memory = mmap(nullptr, 2 * length, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+			if (memory != MAP_FAILED) {
+				char* base = static_cast<char*>(memory);
+
+				if (mmap(base, length, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, file, 0) == MAP_FAILED
+					|| mmap(base + length, length, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, file, 0) == MAP_FAILED) {
+					const int err = errno;
+					munmap(base, 2 * length);
+					errno = err;
+					memory = MAP_FAILED;
+				}
+			}
+
+			// the mappings keep the memory alive
+			const int err = errno;
+			close(file);
+			errno = err;
+
+			return memory == MAP_FAILED ? nullptr : static_cast<char*>(memory);
+		}
+
+		void RingBuffer::unmap(char* memory, size_t length) noexcept {
+			munmap(memory, 2 * length);
+		}
+	#endif
+}
\ No newline at end of file
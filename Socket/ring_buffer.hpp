@@ -0,0 +1,60 @@
+#ifndef WINDOWS_SOCKET_RING_BUFFER_HPP
+	#define WINDOWS_SOCKET_RING_BUFFER_HPP
+
+	#include "util.hpp"
+
+	// Receive buffer without a wrap around: the memory is mapped twice, one mapping right behind the other, so the
+	// readable bytes and the free room are always one contiguous range. A parser reads a frame in place even if it
+	// crosses the end of the buffer, and nothing is ever moved to the front.
+
+	namespace winLib {
+		constexpr size_t RING_CAPACITY = 65536;
+
+		class RingBuffer {
+		public:
+			// capacity is rounded up to the page size (the allocation granularity on Windows)
+			// throws std::system_error if the memory can't be mapped
+			explicit RingBuffer(size_t capacity = RING_CAPACITY);
+			RingBuffer(RingBuffer&& other) noexcept;
+			RingBuffer& operator=(RingBuffer&& other) noexcept;
+			~RingBuffer();
+
+			RingBuffer(const RingBuffer&) = delete;
+			RingBuffer& operator=(const RingBuffer&) = delete;
+
+			size_t capacity() const noexcept { return length; }
+			// readable bytes
+			size_t size() const noexcept { return count; }
+			bool empty() const noexcept { return count == 0; }
+			// writable bytes
+			size_t room() const noexcept { return length - count; }
+
+			// size() contiguous bytes
+			const char* data() const noexcept { return memory + head; }
+			// room() contiguous bytes, commit() makes them readable
+			char* write_position() noexcept { return memory + (head + count) % length; }
+
+			void commit(size_t written) noexcept;
+			void consume(size_t read) noexcept;
+			void clear() noexcept { head = count = 0; }
+
+			// grows to at least capacity and keeps the content, false on error
+			bool reserve(size_t capacity);
+
+			// one recv into the room: bytes received, 0 if the peer closed the connection (or there is no room)
+			// or SOCKET_ERROR
+			int receive(SOCKET sock);
+
+		private:
+			char* memory = nullptr;		// 2 * length bytes, the second half shows the first one
+			size_t length = 0;
+			size_t head = 0;			// < length
+			size_t count = 0;
+
+			// nullptr on error (the error code in errno / GetLastError())
+			static char* map(size_t length);
+			static void unmap(char* memory, size_t length) noexcept;
+			static size_t granularity() noexcept;
+		};
+	}
+#endif
\ No newline at end of file
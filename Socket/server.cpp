@@ -3,35 +3,78 @@
 namespace winLib {
 	ServerSocket::ServerSocket(LPCSTR port) : Socket(port) {}
 
-	int ServerSocket::create_socket() {
-		ZeroMemory(&hints, sizeof(hints));
-		hints.ai_family = AF_INET;
+	int ServerSocket::open_listener(int family) {
+		free_result();
+
+		hints = {};
+		hints.ai_family = family;
 		hints.ai_socktype = SOCK_STREAM;
 		hints.ai_protocol = IPPROTO_TCP;
 		hints.ai_flags = AI_PASSIVE;
 
 		// Resolve the local address and port to be used by the server
-		if (const int r = getaddrinfo(NULL, port, &hints, &result)) {
-			std::cout << "\nERROR: getaddrinfo failed: " << r << std::endl;
+		if (const int r = getaddrinfo(NULL, port, &hints, &result))
 			return r;
+
+		sock.reset(socket(result->ai_family, result->ai_socktype, result->ai_protocol));
+
+		if (!sock) {
+			const int err = last_socket_error();
+			free_result();
+			return err;
 		}
 
-		sock = socket(result->ai_family, result->ai_socktype, result->ai_protocol);
+		return 0;
+	}
+
+	int ServerSocket::create_socket() {
+		bool listening = false;
+
+		if (dual_stack && open_listener(AF_INET6) == 0) {
+			// off by default on Linux, on by default on Windows (and a sysctl elsewhere)
+			const int v6_only = 0;
+
+			if (setsockopt(sock.get(), IPPROTO_IPV6, IPV6_V6ONLY, reinterpret_cast<const char*>(&v6_only), sizeof(v6_only)) == SOCKET_ERROR) {
+				free_result();
+				sock.close();
+			}
+			else
+				listening = true;
+		}
 
-		if (sock == INVALID_SOCKET) {
-			std::cout << "\nERROR: socket failed: " << WSAGetLastError() << std::endl;
-			freeaddrinfo(result);
-			return WSAGetLastError();
+		// IPv4 only: not asked for dual stack or no IPv6 on this host
+		if (!listening) {
+			if (const int r = open_listener(AF_INET)) {
+				std::cout << "\nERROR: listening socket failed: " << r << std::endl;
+				return r;
+			}
 		}
 
+		#ifdef WINDOWS_SOCKET_POSIX
+			// a restarted server can bind again while old connections are in TIME_WAIT
+			// (not on Windows, there SO_REUSEADDR lets other processes steal the port)
+			const int reuse = 1;
+			setsockopt(sock.get(), SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+			#ifdef SO_REUSEPORT
+				if (reuse_port && setsockopt(sock.get(), SOL_SOCKET, SO_REUSEPORT, &reuse, sizeof(reuse)) == SOCKET_ERROR) {
+					const int err = last_socket_error();
+					std::cout << "\nERROR: SO_REUSEPORT failed: " << err << std::endl;
+					free_result();
+					sock.close();
+					return err;
+				}
+			#endif
+		#endif
+
 		return 0;
 	}
 
 	bool ServerSocket::bind_socket() {
-		if (bind(sock, result->ai_addr, (int)result->ai_addrlen) == SOCKET_ERROR) {
-			std::cout << "\nERROR: bind failed: " << WSAGetLastError() << std::endl;
-			freeaddrinfo(result);
-			closesocket(sock);
+		if (bind(sock.get(), result->ai_addr, static_cast<socklen_t>(result->ai_addrlen)) == SOCKET_ERROR) {
+			std::cout << "\nERROR: bind failed: " << last_socket_error() << std::endl;
+			free_result();
+			sock.close();
 			return false;
 		}
 
@@ -40,29 +83,27 @@ namespace winLib {
 		// The freeaddrinfo function is called to free the memory 
 		// allocated by the getaddrinfo function for this address
 		// information.
-		freeaddrinfo(result);
+		free_result();
 
 		return true;
 	}
 
 	int ServerSocket::listen_state() {
-		if (listen(sock, SOMAXCONN) == SOCKET_ERROR) {
-			std::cout << "\nERROR: listen failed: " << WSAGetLastError() << std::endl;
-			closesocket(sock);
-			shutdown(sock, SD_BOTH);
-			return WSAGetLastError();
+		if (listen(sock.get(), SOMAXCONN) == SOCKET_ERROR) {
+			const int err = last_socket_error();
+			std::cout << "\nERROR: listen failed: " << err << std::endl;
+			sock.close();
+			return err;
 		}
 
 		return 0;
 	}
 
-	SOCKET ServerSocket::accept_client() {
-		SOCKET client = INVALID_SOCKET;
+	SocketHandle ServerSocket::accept_client() {
+		SocketHandle client(accept(sock.get(), nullptr, nullptr));
 
-		if ((client = accept(sock, nullptr, nullptr) == INVALID_SOCKET)) {
-			std::cout << "\nERROR: accept failed: " << WSAGetLastError() << std::endl;
-			return INVALID_SOCKET;
-		}
+		if (!client)
+			std::cout << "\nERROR: accept failed: " << last_socket_error() << std::endl;
 
 		return client;
 	}
@@ -70,8 +111,8 @@ namespace winLib {
 	int ServerSocket::send_data(char* data, int length) {
 		int bytes_sent;
 
-		if ((bytes_sent = send(sock, data, length, 0)) == SOCKET_ERROR) {
-			std::cout << "\nERROR: send failed: " << WSAGetLastError() << std::endl;
+		if ((bytes_sent = static_cast<int>(send(sock.get(), data, length, SEND_FLAGS))) == SOCKET_ERROR) {
+			std::cout << "\nERROR: send failed: " << last_socket_error() << std::endl;
 			return SOCKET_ERROR;
 		}
 
@@ -81,8 +122,8 @@ namespace winLib {
 	int ServerSocket::receive_data(char* buffer, int length) {
 		int bytes_recv;
 
-		if ((bytes_recv = recv(sock, buffer, length, 0)) == SOCKET_ERROR) {
-			std::cout << "\nERROR: recive failed: " << WSAGetLastError() << std::endl;
+		if ((bytes_recv = static_cast<int>(recv(sock.get(), buffer, length, 0))) == SOCKET_ERROR) {
+			std::cout << "\nERROR: recive failed: " << last_socket_error() << std::endl;
 			return SOCKET_ERROR;
 		}
 
@@ -90,9 +131,9 @@ namespace winLib {
 	}
 
 	bool ServerSocket::stop() {
-		if (shutdown(sock, SD_SEND) == SOCKET_ERROR) {
-			std::cout << "\nERROR: shutdown failed: " << WSAGetLastError() << std::endl;
-			closesocket(sock);
+		if (shutdown(sock.get(), SD_SEND) == SOCKET_ERROR) {
+			std::cout << "\nERROR: shutdown failed: " << last_socket_error() << std::endl;
+			sock.close();
 			return false;
 		}
 
@@ -100,8 +141,6 @@ namespace winLib {
 	}
 
 	bool ServerSocket::disconnect() {
-		if (closesocket(sock) == SOCKET_ERROR)
-			return WSAGetLastError();
-		return 0;
+		return sock.close();
 	}
 }
\ No newline at end of file
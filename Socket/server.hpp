@@ -3,22 +3,31 @@
 
 	#include "socket.hpp"
 
-	// TODO:
-	// https://learn.microsoft.com/en-us/windows/win32/api/winsock2/nf-winsock2-select
+	// Blocking, one client at a time. EventServer (event_server.hpp) serves many connections on one thread.
 
 	namespace winLib {
 		class ServerSocket : public Socket {
 		public:
+			// SO_REUSEPORT (POSIX): several sockets listen on the same port and the kernel spreads the connections
+			bool reuse_port = false;
+			// one IPv6 socket that accepts IPv4 clients as well (as ::ffff:a.b.c.d), IPv4 only if the host has no IPv6
+			bool dual_stack = true;
+
 			ServerSocket(LPCSTR port = DEFAULT_PORT);
 
 			int create_socket() override;
 			bool bind_socket();
 			int listen_state();
-			SOCKET accept_client();
+			// invalid handle on error
+			SocketHandle accept_client();
 			int send_data(char* data, int length) override;
 			int receive_data(char* buffer, int length = DEFAULT_BUFLEN) override;
 			bool stop() override;
 			bool disconnect() override;
+
+		private:
+			// getaddrinfo and socket for family, 0 or the error code (not printed)
+			int open_listener(int family);
 		};
 	}
 #endif
\ No newline at end of file
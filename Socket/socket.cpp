@@ -1,23 +1,77 @@
 #include "socket.hpp"
 
+#include <algorithm>
+
 namespace winLib {
 	Socket::Socket(PCSTR port) {
 		this->port = port;
-		this->sock = INVALID_SOCKET;
-
-		if (const int error = initialize_winsock())
-			throw std::system_error(error, std::system_category());
 	}
 
 	Socket::~Socket() {
-		WSACleanup();
+		free_result();
 	}
 
-	int Socket::initialize_winsock() {
-		if (const int result = WSAStartup(WINSOCK_VERSION, &wsa_data)) {
-			std::cout << "\nERROR: WSAStartup failed: " << result << std::endl;
-			return result;
+	void Socket::free_result() noexcept {
+		if (result)
+			freeaddrinfo(result);
+
+		result = nullptr;
+		ptr = nullptr;
+	}
+
+	int Socket::send_all(const char* data, size_t length) {
+		size_t sent = 0;
+
+		while (sent < length) {
+			const int r = static_cast<int>(send(sock.get(), data + sent, static_cast<int>(std::min<size_t>(length - sent, 0x7FFFFFFF)), SEND_FLAGS));
+
+			if (r == SOCKET_ERROR) {
+				std::cout << "\nERROR: send failed: " << last_socket_error() << std::endl;
+				return SOCKET_ERROR;
+			}
+
+			sent += static_cast<size_t>(r);
 		}
+
 		return 0;
 	}
+
+	int Socket::recv_exact(char* buffer, size_t length) {
+		size_t received = 0;
+
+		// MSG_WAITALL: the kernel waits for all of it, another round only follows an interruption
+		while (received < length) {
+			const int r = static_cast<int>(recv(sock.get(), buffer + received, static_cast<int>(std::min<size_t>(length - received, 0x7FFFFFFF)), MSG_WAITALL));
+
+			if (r == SOCKET_ERROR) {
+				std::cout << "\nERROR: recive failed: " << last_socket_error() << std::endl;
+				return SOCKET_ERROR;
+			}
+
+			if (r == 0)
+				return 0;
+
+			received += static_cast<size_t>(r);
+		}
+
+		return 1;
+	}
+
+	int Socket::send_chain(BufferChain& chain) {
+		const int bytes_sent = winLib::send_chain(sock.get(), chain);
+
+		if (bytes_sent == SOCKET_ERROR)
+			std::cout << "\nERROR: send failed: " << last_socket_error() << std::endl;
+
+		return bytes_sent;
+	}
+
+	int Socket::receive_chain(BufferChain& chain, size_t length) {
+		const int bytes_recv = winLib::receive_chain(sock.get(), chain, length);
+
+		if (bytes_recv == SOCKET_ERROR)
+			std::cout << "\nERROR: recive failed: " << last_socket_error() << std::endl;
+
+		return bytes_recv;
+	}
 }
\ No newline at end of file
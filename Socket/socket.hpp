@@ -4,27 +4,40 @@
 	// https://learn.microsoft.com/de-de/windows/win32/winsock/getting-started-with-winsock
 
 	#include "util.hpp"
+	#include "platform.hpp"
+	#include "buffer.hpp"
 
 	namespace winLib {
 		class Socket {
 		public:
-			WSADATA   wsa_data;
-			SOCKET    sock;
+			NetworkGuard network;	// first member: alive as long as the socket
+			SocketHandle sock;
 			addrinfo* result = nullptr;
 			addrinfo* ptr = nullptr;
 			addrinfo  hints{};
 			PCSTR     port;
 
 			Socket(PCSTR port = DEFAULT_PORT);
-			~Socket();
+			virtual ~Socket();
 
-			int initialize_winsock();
+			// frees the getaddrinfo result (if any)
+			void free_result() noexcept;
 
 			virtual int create_socket() null_method;
 			virtual int send_data(char* data, int length) null_method;
 			virtual int receive_data(char* buffer, int length = DEFAULT_BUFLEN) null_method;
 			virtual bool stop() null_method;
 			virtual bool disconnect() null_method;
+
+			// sends until all of data is sent (a blocking socket), 0 or SOCKET_ERROR (length may not fit into an int)
+			int send_all(const char* data, size_t length);
+			// receives until buffer is full: 1, 0 if the peer closed the connection before or SOCKET_ERROR
+			int recv_exact(char* buffer, size_t length);
+
+			// all slices of chain with one call, the sent bytes are consumed. Bytes sent or SOCKET_ERROR
+			int send_chain(BufferChain& chain);
+			// appends up to length received bytes to chain (in pooled slabs). Bytes received or SOCKET_ERROR
+			int receive_chain(BufferChain& chain, size_t length = SLAB_SIZE);
 		};
 	}
 #endif
\ No newline at end of file
@@ -0,0 +1,800 @@
+#include "uring_server.hpp"
+
+#ifdef WINDOWS_SOCKET_IO_URING
+#include <linux/io_uring.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+
+#include <algorithm>
+#include <csignal>
+#include <cstring>
+#include <system_error>
+
+namespace winLib {
+	// the kind of a request in the upper 32 bits of its user_data, the descriptor in the lower ones
+	enum UringRequest : unsigned long long {
+		URING_ACCEPT  = 1,
+		URING_RECV    = 2,
+		URING_SEND    = 3,
+		URING_WAKE    = 4,
+		URING_CANCEL  = 5
+	};
+
+	constexpr unsigned short RECV_GROUP = 0;
+	// registered files at most (and the file limit of the process)
+	constexpr unsigned int MAX_FILE_SLOTS = 65536;
+
+	static unsigned long long request_data(UringRequest request, SOCKET fd) noexcept {
+		return static_cast<unsigned long long>(request) << 32 | static_cast<unsigned int>(fd);
+	}
+
+	template <class T>
+	static T load_acquire(const T* value) noexcept {
+		return __atomic_load_n(value, __ATOMIC_ACQUIRE);
+	}
+
+	template <class T>
+	static void store_release(T* value, T v) noexcept {
+		__atomic_store_n(value, v, __ATOMIC_RELEASE);
+	}
+
+	static int uring_setup(unsigned int entries, io_uring_params* params) noexcept {
+		return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+	}
+
+	static int uring_enter(int fd, unsigned int submit, unsigned int wait, unsigned int flags, const void* arg, size_t size) noexcept {
+		return static_cast<int>(syscall(__NR_io_uring_enter, fd, submit, wait, flags, arg, size));
+	}
+
+	static int uring_register(int fd, unsigned int opcode, const void* arg, unsigned int count) noexcept {
+		return static_cast<int>(syscall(__NR_io_uring_register, fd, opcode, arg, count));
+	}
+
+	// populated, the kernel uses the buffers from the first request on
+	static void* map_memory(size_t size) noexcept {
+		void* memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE, -1, 0);
+		return memory == MAP_FAILED ? nullptr : memory;
+	}
+
+	// The rings shared with the kernel and the buffer memory.
+	struct UringRing {
+		int fd = -1;
+
+		unsigned char* ring_memory = nullptr;
+		size_t ring_size = 0;
+		io_uring_sqe* sqes = nullptr;
+		size_t sqes_size = 0;
+
+		unsigned int* sq_head = nullptr;
+		unsigned int* sq_tail = nullptr;
+		unsigned int sq_mask = 0, sq_entries = 0;
+		unsigned int sq_local_tail = 0;		// prepared, published with the next enter
+
+		unsigned int* cq_head = nullptr;
+		unsigned int* cq_tail = nullptr;
+		unsigned int cq_mask = 0;
+		io_uring_cqe* cqes = nullptr;
+
+		// provided buffers of the receives, given back through the buffer ring
+		io_uring_buf_ring* buffer_ring = nullptr;
+		size_t buffer_ring_size = 0;
+		unsigned short buffer_tail = 0, buffer_mask = 0;
+		unsigned char* recv_memory = nullptr;
+		size_t recv_memory_size = 0;
+		unsigned int recv_buffer_size = 0;
+
+		// registered buffers of the sends
+		unsigned char* send_memory = nullptr;
+		size_t send_memory_size = 0;
+		unsigned int send_buffer_size = 0;
+		bool fixed_buffers = false;
+
+		unsigned int file_slots = 0;
+		// submitted requests without their last completion, the memory above is in use until it is 0
+		unsigned int in_flight = 0;
+
+		unsigned long long wake_value = 0;
+		SocketHandle wake_handle;
+
+		~UringRing() {
+			if (fd != -1)
+				close(fd);
+
+			// after the ring, the kernel might still use them until then
+			if (ring_memory)   munmap(ring_memory, ring_size);
+			if (sqes)          munmap(sqes, sqes_size);
+			if (buffer_ring)   munmap(buffer_ring, buffer_ring_size);
+			if (recv_memory)   munmap(recv_memory, recv_memory_size);
+			if (send_memory)   munmap(send_memory, send_memory_size);
+		}
+
+		// 0 or the error code
+		int init(const UringConfig& config) {
+			io_uring_params params{};
+			params.flags = IORING_SETUP_CQSIZE | IORING_SETUP_SUBMIT_ALL | IORING_SETUP_COOP_TASKRUN;
+			params.cq_entries = config.ring_entries * 2;
+
+			fd = uring_setup(config.ring_entries, &params);
+
+			// older kernel, without the optional flags
+			if (fd < 0 && errno == EINVAL) {
+				params = {};
+				params.flags = IORING_SETUP_CQSIZE;
+				params.cq_entries = config.ring_entries * 2;
+
+				fd = uring_setup(config.ring_entries, &params);
+			}
+
+			if (fd < 0)
+				return errno;
+
+			if (!(params.features & IORING_FEAT_SINGLE_MMAP) || !(params.features & IORING_FEAT_EXT_ARG) || !(params.features & IORING_FEAT_NODROP))
+				return ENOSYS;
+
+			if (!supports_operations())
+				return ENOSYS;
+
+			ring_size = std::max(params.sq_off.array + params.sq_entries * sizeof(unsigned int), params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe));
+			void* rings = mmap(nullptr, ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+
+			if (rings == MAP_FAILED)
+				return errno;
+
+			ring_memory = static_cast<unsigned char*>(rings);
+
+			sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+			void* entries = mmap(nullptr, sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+
+			if (entries == MAP_FAILED)
+				return errno;
+
+			sqes = static_cast<io_uring_sqe*>(entries);
+
+			sq_head    = reinterpret_cast<unsigned int*>(ring_memory + params.sq_off.head);
+			sq_tail    = reinterpret_cast<unsigned int*>(ring_memory + params.sq_off.tail);
+			sq_mask    = *reinterpret_cast<unsigned int*>(ring_memory + params.sq_off.ring_mask);
+			sq_entries = params.sq_entries;
+			sq_local_tail = *sq_tail;
+
+			// the entry i of the submission queue is always sqes[i]
+			unsigned int* sq_array = reinterpret_cast<unsigned int*>(ring_memory + params.sq_off.array);
+			for (unsigned int i = 0; i < sq_entries; i++)
+				sq_array[i] = i;
+
+			cq_head = reinterpret_cast<unsigned int*>(ring_memory + params.cq_off.head);
+			cq_tail = reinterpret_cast<unsigned int*>(ring_memory + params.cq_off.tail);
+			cq_mask = *reinterpret_cast<unsigned int*>(ring_memory + params.cq_off.ring_mask);
+			cqes    = reinterpret_cast<io_uring_cqe*>(ring_memory + params.cq_off.cqes);
+
+			if (const int r = init_recv_buffers(config))
+				return r;
+
+			if (const int r = init_send_buffers(config))
+				return r;
+
+			init_files();
+
+			wake_handle.reset(eventfd(0, EFD_CLOEXEC));
+
+			if (!wake_handle)
+				return errno;
+
+			return 0;
+		}
+
+		int init_recv_buffers(const UringConfig& config) {
+			if (config.recv_buffers == 0 || config.recv_buffers > 32768 || (config.recv_buffers & (config.recv_buffers - 1)))
+				return EINVAL;
+
+			buffer_ring_size = config.recv_buffers * sizeof(io_uring_buf);
+			buffer_ring = static_cast<io_uring_buf_ring*>(map_memory(buffer_ring_size));
+
+			recv_buffer_size = config.recv_buffer_size;
+			recv_memory_size = static_cast<size_t>(config.recv_buffers) * recv_buffer_size;
+			recv_memory = static_cast<unsigned char*>(map_memory(recv_memory_size));
+
+			if (!buffer_ring || !recv_memory)
+				return ENOMEM;
+
+			io_uring_buf_reg reg{};
+			reg.ring_addr = reinterpret_cast<unsigned long long>(buffer_ring);
+			reg.ring_entries = config.recv_buffers;
+			reg.bgid = RECV_GROUP;
+
+			if (uring_register(fd, IORING_REGISTER_PBUF_RING, &reg, 1) < 0)
+				return errno;
+
+			buffer_mask = static_cast<unsigned short>(config.recv_buffers - 1);
+
+			for (unsigned int i = 0; i < config.recv_buffers; i++)
+				recycle(static_cast<unsigned short>(i));
+
+			return 0;
+		}
+
+		// every operation of the server, IORING_OP_SEND_ZC came with 6.0 like the multishot recv (which has no
+		// opcode of its own, an older kernel takes the flag and completes the recv only once)
+		bool supports_operations() {
+			constexpr unsigned char needed[] = {
+				IORING_OP_ACCEPT, IORING_OP_RECV, IORING_OP_SEND, IORING_OP_READ, IORING_OP_ASYNC_CANCEL, IORING_OP_SEND_ZC
+			};
+
+			std::vector<unsigned char> memory(sizeof(io_uring_probe) + IORING_OP_LAST * sizeof(io_uring_probe_op));
+			io_uring_probe* probe = reinterpret_cast<io_uring_probe*>(memory.data());
+
+			if (uring_register(fd, IORING_REGISTER_PROBE, probe, IORING_OP_LAST) < 0)
+				return false;
+
+			for (const unsigned char op : needed) {
+				if (op > probe->last_op || !(probe->ops[op].flags & IO_URING_OP_SUPPORTED))
+					return false;
+			}
+
+			return true;
+		}
+
+		int init_send_buffers(const UringConfig& config) {
+			send_buffer_size = config.send_buffer_size;
+			send_memory_size = static_cast<size_t>(config.send_buffers) * send_buffer_size;
+			send_memory = static_cast<unsigned char*>(map_memory(send_memory_size));
+
+			if (!send_memory)
+				return ENOMEM;
+
+			std::vector<iovec> buffers(config.send_buffers);
+
+			for (unsigned int i = 0; i < config.send_buffers; i++)
+				buffers[i] = { send_memory + static_cast<size_t>(i) * send_buffer_size, send_buffer_size };
+
+			// pinned memory counts against RLIMIT_MEMLOCK, the sends work without the registration as well
+			fixed_buffers = uring_register(fd, IORING_REGISTER_BUFFERS, buffers.data(), config.send_buffers) == 0;
+
+			if (!fixed_buffers)
+				std::cout << "\nWARNING: io_uring buffer registration failed: " << errno << std::endl;
+
+			return 0;
+		}
+
+		void init_files() {
+			rlimit limit{};
+			getrlimit(RLIMIT_NOFILE, &limit);
+
+			const unsigned int slots = static_cast<unsigned int>(std::min<rlim_t>(limit.rlim_cur, MAX_FILE_SLOTS));
+
+			// sparse: every slot is empty until a connection is registered
+			const std::vector<int> empty(slots, -1);
+
+			if (uring_register(fd, IORING_REGISTER_FILES, empty.data(), slots) == 0)
+				file_slots = slots;
+		}
+
+		// false if the slot is not available, the descriptor is used directly then
+		bool register_file(SOCKET sock) noexcept {
+			if (static_cast<unsigned int>(sock) >= file_slots)
+				return false;
+
+			io_uring_files_update update{};
+			update.offset = static_cast<unsigned int>(sock);
+			update.fds = reinterpret_cast<unsigned long long>(&sock);
+
+			return uring_register(fd, IORING_REGISTER_FILES_UPDATE, &update, 1) == 1;
+		}
+
+		void unregister_file(SOCKET sock) noexcept {
+			const int empty = -1;
+
+			io_uring_files_update update{};
+			update.offset = static_cast<unsigned int>(sock);
+			update.fds = reinterpret_cast<unsigned long long>(&empty);
+
+			uring_register(fd, IORING_REGISTER_FILES_UPDATE, &update, 1);
+		}
+
+		// gives a provided buffer back to the kernel
+		void recycle(unsigned short id) {
+			// the ring is an array of io_uring_buf, not buffer_ring->bufs: in C++ the empty struct in front of the
+			// flexible array (__DECLARE_FLEX_ARRAY) moves it 8 bytes past the ring the kernel reads
+			io_uring_buf* buffer = reinterpret_cast<io_uring_buf*>(buffer_ring) + (buffer_tail & buffer_mask);
+
+			buffer->addr = reinterpret_cast<unsigned long long>(recv_memory + static_cast<size_t>(id) * recv_buffer_size);
+			buffer->len = recv_buffer_size;
+			buffer->bid = id;
+
+			buffer_tail++;
+			store_release(&buffer_ring->tail, buffer_tail);
+		}
+
+		// submits what's queued if the queue is full, nullptr if that didn't make room
+		io_uring_sqe* get_sqe() noexcept {
+			if (sq_local_tail - load_acquire(sq_head) >= sq_entries) {
+				enter(0, 0);
+
+				if (sq_local_tail - load_acquire(sq_head) >= sq_entries)
+					return nullptr;
+			}
+
+			io_uring_sqe* sqe = &sqes[sq_local_tail & sq_mask];
+			std::memset(sqe, 0, sizeof(*sqe));
+			sq_local_tail++;
+
+			return sqe;
+		}
+
+		io_uring_sqe* prepare(unsigned char opcode, SOCKET sock, bool fixed_file, unsigned long long data) noexcept {
+			io_uring_sqe* sqe = get_sqe();
+
+			if (!sqe)
+				return nullptr;
+
+			sqe->opcode = opcode;
+			sqe->fd = sock;
+			sqe->user_data = data;
+
+			in_flight++;
+
+			if (fixed_file)
+				sqe->flags |= IOSQE_FIXED_FILE;
+
+			return sqe;
+		}
+
+		// submits everything prepared and waits for wait completions (up to timeout_ms, -1: no timeout)
+		bool enter(unsigned int wait, int timeout_ms) noexcept {
+			store_release(sq_tail, sq_local_tail);
+
+			const unsigned int submit = sq_local_tail - load_acquire(sq_head);
+
+			if (submit == 0 && wait == 0)
+				return true;
+
+			int result;
+
+			if (wait > 0 && timeout_ms >= 0) {
+				__kernel_timespec timeout{};
+				timeout.tv_sec = timeout_ms / 1000;
+				timeout.tv_nsec = static_cast<long long>(timeout_ms % 1000) * 1000000;
+
+				io_uring_getevents_arg arg{};
+				arg.ts = reinterpret_cast<unsigned long long>(&timeout);
+
+				result = uring_enter(fd, submit, wait, IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG, &arg, sizeof(arg));
+			} else
+				result = uring_enter(fd, submit, wait, wait > 0 ? IORING_ENTER_GETEVENTS : 0, nullptr, 0);
+
+			if (result < 0 && errno != ETIME && errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+				std::cout << "\nERROR: io_uring_enter failed: " << errno << std::endl;
+				return false;
+			}
+
+			return true;
+		}
+	};
+
+	UringServer::UringServer(ConnectionHandlers handlers, PCSTR port, const UringConfig& config) : ConnectionServer(std::move(handlers), port), quit_requested(false) {
+		this->config = config;
+		this->accept_armed = false;
+		this->fixed_sends = true;
+		this->draining = false;
+	}
+
+	UringServer::~UringServer() {
+		stop();
+
+		if (!ring)
+			return;
+
+		// nothing new is armed, everything in flight is cancelled (the wake read, the receives) and the buffers
+		// and slots are freed only after the kernel completed the last request
+		draining = true;
+
+		if (io_uring_sqe* sqe = ring->prepare(IORING_OP_ASYNC_CANCEL, -1, false, request_data(URING_CANCEL, 0)))
+			sqe->cancel_flags = IORING_ASYNC_CANCEL_ANY;
+
+		while (ring->in_flight > 0) {
+			if (run_once() == -1)
+				break;
+		}
+	}
+
+	int UringServer::start() {
+		if (ring)
+			return 0;
+
+		auto new_ring = std::make_unique<UringRing>();
+
+		if (const int r = new_ring->init(config)) {
+			std::cout << "\nERROR: io_uring setup failed: " << r << std::endl;
+			return r;
+		}
+
+		if (const int r = open_listener())
+			return r;
+
+		ring = std::move(new_ring);
+
+		free_send_buffers.clear();
+		for (int i = static_cast<int>(config.send_buffers) - 1; i >= 0; i--)
+			free_send_buffers.push_back(i);
+
+		arm_accept();
+		arm_wake();
+
+		return ring->enter(0, 0) ? 0 : -1;
+	}
+
+	void UringServer::stop() noexcept {
+		if (listener.sock) {
+			// ends the multishot accept
+			shutdown(listener.sock.get(), SHUT_RDWR);
+			listener.sock.close();
+		}
+
+		for (Slot& slot : slots) {
+			if (slot.connection)
+				close_connection(slot.connection.get());
+		}
+	}
+
+	void UringServer::run() {
+		while (!quit_requested.exchange(false)) {
+			if (run_once() == -1)
+				break;
+		}
+	}
+
+	void UringServer::quit() noexcept {
+		quit_requested = true;
+
+		if (ring) {
+			const unsigned long long one = 1;
+
+			if (write(ring->wake_handle.get(), &one, sizeof(one)) == -1) {
+				// the counter is full: the loop is going to wake up anyway
+			}
+		}
+	}
+
+	int UringServer::run_once(int timeout_ms) {
+		if (!ring)
+			return -1;
+
+		closed.clear();
+
+		for (const SOCKET fd : rearm_recv) {
+			Slot& slot = slots[fd];
+
+			if (slot.connection && !slot.closing && !slot.recv_armed)
+				arm_recv(fd);
+		}
+
+		rearm_recv.clear();
+
+		submit_sends();
+
+		if (!ring->enter(1, timeout_ms))
+			return -1;
+
+		int count = 0;
+		unsigned int head = *ring->cq_head;
+
+		while (head != load_acquire(ring->cq_tail)) {
+			const io_uring_cqe cqe = ring->cqes[head & ring->cq_mask];
+
+			// the handlers below may submit new requests, the slot is free again
+			store_release(ring->cq_head, ++head);
+			count++;
+
+			if (!(cqe.flags & IORING_CQE_F_MORE))
+				ring->in_flight--;
+
+			const SOCKET fd = static_cast<SOCKET>(cqe.user_data & 0xFFFFFFFF);
+
+			switch (cqe.user_data >> 32) {
+			case URING_ACCEPT:
+				accepted(cqe.res, cqe.flags);
+				break;
+			case URING_RECV:
+				received(fd, cqe.res, cqe.flags);
+				break;
+			case URING_SEND:
+				sent(fd, cqe.res);
+				break;
+			case URING_WAKE:
+				arm_wake();
+				break;
+			}
+		}
+
+		return count;
+	}
+
+	bool UringServer::send_connection(Connection& connection, const char* data, size_t length) {
+		const SOCKET fd = connection.sock.get();
+		Slot& slot = slots[fd];
+
+		if (!queue_output(connection, data, length))
+			return false;
+
+		// the completion of a send in flight queues the rest
+		if (!slot.send_queued && slot.send_buffer < 0) {
+			slot.send_queued = true;
+			pending_sends.push_back(fd);
+		}
+
+		return true;
+	}
+
+	void UringServer::close_connection(Connection* connection) noexcept {
+		const SOCKET fd = connection->sock.get();
+
+		if (fd == INVALID_SOCKET || slots[fd].closing)
+			return;
+
+		request_close(*connection);
+
+		// its handler is running, the caller of the handler closes it when it returns (like EventServer)
+		if (connection == dispatching)
+			return;
+
+		Slot& slot = slots[fd];
+
+		slot.closing = true;
+
+		if (handlers.on_close)
+			handlers.on_close(*connection);
+
+		// completes the multishot recv and the send in flight
+		shutdown(fd, SHUT_RDWR);
+		connection_count.fetch_sub(1, std::memory_order_relaxed);
+
+		release(fd);
+	}
+
+	void UringServer::release(SOCKET fd) noexcept {
+		Slot& slot = slots[fd];
+
+		if (!slot.connection || !slot.closing || slot.recv_armed || slot.send_buffer >= 0)
+			return;
+
+		if (slot.fixed_file)
+			ring->unregister_file(fd);
+
+		slot.connection->sock.close();
+		closed.push_back(std::move(slot.connection));
+		slot = {};
+	}
+
+	void UringServer::arm_accept() {
+		if (!listener.sock || draining)
+			return;
+
+		if (io_uring_sqe* sqe = ring->prepare(IORING_OP_ACCEPT, listener.sock.get(), false, request_data(URING_ACCEPT, 0))) {
+			sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+			sqe->accept_flags = SOCK_CLOEXEC;
+			accept_armed = true;
+		}
+	}
+
+	void UringServer::arm_recv(SOCKET fd) {
+		Slot& slot = slots[fd];
+
+		if (draining)
+			return;
+
+		if (io_uring_sqe* sqe = ring->prepare(IORING_OP_RECV, fd, slot.fixed_file, request_data(URING_RECV, fd))) {
+			sqe->ioprio = IORING_RECV_MULTISHOT;
+			sqe->flags |= IOSQE_BUFFER_SELECT;
+			sqe->buf_group = RECV_GROUP;
+			slot.recv_armed = true;
+		} else
+			rearm_recv.push_back(fd);
+	}
+
+	void UringServer::arm_wake() {
+		if (draining)
+			return;
+
+		if (io_uring_sqe* sqe = ring->prepare(IORING_OP_READ, ring->wake_handle.get(), false, request_data(URING_WAKE, 0))) {
+			sqe->addr = reinterpret_cast<unsigned long long>(&ring->wake_value);
+			sqe->len = sizeof(ring->wake_value);
+		}
+	}
+
+	void UringServer::submit_sends() {
+		size_t waiting = 0;
+
+		for (size_t i = 0; i < pending_sends.size(); i++) {
+			const SOCKET fd = pending_sends[i];
+			Slot& slot = slots[fd];
+
+			slot.send_queued = false;
+
+			if (!slot.connection || slot.closing || slot.send_buffer >= 0 || slot.connection->output.empty())
+				continue;
+
+			// all send buffers are in flight, the next completion frees one
+			if (!start_send(fd)) {
+				slot.send_queued = true;
+				pending_sends[waiting++] = fd;
+			}
+		}
+
+		pending_sends.resize(waiting);
+	}
+
+	bool UringServer::start_send(SOCKET fd) {
+		if (free_send_buffers.empty())
+			return false;
+
+		Slot& slot = slots[fd];
+		std::vector<char>& output = slot.connection->output;
+
+		const int buffer = free_send_buffers.back();
+		free_send_buffers.pop_back();
+
+		// many small sends of one iteration leave in one request
+		const size_t length = std::min<size_t>(output.size(), ring->send_buffer_size);
+		std::memcpy(ring->send_memory + static_cast<size_t>(buffer) * ring->send_buffer_size, output.data(), length);
+		output.erase(output.begin(), output.begin() + static_cast<std::ptrdiff_t>(length));
+
+		slot.send_buffer = buffer;
+		slot.send_offset = 0;
+		slot.send_length = static_cast<unsigned int>(length);
+
+		submit_send(fd);
+
+		if (slot.connection && !slot.closing)
+			output_sent(*slot.connection);
+
+		return true;
+	}
+
+	void UringServer::submit_send(SOCKET fd) {
+		Slot& slot = slots[fd];
+		unsigned char* data = ring->send_memory + static_cast<size_t>(slot.send_buffer) * ring->send_buffer_size + slot.send_offset;
+
+		io_uring_sqe* sqe = ring->prepare(IORING_OP_SEND, fd, slot.fixed_file, request_data(URING_SEND, fd));
+
+		// the queue is full even after a submit, the connection can't continue
+		if (!sqe) {
+			free_send_buffers.push_back(slot.send_buffer);
+			slot.send_buffer = -1;
+			close_connection(slot.connection.get());
+			return;
+		}
+
+		sqe->addr = reinterpret_cast<unsigned long long>(data);
+		sqe->len = slot.send_length;
+		sqe->msg_flags = MSG_NOSIGNAL;
+
+		slot.send_fixed = fixed_sends && ring->fixed_buffers;
+
+		if (slot.send_fixed) {
+			sqe->ioprio = IORING_RECVSEND_FIXED_BUF;
+			sqe->buf_index = static_cast<unsigned short>(slot.send_buffer);
+		}
+	}
+
+	void UringServer::accepted(int result, unsigned int flags) {
+		if (!(flags & IORING_CQE_F_MORE))
+			accept_armed = false;
+
+		// accepted before stop() shut the listener down
+		if (result >= 0 && !listener.sock) {
+			close(result);
+			return;
+		}
+
+		if (result >= 0) {
+			const SOCKET fd = result;
+
+			if (static_cast<size_t>(fd) >= slots.size())
+				slots.resize(static_cast<size_t>(fd) + 1);
+
+			Slot& slot = slots[fd];
+
+			apply_send_options(fd);
+
+			slot = {};
+			slot.connection = std::make_unique<Connection>(this, SocketHandle(fd));
+			slot.fixed_file = ring->register_file(fd);
+
+			connection_count.fetch_add(1, std::memory_order_relaxed);
+
+			arm_recv(fd);
+
+			Connection* connection = slot.connection.get();
+
+			dispatch(handlers.on_open, connection);
+
+			if (close_requested(*connection))
+				close_connection(connection);
+		} else if (result != -ECANCELED && result != -EINVAL)
+			std::cout << "\nERROR: accept failed: " << -result << std::endl;
+
+		if (!accept_armed)
+			arm_accept();
+	}
+
+	void UringServer::received(SOCKET fd, int result, unsigned int flags) {
+		Slot& slot = slots[fd];
+
+		if (!(flags & IORING_CQE_F_MORE))
+			slot.recv_armed = false;
+
+		Connection* connection = slot.connection.get();
+		const bool alive = connection && !slot.closing;
+
+		if (flags & IORING_CQE_F_BUFFER) {
+			const unsigned short id = static_cast<unsigned short>(flags >> IORING_CQE_BUFFER_SHIFT);
+			const char* data = reinterpret_cast<const char*>(ring->recv_memory + static_cast<size_t>(id) * ring->recv_buffer_size);
+
+			if (alive && result > 0)
+				connection->input.append(data, static_cast<size_t>(result));
+
+			ring->recycle(id);
+		}
+
+		if (alive) {
+			if (result > 0) {
+				dispatch(handlers.on_data, connection);
+
+				if (close_requested(*connection))
+					close_connection(connection);
+				else if (!slot.recv_armed)
+					arm_recv(fd);
+			} else if (result == -ENOBUFS) {
+				// all provided buffers are in use, armed again with the next iteration
+				rearm_recv.push_back(fd);
+			} else {
+				// closed by the peer (0) or failed
+				close_connection(connection);
+			}
+		}
+
+		release(fd);
+	}
+
+	void UringServer::sent(SOCKET fd, int result) {
+		Slot& slot = slots[fd];
+
+		// the kernel doesn't take fixed buffers for plain sends (before 6.10), the same memory works without
+		// (every fixed send that was in flight when the first one failed is sent again)
+		if (result == -EINVAL && slot.send_fixed && !slot.closing) {
+			fixed_sends = false;
+			submit_send(fd);
+			return;
+		}
+
+		if (result > 0 && !slot.closing && static_cast<unsigned int>(result) < slot.send_length) {
+			slot.send_offset += static_cast<unsigned int>(result);
+			slot.send_length -= static_cast<unsigned int>(result);
+			submit_send(fd);
+			return;
+		}
+
+		free_send_buffers.push_back(slot.send_buffer);
+		slot.send_buffer = -1;
+
+		Connection* connection = slot.connection.get();
+
+		if (connection && !slot.closing) {
+			if (result < 0)
+				close_connection(connection);
+			else if (!connection->output.empty()) {
+				slot.send_queued = true;
+				pending_sends.push_back(fd);
+			} else {
+				dispatch(handlers.on_writable, connection);
+
+				if (close_requested(*connection))
+					close_connection(connection);
+			}
+		}
+
+		release(fd);
+	}
+}
+#endif
\ No newline at end of file
@@ -0,0 +1,93 @@
+#ifndef WINDOWS_SOCKET_URING_SERVER_HPP
+	#define WINDOWS_SOCKET_URING_SERVER_HPP
+
+	#include "connection.hpp"
+
+	#ifdef WINDOWS_SOCKET_IO_URING
+		#include <memory>
+
+		// Completion based server on io_uring (Linux 6.0 or newer), with the same Connection API as EventServer.
+		//  - one multishot accept for all new connections
+		//  - one multishot recv per connection, into a ring of provided buffers (no buffer per connection)
+		//  - the accepted sockets are registered files and the sends come from registered (fixed) buffers
+		//  - Connection::send_data only queues, all queued sends go to the kernel with the wait of the next iteration
+		// In the steady state one io_uring_enter call per iteration submits every send and reaps every completion.
+
+		namespace winLib {
+			struct UringRing;
+
+			struct UringConfig {
+				unsigned int ring_entries = 4096;		// submission queue, the completion queue is twice as big
+				unsigned int recv_buffers = 4096;		// provided buffers, a power of 2
+				unsigned int recv_buffer_size = 4096;
+				unsigned int send_buffers = 1024;		// registered buffers, a connection holds one while a send is in flight
+				unsigned int send_buffer_size = 16384;
+			};
+
+			class UringServer : public ConnectionServer {
+			public:
+				UringServer(ConnectionHandlers handlers, PCSTR port = DEFAULT_PORT, const UringConfig& config = {});
+				~UringServer() override;
+
+				// sets up the ring, the buffers and the listener, 0 or the error code
+				int start() override;
+				// closes the listening socket and all connections (on the thread of run(), or after it returned)
+				void stop() noexcept override;
+
+				// submits the queued sends and handles the completions, waits up to timeout_ms (-1: until one arrives)
+				// returns the number of completions or -1
+				int run_once(int timeout_ms = -1);
+				// until quit()
+				void run();
+				// thread safe, run() returns after the current iteration
+				void quit() noexcept;
+
+			protected:
+				// queues the data, it is submitted with the next iteration
+				bool send_connection(Connection& connection, const char* data, size_t length) override;
+				void close_connection(Connection* connection) noexcept override;
+
+			private:
+				struct Slot {
+					std::unique_ptr<Connection> connection;
+					bool closing = false;
+					bool fixed_file = false;		// registered, the requests use the index instead of the descriptor
+					bool recv_armed = false;
+					bool send_queued = false;		// in pending_sends
+					int send_buffer = -1;			// registered buffer of the send in flight
+					bool send_fixed = false;		// the send in flight uses IORING_RECVSEND_FIXED_BUF
+					unsigned int send_offset = 0, send_length = 0;
+				};
+
+				UringConfig config;
+				std::unique_ptr<UringRing> ring;
+
+				// indexed by the file descriptor, a descriptor is closed only after its last completion
+				std::vector<Slot> slots;
+				// closed, freed with the next iteration (a handler may still hold a reference)
+				std::vector<std::unique_ptr<Connection>> closed;
+				std::vector<SOCKET> pending_sends;
+				std::vector<int> free_send_buffers;
+				std::vector<SOCKET> rearm_recv;	// ran out of provided buffers
+				bool accept_armed;
+				bool fixed_sends;				// the kernel takes IORING_RECVSEND_FIXED_BUF for plain sends
+				bool draining;					// the destructor waits for the last completions, nothing new is armed
+
+				std::atomic<bool> quit_requested;
+
+				void arm_accept();
+				void arm_recv(SOCKET fd);
+				void arm_wake();
+				void submit_sends();
+				bool start_send(SOCKET fd);
+				void submit_send(SOCKET fd);
+
+				void accepted(int result, unsigned int flags);
+				void received(SOCKET fd, int result, unsigned int flags);
+				void sent(SOCKET fd, int result);
+				// closes the descriptor once nothing is in flight
+				void release(SOCKET fd) noexcept;
+			};
+		}
+	#endif
+#endif
\ No newline at end of file
@@ -6,23 +6,81 @@
 	constexpr auto DEFAULT_PORT   = "27015";
 	constexpr auto DEFAULT_BUFLEN = 512;
 
-	// Ensure that the build environment links to the Winsock Library file 
-	// Ws2_32.lib. Applications that use Winsock must be linked with the 
-	// Ws2_32.lib library file. The #pragma comment indicates to the linker 
-	// that the Ws2_32.lib file is needed.
-	#pragma comment(lib, "Ws2_32.lib")
-
-	// The Winsock2.h header file contains most of the Winsock functions, 
-	// structures, and definitions.
-	#include <winsock2.h>
-	// The Ws2tcpip.h header file contains definitions introduced in the 
-	// WinSock 2 Protocol-Specific Annex document for TCP/IP that includes 
-	// newer functions and structures used to retrieve IP addresses.
-	#include <ws2tcpip.h>
+	#ifdef _WIN32
+		#define WINDOWS_SOCKET_WINSOCK
+
+		// Ensure that the build environment links to the Winsock Library file
+		// Ws2_32.lib. Applications that use Winsock must be linked with the
+		// Ws2_32.lib library file. The #pragma comment indicates to the linker
+		// that the Ws2_32.lib file is needed.
+		#pragma comment(lib, "Ws2_32.lib")
+
+		// The Winsock2.h header file contains most of the Winsock functions,
+		// structures, and definitions.
+		#include <winsock2.h>
+		// The Ws2tcpip.h header file contains definitions introduced in the
+		// WinSock 2 Protocol-Specific Annex document for TCP/IP that includes
+		// newer functions and structures used to retrieve IP addresses.
+		#include <ws2tcpip.h>
+
+		// no SIGPIPE on Windows
+		constexpr int SEND_FLAGS = 0;
+	#else
+		#define WINDOWS_SOCKET_POSIX
+
+		// BSD sockets, the Winsock names the socket classes use are mapped onto them
+		#include <sys/types.h>
+		#include <sys/socket.h>
+		#include <netinet/in.h>
+		#include <netinet/tcp.h>
+		#include <arpa/inet.h>
+		#include <netdb.h>
+		#include <unistd.h>
+		#include <fcntl.h>
+		#include <cerrno>
+
+		using SOCKET = int;
+		using PCSTR  = const char*;
+		using LPCSTR = const char*;
+
+		#define INVALID_SOCKET (-1)
+		#define SOCKET_ERROR   (-1)
+
+		#define SD_RECEIVE SHUT_RD
+		#define SD_SEND    SHUT_WR
+		#define SD_BOTH    SHUT_RDWR
+
+		// the event loop (event_loop.hpp) is built on epoll
+		#ifdef __linux__
+			#define WINDOWS_SOCKET_EPOLL
+		#endif
+
+		// the completion based server (uring_server.hpp) talks to io_uring directly, without liburing
+		#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+			#define WINDOWS_SOCKET_IO_URING
+		#endif
+
+		// datagrams in batches (datagram.hpp): sendmmsg / recvmmsg, UDP GSO / GRO
+		#ifdef __linux__
+			#define WINDOWS_SOCKET_MMSG
+		#endif
+
+		// a send to a closed connection returns an error instead of killing the process
+		#ifdef MSG_NOSIGNAL
+			constexpr int SEND_FLAGS = MSG_NOSIGNAL;
+		#else
+			constexpr int SEND_FLAGS = 0;
+		#endif
+	#endif
+
 	#include <iostream>
 
 	#define null_method { return 0; }
 
-	#define cin_wait system("pause")
+	#ifdef WINDOWS_SOCKET_WINSOCK
+		#define cin_wait system("pause")
+	#else
+		#define cin_wait std::cin.get()
+	#endif
 
 #endif
\ No newline at end of file
@@ -0,0 +1,131 @@
+#include "backend.hpp"
+#include "window.hpp"
+
+#include <chrono>
+
+namespace winLib {
+	void Backend::show(int command) noexcept {}
+
+	double Backend::time() const noexcept {
+		return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	unsigned long Backend::refreshRate() const noexcept {
+		return 60;
+	}
+
+	void Backend::setTitle(const std::string& title) {}
+
+	std::string Backend::getTitle() const {
+		return "";
+	}
+
+	void Backend::setCursor(NATIV_CURSOR cursor) noexcept {}
+
+	void Backend::showCursor(bool visible) noexcept {}
+
+	NullBackend::NullBackend() noexcept {
+		window = nullptr;
+		presented = 0;
+		closed = false;
+	}
+
+	NullBackend::~NullBackend() {
+		destroy();
+	}
+
+	bool NullBackend::create(Window* window, int width, int height, NATIV_CURSOR cursor) noexcept {
+		destroy();
+
+		this->window = window;
+		closed = false;
+		presented = 0;
+
+		if (!resize(width > 0 ? width : 0, height > 0 ? height : 0)) {
+			this->window = nullptr;
+			return false;
+		}
+
+		return true;
+	}
+
+	void NullBackend::destroy() noexcept {
+		if (!window)
+			return;
+
+		freeAligned(window->state.memory);
+		window->state = {};
+		window = nullptr;
+	}
+
+	bool NullBackend::pumpEvents(Window* window) noexcept {
+		for (const InputEvent& event : injected)
+			dispatch_input_event(event, &window->keyboard, &window->mouse, window->inputQueue());
+
+		injected.clear();
+
+		return !closed;
+	}
+
+	void NullBackend::present(const RenderState& state) noexcept {
+		presented++;
+	}
+
+	void NullBackend::setTitle(const std::string& title) {
+		this->title = title;
+	}
+
+	std::string NullBackend::getTitle() const {
+		return title;
+	}
+
+	void NullBackend::injectEvent(const InputEvent& event) {
+		injected.push_back(event);
+	}
+
+	bool NullBackend::resize(unsigned int width, unsigned int height) noexcept {
+		if (!window)
+			return false;
+
+		RenderState& state = window->state;
+
+		freeAligned(state.memory);
+
+		state.width = width;
+		state.height = height;
+		state.memory = static_cast<unsigned int*>(allocateAligned(static_cast<size_t>(width) * height * sizeof(unsigned int)));
+		state.format = PixelFormat::PIXEL_BGRA8;
+
+		if (!state.memory) {
+			state = {};
+			return false;
+		}
+
+		return true;
+	}
+
+	void NullBackend::close() noexcept {
+		closed = true;
+	}
+
+	unsigned long long NullBackend::framesPresented() const noexcept {
+		return presented;
+	}
+
+	std::unique_ptr<Backend> create_null_backend() {
+		return std::make_unique<NullBackend>();
+	}
+
+	std::unique_ptr<Backend> create_default_backend() {
+		#if defined(WINDOWS_WINDOW_WIN32)
+			return create_win32_backend();
+		#else
+			#ifdef WINDOWS_WINDOW_X11
+				if (std::unique_ptr<Backend> x11 = create_x11_backend())
+					return x11;
+			#endif
+
+			return create_null_backend();
+		#endif
+	}
+}
\ No newline at end of file
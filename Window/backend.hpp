@@ -0,0 +1,98 @@
+#ifndef WINDOWS_WINDOW_BACKEND_HPP
+	#define WINDOWS_WINDOW_BACKEND_HPP
+
+	#include "util.hpp"
+	#include "input.hpp"
+
+	#include <memory>
+	#include <string>
+	#include <vector>
+
+	// Everything Window needs from the platform: a window, its events, a place to show the render target and a clock.
+	//   Win32Backend: CreateWindowEx, PeekMessage, StretchDIBits (WINDOWS_WINDOW_WIN32)
+	//   X11Backend:   Xlib window, the render target lives in a MIT-SHM segment (define WINDOWS_WINDOW_X11, link X11 and Xext)
+	//   NullBackend:  no window at all, for servers and benchmarks
+
+	namespace winLib {
+		class Window;
+		struct RenderState;
+
+		#ifdef WINDOWS_WINDOW_WIN32
+			constexpr int DEFAULT_SHOW_COMMAND = SW_SHOW;
+		#else
+			constexpr int DEFAULT_SHOW_COMMAND = 1;
+		#endif
+
+		class Backend {
+		public:
+			virtual ~Backend() = default;
+
+			// creates the window, the render target (window->state) is set up by the backend whenever the size changes
+			virtual bool create(Window* window, int width, int height, NATIV_CURSOR cursor) noexcept = 0;
+			// releases the window and the render target
+			virtual void destroy() noexcept = 0;
+			virtual void show(int command) noexcept;
+
+			// handles every pending event, input goes into window->keyboard / mouse / inputQueue()
+			// returns false once the window was closed
+			virtual bool pumpEvents(Window* window) noexcept = 0;
+			virtual void present(const RenderState& state) noexcept = 0;
+
+			// monotonic clock in seconds
+			virtual double time() const noexcept;
+			virtual unsigned long refreshRate() const noexcept;
+
+			virtual void setTitle(const std::string& title);
+			virtual std::string getTitle() const;
+			virtual void setCursor(NATIV_CURSOR cursor) noexcept;
+			virtual void showCursor(bool visible) noexcept;
+		};
+
+		// Presents nothing, the render target is plain memory. Events can be injected to drive the input.
+		class NullBackend : public Backend {
+		public:
+			NullBackend() noexcept;
+			~NullBackend() override;
+
+			bool create(Window* window, int width, int height, NATIV_CURSOR cursor) noexcept override;
+			void destroy() noexcept override;
+
+			bool pumpEvents(Window* window) noexcept override;
+			void present(const RenderState& state) noexcept override;
+
+			void setTitle(const std::string& title) override;
+			std::string getTitle() const override;
+
+			// the next pumpEvents(...) applies them (the time stamp is set if it is 0)
+			void injectEvent(const InputEvent& event);
+			// reallocates the render target like a resized window would
+			bool resize(unsigned int width, unsigned int height) noexcept;
+			// the next pumpEvents(...) returns false
+			void close() noexcept;
+
+			unsigned long long framesPresented() const noexcept;
+
+		private:
+			Window* window;
+			std::string title;
+			std::vector<InputEvent> injected;
+			unsigned long long presented;
+			bool closed;
+		};
+
+		std::unique_ptr<Backend> create_null_backend();
+
+		#ifdef WINDOWS_WINDOW_WIN32
+			std::unique_ptr<Backend> create_win32_backend(DWORD window_style = WS_OVERLAPPEDWINDOW, HINSTANCE instance = nullptr);
+		#endif
+
+		#ifdef WINDOWS_WINDOW_X11
+			// nullptr if the display can't be opened (nullptr -> $DISPLAY)
+			std::unique_ptr<Backend> create_x11_backend(const char* display_name = nullptr);
+		#endif
+
+		// Win32 on windows, X11 if it is compiled in and a display is available, the NullBackend otherwise
+		std::unique_ptr<Backend> create_default_backend();
+	}
+
+#endif
\ No newline at end of file
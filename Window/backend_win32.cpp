@@ -0,0 +1,270 @@
+#include "backend.hpp"
+#include "window.hpp"
+
+#ifdef WINDOWS_WINDOW_WIN32
+namespace winLib {
+	class Win32Backend : public Backend {
+	public:
+		Win32Backend(DWORD window_style, HINSTANCE instance) noexcept;
+		~Win32Backend() override;
+
+		bool create(Window* window, int width, int height, NATIV_CURSOR cursor) noexcept override;
+		void destroy() noexcept override;
+		void show(int command) noexcept override;
+
+		bool pumpEvents(Window* window) noexcept override;
+		void present(const RenderState& state) noexcept override;
+
+		double time() const noexcept override;
+		unsigned long refreshRate() const noexcept override;
+
+		void setTitle(const std::string& title) override;
+		std::string getTitle() const override;
+		void setCursor(NATIV_CURSOR cursor) noexcept override;
+		void showCursor(bool visible) noexcept override;
+
+	private:
+		static LRESULT __stdcall window_callback(HWND window_handle, _In_ UINT message, _In_ WPARAM wparam, _In_ LPARAM lparam) noexcept;
+		LRESULT window_event(UINT message, WPARAM wparam, LPARAM lparam) noexcept;
+
+		Window* window;
+		HWND window_handle;
+		HDC device_context_handle;
+		DWORD window_style;
+		HINSTANCE instance;
+		BITMAPINFO info;
+		LARGE_INTEGER cpu_frequency;
+		bool closed;
+	};
+
+	Win32Backend::Win32Backend(DWORD window_style, HINSTANCE instance) noexcept {
+		this->window = nullptr;
+		this->window_handle = nullptr;
+		this->device_context_handle = nullptr;
+		this->window_style = window_style;
+		this->instance = instance;
+		this->info = {};
+		this->closed = false;
+
+		QueryPerformanceFrequency(&cpu_frequency);
+	}
+
+	Win32Backend::~Win32Backend() {
+		destroy();
+	}
+
+	LRESULT __stdcall Win32Backend::window_callback(HWND window_handle, _In_ UINT message, _In_ WPARAM wparam, _In_ LPARAM lparam) noexcept {
+		Win32Backend* this_pointer = nullptr;
+
+		if (message == WM_NCCREATE) {
+			CREATESTRUCT* create = (CREATESTRUCT*)lparam;
+
+			this_pointer = static_cast<Win32Backend*>(create->lpCreateParams);
+
+			if (this_pointer) {
+				SetWindowLongPtr(window_handle, GWLP_USERDATA, (LONG_PTR)this_pointer);
+
+				this_pointer->window_handle = window_handle;
+			}
+		} else
+			this_pointer = (Win32Backend*)GetWindowLongPtr(window_handle, GWLP_USERDATA);
+
+		if (this_pointer)
+			return this_pointer->window_event(message, wparam, lparam);
+
+		return DefWindowProc(window_handle, message, wparam, lparam);
+	}
+
+	bool Win32Backend::create(Window* window, int width, int height, NATIV_CURSOR cursor) noexcept {
+		const wchar_t* name = L"Window-Class Framework";
+
+		destroy();
+
+		this->window = window;
+		this->closed = false;
+
+		WNDCLASS wc = { };
+
+		wc.lpfnWndProc = window_callback;
+		wc.hInstance = instance;
+		wc.lpszClassName = name;
+		wc.hCursor = load_nativ_cursor(cursor);
+
+		RegisterClass(&wc);
+
+		// Create the window.
+
+		window_handle = CreateWindowEx(
+			0,                              // Optional window styles.
+			name,                           // Window class
+			L"Learn to Program Windows",    // Window text
+			window_style,                   // Window style
+
+			// Size and position
+			CW_USEDEFAULT, CW_USEDEFAULT, width, height,
+
+			nullptr,       // Parent window
+			nullptr,       // Menu
+			instance,      // Instance handle
+			this           // Additional application data
+		);
+
+		if (!window_handle) {
+			DEBUGSTRING(Txt("Failed to create a Window! Last Error: %ul\n"), 100, GetLastError())
+			this->window = nullptr;
+			return false;
+		}
+
+		device_context_handle = GetDC(window_handle);
+
+		register_raw_mouse(window_handle);
+
+		return true;
+	}
+
+	void Win32Backend::destroy() noexcept {
+		if (window_handle) {
+			if (device_context_handle)
+				ReleaseDC(window_handle, device_context_handle);
+
+			// WM_DESTROY would only mark the window as closed, detach first
+			SetWindowLongPtr(window_handle, GWLP_USERDATA, 0);
+			DestroyWindow(window_handle);
+		}
+
+		if (window && window->state.memory) {
+			VirtualFree(window->state.memory, 0, MEM_RELEASE);
+			window->state = {};
+		}
+
+		window = nullptr;
+		window_handle = nullptr;
+		device_context_handle = nullptr;
+	}
+
+	void Win32Backend::show(int command) noexcept {
+		ShowWindow(window_handle, command);
+	}
+
+	bool Win32Backend::pumpEvents(Window* window) noexcept {
+		MSG msg = {};
+		while (PeekMessage(&msg, window_handle, 0, 0, PM_REMOVE)) {
+			if (!handle_input(&msg, &window->keyboard, &window->mouse, window->inputQueue())) {
+				// TODO error handeling
+			}
+		}
+
+		return !closed;
+	}
+
+	void Win32Backend::present(const RenderState& state) noexcept {
+		StretchDIBits(
+			device_context_handle,
+			0, state.height, state.width, -static_cast<long long>(state.height),
+			0, 0, state.width, state.height,
+			state.memory,
+			&info,
+			DIB_RGB_COLORS,
+			SRCCOPY
+		);
+	}
+
+	double Win32Backend::time() const noexcept {
+		LARGE_INTEGER counter;
+		QueryPerformanceCounter(&counter);
+
+		return static_cast<double>(counter.QuadPart) / static_cast<double>(cpu_frequency.QuadPart);
+	}
+
+	unsigned long Win32Backend::refreshRate() const noexcept {
+		DEVMODE mode{};
+		mode.dmSize = sizeof(mode);
+		mode.dmDriverExtra = 0;
+
+		if (EnumDisplaySettings(nullptr, ENUM_CURRENT_SETTINGS, &mode))
+			return mode.dmDisplayFrequency;
+
+		// handle error
+		return 60;
+	}
+
+	void Win32Backend::setTitle(const std::string& title) {
+		#if defined(UNICODE) || defined(_UNICODE)
+			SetWindowText(window_handle, convertS2W(title).c_str());
+		#else
+			SetWindowText(window_handle, title.c_str());
+		#endif
+	}
+
+	std::string Win32Backend::getTitle() const {
+		const int str_length = GetWindowTextLength(window_handle);
+
+		if (str_length <= 0)
+			return "";
+
+		#if defined(UNICODE) || defined(_UNICODE)
+			std::wstring title(static_cast<size_t>(str_length) + 1, L'\0');
+			title.resize(GetWindowText(window_handle, title.data(), str_length + 1));
+			return convertW2S(title);
+		#else
+			std::string title(static_cast<size_t>(str_length) + 1, '\0');
+			title.resize(GetWindowText(window_handle, title.data(), str_length + 1));
+			return title;
+		#endif
+	}
+
+	void Win32Backend::setCursor(NATIV_CURSOR cursor) noexcept {
+		SetCursor(load_nativ_cursor(cursor));
+	}
+
+	void Win32Backend::showCursor(bool visible) noexcept {
+		ShowCursor(visible);
+	}
+
+	LRESULT Win32Backend::window_event(UINT message, WPARAM wparam, LPARAM lparam) noexcept {
+
+		switch (message) {
+		case WM_DESTROY: {
+			closed = true;
+			return 0;
+		}
+		case WM_SIZE: {
+			if (!window)
+				return 0;
+
+			RenderState& state = window->state;
+
+			RECT client_rect = {};
+
+			GetClientRect(window_handle, &client_rect);
+
+			state.width = client_rect.right - client_rect.left;
+			state.height = client_rect.bottom - client_rect.top;
+
+			const int buffersize = int(static_cast<unsigned long long>(state.width) * state.height * sizeof(unsigned int));
+
+			if (state.memory)
+				VirtualFree(state.memory, 0, MEM_RELEASE);
+
+			state.memory = static_cast<unsigned int*>(VirtualAlloc(nullptr, buffersize, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE));
+			state.format = PixelFormat::PIXEL_BGRA8;
+
+			info.bmiHeader.biSize = sizeof(info.bmiHeader);
+			info.bmiHeader.biWidth = state.width;
+			info.bmiHeader.biHeight = state.height;
+			info.bmiHeader.biPlanes = 1;
+			info.bmiHeader.biBitCount = 32;
+			info.bmiHeader.biCompression = BI_RGB;
+
+			return 0;
+		}
+		default:
+			return DefWindowProc(window_handle, message, wparam, lparam);
+		}
+	}
+
+	std::unique_ptr<Backend> create_win32_backend(DWORD window_style, HINSTANCE instance) {
+		return std::make_unique<Win32Backend>(window_style, instance);
+	}
+}
+#endif
\ No newline at end of file
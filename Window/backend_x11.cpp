@@ -0,0 +1,577 @@
+#include "backend.hpp"
+#include "window.hpp"
+
+#ifdef WINDOWS_WINDOW_X11
+#include <X11/Xlib.h>
+#include <X11/Xutil.h>
+#include <X11/keysym.h>
+#include <X11/cursorfont.h>
+#include <X11/XKBlib.h>
+#include <X11/extensions/XShm.h>
+
+#include <sys/ipc.h>
+#include <sys/shm.h>
+
+#include <cstdlib>
+
+namespace winLib {
+	static bool x11_shm_failed = false;
+
+	static int x11_shm_error_handler(Display*, XErrorEvent*) {
+		x11_shm_failed = true;
+		return 0;
+	}
+
+	// position of the lowest bit of mask and the number of bits from there on (a channel of a TrueColor visual)
+	static void x11_channel(unsigned long mask, int& shift, int& bits) noexcept {
+		shift = 0;
+		bits = 0;
+
+		while (mask && !(mask & 1)) {
+			mask >>= 1;
+			shift++;
+		}
+
+		while (mask & 1) {
+			mask >>= 1;
+			bits++;
+		}
+	}
+
+	// an 8 bit channel value in a channel of bits bits at shift
+	static unsigned long x11_scale(unsigned int value, int shift, int bits) noexcept {
+		const unsigned long scaled = bits <= 8 ? value >> (8 - bits) : static_cast<unsigned long>(value) << (bits - 8);
+		return scaled << shift;
+	}
+
+	// the X11 keysym -> KEY_..., -1 if there is none
+	static int x11_key(KeySym sym) noexcept {
+		if (sym >= XK_0 && sym <= XK_9)
+			return KEY_0 + static_cast<int>(sym - XK_0);
+		if (sym >= XK_a && sym <= XK_z)
+			return KEY_A + static_cast<int>(sym - XK_a);
+		if (sym >= XK_A && sym <= XK_Z)
+			return KEY_A + static_cast<int>(sym - XK_A);
+		if (sym >= XK_KP_0 && sym <= XK_KP_9)
+			return KEY_NUM_0 + static_cast<int>(sym - XK_KP_0);
+		if (sym >= XK_F1 && sym <= XK_F24)
+			return KEY_F1 + static_cast<int>(sym - XK_F1);
+
+		switch (sym) {
+		case XK_space:		return KEY_SPACE;
+		case XK_Prior:		return KEY_PAGE_UP;
+		case XK_Next:		return KEY_PAGE_DOWN;
+		case XK_End:		return KEY_END;
+		case XK_Home:		return KEY_HOME;
+		case XK_Left:		return KEY_LEFT;
+		case XK_Up:			return KEY_UP;
+		case XK_Right:		return KEY_RIGHT;
+		case XK_Down:		return KEY_DOWN;
+		case XK_Select:		return KEY_SELECT;
+		case XK_Print:		return KEY_SNAPSHOT;
+		case XK_Execute:	return KEY_EXE;
+		case XK_Insert:		return KEY_INSERT;
+		case XK_Delete:		return KEY_DELETE;
+		case XK_Help:		return KEY_HELP;
+		case XK_KP_Multiply:	return KEY_MULTIPLY;
+		case XK_KP_Add:			return KEY_ADD;
+		case XK_KP_Separator:	return KEY_SEPARATOR;
+		case XK_KP_Subtract:	return KEY_SUBTRACT;
+		case XK_KP_Decimal:		return KEY_DECIMAL;
+		case XK_KP_Divide:		return KEY_DIVIDE;
+		// like WM_KEYDOWN: only the side independent modifiers
+		case XK_Shift_L:
+		case XK_Shift_R:	return KEY_SHIFT;
+		case XK_Control_L:
+		case XK_Control_R:	return KEY_CTRL;
+		case XK_Alt_L:
+		case XK_Alt_R:		return KEY_ALT;
+		case XK_Pause:		return KEY_PAUSE;
+		case XK_Caps_Lock:	return KEY_CAPS_LOCK;
+		case XK_Escape:		return KEY_ESC;
+		default:			return -1;
+		}
+	}
+
+	static unsigned int x11_cursor_shape(NATIV_CURSOR cursor) noexcept {
+		switch (cursor) {
+		case NATIV_CURSOR::TEXT:		return XC_xterm;
+		case NATIV_CURSOR::WAIT:		return XC_watch;
+		case NATIV_CURSOR::CROSS:		return XC_crosshair;
+		case NATIV_CURSOR::ARROW_UP:	return XC_sb_up_arrow;
+		case NATIV_CURSOR::PEN:			return XC_pencil;
+		case NATIV_CURSOR::DIAGONAL_1:	return XC_bottom_right_corner;
+		case NATIV_CURSOR::DIAGONAL_2:	return XC_bottom_left_corner;
+		case NATIV_CURSOR::HORIZONTAL:	return XC_sb_h_double_arrow;
+		case NATIV_CURSOR::VERTICAL:	return XC_sb_v_double_arrow;
+		case NATIV_CURSOR::MOVE:		return XC_fleur;
+		case NATIV_CURSOR::NO:			return XC_X_cursor;
+		case NATIV_CURSOR::LINK:		return XC_hand2;
+		case NATIV_CURSOR::WAIT_ARROW:	return XC_watch;
+		case NATIV_CURSOR::HELP:		return XC_question_arrow;
+		case NATIV_CURSOR::LOCATION:	return XC_target;
+		case NATIV_CURSOR::PERSON:		return XC_man;
+		default:						return XC_left_ptr;
+		}
+	}
+
+	// The render target is a MIT-SHM segment the X server reads directly (no copy through the socket).
+	// Without the extension (remote display) it falls back to XPutImage. A TrueColor visual which isn't 32 bit
+	// BGRA (16 bit displays) gets a separate render target that is converted into the image with every present.
+	class X11Backend : public Backend {
+	public:
+		explicit X11Backend(Display* display) noexcept;
+		~X11Backend() override;
+
+		bool create(Window* window, int width, int height, NATIV_CURSOR cursor) noexcept override;
+		void destroy() noexcept override;
+		void show(int command) noexcept override;
+
+		bool pumpEvents(Window* window) noexcept override;
+		void present(const RenderState& state) noexcept override;
+
+		void setTitle(const std::string& title) override;
+		std::string getTitle() const override;
+		void setCursor(NATIV_CURSOR cursor) noexcept override;
+		void showCursor(bool visible) noexcept override;
+
+	private:
+		Display* display;
+		::Window window_handle;
+		GC gc;
+		Visual* visual;
+		int depth;
+		bool native;			// the visual is 32 bit BGRA, the drawing code writes into the image
+		int red_shift, red_bits, green_shift, green_bits, blue_shift, blue_bits;
+		Atom wm_delete_window;
+		Cursor cursor;
+		Cursor blank_cursor;
+
+		XImage* image;
+		unsigned int* pixels;	// the render target if the visual isn't native
+		XShmSegmentInfo shm;
+		bool use_shm;
+		int shm_completion;		// event type of XShmCompletionEvent
+		bool present_pending;	// the server may still read the segment
+
+		Window* window;
+		bool closed;
+
+		bool create_surface(unsigned int width, unsigned int height) noexcept;
+		void destroy_surface() noexcept;
+		void wait_for_present() noexcept;
+		void convert_pixels(const RenderState& state) noexcept;
+		void dispatch(const InputEvent& event) noexcept;
+	};
+
+	X11Backend::X11Backend(Display* display) noexcept {
+		this->display = display;
+		this->window_handle = 0;
+		this->gc = nullptr;
+		this->visual = DefaultVisual(display, DefaultScreen(display));
+		this->depth = DefaultDepth(display, DefaultScreen(display));
+		// the drawing code writes 0xAARRGGBB (PIXEL_BGRA8)
+		this->native = depth >= 24 && visual->red_mask == 0xFF0000 && visual->green_mask == 0xFF00 && visual->blue_mask == 0xFF;
+		x11_channel(visual->red_mask, red_shift, red_bits);
+		x11_channel(visual->green_mask, green_shift, green_bits);
+		x11_channel(visual->blue_mask, blue_shift, blue_bits);
+		this->wm_delete_window = XInternAtom(display, "WM_DELETE_WINDOW", False);
+		this->cursor = 0;
+		this->blank_cursor = 0;
+		this->image = nullptr;
+		this->pixels = nullptr;
+		this->shm = {};
+		// the segment is the render target, a converted image is sent with XPutImage
+		this->use_shm = native && XShmQueryExtension(display);
+		this->shm_completion = XShmGetEventBase(display) + ShmCompletion;
+		this->present_pending = false;
+		this->window = nullptr;
+		this->closed = false;
+	}
+
+	X11Backend::~X11Backend() {
+		destroy();
+		XCloseDisplay(display);
+	}
+
+	bool X11Backend::create(Window* window, int width, int height, NATIV_CURSOR cursor) noexcept {
+		destroy();
+
+		if (width <= 0 || height <= 0)
+			return false;
+
+		if (!native)
+			DEBUGNUMBER("The X11 visual isn't 32 bit BGRA (depth %d), converting every frame\n", 100, depth)
+
+		this->window = window;
+		this->closed = false;
+
+		const int screen = DefaultScreen(display);
+
+		window_handle = XCreateSimpleWindow(display, RootWindow(display, screen), 0, 0, width, height, 0, BlackPixel(display, screen), BlackPixel(display, screen));
+
+		XSelectInput(display, window_handle,
+			KeyPressMask | KeyReleaseMask | ButtonPressMask | ButtonReleaseMask | PointerMotionMask |
+			EnterWindowMask | LeaveWindowMask | StructureNotifyMask | ExposureMask);
+
+		XSetWMProtocols(display, window_handle, &wm_delete_window, 1);
+
+		// only key presses for held keys, like WM_KEYDOWN with the repeat bit
+		XkbSetDetectableAutoRepeat(display, True, nullptr);
+
+		gc = XCreateGC(display, window_handle, 0, nullptr);
+
+		setCursor(cursor);
+
+		if (!create_surface(width, height)) {
+			destroy();
+			return false;
+		}
+
+		return true;
+	}
+
+	void X11Backend::destroy() noexcept {
+		destroy_surface();
+
+		if (blank_cursor) {
+			XFreeCursor(display, blank_cursor);
+			blank_cursor = 0;
+		}
+
+		if (cursor) {
+			XFreeCursor(display, cursor);
+			cursor = 0;
+		}
+
+		if (gc) {
+			XFreeGC(display, gc);
+			gc = nullptr;
+		}
+
+		if (window_handle) {
+			XDestroyWindow(display, window_handle);
+			window_handle = 0;
+		}
+
+		XFlush(display);
+
+		window = nullptr;
+	}
+
+	void X11Backend::show(int command) noexcept {
+		if (command)
+			XMapWindow(display, window_handle);
+		else
+			XUnmapWindow(display, window_handle);
+
+		XFlush(display);
+	}
+
+	bool X11Backend::create_surface(unsigned int width, unsigned int height) noexcept {
+		destroy_surface();
+
+		if (use_shm) {
+			image = XShmCreateImage(display, visual, depth, ZPixmap, nullptr, &shm, width, height);
+
+			// the rows have to be tightly packed, the render target has no stride
+			if (image && image->bytes_per_line == static_cast<int>(width * sizeof(unsigned int))) {
+				shm.shmid = shmget(IPC_PRIVATE, static_cast<size_t>(image->bytes_per_line) * height, IPC_CREAT | 0600);
+				shm.shmaddr = shm.shmid >= 0 ? static_cast<char*>(shmat(shm.shmid, nullptr, 0)) : reinterpret_cast<char*>(-1);
+				shm.readOnly = False;
+
+				if (shm.shmaddr != reinterpret_cast<char*>(-1)) {
+					image->data = shm.shmaddr;
+
+					// XShmAttach fails asynchronously on remote displays
+					x11_shm_failed = false;
+					XErrorHandler previous = XSetErrorHandler(x11_shm_error_handler);
+					XShmAttach(display, &shm);
+					XSync(display, False);
+					XSetErrorHandler(previous);
+
+					// the segment goes away with the last detach
+					shmctl(shm.shmid, IPC_RMID, nullptr);
+
+					if (!x11_shm_failed) {
+						window->state.width = width;
+						window->state.height = height;
+						window->state.memory = reinterpret_cast<unsigned int*>(image->data);
+						window->state.format = PixelFormat::PIXEL_BGRA8;
+						return true;
+					}
+
+					shmdt(shm.shmaddr);
+				} else if (shm.shmid >= 0)
+					shmctl(shm.shmid, IPC_RMID, nullptr);
+			}
+
+			if (image) {
+				image->data = nullptr;
+				XDestroyImage(image);
+				image = nullptr;
+			}
+
+			shm = {};
+			use_shm = false;
+			DEBUGNUMBER("MIT-SHM isn't usable on %s, falling back to XPutImage\n", 256, DisplayString(display))
+		}
+
+		if (native) {
+			char* memory = static_cast<char*>(std::malloc(static_cast<size_t>(width) * height * sizeof(unsigned int)));
+			if (!memory)
+				return false;
+
+			image = XCreateImage(display, visual, depth, ZPixmap, 0, memory, width, height, 32, width * sizeof(unsigned int));
+			if (!image) {
+				std::free(memory);
+				return false;
+			}
+
+			window->state.memory = reinterpret_cast<unsigned int*>(image->data);
+		} else {
+			// the layout of the visual (bytes per pixel, row padding) is up to Xlib
+			image = XCreateImage(display, visual, depth, ZPixmap, 0, nullptr, width, height, 32, 0);
+			if (!image)
+				return false;
+
+			image->data = static_cast<char*>(std::malloc(static_cast<size_t>(image->bytes_per_line) * height));
+			pixels = static_cast<unsigned int*>(std::malloc(static_cast<size_t>(width) * height * sizeof(unsigned int)));
+
+			if (!image->data || !pixels) {
+				destroy_surface();
+				return false;
+			}
+
+			window->state.memory = pixels;
+		}
+
+		window->state.width = width;
+		window->state.height = height;
+		window->state.format = PixelFormat::PIXEL_BGRA8;
+
+		return true;
+	}
+
+	void X11Backend::destroy_surface() noexcept {
+		if (!image)
+			return;
+
+		if (use_shm) {
+			wait_for_present();
+
+			XShmDetach(display, &shm);
+			XSync(display, False);
+
+			image->data = nullptr;
+			XDestroyImage(image);
+			shmdt(shm.shmaddr);
+			shm = {};
+		} else
+			XDestroyImage(image);	// frees the memory too
+
+		image = nullptr;
+
+		std::free(pixels);
+		pixels = nullptr;
+
+		if (window)
+			window->state = {};
+	}
+
+	void X11Backend::wait_for_present() noexcept {
+		while (present_pending) {
+			XEvent event;
+			XIfEvent(display, &event, [](Display*, XEvent* event, XPointer type) -> Bool {
+				return event->type == *reinterpret_cast<int*>(type);
+			}, reinterpret_cast<XPointer>(&shm_completion));
+
+			present_pending = false;
+		}
+	}
+
+	void X11Backend::dispatch(const InputEvent& event) noexcept {
+		dispatch_input_event(event, &window->keyboard, &window->mouse, window->inputQueue());
+	}
+
+	bool X11Backend::pumpEvents(Window* window) noexcept {
+		// the app is about to draw into the segment again
+		wait_for_present();
+
+		unsigned int resize_width = 0, resize_height = 0;
+
+		while (XPending(display)) {
+			XEvent event;
+			XNextEvent(display, &event);
+
+			InputEvent input = {};
+
+			switch (event.type) {
+			case KeyPress:
+			case KeyRelease: {
+				const int key = x11_key(XLookupKeysym(&event.xkey, 0));
+				if (key < 0)
+					break;
+
+				input.type = event.type == KeyPress ? INPUT_KEY_DOWN : INPUT_KEY_UP;
+				input.code = static_cast<unsigned short>(key);
+				dispatch(input);
+				break;
+			}
+			case ButtonPress:
+			case ButtonRelease: {
+				const bool is_down = event.type == ButtonPress;
+				const unsigned int button = event.xbutton.button;
+
+				if (button == Button4 || button == Button5) {
+					// one notch is WHEEL_DELTA (120) like on windows, the release carries no information
+					if (is_down) {
+						input.type = INPUT_MOUSE_WHEEL;
+						input.wheel_delta = button == Button4 ? 120 : -120;
+						dispatch(input);
+					}
+					break;
+				}
+
+				switch (button) {
+				case Button1:	input.code = MOUSE_LEFT; break;
+				case Button2:	input.code = MOUSE_MIDDLE; break;
+				case Button3:	input.code = MOUSE_RIGHT; break;
+				case 8:			input.code = MOUSE_X1; break;
+				case 9:			input.code = MOUSE_X2; break;
+				default:		continue;
+				}
+
+				input.type = is_down ? INPUT_MOUSE_DOWN : INPUT_MOUSE_UP;
+				dispatch(input);
+				break;
+			}
+			case MotionNotify: {
+				input.type = INPUT_MOUSE_MOVE;
+				input.x = event.xmotion.x;
+				input.y = event.xmotion.y;
+				dispatch(input);
+				break;
+			}
+			case EnterNotify:
+			case LeaveNotify: {
+				input.type = event.type == EnterNotify ? INPUT_MOUSE_ENTER : INPUT_MOUSE_LEAVE;
+				dispatch(input);
+				break;
+			}
+			case ConfigureNotify: {
+				// only the last size matters
+				resize_width = static_cast<unsigned int>(event.xconfigure.width);
+				resize_height = static_cast<unsigned int>(event.xconfigure.height);
+				break;
+			}
+			case ClientMessage: {
+				if (static_cast<Atom>(event.xclient.data.l[0]) == wm_delete_window)
+					closed = true;
+				break;
+			}
+			default:
+				break;
+			}
+		}
+
+		if (resize_width && resize_height && (resize_width != window->state.width || resize_height != window->state.height))
+			create_surface(resize_width, resize_height);
+
+		return !closed;
+	}
+
+	void X11Backend::present(const RenderState& state) noexcept {
+		if (!image)
+			return;
+
+		if (use_shm) {
+			// completion event: the next frame must not draw before the server has read this one
+			XShmPutImage(display, window_handle, gc, image, 0, 0, 0, 0, state.width, state.height, True);
+			present_pending = true;
+		} else {
+			if (!native)
+				convert_pixels(state);
+
+			XPutImage(display, window_handle, gc, image, 0, 0, 0, 0, state.width, state.height);
+		}
+
+		XFlush(display);
+	}
+
+	void X11Backend::convert_pixels(const RenderState& state) noexcept {
+		const unsigned int* source = pixels;
+
+		for (unsigned int y = 0; y < state.height; y++) {
+			for (unsigned int x = 0; x < state.width; x++) {
+				const unsigned int color = *source++;
+				const unsigned long pixel = x11_scale((color >> 16) & 0xFF, red_shift, red_bits)
+					| x11_scale((color >> 8) & 0xFF, green_shift, green_bits)
+					| x11_scale(color & 0xFF, blue_shift, blue_bits);
+
+				XPutPixel(image, static_cast<int>(x), static_cast<int>(y), pixel);
+			}
+		}
+	}
+
+	void X11Backend::setTitle(const std::string& title) {
+		XStoreName(display, window_handle, title.c_str());
+		XFlush(display);
+	}
+
+	std::string X11Backend::getTitle() const {
+		char* name = nullptr;
+
+		if (!XFetchName(display, window_handle, &name) || !name)
+			return "";
+
+		std::string title(name);
+		XFree(name);
+
+		return title;
+	}
+
+	void X11Backend::setCursor(NATIV_CURSOR cursor) noexcept {
+		if (this->cursor)
+			XFreeCursor(display, this->cursor);
+
+		this->cursor = XCreateFontCursor(display, x11_cursor_shape(cursor));
+		XDefineCursor(display, window_handle, this->cursor);
+		XFlush(display);
+	}
+
+	void X11Backend::showCursor(bool visible) noexcept {
+		if (visible) {
+			XDefineCursor(display, window_handle, cursor);
+		} else {
+			if (!blank_cursor) {
+				static const char empty[1] = {};
+				XColor black = {};
+				const Pixmap pixmap = XCreateBitmapFromData(display, window_handle, empty, 1, 1);
+				blank_cursor = XCreatePixmapCursor(display, pixmap, pixmap, &black, &black, 0, 0);
+				XFreePixmap(display, pixmap);
+			}
+
+			XDefineCursor(display, window_handle, blank_cursor);
+		}
+
+		XFlush(display);
+	}
+
+	std::unique_ptr<Backend> create_x11_backend(const char* display_name) {
+		Display* display = XOpenDisplay(display_name);
+
+		if (!display)
+			return nullptr;
+
+		// only the channels of a TrueColor visual can be computed from the pixels, the NullBackend takes over
+		if (DefaultVisual(display, DefaultScreen(display))->c_class != TrueColor) {
+			DEBUGNUMBER("The X11 visual of %s isn't TrueColor, no window\n", 256, DisplayString(display))
+			XCloseDisplay(display);
+			return nullptr;
+		}
+
+		return std::make_unique<X11Backend>(display);
+	}
+}
+#endif
\ No newline at end of file
@@ -0,0 +1,582 @@
+#include "capture.hpp"
+#include "window.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+namespace winLib {
+	static void put8(std::vector<unsigned char>& out, unsigned int value) {
+		out.push_back(static_cast<unsigned char>(value));
+	}
+
+	static void put16le(std::vector<unsigned char>& out, unsigned int value) {
+		put8(out, value);
+		put8(out, value >> 8);
+	}
+
+	static void put32le(std::vector<unsigned char>& out, unsigned int value) {
+		put16le(out, value);
+		put16le(out, value >> 16);
+	}
+
+	static void put32be(std::vector<unsigned char>& out, unsigned int value) {
+		put8(out, value >> 24);
+		put8(out, value >> 16);
+		put8(out, value >> 8);
+		put8(out, value);
+	}
+
+	static void putFourCC(std::vector<unsigned char>& out, const char* fourcc) {
+		out.insert(out.end(), fourcc, fourcc + 4);
+	}
+
+	// bytes of an uncompressed 32 bit frame, start() made sure it fits into the 32 bit chunk size
+	static unsigned int avi_frame_size(unsigned int width, unsigned int height) noexcept {
+		return static_cast<unsigned int>(static_cast<unsigned long long>(width) * height * 4);
+	}
+
+	static unsigned int crc32(const unsigned char* data, size_t length, unsigned int crc = 0) noexcept {
+		static const auto table = [] {
+			struct Table { unsigned int values[256]; } table{};
+			for (unsigned int n = 0; n < 256; n++) {
+				unsigned int c = n;
+				for (int k = 0; k < 8; k++)
+					c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+				table.values[n] = c;
+			}
+			return table;
+		}();
+
+		crc = ~crc;
+		for (size_t i = 0; i < length; i++)
+			crc = table.values[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+
+		return ~crc;
+	}
+
+	FrameCapture::FrameCapture() noexcept : head(0), tail(0), running(false), written(0), dropped(0), wake(0) {
+		this->format = CAPTURE_QOI;
+		this->width = 0;
+		this->height = 0;
+		this->fps = 60;
+		this->avi_movi_start = 0;
+	}
+
+	FrameCapture::~FrameCapture() {
+		stop();
+	}
+
+	bool FrameCapture::start(const std::string& path, CaptureFormat format, unsigned int width, unsigned int height, unsigned int fps, unsigned int buffers) {
+		if (isRunning() || width == 0 || height == 0 || buffers == 0)
+			return false;
+
+		// the frames have to be addressable, an AVI chunk size has 32 bits and its frame rectangle 16 bit sides
+		const unsigned long long frame_bytes = static_cast<unsigned long long>(width) * height * 4;
+
+		if (frame_bytes > SIZE_MAX / 2 || (format == CAPTURE_AVI && (frame_bytes + 8 > 0xFFFFFFFF || width > 0xFFFF || height > 0xFFFF))) {
+			DEBUGNUMBER("A capture of %ux%u is too big for the output format\n", 100, width, height)
+			return false;
+		}
+
+		this->path = path;
+		this->format = format;
+		this->width = width;
+		this->height = height;
+		this->fps = fps ? fps : 60;
+
+		// everything the render thread touches is allocated up front
+		try {
+			this->buffers.clear();
+			for (unsigned int i = 0; i < buffers; i++)
+				this->buffers.push_back(std::make_unique<unsigned int[]>(static_cast<size_t>(width) * height));
+
+			output.reserve(static_cast<size_t>(width) * height * 4 + 1024);
+		} catch (const std::bad_alloc&) {
+			this->buffers.clear();
+			return false;
+		}
+
+		if (!begin_stream()) {
+			DEBUGNUMBER("Failed to open the capture output %s\n", 512, path.c_str())
+			this->buffers.clear();
+			return false;
+		}
+
+		head = 0;
+		tail = 0;
+		written = 0;
+		dropped = 0;
+		running = true;
+
+		try {
+			encoder = std::thread(&FrameCapture::encode_loop, this);
+		} catch (const std::system_error&) {
+			running = false;
+			end_stream();
+			return false;
+		}
+
+		return true;
+	}
+
+	void FrameCapture::stop() {
+		if (!encoder.joinable())
+			return;
+
+		running.store(false, std::memory_order_release);
+		wake.fetch_add(1, std::memory_order_release);
+		wake.notify_one();
+
+		encoder.join();
+
+		end_stream();
+	}
+
+	bool FrameCapture::isRunning() const noexcept {
+		return running.load(std::memory_order_acquire);
+	}
+
+	bool FrameCapture::submit(const RenderState& state) noexcept {
+		return submit(state.memory, state.width, state.height, state.format);
+	}
+
+	bool FrameCapture::submit(const unsigned int* memory, unsigned int width, unsigned int height, PixelFormat format) noexcept {
+		if (!memory || !isRunning())
+			return false;
+
+		const unsigned long long h = head.load(std::memory_order_relaxed);
+
+		// every buffer is still queued -> drop the frame instead of waiting for the encoder
+		if (h - tail.load(std::memory_order_acquire) >= buffers.size()) {
+			dropped.fetch_add(1, std::memory_order_relaxed);
+			return false;
+		}
+
+		unsigned int* frame = buffers[h % buffers.size()].get();
+		const unsigned int columns = std::min(width, this->width);
+		const unsigned int rows = std::min(height, this->height);
+		const size_t src_stride = static_cast<size_t>(width) * pixelFormatSize(format);
+
+		for (unsigned int y = 0; y < rows; y++) {
+			unsigned int* dst = frame + static_cast<size_t>(y) * this->width;
+
+			convertPixels(reinterpret_cast<const unsigned char*>(memory) + y * src_stride, format, dst, PIXEL_BGRA8, columns);
+			std::fill(dst + columns, dst + this->width, 0xFF000000);
+		}
+
+		std::fill(frame + static_cast<size_t>(rows) * this->width, frame + static_cast<size_t>(this->height) * this->width, 0xFF000000);
+
+		head.store(h + 1, std::memory_order_release);
+		wake.fetch_add(1, std::memory_order_release);
+		wake.notify_one();
+
+		return true;
+	}
+
+	unsigned long long FrameCapture::framesWritten() const noexcept {
+		return written.load(std::memory_order_relaxed);
+	}
+
+	unsigned long long FrameCapture::framesDropped() const noexcept {
+		return dropped.load(std::memory_order_relaxed);
+	}
+
+	void FrameCapture::encode_loop() noexcept {
+		while (true) {
+			const unsigned int s = wake.load(std::memory_order_acquire);
+			const unsigned long long t = tail.load(std::memory_order_relaxed);
+
+			if (t == head.load(std::memory_order_acquire)) {
+				// all frames are written
+				if (!running.load(std::memory_order_acquire))
+					break;
+
+				wake.wait(s, std::memory_order_acquire);
+				continue;
+			}
+
+			try {
+				if (encode(buffers[t % buffers.size()].get(), t))
+					written.fetch_add(1, std::memory_order_relaxed);
+				else
+					dropped.fetch_add(1, std::memory_order_relaxed);
+			} catch (...) {
+				dropped.fetch_add(1, std::memory_order_relaxed);
+			}
+
+			tail.store(t + 1, std::memory_order_release);
+		}
+	}
+
+	bool FrameCapture::encode(const unsigned int* frame, unsigned long long number) {
+		output.clear();
+
+		switch (format) {
+		case CAPTURE_QOI:
+		case CAPTURE_PNG: {
+			if (format == CAPTURE_QOI)
+				encode_qoi(frame);
+			else
+				encode_png(frame);
+
+			char name[32];
+			std::snprintf(name, sizeof(name), "frame_%06llu.%s", number, format == CAPTURE_QOI ? "qoi" : "png");
+
+			std::ofstream file(std::filesystem::path(path) / name, std::ios::binary);
+			file.write(reinterpret_cast<const char*>(output.data()), static_cast<std::streamsize>(output.size()));
+
+			return file.good();
+		}
+		case CAPTURE_Y4M: {
+			encode_y4m(frame);
+			break;
+		}
+		case CAPTURE_AVI: {
+			encode_avi(frame);
+			break;
+		}
+		}
+
+		stream.write(reinterpret_cast<const char*>(output.data()), static_cast<std::streamsize>(output.size()));
+
+		return stream.good();
+	}
+
+	void FrameCapture::encode_qoi(const unsigned int* frame) {
+		// https://qoiformat.org/qoi-specification.pdf
+		putFourCC(output, "qoif");
+		put32be(output, width);
+		put32be(output, height);
+		put8(output, 3);	// the alpha channel of the render target isn't shown -> rgb
+		put8(output, 0);
+
+		unsigned int index[64] = {};
+		unsigned int previous = 0xFF000000;
+		unsigned int run = 0;
+		const size_t count = static_cast<size_t>(width) * height;
+
+		for (size_t i = 0; i < count; i++) {
+			const unsigned int pixel = frame[i] | 0xFF000000;
+
+			if (pixel == previous) {
+				if (++run == 62) {
+					put8(output, 0xC0 | (run - 1));
+					run = 0;
+				}
+				continue;
+			}
+
+			if (run) {
+				put8(output, 0xC0 | (run - 1));
+				run = 0;
+			}
+
+			const int r = getRedColorValue(pixel), g = getGreenColorValue(pixel), b = getBlueColorValue(pixel);
+			const unsigned int hash = (r * 3 + g * 5 + b * 7 + 255 * 11) % 64;
+
+			if (index[hash] == pixel) {
+				put8(output, hash);
+			} else {
+				index[hash] = pixel;
+
+				const int dr = r - static_cast<int>(getRedColorValue(previous));
+				const int dg = g - static_cast<int>(getGreenColorValue(previous));
+				const int db = b - static_cast<int>(getBlueColorValue(previous));
+				const int dr_dg = dr - dg, db_dg = db - dg;
+
+				// the differences wrap around like the decoder does
+				auto wrap = [](int v) { return static_cast<signed char>(v); };
+
+				if (wrap(dr) >= -2 && wrap(dr) <= 1 && wrap(dg) >= -2 && wrap(dg) <= 1 && wrap(db) >= -2 && wrap(db) <= 1) {
+					put8(output, 0x40 | ((wrap(dr) + 2) << 4) | ((wrap(dg) + 2) << 2) | (wrap(db) + 2));
+				} else if (wrap(dg) >= -32 && wrap(dg) <= 31 && wrap(dr_dg) >= -8 && wrap(dr_dg) <= 7 && wrap(db_dg) >= -8 && wrap(db_dg) <= 7) {
+					put8(output, 0x80 | (wrap(dg) + 32));
+					put8(output, ((wrap(dr_dg) + 8) << 4) | (wrap(db_dg) + 8));
+				} else {
+					put8(output, 0xFE);
+					put8(output, r);
+					put8(output, g);
+					put8(output, b);
+				}
+			}
+
+			previous = pixel;
+		}
+
+		if (run)
+			put8(output, 0xC0 | (run - 1));
+
+		for (int i = 0; i < 7; i++)
+			put8(output, 0x00);
+		put8(output, 0x01);
+	}
+
+	void FrameCapture::encode_png(const unsigned int* frame) {
+		auto chunk = [&](const char* type, const std::vector<unsigned char>& data) {
+			put32be(output, static_cast<unsigned int>(data.size()));
+			const size_t start = output.size();
+			putFourCC(output, type);
+			output.insert(output.end(), data.begin(), data.end());
+			put32be(output, crc32(output.data() + start, output.size() - start));
+		};
+
+		static const unsigned char signature[] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+		output.insert(output.end(), signature, signature + sizeof(signature));
+
+		std::vector<unsigned char> header;
+		put32be(header, width);
+		put32be(header, height);
+		put8(header, 8);	// bit depth
+		put8(header, 2);	// rgb
+		put8(header, 0);
+		put8(header, 0);
+		put8(header, 0);
+		chunk("IHDR", header);
+
+		// raw scanlines: filter type 0 + rgb
+		const size_t row_bytes = static_cast<size_t>(width) * 3 + 1;
+		std::vector<unsigned char> raw(row_bytes * height);
+
+		for (unsigned int y = 0; y < height; y++) {
+			unsigned char* dst = raw.data() + y * row_bytes;
+			const unsigned int* src = frame + static_cast<size_t>(y) * width;
+
+			*dst++ = 0;
+			for (unsigned int x = 0; x < width; x++) {
+				*dst++ = static_cast<unsigned char>(getRedColorValue(src[x]));
+				*dst++ = static_cast<unsigned char>(getGreenColorValue(src[x]));
+				*dst++ = static_cast<unsigned char>(getBlueColorValue(src[x]));
+			}
+		}
+
+		// zlib stream of stored (uncompressed) deflate blocks, the encoder has to keep up with the frame rate
+		std::vector<unsigned char> data;
+		data.reserve(raw.size() + raw.size() / 65535 * 5 + 16);
+		put8(data, 0x78);
+		put8(data, 0x01);
+
+		unsigned int a = 1, b = 0;
+		size_t offset = 0;
+
+		do {
+			const size_t length = std::min<size_t>(raw.size() - offset, 65535);
+
+			put8(data, offset + length == raw.size() ? 1 : 0);
+			put16le(data, static_cast<unsigned int>(length));
+			put16le(data, static_cast<unsigned int>(~length & 0xFFFF));
+			data.insert(data.end(), raw.begin() + offset, raw.begin() + offset + length);
+
+			for (size_t i = offset; i < offset + length; i++) {
+				a = (a + raw[i]) % 65521;
+				b = (b + a) % 65521;
+			}
+
+			offset += length;
+		} while (offset < raw.size());
+
+		put32be(data, (b << 16) | a);
+
+		chunk("IDAT", data);
+		chunk("IEND", {});
+	}
+
+	void FrameCapture::encode_y4m(const unsigned int* frame) {
+		// bt.601 limited range, chroma is the average of 2x2 pixels
+		const unsigned int chroma_width = (width + 1) / 2, chroma_height = (height + 1) / 2;
+		const size_t luma_size = static_cast<size_t>(width) * height;
+		const size_t chroma_size = static_cast<size_t>(chroma_width) * chroma_height;
+
+		static const char frame_header[] = "FRAME\n";
+		output.insert(output.end(), frame_header, frame_header + sizeof(frame_header) - 1);
+
+		const size_t start = output.size();
+		output.resize(start + luma_size + 2 * chroma_size);
+
+		unsigned char* y_plane = output.data() + start;
+		unsigned char* u_plane = y_plane + luma_size;
+		unsigned char* v_plane = u_plane + chroma_size;
+
+		for (size_t i = 0; i < luma_size; i++) {
+			const int r = getRedColorValue(frame[i]), g = getGreenColorValue(frame[i]), b = getBlueColorValue(frame[i]);
+			y_plane[i] = static_cast<unsigned char>(((66 * r + 129 * g + 25 * b + 128) >> 8) + 16);
+		}
+
+		for (unsigned int cy = 0; cy < chroma_height; cy++) {
+			for (unsigned int cx = 0; cx < chroma_width; cx++) {
+				int r = 0, g = 0, b = 0, n = 0;
+
+				for (unsigned int y = cy * 2; y < std::min(cy * 2 + 2, height); y++) {
+					for (unsigned int x = cx * 2; x < std::min(cx * 2 + 2, width); x++) {
+						const unsigned int pixel = frame[static_cast<size_t>(y) * width + x];
+						r += getRedColorValue(pixel);
+						g += getGreenColorValue(pixel);
+						b += getBlueColorValue(pixel);
+						n++;
+					}
+				}
+
+				r /= n; g /= n; b /= n;
+
+				u_plane[static_cast<size_t>(cy) * chroma_width + cx] = static_cast<unsigned char>(((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128);
+				v_plane[static_cast<size_t>(cy) * chroma_width + cx] = static_cast<unsigned char>(((112 * r - 94 * g - 18 * b + 128) >> 8) + 128);
+			}
+		}
+	}
+
+	void FrameCapture::encode_avi(const unsigned int* frame) {
+		const unsigned int frame_size = avi_frame_size(width, height);
+		const std::streamoff position = stream.tellp();
+
+		putFourCC(output, "00db");
+		put32le(output, frame_size);
+
+		// dibs are stored bottom up
+		const size_t start = output.size();
+		output.resize(start + frame_size);
+
+		for (unsigned int y = 0; y < height; y++)
+			std::memcpy(output.data() + start + static_cast<size_t>(height - 1 - y) * width * 4, frame + static_cast<size_t>(y) * width, static_cast<size_t>(width) * 4);
+
+		// idx1 offsets are relative to the "movi" fourcc
+		avi_index.push_back({ static_cast<unsigned int>(position - avi_movi_start), frame_size });
+	}
+
+	bool FrameCapture::begin_stream() {
+		avi_index.clear();
+
+		switch (format) {
+		case CAPTURE_QOI:
+		case CAPTURE_PNG: {
+			std::error_code error;
+			std::filesystem::create_directories(path, error);
+			return std::filesystem::is_directory(path);
+		}
+		case CAPTURE_Y4M: {
+			stream.open(path, std::ios::binary | std::ios::trunc);
+
+			char header[128];
+			const int length = std::snprintf(header, sizeof(header), "YUV4MPEG2 W%u H%u F%u:1 Ip A1:1 C420jpeg\n", width, height, fps);
+			stream.write(header, length);
+
+			return stream.good();
+		}
+		case CAPTURE_AVI: {
+			stream.open(path, std::ios::binary | std::ios::trunc);
+
+			// the sizes and frame counts are patched by end_stream()
+			std::vector<unsigned char> header;
+			const unsigned int frame_size = avi_frame_size(width, height);
+
+			putFourCC(header, "RIFF");
+			put32le(header, 0);
+			putFourCC(header, "AVI ");
+
+			putFourCC(header, "LIST");
+			put32le(header, 192);
+			putFourCC(header, "hdrl");
+
+			putFourCC(header, "avih");
+			put32le(header, 56);
+			put32le(header, 1000000 / fps);		// micro seconds per frame
+			put32le(header, static_cast<unsigned int>(std::min<unsigned long long>(static_cast<unsigned long long>(frame_size) * fps, 0xFFFFFFFF)));	// max bytes per second
+			put32le(header, 0);
+			put32le(header, 0x10);				// AVIF_HASINDEX
+			put32le(header, 0);					// total frames
+			put32le(header, 0);
+			put32le(header, 1);					// streams
+			put32le(header, frame_size + 8);
+			put32le(header, width);
+			put32le(header, height);
+			for (int i = 0; i < 4; i++)
+				put32le(header, 0);
+
+			putFourCC(header, "LIST");
+			put32le(header, 116);
+			putFourCC(header, "strl");
+
+			putFourCC(header, "strh");
+			put32le(header, 56);
+			putFourCC(header, "vids");
+			putFourCC(header, "DIB ");
+			put32le(header, 0);
+			put16le(header, 0);
+			put16le(header, 0);
+			put32le(header, 0);
+			put32le(header, 1);					// scale
+			put32le(header, fps);				// rate
+			put32le(header, 0);
+			put32le(header, 0);					// length in frames
+			put32le(header, frame_size + 8);
+			put32le(header, 0xFFFFFFFF);		// quality
+			put32le(header, 0);
+			put16le(header, 0);
+			put16le(header, 0);
+			put16le(header, width);
+			put16le(header, height);
+
+			putFourCC(header, "strf");
+			put32le(header, 40);
+			put32le(header, 40);				// BITMAPINFOHEADER
+			put32le(header, width);
+			put32le(header, height);
+			put16le(header, 1);
+			put16le(header, 32);
+			put32le(header, 0);					// BI_RGB
+			put32le(header, frame_size);
+			for (int i = 0; i < 4; i++)
+				put32le(header, 0);
+
+			putFourCC(header, "LIST");
+			put32le(header, 0);
+			avi_movi_start = static_cast<std::streamoff>(header.size());
+			putFourCC(header, "movi");
+
+			stream.write(reinterpret_cast<const char*>(header.data()), static_cast<std::streamsize>(header.size()));
+
+			return stream.good();
+		}
+		}
+
+		return false;
+	}
+
+	void FrameCapture::end_stream() {
+		if (!stream.is_open())
+			return;
+
+		if (format == CAPTURE_AVI) {
+			const std::streamoff movi_end = stream.tellp();
+			std::vector<unsigned char> index;
+
+			putFourCC(index, "idx1");
+			put32le(index, static_cast<unsigned int>(avi_index.size() * 16));
+			for (const AviIndexEntry& entry : avi_index) {
+				putFourCC(index, "00db");
+				put32le(index, 0x10);	// AVIIF_KEYFRAME
+				put32le(index, entry.offset);
+				put32le(index, entry.size);
+			}
+
+			stream.write(reinterpret_cast<const char*>(index.data()), static_cast<std::streamsize>(index.size()));
+
+			const std::streamoff file_end = stream.tellp();
+			const unsigned int frames = static_cast<unsigned int>(avi_index.size());
+
+			auto patch = [&](std::streamoff offset, unsigned int value) {
+				std::vector<unsigned char> bytes;
+				put32le(bytes, value);
+				stream.seekp(offset);
+				stream.write(reinterpret_cast<const char*>(bytes.data()), 4);
+			};
+
+			patch(4, static_cast<unsigned int>(file_end - 8));							// RIFF size
+			patch(48, frames);															// avih total frames
+			patch(140, frames);															// strh length
+			patch(avi_movi_start - 4, static_cast<unsigned int>(movi_end - avi_movi_start));	// movi size
+		}
+
+		stream.close();
+	}
+}
\ No newline at end of file
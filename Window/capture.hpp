@@ -0,0 +1,86 @@
+#ifndef WINDOWS_WINDOW_CAPTURE_HPP
+	#define WINDOWS_WINDOW_CAPTURE_HPP
+
+	#include "util.hpp"
+	#include "pixel.hpp"
+
+	#include <atomic>
+	#include <fstream>
+	#include <memory>
+	#include <thread>
+	#include <vector>
+
+	namespace winLib {
+		struct RenderState;
+
+		enum CaptureFormat {
+			CAPTURE_QOI,	// one .qoi file per frame
+			CAPTURE_PNG,	// one .png file per frame (stored deflate blocks, no compression)
+			CAPTURE_Y4M,	// one YUV4MPEG2 stream (4:2:0)
+			CAPTURE_AVI		// one uncompressed 32 bit AVI stream
+		};
+
+		// Records the render target without stalling the render thread:
+		// submit(...) only copies the frame into one of the preallocated buffers,
+		// a background thread encodes and writes them. If all buffers are still
+		// waiting for the encoder the frame is dropped.
+		class FrameCapture {
+		public:
+			FrameCapture() noexcept;
+			FrameCapture(const FrameCapture&) = delete;
+			~FrameCapture();
+
+			FrameCapture& operator= (const FrameCapture&) = delete;
+
+			// path is a directory for CAPTURE_QOI / CAPTURE_PNG and a file for CAPTURE_Y4M / CAPTURE_AVI
+			// frames with another size are cropped or padded to width x height
+			bool start(const std::string& path, CaptureFormat format, unsigned int width, unsigned int height, unsigned int fps = 60, unsigned int buffers = 4);
+			// waits until all submitted frames are written
+			void stop();
+
+			bool isRunning() const noexcept;
+
+			// called by the render thread, returns false if the frame was dropped
+			bool submit(const RenderState& state) noexcept;
+			bool submit(const unsigned int* memory, unsigned int width, unsigned int height, PixelFormat format = PIXEL_BGRA8) noexcept;
+
+			unsigned long long framesWritten() const noexcept;
+			unsigned long long framesDropped() const noexcept;
+
+		private:
+			struct AviIndexEntry {
+				unsigned int offset, size;
+			};
+
+			std::string path;
+			CaptureFormat format;
+			unsigned int width, height, fps;
+
+			std::vector<std::unique_ptr<unsigned int[]>> buffers;
+			std::atomic<unsigned long long> head;	// next buffer the render thread fills
+			std::atomic<unsigned long long> tail;	// next buffer the encoder writes
+			std::atomic<bool> running;
+			std::atomic<unsigned long long> written;
+			std::atomic<unsigned long long> dropped;
+			std::atomic<unsigned int> wake;			// bumped on every submit / stop, the encoder waits on it
+			std::thread encoder;
+
+			std::ofstream stream;
+			std::vector<unsigned char> output;
+			std::vector<AviIndexEntry> avi_index;
+			std::streamoff avi_movi_start;
+
+			void encode_loop() noexcept;
+			bool encode(const unsigned int* frame, unsigned long long number);
+
+			void encode_qoi(const unsigned int* frame);
+			void encode_png(const unsigned int* frame);
+			void encode_y4m(const unsigned int* frame);
+			void encode_avi(const unsigned int* frame);
+
+			bool begin_stream();
+			void end_stream();
+		};
+	}
+
+#endif
\ No newline at end of file
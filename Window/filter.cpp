@@ -0,0 +1,531 @@
+#include "filter.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace winLib {
+	// below this amount of pixels the threads cost more than they save
+	constexpr size_t PARALLEL_MIN_PIXELS = 256 * 256;
+	// columns handled at once by the vertical passes, one cache line of pixels
+	constexpr unsigned int STRIP_WIDTH = 16;
+
+	// Worker threads for parallel_for, started with the first image that is big enough and kept until the program
+	// ends. A job hands out ranges of items from a shared counter, the calling thread works on it as well.
+	class FilterPool {
+	public:
+		static FilterPool& get() {
+			static FilterPool pool;
+			return pool;
+		}
+
+		// the workers and the calling thread
+		size_t size() const noexcept { return workers.size() + 1; }
+
+		// false if another thread runs a job right now, the caller does it alone then
+		template <class F>
+		bool run(size_t count, size_t chunk, const F& function) {
+			std::unique_lock<std::mutex> lock(run_mutex, std::try_to_lock);
+
+			if (!lock.owns_lock())
+				return false;
+
+			job = { &invoke<F>, &function, count, chunk };
+			next.store(0, std::memory_order_relaxed);
+			busy.store(workers.size(), std::memory_order_relaxed);
+
+			generation.fetch_add(1, std::memory_order_release);
+			generation.notify_all();
+
+			// the workers use function until busy is 0, even if it threw on this thread
+			try {
+				work();
+			} catch (...) {
+				wait_workers();
+				throw;
+			}
+
+			wait_workers();
+			return true;
+		}
+
+	private:
+		struct Job {
+			void (*invoke)(const void* function, size_t begin, size_t end);
+			const void* function;
+			size_t count, chunk;
+		};
+
+		Job job;
+		std::atomic<size_t> next;				// first item nobody took yet
+		std::atomic<size_t> busy;				// workers still in the job
+		std::atomic<unsigned int> generation;	// bumped for every job and the shutdown, the workers wait on it
+		std::atomic<bool> stopping;
+		std::vector<std::thread> workers;
+		std::mutex run_mutex;
+
+		FilterPool() : job(), next(0), busy(0), generation(0), stopping(false) {
+			const unsigned int threads = std::thread::hardware_concurrency();
+
+			for (unsigned int i = 1; i < threads; i++) {
+				try {
+					workers.emplace_back(&FilterPool::work_loop, this);
+				} catch (...) {
+					// no more threads available -> fewer workers
+					break;
+				}
+			}
+		}
+
+		~FilterPool() {
+			stopping.store(true, std::memory_order_release);
+			generation.fetch_add(1, std::memory_order_release);
+			generation.notify_all();
+
+			for (std::thread& worker : workers)
+				worker.join();
+		}
+
+		template <class F>
+		static void invoke(const void* function, size_t begin, size_t end) {
+			(*static_cast<const F*>(function))(begin, end);
+		}
+
+		void work() {
+			for (;;) {
+				const size_t begin = next.fetch_add(job.chunk, std::memory_order_relaxed);
+
+				if (begin >= job.count)
+					return;
+
+				job.invoke(job.function, begin, std::min(begin + job.chunk, job.count));
+			}
+		}
+
+		void wait_workers() noexcept {
+			for (size_t b = busy.load(std::memory_order_acquire); b != 0; b = busy.load(std::memory_order_acquire))
+				busy.wait(b, std::memory_order_acquire);
+		}
+
+		void work_loop() {
+			unsigned int seen = 0;
+
+			for (;;) {
+				generation.wait(seen, std::memory_order_acquire);
+				seen = generation.load(std::memory_order_acquire);
+
+				if (stopping.load(std::memory_order_acquire))
+					return;
+
+				work();
+
+				if (busy.fetch_sub(1, std::memory_order_acq_rel) == 1)
+					busy.notify_one();
+			}
+		}
+	};
+
+	// calls function(begin, end) for parts of [0;count) on all cores
+	template <class F>
+	static void parallel_for(size_t count, size_t pixels_per_item, const F& function) {
+		if (count < 2 || count * pixels_per_item < PARALLEL_MIN_PIXELS) {
+			function(size_t(0), count);
+			return;
+		}
+
+		FilterPool& pool = FilterPool::get();
+
+		// a few ranges per thread, one that is done early takes the next range
+		const size_t chunk = std::max<size_t>(1, count / (pool.size() * 4));
+
+		if (pool.size() <= 1 || !pool.run(count, chunk, function))
+			function(size_t(0), count);
+	}
+
+	// the four channels of a pixel as floats, in memory order
+	// one pixel per vector: the channels are computed together, the pixels one after the other
+	#ifdef WINDOWS_WINDOW_X86
+		struct Channels {
+			__m128 v;
+		};
+
+		static inline Channels load(unsigned int pixel) noexcept {
+			const __m128i zero = _mm_setzero_si128();
+			const __m128i v = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(static_cast<int>(pixel)), zero), zero);
+			return { _mm_cvtepi32_ps(v) };
+		}
+
+		// rounds and saturates every channel to [0;255]
+		static inline unsigned int store(Channels c) noexcept {
+			__m128i v = _mm_cvtps_epi32(c.v);
+			v = _mm_packs_epi32(v, v);
+			v = _mm_packus_epi16(v, v);
+			return static_cast<unsigned int>(_mm_cvtsi128_si32(v));
+		}
+
+		static inline Channels zero() noexcept { return { _mm_setzero_ps() }; }
+		static inline Channels set(float a, float b, float c, float d) noexcept { return { _mm_setr_ps(a, b, c, d) }; }
+		static inline Channels operator+(Channels a, Channels b) noexcept { return { _mm_add_ps(a.v, b.v) }; }
+		static inline Channels operator-(Channels a, Channels b) noexcept { return { _mm_sub_ps(a.v, b.v) }; }
+		static inline Channels operator*(Channels a, Channels b) noexcept { return { _mm_mul_ps(a.v, b.v) }; }
+		static inline Channels operator*(Channels a, float t) noexcept { return { _mm_mul_ps(a.v, _mm_set1_ps(t)) }; }
+
+		template <int lane>
+		static inline Channels splat(Channels a) noexcept { return { _mm_shuffle_ps(a.v, a.v, _MM_SHUFFLE(lane, lane, lane, lane)) }; }
+	#else
+		struct Channels {
+			float v[4];
+		};
+
+		static inline Channels load(unsigned int pixel) noexcept {
+			return { { float(pixel & 0xFF), float((pixel >> 8) & 0xFF), float((pixel >> 16) & 0xFF), float(pixel >> 24) } };
+		}
+
+		static inline unsigned int store(Channels c) noexcept {
+			unsigned int pixel = 0;
+			for (int i = 0; i < 4; i++) {
+				const float v = std::nearbyint(c.v[i]);
+				pixel |= static_cast<unsigned int>(v < 0.f ? 0.f : (v > 255.f ? 255.f : v)) << (i * 8);
+			}
+			return pixel;
+		}
+
+		static inline Channels zero() noexcept { return { { 0.f, 0.f, 0.f, 0.f } }; }
+		static inline Channels set(float a, float b, float c, float d) noexcept { return { { a, b, c, d } }; }
+		static inline Channels operator+(Channels a, Channels b) noexcept { return { { a.v[0] + b.v[0], a.v[1] + b.v[1], a.v[2] + b.v[2], a.v[3] + b.v[3] } }; }
+		static inline Channels operator-(Channels a, Channels b) noexcept { return { { a.v[0] - b.v[0], a.v[1] - b.v[1], a.v[2] - b.v[2], a.v[3] - b.v[3] } }; }
+		static inline Channels operator*(Channels a, Channels b) noexcept { return { { a.v[0] * b.v[0], a.v[1] * b.v[1], a.v[2] * b.v[2], a.v[3] * b.v[3] } }; }
+		static inline Channels operator*(Channels a, float t) noexcept { return { { a.v[0] * t, a.v[1] * t, a.v[2] * t, a.v[3] * t } }; }
+
+		template <int lane>
+		static inline Channels splat(Channels a) noexcept { return { { a.v[lane], a.v[lane], a.v[lane], a.v[lane] } }; }
+	#endif
+
+	static bool filterable(const Image& image) noexcept {
+		return image.memory && image.width && image.height && pixelFormatSize(image.format) == 4;
+	}
+
+	static unsigned int* pixels(const Image& image, unsigned int y) noexcept {
+		return reinterpret_cast<unsigned int*>(image.row(y));
+	}
+
+	// memory of the calling thread (a worker of the FilterPool or the caller) for the lines and strips of a pass,
+	// grows to the biggest image and is kept, so a filter call doesn't allocate per chunk
+	static unsigned int* scratch(size_t size) {
+		static thread_local std::vector<unsigned int> buffer;
+
+		if (buffer.size() < size)
+			buffer.resize(size);
+
+		return buffer.data();
+	}
+
+	static int clamp_index(long long i, unsigned int size) noexcept {
+		return static_cast<int>(i < 0 ? 0 : (i >= size ? size - 1 : i));
+	}
+
+	// runs row_pass on every row and column_pass on every strip of STRIP_WIDTH columns
+	// row_pass(unsigned int* row, unsigned int* line) gets a line buffer with the size of a row
+	// column_pass(unsigned int x0, unsigned int columns, unsigned int* strip) gets a copy of the strip
+	template <class RowPass, class ColumnPass>
+	static void separable(Image& image, const RowPass& row_pass, const ColumnPass& column_pass) {
+		parallel_for(image.height, image.width, [&](size_t begin, size_t end) {
+			unsigned int* line = scratch(image.width);
+
+			for (size_t y = begin; y < end; y++)
+				row_pass(pixels(image, static_cast<unsigned int>(y)), line);
+		});
+
+		const size_t strips = (image.width + STRIP_WIDTH - 1) / STRIP_WIDTH;
+
+		parallel_for(strips, static_cast<size_t>(STRIP_WIDTH) * image.height, [&](size_t begin, size_t end) {
+			unsigned int* strip = scratch(static_cast<size_t>(image.height) * STRIP_WIDTH);
+
+			for (size_t s = begin; s < end; s++) {
+				const unsigned int x0 = static_cast<unsigned int>(s * STRIP_WIDTH);
+				const unsigned int columns = std::min(STRIP_WIDTH, image.width - x0);
+
+				// the copy keeps the strip in the cache and makes the pass in place
+				for (unsigned int y = 0; y < image.height; y++)
+					std::copy_n(pixels(image, y) + x0, columns, strip + static_cast<size_t>(y) * STRIP_WIDTH);
+
+				column_pass(x0, columns, strip);
+			}
+		});
+	}
+
+	bool boxBlur(Image& image, unsigned int radius, unsigned int passes) {
+		if (!filterable(image))
+			return false;
+
+		if (radius == 0 || passes == 0)
+			return true;
+
+		const float inv = 1.f / static_cast<float>(2 * radius + 1);
+		const long long r = radius;
+
+		auto row_pass = [&](unsigned int* row, unsigned int* line) {
+			const unsigned int width = image.width;
+
+			std::copy_n(row, width, line);
+
+			Channels sum = zero();
+			for (long long k = -r; k <= r; k++)
+				sum = sum + load(line[clamp_index(k, width)]);
+
+			for (long long x = 0; x < width; x++) {
+				row[x] = store(sum * inv);
+				sum = sum + load(line[clamp_index(x + r + 1, width)]) - load(line[clamp_index(x - r, width)]);
+			}
+		};
+
+		auto column_pass = [&](unsigned int x0, unsigned int columns, unsigned int* strip) {
+			const unsigned int height = image.height;
+			Channels sums[STRIP_WIDTH];
+
+			for (unsigned int c = 0; c < columns; c++) {
+				sums[c] = zero();
+				for (long long k = -r; k <= r; k++)
+					sums[c] = sums[c] + load(strip[clamp_index(k, height) * STRIP_WIDTH + c]);
+			}
+
+			for (long long y = 0; y < height; y++) {
+				unsigned int* row = pixels(image, static_cast<unsigned int>(y)) + x0;
+				const unsigned int* add = strip + static_cast<size_t>(clamp_index(y + r + 1, height)) * STRIP_WIDTH;
+				const unsigned int* sub = strip + static_cast<size_t>(clamp_index(y - r, height)) * STRIP_WIDTH;
+
+				for (unsigned int c = 0; c < columns; c++) {
+					row[c] = store(sums[c] * inv);
+					sums[c] = sums[c] + load(add[c]) - load(sub[c]);
+				}
+			}
+		};
+
+		// a few box passes converge to a gaussian blur
+		for (unsigned int pass = 0; pass < passes; pass++)
+			separable(image, row_pass, column_pass);
+
+		return true;
+	}
+
+	bool gaussianBlur(Image& image, float sigma) {
+		if (!filterable(image))
+			return false;
+
+		if (!(sigma > 0.f))
+			return true;
+
+		const long long r = static_cast<long long>(std::ceil(sigma * 3.f));
+		std::vector<float> weights(static_cast<size_t>(r + 1));
+		float total = 0.f;
+
+		for (long long k = 0; k <= r; k++) {
+			weights[k] = std::exp(-static_cast<float>(k * k) / (2.f * sigma * sigma));
+			total += k == 0 ? weights[k] : 2.f * weights[k];
+		}
+
+		for (float& weight : weights)
+			weight /= total;
+
+		auto row_pass = [&](unsigned int* row, unsigned int* line) {
+			const unsigned int width = image.width;
+
+			std::copy_n(row, width, line);
+
+			for (long long x = 0; x < width; x++) {
+				Channels sum = load(line[x]) * weights[0];
+
+				for (long long k = 1; k <= r; k++)
+					sum = sum + (load(line[clamp_index(x - k, width)]) + load(line[clamp_index(x + k, width)])) * weights[k];
+
+				row[x] = store(sum);
+			}
+		};
+
+		auto column_pass = [&](unsigned int x0, unsigned int columns, unsigned int* strip) {
+			const unsigned int height = image.height;
+
+			for (long long y = 0; y < height; y++) {
+				unsigned int* row = pixels(image, static_cast<unsigned int>(y)) + x0;
+
+				for (unsigned int c = 0; c < columns; c++) {
+					Channels sum = load(strip[y * STRIP_WIDTH + c]) * weights[0];
+
+					for (long long k = 1; k <= r; k++)
+						sum = sum + (load(strip[clamp_index(y - k, height) * STRIP_WIDTH + c]) + load(strip[clamp_index(y + k, height) * STRIP_WIDTH + c])) * weights[k];
+
+					row[c] = store(sum);
+				}
+			}
+		};
+
+		separable(image, row_pass, column_pass);
+
+		return true;
+	}
+
+	bool convolve(Image& image, const float* kernel, unsigned int size, float divisor, float bias) {
+		if (!filterable(image) || !kernel || (size != 3 && size != 5) || divisor == 0.f)
+			return false;
+
+		const unsigned int width = image.width, height = image.height;
+		const int r = static_cast<int>(size / 2);
+		const float inv = 1.f / divisor;
+		const Channels bias4 = set(bias, bias, bias, bias);
+
+		// every band is filtered by its own thread, the rows around a band are
+		// copied before any thread starts writing, the rows inside of a band are
+		// copied into a ring right before they get overwritten
+		// one band per thread of the pool: every band costs 2 * r halo rows
+		const unsigned int threads = static_cast<size_t>(width) * height < PARALLEL_MIN_PIXELS ? 1 : static_cast<unsigned int>(FilterPool::get().size());
+		const unsigned int bands = std::min(threads, height);
+		const unsigned int band_height = (height + bands - 1) / bands;
+		const size_t row_size = width;
+
+		std::vector<unsigned int> halos(static_cast<size_t>(bands) * 2 * r * row_size);
+
+		auto top_halo = [&](unsigned int band) { return halos.data() + static_cast<size_t>(band) * 2 * r * row_size; };
+		auto bottom_halo = [&](unsigned int band) { return top_halo(band) + r * row_size; };
+
+		for (unsigned int band = 0; band < bands; band++) {
+			const long long y0 = static_cast<long long>(band) * band_height;
+			const long long y1 = std::min<long long>(y0 + band_height, height);
+
+			for (int i = 0; i < r; i++) {
+				std::copy_n(pixels(image, clamp_index(y0 - r + i, height)), row_size, top_halo(band) + i * row_size);
+				std::copy_n(pixels(image, clamp_index(y1 + i, height)), row_size, bottom_halo(band) + i * row_size);
+			}
+		}
+
+		parallel_for(bands, PARALLEL_MIN_PIXELS, [&](size_t begin, size_t end) {
+			unsigned int* ring = scratch(static_cast<size_t>(r + 2) * row_size);
+			unsigned int* output = ring + static_cast<size_t>(r + 1) * row_size;
+			const unsigned int* rows[5];
+
+			for (size_t band = begin; band < end; band++) {
+				const long long y0 = static_cast<long long>(band) * band_height;
+				const long long y1 = std::min<long long>(y0 + band_height, height);
+
+				for (long long y = y0; y < y1; y++) {
+					for (int k = -r; k <= r; k++) {
+						const long long yy = clamp_index(y + k, height);
+
+						if (yy < y0)
+							rows[k + r] = top_halo(static_cast<unsigned int>(band)) + (yy - (y0 - r)) * row_size;
+						else if (yy >= y1)
+							rows[k + r] = bottom_halo(static_cast<unsigned int>(band)) + (yy - y1) * row_size;
+						else if (yy < y)
+							rows[k + r] = ring + (yy % (r + 1)) * row_size;
+						else
+							rows[k + r] = pixels(image, static_cast<unsigned int>(yy));
+					}
+
+					for (long long x = 0; x < width; x++) {
+						Channels sum = zero();
+
+						for (int ky = 0; ky < static_cast<int>(size); ky++)
+							for (int kx = 0; kx < static_cast<int>(size); kx++)
+								sum = sum + load(rows[ky][clamp_index(x + kx - r, width)]) * kernel[ky * size + kx];
+
+						output[x] = store(sum * inv + bias4);
+					}
+
+					unsigned int* row = pixels(image, static_cast<unsigned int>(y));
+
+					std::copy_n(row, row_size, ring + (y % (r + 1)) * row_size);
+					std::copy_n(output, row_size, row);
+				}
+			}
+		});
+
+		return true;
+	}
+
+	bool colorMatrix(Image& image, const float matrix[20]) {
+		if (!filterable(image) || !matrix)
+			return false;
+
+		// channel (0 red, 1 green, 2 blue, 3 alpha) of every lane in memory order
+		const bool bgra = image.format == PIXEL_BGRA8 || image.format == PIXEL_BGRA8_PREMULTIPLIED;
+		const int lane_channel[4] = { bgra ? 2 : 0, 1, bgra ? 0 : 2, 3 };
+
+		Channels columns[4];
+		float offset[4];
+
+		for (int lane = 0; lane < 4; lane++)
+			offset[lane] = matrix[lane_channel[lane] * 5 + 4] * 255.f;
+
+		for (int input = 0; input < 4; input++) {
+			float column[4];
+			for (int lane = 0; lane < 4; lane++)
+				column[lane] = matrix[lane_channel[lane] * 5 + lane_channel[input]];
+			columns[input] = set(column[0], column[1], column[2], column[3]);
+		}
+
+		const Channels offset4 = set(offset[0], offset[1], offset[2], offset[3]);
+
+		parallel_for(image.height, image.width, [&](size_t begin, size_t end) {
+			for (size_t y = begin; y < end; y++) {
+				unsigned int* row = pixels(image, static_cast<unsigned int>(y));
+
+				for (unsigned int x = 0; x < image.width; x++) {
+					const Channels c = load(row[x]);
+					row[x] = store(columns[0] * splat<0>(c) + columns[1] * splat<1>(c) + columns[2] * splat<2>(c) + columns[3] * splat<3>(c) + offset4);
+				}
+			}
+		});
+
+		return true;
+	}
+
+	bool applyLUT(Image& image, const unsigned char lut[256], bool alpha) {
+		if (!filterable(image) || !lut)
+			return false;
+
+		// a lookup per byte beats any vectorized math, the table stays in the l1 cache
+		parallel_for(image.height, image.width, [&](size_t begin, size_t end) {
+			for (size_t y = begin; y < end; y++) {
+				unsigned char* bytes = image.row(static_cast<unsigned int>(y));
+				unsigned char* last = bytes + static_cast<size_t>(image.width) * 4;
+
+				if (alpha) {
+					for (; bytes < last; bytes++)
+						*bytes = lut[*bytes];
+				} else {
+					// every 32 bit format keeps the alpha channel in the last byte
+					for (; bytes < last; bytes += 4) {
+						bytes[0] = lut[bytes[0]];
+						bytes[1] = lut[bytes[1]];
+						bytes[2] = lut[bytes[2]];
+					}
+				}
+			}
+		});
+
+		return true;
+	}
+
+	void buildLUT(unsigned char lut[256], float brightness, float contrast, float gamma) noexcept {
+		const float inv_gamma = gamma > 0.f ? 1.f / gamma : 1.f;
+
+		for (int i = 0; i < 256; i++) {
+			float v = static_cast<float>(i) / 255.f;
+
+			v = (v - 0.5f) * contrast + 0.5f + brightness;
+			v = v < 0.f ? 0.f : (v > 1.f ? 1.f : v);
+			v = std::pow(v, inv_gamma);
+
+			lut[i] = static_cast<unsigned char>(v * 255.f + 0.5f);
+		}
+	}
+
+	bool brightnessContrastGamma(Image& image, float brightness, float contrast, float gamma) {
+		unsigned char lut[256];
+
+		buildLUT(lut, brightness, contrast, gamma);
+
+		return applyLUT(image, lut);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,34 @@
+#ifndef WINDOWS_WINDOW_FILTER_HPP
+	#define WINDOWS_WINDOW_FILTER_HPP
+
+	#include "util.hpp"
+	#include "image.hpp"
+
+	// All filters work in place on 32 bit images (every PixelFormat with 4 bytes per pixel).
+	// Use Window::getRenderTarget() to run them on the render target.
+	// Rows (or column strips) are split across threads when the image is big enough.
+
+	namespace winLib {
+		// sliding window: the cost per pixel doesn't depend on the radius
+		bool boxBlur(Image& image, unsigned int radius, unsigned int passes = 1);
+		// exact kernel with a radius of 3 sigma: the cost per pixel grows with sigma,
+		// boxBlur(image, radius, 3) comes close to a big gaussian blur at a constant cost
+		bool gaussianBlur(Image& image, float sigma);
+
+		// kernel is row major with size * size entries, size has to be 3 or 5
+		// result = sum(kernel * pixel) / divisor + bias (the alpha channel is filtered too)
+		bool convolve(Image& image, const float* kernel, unsigned int size, float divisor = 1.f, float bias = 0.f);
+
+		// row major 4x5 matrix in the order red, green, blue, alpha, offset
+		// the offset is in [0;1] and scaled to [0;255]
+		bool colorMatrix(Image& image, const float matrix[20]);
+
+		// lookup table for the color channels (and the alpha channel if alpha is set)
+		bool applyLUT(Image& image, const unsigned char lut[256], bool alpha = false);
+
+		// brightness in [-1;1], contrast in [0;...] (1 -> no change), gamma > 0 (1 -> no change)
+		bool brightnessContrastGamma(Image& image, float brightness = 0.f, float contrast = 1.f, float gamma = 1.f);
+		void buildLUT(unsigned char lut[256], float brightness = 0.f, float contrast = 1.f, float gamma = 1.f) noexcept;
+	}
+
+#endif
\ No newline at end of file
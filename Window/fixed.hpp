@@ -0,0 +1,136 @@
+#ifndef WINDOWS_WINDOW_FIXED_HPP
+	#define WINDOWS_WINDOW_FIXED_HPP
+
+	#include "util.hpp"
+	#include "vector2.hpp"
+
+	#include <compare>
+	#include <type_traits>
+
+	// Fixed point numbers with Frac fractional bits, stored in the signed integer T.
+	// All arithmetic is integer only and constexpr, so the same inputs give the same bits everywhere.
+	// Products and quotients of an int based fixed go through a 64 bit intermediate. Products round down (towards
+	// negative infinity), quotients truncate towards zero like integer division.
+
+	namespace winLib {
+		template <unsigned int Frac, class T = int>
+		class fixed {
+		public:
+			static_assert(std::is_integral_v<T> && std::is_signed_v<T>, "fixed needs a signed integer type");
+			static_assert(Frac > 0 && Frac < sizeof(T) * 8 - 1, "fixed needs at least one integer bit");
+
+			using raw_type = T;
+			using wide_type = std::conditional_t<(sizeof(T) < sizeof(long long)), long long, T>;
+
+			static constexpr unsigned int FRACTION_BITS = Frac;
+			static constexpr T ONE = T(1) << Frac;
+			static constexpr T HALF = T(1) << (Frac - 1);
+
+			T raw;
+
+			constexpr fixed() noexcept : raw(0) {}
+			constexpr fixed(int value) noexcept : raw(static_cast<T>(static_cast<T>(value) * ONE)) {}
+			// rounds to the nearest representable value
+			explicit constexpr fixed(double value) noexcept : raw(static_cast<T>(value * static_cast<double>(ONE) + (value < 0 ? -0.5 : 0.5))) {}
+
+			static constexpr fixed fromRaw(T raw) noexcept { fixed result; result.raw = raw; return result; }
+			static constexpr fixed fromFloat(double value) noexcept { return fixed(value); }
+			static constexpr fixed epsilon() noexcept { return fromRaw(1); }
+
+			// to an other number of fraction bits (rounds down if bits are lost)
+			template <unsigned int F, class R = T>
+			constexpr fixed<F, R> convert() const noexcept {
+				if constexpr (F >= Frac)
+					return fixed<F, R>::fromRaw(static_cast<R>(static_cast<R>(raw) << (F - Frac)));
+				else
+					return fixed<F, R>::fromRaw(static_cast<R>(raw >> (Frac - F)));
+			}
+
+			constexpr T floor() const noexcept { return raw >> Frac; }
+			constexpr T ceil() const noexcept { return (raw + (ONE - 1)) >> Frac; }
+			constexpr T round() const noexcept { return (raw + HALF) >> Frac; }	// halves round up
+			constexpr fixed fraction() const noexcept { return fromRaw(raw & (ONE - 1)); }
+
+			constexpr float toFloat() const noexcept { return static_cast<float>(raw) / static_cast<float>(ONE); }
+			constexpr double toDouble() const noexcept { return static_cast<double>(raw) / static_cast<double>(ONE); }
+
+			const std::string str() const { return std::to_string(toDouble()); }
+			friend std::ostream& operator<<(std::ostream& output, const fixed& value) { output << value.str(); return output; }
+
+			constexpr fixed operator+ (const fixed& other)	const noexcept { return fromRaw(raw + other.raw); }
+			constexpr fixed operator- (const fixed& other)	const noexcept { return fromRaw(raw - other.raw); }
+			constexpr fixed operator* (const fixed& other)	const noexcept { return fromRaw(static_cast<T>((static_cast<wide_type>(raw) * other.raw) >> Frac)); }
+			constexpr fixed operator/ (const fixed& other)	const noexcept { return fromRaw(static_cast<T>((static_cast<wide_type>(raw) << Frac) / other.raw)); }
+
+			// with an integer: the product is exact, the quotient truncates towards zero
+			constexpr fixed operator* (int t)				const noexcept { return fromRaw(raw * t); }
+			constexpr fixed operator/ (int t)				const noexcept { return fromRaw(raw / t); }
+
+			constexpr fixed& operator+=(const fixed& other)	noexcept { raw += other.raw; return *this; }
+			constexpr fixed& operator-=(const fixed& other)	noexcept { raw -= other.raw; return *this; }
+			constexpr fixed& operator*=(const fixed& other)	noexcept { return *this = *this * other; }
+			constexpr fixed& operator/=(const fixed& other)	noexcept { return *this = *this / other; }
+			constexpr fixed& operator*=(int t)				noexcept { raw *= t; return *this; }
+			constexpr fixed& operator/=(int t)				noexcept { raw /= t; return *this; }
+
+			constexpr fixed operator+ ()					const noexcept { return *this; }
+			constexpr fixed operator- ()					const noexcept { return fromRaw(-raw); }
+
+			constexpr bool operator==(const fixed& other)	const noexcept = default;
+			constexpr auto operator<=>(const fixed& other)	const noexcept = default;
+		};
+
+		// fixed point vector, the arithmetic of vector2<T> without any float conversion
+		template <unsigned int Frac, class R>
+		class vector2<fixed<Frac, R>> {
+		public:
+			using value_type = fixed<Frac, R>;
+
+			value_type x, y;
+			constexpr vector2() noexcept : x(0), y(0) {}
+			constexpr vector2(value_type x, value_type y) noexcept : x(x), y(y) {}
+			// integer (pixel) coordinates
+			constexpr vector2(const vector2<int>& other) noexcept : x(other.x), y(other.y) {}
+
+			static constexpr vector2 fromFloat(const vector2<float>& other) noexcept { return vector2(value_type(static_cast<double>(other.x)), value_type(static_cast<double>(other.y))); }
+
+			constexpr vector2<int> floor() const noexcept { return vector2<int>(static_cast<int>(x.floor()), static_cast<int>(y.floor())); }
+			constexpr vector2<int> ceil() const noexcept { return vector2<int>(static_cast<int>(x.ceil()), static_cast<int>(y.ceil())); }
+			constexpr vector2<int> round() const noexcept { return vector2<int>(static_cast<int>(x.round()), static_cast<int>(y.round())); }
+			constexpr vector2<float> toFloat() const noexcept { return vector2<float>(x.toFloat(), y.toFloat()); }
+
+			constexpr vector2 perp() const noexcept { return vector2(-y, x); }
+			constexpr vector2 maximum(const vector2& other) const noexcept { return vector2(x > other.x ? x : other.x, y > other.y ? y : other.y); }
+			constexpr vector2 minimum(const vector2& other) const noexcept { return vector2(x < other.x ? x : other.x, y < other.y ? y : other.y); }
+
+			// exact, the results have 2 * Frac fraction bits (no rounding, no overflow for |coordinates| < 2^30 raw)
+			constexpr long long dot(const vector2& other) const noexcept { return static_cast<long long>(x.raw) * other.x.raw + static_cast<long long>(y.raw) * other.y.raw; }
+			constexpr long long cross(const vector2& other) const noexcept { return static_cast<long long>(x.raw) * other.y.raw - static_cast<long long>(y.raw) * other.x.raw; }
+
+			const std::string str() const { return std::string("vector2{ x: ") + x.str() + ", y:" + y.str() + "}"; }
+			friend std::ostream& operator<<(std::ostream& output, const vector2& vector) { output << vector.str(); return output; }
+
+			constexpr vector2 operator+ (const vector2& other)		const noexcept { return vector2(x + other.x, y + other.y); }
+			constexpr vector2 operator- (const vector2& other)		const noexcept { return vector2(x - other.x, y - other.y); }
+			constexpr vector2 operator* (const value_type& t)		const noexcept { return vector2(x * t, y * t); }
+			constexpr vector2 operator/ (const value_type& t)		const noexcept { return vector2(x / t, y / t); }
+			constexpr vector2 operator* (int t)						const noexcept { return vector2(x * t, y * t); }
+
+			constexpr vector2& operator+=(const vector2& other)		noexcept { x += other.x; y += other.y; return *this; }
+			constexpr vector2& operator-=(const vector2& other)		noexcept { x -= other.x; y -= other.y; return *this; }
+			constexpr vector2& operator*=(const value_type& t)		noexcept { x *= t; y *= t; return *this; }
+			constexpr vector2& operator*=(int t)					noexcept { x *= t; y *= t; return *this; }
+
+			constexpr vector2 operator- ()							const noexcept { return vector2(-x, -y); }
+
+			constexpr bool operator==(const vector2& other)			const noexcept { return x == other.x && y == other.y; }
+			constexpr bool operator!=(const vector2& other)			const noexcept { return x != other.x || y != other.y; }
+		};
+
+		using fixed8  = fixed<8>;	// sub pixel coordinates of the rasterizer
+		using fixed16 = fixed<16>;
+		using vector2x8  = vector2<fixed8>;
+		using vector2x16 = vector2<fixed16>;
+	}
+
+#endif
\ No newline at end of file
@@ -1,91 +1,383 @@
 #include "image.hpp"
 
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
 namespace winLib {
 	void GDI_PLUS_IMAGE_LOADER::gdi_plus_startup() noexcept {
-		const Gdiplus::GdiplusStartupInput startupInput;
-		GdiplusStartup(&token, &startupInput, nullptr);
+		#ifdef WINDOWS_WINDOW_WIN32
+			const Gdiplus::GdiplusStartupInput startupInput;
+			GdiplusStartup(&token, &startupInput, nullptr);
+		#endif
 	}
 
 	void GDI_PLUS_IMAGE_LOADER::gdi_plus_shutdown() noexcept {
-		Gdiplus::GdiplusShutdown(token);
+		#ifdef WINDOWS_WINDOW_WIN32
+			Gdiplus::GdiplusShutdown(token);
+		#endif
 	}
 
-	Image::Image(unsigned int width, unsigned int height) {
-		this->width = width;
-		this->height = height;
-		this->memory = new unsigned int[width * height];
+	void* allocateAligned(size_t bytes, size_t alignment) noexcept {
+		#ifdef WINDOWS_WINDOW_WIN32
+			return _aligned_malloc(bytes ? bytes : 1, alignment);
+		#else
+			// aligned_alloc wants a multiple of the alignment
+			return std::aligned_alloc(alignment, bytes ? (bytes + alignment - 1) / alignment * alignment : alignment);
+		#endif
+	}
+
+	void freeAligned(void* memory) noexcept {
+		#ifdef WINDOWS_WINDOW_WIN32
+			_aligned_free(memory);
+		#else
+			std::free(memory);
+		#endif
+	}
+
+	Image::Image() noexcept {
+		this->width = 0;
+		this->height = 0;
+		this->memory = nullptr;
+		this->stride = 0;
+		this->format = PIXEL_BGRA8;
+		this->pool = nullptr;
+		this->capacity = 0;
+		this->owner = false;
 	}
 
-	Image::Image(std::string& image_file) {
+	Image::Image(unsigned int width, unsigned int height, PixelFormat format, ImagePool* pool) : Image() {
+		if (!allocate(width, height, format, pool))
+			throw std::bad_alloc();
+	}
+
+	Image::Image(std::string& image_file) : Image() {
 		if (!load_image_file(image_file)) {
 			// TODO handle error
 		}
 	}
 
+	Image::Image(Image&& image) noexcept : Image() {
+		*this = std::move(image);
+	}
+
 	Image::~Image() {
-		if (this->memory)
-			delete this->memory;
+		release();
+	}
+
+	Image& Image::operator= (Image&& image) noexcept {
+		if (this == &image)
+			return *this;
+
+		release();
+
+		width = image.width;
+		height = image.height;
+		memory = image.memory;
+		stride = image.stride;
+		format = image.format;
+		pool = image.pool;
+		capacity = image.capacity;
+		owner = image.owner;
+
+		image.memory = nullptr;
+		image.owner = false;
+		image.pool = nullptr;
+		image.capacity = 0;
+		image.release();
+
+		return *this;
+	}
+
+	Image Image::view(void* memory, unsigned int width, unsigned int height, unsigned int stride, PixelFormat format) noexcept {
+		Image image;
+
+		if (!memory)
+			return image;
+
+		image.width = width;
+		image.height = height;
+		image.memory = static_cast<unsigned int*>(memory);
+		image.stride = stride;
+		image.format = format;
+
+		return image;
+	}
+
+	Image Image::clone() const {
+		Image copy(width, height, format);
+		const size_t row_bytes = static_cast<size_t>(width) * pixelFormatSize(format);
+
+		if (memory)
+			for (unsigned int y = 0; y < height; y++)
+				std::memcpy(copy.row(y), row(y), row_bytes);
+
+		return copy;
+	}
+
+	void Image::release() noexcept {
+		if (memory && owner) {
+			if (pool)
+				pool->deallocate(memory, capacity);
+			else
+				freeAligned(memory);
+		}
+
+		width = 0;
+		height = 0;
+		memory = nullptr;
+		stride = 0;
+		pool = nullptr;
+		capacity = 0;
+		owner = false;
+	}
+
+	bool Image::allocate(unsigned int width, unsigned int height, PixelFormat format, ImagePool* pool) {
+		release();
+
+		const size_t row_bytes = static_cast<size_t>(width) * pixelFormatSize(format);
+		const size_t bytes = row_bytes * height;
+
+		void* block = nullptr;
+		size_t block_capacity = bytes;
+
+		if (pool)
+			block = pool->allocate(bytes, block_capacity);
+		else
+			block = allocateAligned(bytes);
+
+		if (!block)
+			return false;
+
+		this->width = width;
+		this->height = height;
+		this->memory = static_cast<unsigned int*>(block);
+		this->stride = static_cast<unsigned int>(row_bytes);
+		this->format = format;
+		this->pool = pool;
+		this->capacity = block_capacity;
+		this->owner = true;
+
+		return true;
+	}
+
+	bool Image::isView() const noexcept {
+		return memory && !owner;
+	}
+
+	unsigned char* Image::row(unsigned int y) const noexcept {
+		return reinterpret_cast<unsigned char*>(memory) + static_cast<size_t>(y) * stride;
 	}
 
 	unsigned int Image::getColor(unsigned int x, unsigned int y) noexcept {
 		if (x < 0 || x >= width || y < 0 || y >= height || !memory)
 			return 0x00000000;
 
-		return *(memory + x + y * width);
+		if (format == PIXEL_BGRA8)
+			return reinterpret_cast<const unsigned int*>(row(y))[x];
+
+		const unsigned char* address = row(y) + static_cast<size_t>(x) * pixelFormatSize(format);
+
+		return convertColor(loadPixel(address, format), format, PIXEL_BGRA8);
 	}
 
 	bool Image::setColor(unsigned int x, unsigned int y, unsigned int color_code) noexcept {
 		if (x < 0 || x >= width || y < 0 || y >= height || !memory)
 			return false;
 
-		*(memory + x + y * width) = color_code;
+		if (format == PIXEL_BGRA8) {
+			reinterpret_cast<unsigned int*>(row(y))[x] = color_code;
+			return true;
+		}
+
+		unsigned char* address = row(y) + static_cast<size_t>(x) * pixelFormatSize(format);
+
+		storePixel(address, format, convertColor(color_code, PIXEL_BGRA8, format));
 
 		return true;
 	}
 
-	Image* Image::getSubimage(unsigned int src_x, unsigned int src_y, unsigned int width, unsigned int height) {
-		Image* subimage = new Image(width, height);
+	bool Image::convert(PixelFormat format) {
+		if (format >= PIXEL_FORMAT_COUNT)
+			return false;
+
+		if (isView())
+			return false;
 
-		for (unsigned int i = 0; i < width; i++) {
-			for (unsigned int j = 0; j < height; j++) {
-				subimage->setColor(i, j, this->getColor(src_x + i, src_y + j));
+		if (format == this->format || !memory) {
+			this->format = format;
+			return true;
+		}
+
+		// same pixel size -> convert in place
+		if (pixelFormatSize(format) == pixelFormatSize(this->format)) {
+			for (unsigned int y = 0; y < height; y++)
+				convertPixels(row(y), this->format, row(y), format, width);
+
+			this->format = format;
+			return true;
+		}
+
+		Image converted(width, height, format);
+
+		for (unsigned int y = 0; y < height; y++)
+			convertPixels(row(y), this->format, converted.row(y), format, width);
+
+		*this = std::move(converted);
+
+		return true;
+	}
+
+	Image Image::getSubimage(unsigned int src_x, unsigned int src_y, unsigned int width, unsigned int height) noexcept {
+		Image view;
+
+		if (!memory || src_x >= this->width || src_y >= this->height)
+			return view;
+
+		view.width = std::min(width, this->width - src_x);
+		view.height = std::min(height, this->height - src_y);
+		view.memory = reinterpret_cast<unsigned int*>(row(src_y) + static_cast<size_t>(src_x) * pixelFormatSize(format));
+		view.stride = stride;
+		view.format = format;
+
+		return view;
+	}
+
+	ImagePool::ImagePool(size_t max_cached_bytes) noexcept {
+		this->cached_bytes = 0;
+		this->max_cached_bytes = max_cached_bytes;
+	}
+
+	ImagePool::~ImagePool() {
+		trim();
+	}
+
+	Image ImagePool::acquire(unsigned int width, unsigned int height, PixelFormat format) {
+		return Image(width, height, format, this);
+	}
+
+	void ImagePool::trim() noexcept {
+		const std::lock_guard<std::mutex> guard(lock);
+
+		for (std::vector<void*>& blocks : free_blocks) {
+			for (void* block : blocks)
+				freeAligned(block);
+			blocks.clear();
+		}
+
+		cached_bytes = 0;
+	}
+
+	size_t ImagePool::cachedBytes() const noexcept {
+		const std::lock_guard<std::mutex> guard(lock);
+		return cached_bytes;
+	}
+
+	void* ImagePool::allocate(size_t bytes, size_t& capacity) {
+		size_t size_class = MIN_CLASS;
+
+		while ((static_cast<size_t>(1) << size_class) < bytes && size_class < MIN_CLASS + CLASSES)
+			size_class++;
+
+		// too big for the pool
+		if (size_class >= MIN_CLASS + CLASSES) {
+			capacity = 0;
+			return allocateAligned(bytes);
+		}
+
+		capacity = static_cast<size_t>(1) << size_class;
+
+		{
+			const std::lock_guard<std::mutex> guard(lock);
+			std::vector<void*>& blocks = free_blocks[size_class - MIN_CLASS];
+
+			if (!blocks.empty()) {
+				void* block = blocks.back();
+				blocks.pop_back();
+				cached_bytes -= capacity;
+				return block;
 			}
 		}
 
-		return subimage;
+		return allocateAligned(capacity);
+	}
+
+	void ImagePool::deallocate(void* memory, size_t capacity) noexcept {
+		if (!memory)
+			return;
+
+		size_t size_class = MIN_CLASS;
+
+		while ((static_cast<size_t>(1) << size_class) < capacity && size_class < MIN_CLASS + CLASSES)
+			size_class++;
+
+		// not allocated by a size class (or the cache is full)
+		if (capacity == 0 || size_class >= MIN_CLASS + CLASSES || (static_cast<size_t>(1) << size_class) != capacity) {
+			freeAligned(memory);
+			return;
+		}
+
+		{
+			const std::lock_guard<std::mutex> guard(lock);
+
+			if (cached_bytes + capacity <= max_cached_bytes) {
+				try {
+					free_blocks[size_class - MIN_CLASS].push_back(memory);
+					cached_bytes += capacity;
+					return;
+				} catch (...) {
+					// fall through and free the block
+				}
+			}
+		}
+
+		freeAligned(memory);
 	}
 
 	bool Image::load_image_file(const std::string& image_file) {
 		// clear out existing image
-		if (this->memory)
-			delete this->memory;
+		release();
 
 		// Check file exists
 		if (!std::filesystem::exists(image_file)) {
-			OutputDebugString(Txt("The input file doesn't exist!"));
+			DEBUGNUMBER("The input file %s doesn't exist!\n", 512, image_file.c_str())
 			return false;
 		}
 
+		#ifndef WINDOWS_WINDOW_WIN32
+			DEBUGNUMBER("Can't load %s: there is no image decoder without gdi+\n", 512, image_file.c_str())
+			return false;
+		#else
+
 		// Load image from file
 		Gdiplus::Bitmap* bmp = Gdiplus::Bitmap::FromFile(convertS2W(image_file).c_str());
 
 		if (bmp->GetLastStatus() != Gdiplus::Ok)
 			return false;
 
-		this->width = bmp->GetWidth();
-		this->height = bmp->GetHeight();
+		if (!allocate(bmp->GetWidth(), bmp->GetHeight(), PIXEL_BGRA8, nullptr)) {
+			delete bmp;
+			return false;
+		}
 
-		this->memory = new unsigned int[this->width * this->height];
+		// PixelFormat32bppARGB is 0xAARRGGBB -> the rows can be copied as they are
+		const Gdiplus::Rect rect(0, 0, static_cast<int>(width), static_cast<int>(height));
+		Gdiplus::BitmapData data = {};
 
-		for (int y = 0; y < static_cast<long long>(height); y++)
-			for (int x = 0; x < static_cast<long long>(width); x++) {
-				Gdiplus::Color c;
-				bmp->GetPixel(x, y, &c);
-				this->setColor(static_cast<unsigned int>(x), static_cast<unsigned int>(y), static_cast<unsigned int>(c.GetValue()));
-			}
+		if (bmp->LockBits(&rect, Gdiplus::ImageLockModeRead, PixelFormat32bppARGB, &data) != Gdiplus::Ok) {
+			delete bmp;
+			release();
+			return false;
+		}
+
+		for (unsigned int y = 0; y < height; y++)
+			std::memcpy(row(y), static_cast<const unsigned char*>(data.Scan0) + static_cast<long long>(y) * data.Stride, static_cast<size_t>(width) * sizeof(unsigned int));
+
+		bmp->UnlockBits(&data);
 
 		delete bmp;
 
 		return true;
+		#endif
 	}
 }
@@ -2,43 +2,56 @@
 	#define WINDOWS_WINDOW_IMAGE_HPP
 
 	#include "util.hpp"
-
-	// I'm sorry... A library but:
-	// TODO rewrite all the image loader code!
-	#ifndef min
-		#define min(a, b) ((a < b) ? a : b)
-	#endif
-	#ifndef max
-		#define max(a, b) ((a > b) ? a : b)
-	#endif
-	#include <objidl.h>
-	#include <gdiplus.h>
-
-	#if defined(__MINGW32__)
-		#include <gdiplus/gdiplusinit.h>
-	#else
-		#include <gdiplusinit.h>
-	#endif
-
-	#include <shlwapi.h>
-
-	#if !defined(__MINGW32__)
-		#pragma comment(lib, "gdiplus.lib")
-		#pragma comment(lib, "Shlwapi.lib")
+	#include "pixel.hpp"
+
+	#include <mutex>
+	#include <vector>
+
+	#ifdef WINDOWS_WINDOW_WIN32
+		// I'm sorry... A library but:
+		// TODO rewrite all the image loader code!
+		#ifndef min
+			#define min(a, b) ((a < b) ? a : b)
+		#endif
+		#ifndef max
+			#define max(a, b) ((a > b) ? a : b)
+		#endif
+		#include <objidl.h>
+		#include <gdiplus.h>
+
+		#if defined(__MINGW32__)
+			#include <gdiplus/gdiplusinit.h>
+		#else
+			#include <gdiplusinit.h>
+		#endif
+
+		#include <shlwapi.h>
+
+		#if !defined(__MINGW32__)
+			#pragma comment(lib, "gdiplus.lib")
+			#pragma comment(lib, "Shlwapi.lib")
+		#endif
+
+		#undef min
+		#undef max
 	#endif
 
-	#undef min
-	#undef max
-
 	namespace winLib {
+		// without gdi+ (WINDOWS_WINDOW_POSIX) both calls do nothing and Image::load_image_file fails
 		class GDI_PLUS_IMAGE_LOADER {
 		public:
-			ULONG_PTR token;
+			#ifdef WINDOWS_WINDOW_WIN32
+				ULONG_PTR token;
+			#else
+				unsigned long long token;
+			#endif
 
 			void gdi_plus_startup() noexcept;
 			void gdi_plus_shutdown() noexcept;
 		};
 
+		class ImagePool;
+
 		class Image {
 		public:
 			enum Flip {
@@ -48,22 +61,86 @@
 			};
 
 			unsigned int width, height;
-			unsigned int* memory;
+			unsigned int* memory;	// first pixel, inside of the parent memory if the image is a view
+			unsigned int stride;	// bytes between the start of two rows
+			PixelFormat format;
 
-			Image(unsigned int width, unsigned int height);
+			Image() noexcept;
+			Image(unsigned int width, unsigned int height, PixelFormat format = PIXEL_BGRA8, ImagePool* pool = nullptr);
 			Image(std::string& image_file);
 			Image(const Image& image) = delete;
+			Image(Image&& image) noexcept;
 			~Image();
 
 			Image& operator= (const Image&) = delete;
+			Image& operator= (Image&& image) noexcept;
+
+			// non owning image on top of existing pixels (e.g. a render target)
+			static Image view(void* memory, unsigned int width, unsigned int height, unsigned int stride, PixelFormat format = PIXEL_BGRA8) noexcept;
 
+			// deep copy, the copy always owns its memory
+			Image clone() const;
+			// frees the memory (if owned) and leaves an empty image
+			void release() noexcept;
+
+			bool isView() const noexcept;
+			unsigned char* row(unsigned int y) const noexcept;
+
+			// both take / return the color code as PIXEL_BGRA8, whatever format the image is stored in
 			unsigned int getColor(unsigned int x, unsigned int y) noexcept;
 			bool setColor(unsigned int x, unsigned int y, unsigned int color_code = 0xFFFFFFFF) noexcept;
 
-			Image* getSubimage(unsigned int src_x, unsigned int src_y, unsigned int width, unsigned int height);
+			// converts the whole image once, so blits don't have to convert every pixel
+			// false for a view: it can't reallocate the pixels and would change the format under its parent
+			bool convert(PixelFormat format);
+
+			// zero copy view into this image, only valid as long as this image is alive and not reallocated
+			// (writable, so only of a non const image: clone() the view for a copy)
+			Image getSubimage(unsigned int src_x, unsigned int src_y, unsigned int width, unsigned int height) noexcept;
 
 			bool load_image_file(const std::string& image_file);
+
+		private:
+			ImagePool* pool;	// the pool the memory is returned to, nullptr -> aligned heap memory
+			size_t capacity;	// allocated bytes, 0 for views and empty images
+			bool owner;
+
+			bool allocate(unsigned int width, unsigned int height, PixelFormat format, ImagePool* pool);
 		};
+
+		// Recycles the pixel memory of short living images (size classes of power of two bytes).
+		// The pool has to outlive all images acquired from it.
+		class ImagePool {
+		public:
+			static constexpr size_t ALIGNMENT = 64;
+
+			ImagePool(size_t max_cached_bytes = 64 * 1024 * 1024) noexcept;
+			ImagePool(const ImagePool&) = delete;
+			~ImagePool();
+
+			ImagePool& operator= (const ImagePool&) = delete;
+
+			Image acquire(unsigned int width, unsigned int height, PixelFormat format = PIXEL_BGRA8);
+
+			// frees all cached memory
+			void trim() noexcept;
+			size_t cachedBytes() const noexcept;
+
+			void* allocate(size_t bytes, size_t& capacity);
+			void deallocate(void* memory, size_t capacity) noexcept;
+
+		private:
+			static constexpr size_t MIN_CLASS = 6;	// 64 bytes
+			static constexpr size_t CLASSES = 26;	// up to 2 GiB
+
+			mutable std::mutex lock;
+			std::vector<void*> free_blocks[CLASSES];
+			size_t cached_bytes;
+			size_t max_cached_bytes;
+		};
+
+		void* allocateAligned(size_t bytes, size_t alignment = ImagePool::ALIGNMENT) noexcept;
+		void freeAligned(void* memory) noexcept;
 	}
 
 #endif
\ No newline at end of file
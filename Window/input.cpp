@@ -1,176 +1,470 @@
 #include "input.hpp"
+#include "util.hpp"
+
+#include <chrono>
 
 namespace winLib {
-	bool handle_input(const MSG* msg, KeyBoard* keyboard, Mouse* mouse) noexcept {
-		if (!msg || !keyboard || !mouse)
-			return false;
-
-		switch (msg->message) {
-		case WM_KEYUP:
-		case WM_KEYDOWN: {
-			const unsigned int key_code = static_cast<unsigned int>(msg->wParam);
-			const bool is_down = (msg->lParam & 0x80000000 /* 0x80000000 == (1U << 31)*/) == 0;
-
-			#define key_case(first, winFirst, winLast)							\
-				if (key_code >= winFirst && key_code <= winLast) {				\
-					keyboard->buttons[key_code - winFirst + first] = is_down;	\
-					break;														\
-				}																\
-
-			key_case(KEY_SPACE, VK_SPACE, '9')
-			key_case(KEY_A, 'A', 'Z');
-			key_case(KEY_NUM_0, VK_NUMPAD0, VK_F24)
-			key_case(KEY_SHIFT_L, VK_LSHIFT, VK_RMENU)
-			key_case(KEY_SHIFT, VK_SHIFT, VK_CAPITAL)
+	long long input_time() noexcept {
+		#ifdef WINDOWS_WINDOW_WIN32
+			static const long long frequency = [] {
+				LARGE_INTEGER f;
+				QueryPerformanceFrequency(&f);
+				return f.QuadPart;
+			}();
 
-			break;
-		}
-		case WM_MOUSEWHEEL: {
-			const short delta = GET_WHEEL_DELTA_WPARAM(msg->wParam);
+			LARGE_INTEGER counter;
+			QueryPerformanceCounter(&counter);
 
-			mouse->scroll_delta += delta;
+			// split to not overflow for large counter values
+			const long long seconds = counter.QuadPart / frequency;
+			const long long rest = counter.QuadPart % frequency;
 
-			break;
-		}
-		case WM_MOUSEMOVE: {
-			const unsigned short x = msg->lParam & 0xFFFF, y = (msg->lParam >> 16) & 0xFFFF;
+			return seconds * 1000000 + rest * 1000000 / frequency;
+		#else
+			return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+		#endif
+	}
 
-			mouse->x = x;
-			mouse->y = y;
+	// Mouse keeps the low 16 bits of the client position (like the lParam of the messages), a position left of or
+	// above the window is negative again as short
+	static int signed_position(unsigned short coordinate) noexcept {
+		return static_cast<short>(coordinate);
+	}
 
-			break;
-		}
-		case WM_LBUTTONDOWN: {
-			mouse->buttons[MOUSE_LEFT] = true;
-			break;
-		}
-		case WM_LBUTTONUP: {
-			mouse->buttons[MOUSE_LEFT] = false;
-			break;
-		}
-		case WM_RBUTTONDOWN: {
-			mouse->buttons[MOUSE_RIGHT] = true;
-			break;
-		}
-		case WM_RBUTTONUP: {
-			mouse->buttons[MOUSE_RIGHT] = false;
-			break;
+	static void push_input_event(InputEventQueue* events, const Mouse* mouse, InputEventType type, unsigned short code = 0, short wheel_delta = 0, bool repeat = false, long long time = 0) noexcept {
+		if (!events)
+			return;
+
+		InputEvent event = {};
+		event.time = time ? time : input_time();
+		event.type = type;
+		event.repeat = repeat;
+		event.code = code;
+		event.x = signed_position(mouse->x);
+		event.y = signed_position(mouse->y);
+		event.wheel_delta = wheel_delta;
+
+		events->push(event);
+	}
+
+	static void add_mouse_point(InputEventQueue* events, Mouse* mouse, int x, int y, long long time) noexcept {
+		// if the history is full the newest point replaces the last one
+		if (mouse->history_count == MOUSE_HISTORY_CAPACITY)
+			mouse->history_count--;
+
+		mouse->history[mouse->history_count++] = MousePoint{ x, y, time };
+
+		mouse->x = static_cast<unsigned short>(x);
+		mouse->y = static_cast<unsigned short>(y);
+
+		push_input_event(events, mouse, INPUT_MOUSE_MOVE, 0, 0, false, time);
+	}
+
+	static void set_key(KeyBoard* keyboard, size_t key, bool is_down) noexcept {
+		const bool was_down = keyboard->down.test(key);
+
+		keyboard->down.set(key, is_down);
+
+		if (is_down && !was_down)
+			keyboard->pressed.set(key);
+		else if (!is_down && was_down)
+			keyboard->released.set(key);
+	}
+
+	static void set_mouse_button(InputEventQueue* events, Mouse* mouse, unsigned short button, bool is_down) noexcept {
+		const unsigned char bit = static_cast<unsigned char>(1 << button);
+
+		if (is_down) {
+			mouse->pressed |= bit & ~mouse->buttons;
+			mouse->buttons |= bit;
+		} else {
+			mouse->released |= bit & mouse->buttons;
+			mouse->buttons &= ~bit;
 		}
-		case WM_MBUTTONDOWN: {
-			mouse->buttons[MOUSE_MIDDLE] = true;
-			break;
+
+		push_input_event(events, mouse, is_down ? INPUT_MOUSE_DOWN : INPUT_MOUSE_UP, button);
+	}
+
+	#ifdef WINDOWS_WINDOW_WIN32
+		// WM_MOUSEMOVE is only generated once per message loop, so at low frame rates
+		// the system keeps the points in between: take all of them since the last call
+		static void collect_mouse_points(const MSG* msg, Mouse* mouse, InputEventQueue* events, short x, short y) noexcept {
+			constexpr int MAX_POINTS = 64;	// the system doesn't keep more
+
+			POINT screen = { x, y };
+			ClientToScreen(msg->hwnd, &screen);
+
+			MOUSEMOVEPOINT current = {};
+			current.x = screen.x & 0xFFFF;
+			current.y = screen.y & 0xFFFF;
+			current.time = msg->time;
+
+			MOUSEMOVEPOINT points[MAX_POINTS];
+			const int count = GetMouseMovePointsEx(sizeof(MOUSEMOVEPOINT), &current, points, MAX_POINTS, GMMP_USE_DISPLAY_POINTS);
+
+			if (count <= 0) {
+				add_mouse_point(events, mouse, x, y, input_time());
+				return;
+			}
+
+			// the points are sorted newest first
+			int fresh = 0;
+			while (fresh < count && !(points[fresh].x == mouse->last_point.x && points[fresh].y == mouse->last_point.y && points[fresh].time == mouse->last_point.time))
+				fresh++;
+
+			// first move: the older points belong to another window
+			if (mouse->last_point.time == 0)
+				fresh = 1;
+
+			const long long now = input_time();
+			const DWORD tick = GetTickCount();
+
+			for (int i = fresh - 1; i >= 0; i--) {
+				// coordinates are 16 bit, negative ones are left of / above the primary monitor
+				POINT point = { points[i].x > 32767 ? points[i].x - 65536 : points[i].x, points[i].y > 32767 ? points[i].y - 65536 : points[i].y };
+				ScreenToClient(msg->hwnd, &point);
+
+				add_mouse_point(events, mouse, point.x, point.y, now - static_cast<long long>(tick - points[i].time) * 1000);
+			}
+
+			mouse->last_point = points[0];
 		}
-		case WM_MBUTTONUP: {
-			mouse->buttons[MOUSE_MIDDLE] = false;
-			break;
+
+		bool register_raw_mouse(HWND window_handle) noexcept {
+			RAWINPUTDEVICE device = {};
+			device.usUsagePage = 0x01;	// generic desktop controls
+			device.usUsage = 0x02;		// mouse
+			device.dwFlags = 0;
+			device.hwndTarget = window_handle;
+
+			if (!RegisterRawInputDevices(&device, 1, sizeof(device))) {
+				DEBUGSTRING(Txt("Failed to register the raw mouse input! Last Error: %ul\n"), 100, GetLastError())
+				return false;
+			}
+
+			return true;
 		}
-		case WM_XBUTTONDOWN: {
-			const unsigned short x_button = GET_XBUTTON_WPARAM(msg->wParam);
 
-			if (x_button == XBUTTON1) {
-				mouse->buttons[MOUSE_X1] = true;
+		bool handle_input(const MSG* msg, KeyBoard* keyboard, Mouse* mouse, InputEventQueue* events) noexcept {
+			if (!msg || !keyboard || !mouse)
+				return false;
+
+			switch (msg->message) {
+			case WM_SYSKEYUP:
+			case WM_SYSKEYDOWN:
+			case WM_KEYUP:
+			case WM_KEYDOWN: {
+				const unsigned int key_code = static_cast<unsigned int>(msg->wParam);
+				const bool is_down = (msg->lParam & 0x80000000 /* 0x80000000 == (1U << 31)*/) == 0;
+				int key = -1;
+
+				// alt and F10 come as system keys, the default window procedure still needs them (alt + F4, menus)
+				if (msg->message == WM_SYSKEYDOWN || msg->message == WM_SYSKEYUP) {
+					TranslateMessage(msg);
+					DispatchMessage(msg);
+				}
+
+				#define key_case(first, winFirst, winLast)							\
+					if (key == -1 && key_code >= winFirst && key_code <= winLast)	\
+						key = key_code - winFirst + first;							\
+
+				key_case(KEY_SPACE, VK_SPACE, '9')
+				key_case(KEY_A, 'A', 'Z');
+				key_case(KEY_NUM_0, VK_NUMPAD0, VK_F24)
+				key_case(KEY_SHIFT_L, VK_LSHIFT, VK_RMENU)
+				key_case(KEY_SHIFT, VK_SHIFT, VK_CAPITAL)
+
+				#undef key_case
+
+				if (key == -1)
+					break;
+
+				const bool repeat = is_down && keyboard->down.test(key);
+
+				set_key(keyboard, key, is_down);
+				push_input_event(events, mouse, is_down ? INPUT_KEY_DOWN : INPUT_KEY_UP, static_cast<unsigned short>(key), 0, repeat);
+
 				break;
 			}
+			case WM_MOUSEWHEEL: {
+				const short delta = GET_WHEEL_DELTA_WPARAM(msg->wParam);
 
-			if (x_button == XBUTTON2) {
-				mouse->buttons[MOUSE_X2] = true;
+				mouse->scroll_delta += delta;
+				push_input_event(events, mouse, INPUT_MOUSE_WHEEL, 0, delta);
+
+				break;
 			}
+			case WM_MOUSEMOVE: {
+				const unsigned short x = msg->lParam & 0xFFFF, y = (msg->lParam >> 16) & 0xFFFF;
 
-			break;
-		}
-		case WM_XBUTTONUP: {
-			const unsigned short x_button = GET_XBUTTON_WPARAM(msg->wParam);
+				collect_mouse_points(msg, mouse, events, static_cast<short>(x), static_cast<short>(y));
+
+				mouse->x = x;
+				mouse->y = y;
+
+				break;
+			}
+			case WM_INPUT: {
+				RAWINPUT raw;
+				UINT size = sizeof(raw);
+
+				if (GetRawInputData(reinterpret_cast<HRAWINPUT>(msg->lParam), RID_INPUT, &raw, &size, sizeof(RAWINPUTHEADER)) != static_cast<UINT>(-1)
+					&& raw.header.dwType == RIM_TYPEMOUSE && !(raw.data.mouse.usFlags & MOUSE_MOVE_ABSOLUTE)
+					&& (raw.data.mouse.lLastX || raw.data.mouse.lLastY)) {
+					mouse->raw_dx += raw.data.mouse.lLastX;
+					mouse->raw_dy += raw.data.mouse.lLastY;
+
+					if (events) {
+						InputEvent event = {};
+						event.time = input_time();
+						event.type = INPUT_MOUSE_RAW;
+						event.x = signed_position(mouse->x);
+						event.y = signed_position(mouse->y);
+						event.dx = raw.data.mouse.lLastX;
+						event.dy = raw.data.mouse.lLastY;
 
-			if (x_button == XBUTTON1) {
-				mouse->buttons[MOUSE_X1] = false;
+						events->push(event);
+					}
+				}
+
+				// the default window procedure has to clean up after WM_INPUT
+				DispatchMessage(msg);
+				break;
+			}
+			case WM_LBUTTONDOWN: {
+				set_mouse_button(events, mouse, MOUSE_LEFT, true);
+				break;
+			}
+			case WM_LBUTTONUP: {
+				set_mouse_button(events, mouse, MOUSE_LEFT, false);
+				break;
+			}
+			case WM_RBUTTONDOWN: {
+				set_mouse_button(events, mouse, MOUSE_RIGHT, true);
+				break;
+			}
+			case WM_RBUTTONUP: {
+				set_mouse_button(events, mouse, MOUSE_RIGHT, false);
+				break;
+			}
+			case WM_MBUTTONDOWN: {
+				set_mouse_button(events, mouse, MOUSE_MIDDLE, true);
+				break;
+			}
+			case WM_MBUTTONUP: {
+				set_mouse_button(events, mouse, MOUSE_MIDDLE, false);
 				break;
 			}
+			case WM_XBUTTONUP:
+			case WM_XBUTTONDOWN: {
+				const unsigned short x_button = GET_XBUTTON_WPARAM(msg->wParam);
+				const bool is_down = msg->message == WM_XBUTTONDOWN;
+
+				if (x_button == XBUTTON1) {
+					set_mouse_button(events, mouse, MOUSE_X1, is_down);
+					break;
+				}
+
+				if (x_button == XBUTTON2) {
+					set_mouse_button(events, mouse, MOUSE_X2, is_down);
+				}
 
-			if (x_button == XBUTTON2) {
-				mouse->buttons[MOUSE_X2] = false;
+				break;
+			}
+			case WM_MOUSELEAVE: {
+				mouse->focus = false;
+				push_input_event(events, mouse, INPUT_MOUSE_LEAVE);
+				break;
+			}
+			case WM_MOUSEHOVER: {
+				mouse->focus = true;
+				push_input_event(events, mouse, INPUT_MOUSE_ENTER);
+				break;
+			}
+			default: {
+				TranslateMessage(msg);
+				DispatchMessage(msg);
+				break;
+			}
 			}
 
-			break;
+			return true;
 		}
-		case WM_MOUSELEAVE: {
-			mouse->focus = false;
+	#endif
+
+	void apply_input_event(const InputEvent& event, KeyBoard* keyboard, Mouse* mouse) noexcept {
+		if (!keyboard || !mouse)
+			return;
+
+		switch (event.type) {
+		case INPUT_KEY_DOWN:
+		case INPUT_KEY_UP: {
+			if (event.code < KEYS_COUNT)
+				set_key(keyboard, event.code, event.type == INPUT_KEY_DOWN);
 			break;
 		}
-		case WM_MOUSEHOVER: {
-			mouse->focus = true;
+		case INPUT_MOUSE_DOWN:
+		case INPUT_MOUSE_UP: {
+			if (event.code < MOUSE_COUNT)
+				set_mouse_button(nullptr, mouse, event.code, event.type == INPUT_MOUSE_DOWN);
 			break;
 		}
-		default: {
-			TranslateMessage(msg);
-			DispatchMessage(msg);
+		case INPUT_MOUSE_MOVE: {
+			add_mouse_point(nullptr, mouse, event.x, event.y, event.time);
 			break;
 		}
+		case INPUT_MOUSE_RAW: {
+			mouse->raw_dx += event.dx;
+			mouse->raw_dy += event.dy;
+			break;
 		}
-
-		return true;
-	}
-
-	LPCWSTR nativ_cursor_idc(NATIV_CURSOR cursor) noexcept {
-		switch (cursor) {
-		case NATIV_CURSOR::ARROW: {
-			return IDC_ARROW;
-		}
-		case NATIV_CURSOR::TEXT: {
-			return IDC_IBEAM;
-		}
-		case NATIV_CURSOR::WAIT: {
-			return IDC_WAIT;
-		}
-		case NATIV_CURSOR::CROSS: {
-			return IDC_CROSS;
-		}
-		case NATIV_CURSOR::ARROW_UP: {
-			return IDC_UPARROW;
-		}
-		case NATIV_CURSOR::PEN: {
-			// there is no macro from win32 api for this...
-			return MAKEINTRESOURCE(32631);
-		}
-		case NATIV_CURSOR::DIAGONAL_1: {
-			return IDC_SIZENWSE;
-		}
-		case NATIV_CURSOR::DIAGONAL_2: {
-			return IDC_SIZENESW;
-		}
-		case NATIV_CURSOR::HORIZONTAL: {
-			return IDC_SIZEWE;
-		}
-		case NATIV_CURSOR::VERTICAL: {
-			return IDC_SIZENS;
-		}
-		case NATIV_CURSOR::MOVE: {
-			return IDC_SIZEALL;
-		}
-		case NATIV_CURSOR::NO: {
-			return IDC_NO;
+		case INPUT_MOUSE_WHEEL: {
+			mouse->scroll_delta += event.wheel_delta;
+			break;
 		}
-		case NATIV_CURSOR::LINK: {
-			return IDC_HAND;
+		case INPUT_MOUSE_ENTER: {
+			mouse->focus = true;
+			break;
 		}
-		case NATIV_CURSOR::WAIT_ARROW: {
-			return IDC_APPSTARTING;
+		case INPUT_MOUSE_LEAVE: {
+			mouse->focus = false;
+			break;
 		}
-		case NATIV_CURSOR::HELP: {
-			return IDC_HELP;
 		}
-		case NATIV_CURSOR::LOCATION: {
-			return IDC_PIN;
+	}
+
+	void dispatch_input_event(InputEvent event, KeyBoard* keyboard, Mouse* mouse, InputEventQueue* events) noexcept {
+		if (!keyboard || !mouse)
+			return;
+
+		if (!event.time)
+			event.time = input_time();
+
+		if (event.type == INPUT_KEY_DOWN)
+			event.repeat = event.code < KEYS_COUNT && keyboard->down.test(event.code);
+
+		apply_input_event(event, keyboard, mouse);
+
+		// the position after the event, like handle_input does it (a move keeps its own, it isn't cut to 16 bits)
+		if (event.type != INPUT_MOUSE_MOVE) {
+			event.x = signed_position(mouse->x);
+			event.y = signed_position(mouse->y);
 		}
-		case NATIV_CURSOR::PERSON: {
-			return IDC_PERSON;
+
+		if (events)
+			events->push(event);
+	}
+
+	void next_input_frame(KeyBoard* keyboard, Mouse* mouse) noexcept {
+		if (keyboard) {
+			keyboard->previous = keyboard->down;
+			keyboard->pressed.reset();
+			keyboard->released.reset();
 		}
-		default: {
-			return IDC_ARROW;
+
+		if (mouse) {
+			mouse->previous = mouse->buttons;
+			mouse->pressed = 0;
+			mouse->released = 0;
+			mouse->scroll_delta = 0;
+			mouse->raw_dx = 0;
+			mouse->raw_dy = 0;
+			mouse->history_count = 0;
 		}
+	}
+
+	KeyShortcut create_key_shortcut(std::initializer_list<unsigned short> keys, bool exact) noexcept {
+		KeyShortcut shortcut = {};
+		shortcut.exact = exact;
+
+		for (const unsigned short key : keys) {
+			if (key < KEYS_COUNT)
+				shortcut.keys.set(key);
 		}
+
+		if (keys.size() > 0 && *(keys.end() - 1) < KEYS_COUNT)
+			shortcut.trigger.set(*(keys.end() - 1));
+
+		return shortcut;
 	}
 
-	HCURSOR load_nativ_cursor(NATIV_CURSOR cursor) noexcept {
-		return LoadCursor(nullptr, nativ_cursor_idc(cursor));
+	size_t match_key_shortcuts(const KeyBoard& keyboard, const std::span<const KeyShortcut>& shortcuts, unsigned int* matches, size_t max_matches) noexcept {
+		if (!keyboard.pressed.any() || !matches)
+			return 0;
+
+		size_t count = 0;
+
+		for (size_t i = 0; i < shortcuts.size() && count < max_matches; i++) {
+			if (shortcuts[i].matches(keyboard))
+				matches[count++] = static_cast<unsigned int>(i);
+		}
+
+		return count;
 	}
+
+	#ifdef WINDOWS_WINDOW_WIN32
+		LPCWSTR nativ_cursor_idc(NATIV_CURSOR cursor) noexcept {
+			switch (cursor) {
+			case NATIV_CURSOR::ARROW: {
+				return IDC_ARROW;
+			}
+			case NATIV_CURSOR::TEXT: {
+				return IDC_IBEAM;
+			}
+			case NATIV_CURSOR::WAIT: {
+				return IDC_WAIT;
+			}
+			case NATIV_CURSOR::CROSS: {
+				return IDC_CROSS;
+			}
+			case NATIV_CURSOR::ARROW_UP: {
+				return IDC_UPARROW;
+			}
+			case NATIV_CURSOR::PEN: {
+				// there is no macro from win32 api for this...
+				return MAKEINTRESOURCE(32631);
+			}
+			case NATIV_CURSOR::DIAGONAL_1: {
+				return IDC_SIZENWSE;
+			}
+			case NATIV_CURSOR::DIAGONAL_2: {
+				return IDC_SIZENESW;
+			}
+			case NATIV_CURSOR::HORIZONTAL: {
+				return IDC_SIZEWE;
+			}
+			case NATIV_CURSOR::VERTICAL: {
+				return IDC_SIZENS;
+			}
+			case NATIV_CURSOR::MOVE: {
+				return IDC_SIZEALL;
+			}
+			case NATIV_CURSOR::NO: {
+				return IDC_NO;
+			}
+			case NATIV_CURSOR::LINK: {
+				return IDC_HAND;
+			}
+			case NATIV_CURSOR::WAIT_ARROW: {
+				return IDC_APPSTARTING;
+			}
+			case NATIV_CURSOR::HELP: {
+				return IDC_HELP;
+			}
+			case NATIV_CURSOR::LOCATION: {
+				return IDC_PIN;
+			}
+			case NATIV_CURSOR::PERSON: {
+				return IDC_PERSON;
+			}
+			default: {
+				return IDC_ARROW;
+			}
+			}
+		}
+
+		HCURSOR load_nativ_cursor(NATIV_CURSOR cursor) noexcept {
+			return LoadCursor(nullptr, nativ_cursor_idc(cursor));
+		}
+	#endif
 }
@@ -1,7 +1,11 @@
 #ifndef WINDOWS_WINDOW_INPUT_HPP
 	#define WINDOWS_WINDOW_INPUT_HPP
 
-	#include <windows.h>
+	#include "util.hpp"
+	#include "queue.hpp"
+
+	#include <initializer_list>
+	#include <span>
 
 	namespace winLib {
 		enum {
@@ -119,8 +123,75 @@
 			KEYS_COUNT
 		};
 
+		// fixed size bit set, all operations work on whole 64 bit words
+		template <size_t Bits>
+		struct BitSet {
+			static constexpr size_t WORDS = (Bits + 63) / 64;
+
+			unsigned long long words[WORDS];
+
+			constexpr bool test(size_t bit) const noexcept {
+				return (words[bit >> 6] >> (bit & 63)) & 1;
+			}
+
+			constexpr void set(size_t bit, bool value = true) noexcept {
+				const unsigned long long mask = 1ULL << (bit & 63);
+				words[bit >> 6] = value ? (words[bit >> 6] | mask) : (words[bit >> 6] & ~mask);
+			}
+
+			constexpr void reset() noexcept {
+				for (size_t i = 0; i < WORDS; i++)
+					words[i] = 0;
+			}
+
+			constexpr bool any() const noexcept {
+				unsigned long long result = 0;
+				for (size_t i = 0; i < WORDS; i++)
+					result |= words[i];
+				return result != 0;
+			}
+
+			// every bit of other is set in this
+			constexpr bool contains(const BitSet& other) const noexcept {
+				unsigned long long missing = 0;
+				for (size_t i = 0; i < WORDS; i++)
+					missing |= other.words[i] & ~words[i];
+				return missing == 0;
+			}
+
+			// every bit of other is set in this or in also
+			constexpr bool contains(const BitSet& other, const BitSet& also) const noexcept {
+				unsigned long long missing = 0;
+				for (size_t i = 0; i < WORDS; i++)
+					missing |= other.words[i] & ~(words[i] | also.words[i]);
+				return missing == 0;
+			}
+
+			constexpr bool intersects(const BitSet& other) const noexcept {
+				unsigned long long common = 0;
+				for (size_t i = 0; i < WORDS; i++)
+					common |= other.words[i] & words[i];
+				return common != 0;
+			}
+
+			// no bit is set in this which isn't set in other or outside of mask
+			constexpr bool onlyWithin(const BitSet& other, const BitSet& mask) const noexcept {
+				unsigned long long extra = 0;
+				for (size_t i = 0; i < WORDS; i++)
+					extra |= words[i] & mask.words[i] & ~other.words[i];
+				return extra == 0;
+			}
+		};
+
+		using KeyBits = BitSet<KEYS_COUNT>;
+
+		// pressed and released collect every transition since the last next_input_frame(...),
+		// so a key which goes down and up again within one frame is in both
 		struct KeyBoard {
-			bool buttons[KEYS_COUNT];
+			KeyBits down;		// the current state
+			KeyBits previous;	// the state at the end of the last frame
+			KeyBits pressed;	// went down in this frame (auto repeat doesn't count)
+			KeyBits released;	// went up in this frame
 		};
 
 		enum {
@@ -133,14 +204,81 @@
 			MOUSE_COUNT
 		};
 
+		// a position of the mouse in client coordinates (can be outside of the window while a button is held)
+		struct MousePoint {
+			int x, y;
+			long long time;		// microseconds, see input_time()
+		};
+
+		constexpr size_t MOUSE_HISTORY_CAPACITY = 256;
+
 		struct Mouse {
 			unsigned short x, y;		// the x and y position of the mouse
 			short scroll_delta;			// the last scroll_delta before the next call of onUpdate of the mouse
-			bool buttons[MOUSE_COUNT];	// All the button states of the mouse
+			unsigned char buttons;		// All the button states of the mouse, bit MOUSE_... is set if it is down
+			unsigned char previous;		// buttons at the end of the last frame
+			unsigned char pressed;		// went down in this frame
+			unsigned char released;		// went up in this frame
 			bool focus;					// When the mouse is inside of the window-client-area -> true
+
+			int raw_dx, raw_dy;			// relative motion of the device in this frame (WM_INPUT), not clamped to the window or screen
+										// Win32 only: the X11 backend reports positions, these stay 0 there
+			unsigned short history_count;
+			MousePoint history[MOUSE_HISTORY_CAPACITY];	// every position in this frame, oldest first (the newest one is x, y)
+
+			#ifdef WINDOWS_WINDOW_WIN32
+				MOUSEMOVEPOINT last_point;	// newest system point of the last WM_MOUSEMOVE, in screen coordinates
+			#endif
+		};
+
+		enum InputEventType : unsigned char {
+			INPUT_KEY_DOWN,		// code is a KEY_... value
+			INPUT_KEY_UP,
+			INPUT_MOUSE_DOWN,	// code is a MOUSE_... value
+			INPUT_MOUSE_UP,
+			INPUT_MOUSE_MOVE,
+			INPUT_MOUSE_WHEEL,
+			INPUT_MOUSE_ENTER,
+			INPUT_MOUSE_LEAVE,
+			INPUT_MOUSE_RAW		// relative device motion in dx, dy (Win32 only, see register_raw_mouse)
 		};
 
-		bool handle_input(const MSG* msg, KeyBoard* keyboard, Mouse* mouse) noexcept;
+		struct InputEvent {
+			long long time;				// microseconds, see input_time()
+			InputEventType type;
+			bool repeat;				// INPUT_KEY_DOWN only: the key was already down (auto repeat)
+			unsigned short code;		// KEY_... or MOUSE_..., 0 for the other events
+			int x, y;					// the mouse position when the event happened (negative left of / above the window)
+			short wheel_delta;			// INPUT_MOUSE_WHEEL only
+			int dx, dy;					// INPUT_MOUSE_RAW only
+		};
+
+		constexpr size_t INPUT_EVENT_CAPACITY = 1024;
+
+		// filled by the thread which runs the message pump, drained by the app (can be another thread)
+		// push fails when it is full: the new event is dropped, the ones already queued stay
+		using InputEventQueue = SPSCQueue<InputEvent, INPUT_EVENT_CAPACITY>;
+
+		// high resolution time stamp (QueryPerformanceCounter / steady_clock) in microseconds
+		long long input_time() noexcept;
+
+		#ifdef WINDOWS_WINDOW_WIN32
+			// updates the polled state and pushes the matching event if events is set
+			// events which don't fit into the queue anymore are dropped, the polled state is updated anyway
+			bool handle_input(const MSG* msg, KeyBoard* keyboard, Mouse* mouse, InputEventQueue* events = nullptr) noexcept;
+			// asks the system for WM_INPUT messages of the mouse (for Mouse::raw_dx / raw_dy)
+			bool register_raw_mouse(HWND window_handle) noexcept;
+		#endif
+
+		// updates the polled state like handle_input did when the event was created (used to replay recorded input)
+		void apply_input_event(const InputEvent& event, KeyBoard* keyboard, Mouse* mouse) noexcept;
+		// handle_input for backends without MSG: fills in the mouse position and the repeat flag,
+		// updates the polled state and pushes the event if events is set
+		void dispatch_input_event(InputEvent event, KeyBoard* keyboard, Mouse* mouse, InputEventQueue* events) noexcept;
+
+		// call once per frame after the app has seen the input: previous = down, pressed = released = nothing
+		// also clears the raw motion and the mouse history
+		void next_input_frame(KeyBoard* keyboard, Mouse* mouse) noexcept;
 
 		enum NATIV_CURSOR {
 			ARROW,			// Default cursor
@@ -162,11 +300,39 @@
 			PERSON			// Person select cursor
 		};
 
-		LPCWSTR nativ_cursor_idc(NATIV_CURSOR cursor) noexcept;
-		HCURSOR load_nativ_cursor(NATIV_CURSOR cursor) noexcept;
+		#ifdef WINDOWS_WINDOW_WIN32
+			LPCWSTR nativ_cursor_idc(NATIV_CURSOR cursor) noexcept;
+			HCURSOR load_nativ_cursor(NATIV_CURSOR cursor) noexcept;
+		#endif
+
+		// KEY_SHIFT_L ... KEY_ALT
+		constexpr KeyBits MODIFIER_KEYS = [] {
+			KeyBits bits = {};
+			for (size_t key = KEY_SHIFT_L; key <= KEY_ALT; key++)
+				bits.set(key);
+			return bits;
+		}();
+
+		// a chord like Ctrl + Shift + S: it fires in the frame the last key goes down while the others are held
+		// a key that went down and up again within the frame counts as held, so a quick tap still fires
+		struct KeyShortcut {
+			KeyBits keys;		// all of them have to be down or pressed in this frame
+			KeyBits trigger;	// has to be pressed in this frame
+			bool exact;			// no other modifier (shift, ctrl, alt) may be down
+
+			bool matches(const KeyBoard& keyboard) const noexcept {
+				return keyboard.pressed.intersects(trigger)
+					&& keyboard.down.contains(keys, keyboard.pressed)
+					&& (!exact || keyboard.down.onlyWithin(keys, MODIFIER_KEYS));
+			}
+		};
+
+		// the last key is the trigger, e.g. create_key_shortcut({ KEY_CTRL, KEY_SHIFT, KEY_S })
+		KeyShortcut create_key_shortcut(std::initializer_list<unsigned short> keys, bool exact = false) noexcept;
 
-		// TODO
-		//void create_key_shortcut() noexcept {}
+		// writes the indices of the matching shortcuts into matches, returns how many matched
+		// frames without a pressed key return immediately
+		size_t match_key_shortcuts(const KeyBoard& keyboard, const std::span<const KeyShortcut>& shortcuts, unsigned int* matches, size_t max_matches) noexcept;
 	}
 
 #endif
\ No newline at end of file
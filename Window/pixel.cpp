@@ -0,0 +1,261 @@
+#include "pixel.hpp"
+
+#include <cstring>
+
+namespace winLib {
+	// pixels are converted in chunks, so multi pass conversions stay inside of the l1 cache
+	constexpr size_t PIXEL_CHUNK = 1024;
+
+	static bool isBGRA(PixelFormat format) noexcept {
+		return format == PIXEL_BGRA8 || format == PIXEL_BGRA8_PREMULTIPLIED;
+	}
+
+	static unsigned int swizzleRB(unsigned int c) noexcept {
+		return (c & 0xFF00FF00) | ((c >> 16) & 0xFF) | ((c & 0xFF) << 16);
+	}
+
+	// (x * a) / 255 without a division, exact for all 8 bit inputs
+	static unsigned int mul255(unsigned int x, unsigned int a) noexcept {
+		const unsigned int t = x * a + 128;
+		return (t + (t >> 8)) >> 8;
+	}
+
+	static unsigned int premultiply(unsigned int c) noexcept {
+		const unsigned int a = c >> 24;
+
+		return (c & 0xFF000000) | (mul255((c >> 16) & 0xFF, a) << 16) | (mul255((c >> 8) & 0xFF, a) << 8) | mul255(c & 0xFF, a);
+	}
+
+	static unsigned int unpremultiply(unsigned int c) noexcept {
+		static const auto reciprocal = [] {
+			struct Table { unsigned int values[256]; } table{};
+			for (unsigned int a = 1; a < 256; a++)
+				table.values[a] = (255u * 65536u + a / 2) / a;
+			return table;
+		}();
+
+		const unsigned int a = c >> 24;
+
+		if (a == 0)
+			return 0;
+		if (a == 255)
+			return c;
+
+		auto channel = [&](unsigned int v) {
+			const unsigned int r = (v * reciprocal.values[a] + 32768) >> 16;
+			return r > 255 ? 255u : r;
+		};
+
+		return (c & 0xFF000000) | (channel((c >> 16) & 0xFF) << 16) | (channel((c >> 8) & 0xFF) << 8) | channel(c & 0xFF);
+	}
+
+	static unsigned int bgraToRGB565(unsigned int c) noexcept {
+		return ((c >> 8) & 0xF800) | ((c >> 5) & 0x07E0) | ((c >> 3) & 0x001F);
+	}
+
+	static unsigned int rgb565ToBGRA(unsigned int c) noexcept {
+		const unsigned int r = (c >> 11) & 0x1F, g = (c >> 5) & 0x3F, b = c & 0x1F;
+
+		// replicate the high bits into the low bits, so 0x1F becomes 0xFF
+		return 0xFF000000 | (((r << 3) | (r >> 2)) << 16) | (((g << 2) | (g >> 4)) << 8) | ((b << 3) | (b >> 2));
+	}
+
+	#ifdef WINDOWS_WINDOW_X86
+		WINDOWS_WINDOW_TARGET("ssse3")
+		static size_t swizzleRB_SSSE3(const unsigned int* src, unsigned int* dst, size_t count) noexcept {
+			const __m128i mask = _mm_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+			size_t i = 0;
+
+			for (; i + 4 <= count; i += 4) {
+				const __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_shuffle_epi8(pixels, mask));
+			}
+
+			return i;
+		}
+
+		// sse2 is the base line on x64, so no feature check is needed
+		static size_t premultiply_SSE2(unsigned int* pixels, size_t count) noexcept {
+			const __m128i zero = _mm_setzero_si128();
+			const __m128i round = _mm_set1_epi16(128);
+			const __m128i alpha_mask = _mm_set1_epi32(static_cast<int>(0xFF000000));
+			size_t i = 0;
+
+			auto multiply = [&](__m128i p) {
+				__m128i a = _mm_shufflelo_epi16(p, _MM_SHUFFLE(3, 3, 3, 3));
+				a = _mm_shufflehi_epi16(a, _MM_SHUFFLE(3, 3, 3, 3));
+
+				const __m128i t = _mm_add_epi16(_mm_mullo_epi16(p, a), round);
+				return _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+			};
+
+			for (; i + 4 <= count; i += 4) {
+				const __m128i p = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pixels + i));
+				const __m128i lo = multiply(_mm_unpacklo_epi8(p, zero));
+				const __m128i hi = multiply(_mm_unpackhi_epi8(p, zero));
+				const __m128i result = _mm_packus_epi16(lo, hi);
+
+				// keep the original alpha channel
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(pixels + i), _mm_or_si128(_mm_andnot_si128(alpha_mask, result), _mm_and_si128(alpha_mask, p)));
+			}
+
+			return i;
+		}
+	#endif
+
+	static void swizzleRB(const unsigned int* src, unsigned int* dst, size_t count) noexcept {
+		size_t i = 0;
+
+		#ifdef WINDOWS_WINDOW_X86
+			if (cpuSupportsSSSE3())
+				i = swizzleRB_SSSE3(src, dst, count);
+		#endif
+
+		for (; i < count; i++)
+			dst[i] = swizzleRB(src[i]);
+	}
+
+	static void premultiply(unsigned int* pixels, size_t count) noexcept {
+		size_t i = 0;
+
+		#ifdef WINDOWS_WINDOW_X86
+			i = premultiply_SSE2(pixels, count);
+		#endif
+
+		for (; i < count; i++)
+			pixels[i] = premultiply(pixels[i]);
+	}
+
+	static void unpremultiply(unsigned int* pixels, size_t count) noexcept {
+		for (size_t i = 0; i < count; i++)
+			pixels[i] = unpremultiply(pixels[i]);
+	}
+
+	// converts between two 32 bit formats, in place if src == dst
+	static void convert32(const unsigned int* src, PixelFormat src_format, unsigned int* dst, PixelFormat dst_format, size_t count) noexcept {
+		if (isBGRA(src_format) != isBGRA(dst_format))
+			swizzleRB(src, dst, count);
+		else if (src != dst)
+			std::memmove(dst, src, count * sizeof(unsigned int));
+
+		if (isPremultiplied(src_format) == isPremultiplied(dst_format))
+			return;
+
+		if (isPremultiplied(dst_format))
+			premultiply(dst, count);
+		else
+			unpremultiply(dst, count);
+	}
+
+	static void toBGRA8(const void* src, PixelFormat format, unsigned int* dst, size_t count) noexcept {
+		switch (format) {
+		case PIXEL_RGB565: {
+			const unsigned short* s = static_cast<const unsigned short*>(src);
+			for (size_t i = 0; i < count; i++)
+				dst[i] = rgb565ToBGRA(s[i]);
+			break;
+		}
+		case PIXEL_A8: {
+			const unsigned char* s = static_cast<const unsigned char*>(src);
+			for (size_t i = 0; i < count; i++)
+				dst[i] = (static_cast<unsigned int>(s[i]) << 24) | 0x00FFFFFF;
+			break;
+		}
+		default: {
+			convert32(static_cast<const unsigned int*>(src), format, dst, PIXEL_BGRA8, count);
+			break;
+		}
+		}
+	}
+
+	static void fromBGRA8(const unsigned int* src, void* dst, PixelFormat format, size_t count) noexcept {
+		switch (format) {
+		case PIXEL_RGB565: {
+			unsigned short* d = static_cast<unsigned short*>(dst);
+			for (size_t i = 0; i < count; i++)
+				d[i] = static_cast<unsigned short>(bgraToRGB565(src[i]));
+			break;
+		}
+		case PIXEL_A8: {
+			unsigned char* d = static_cast<unsigned char*>(dst);
+			for (size_t i = 0; i < count; i++)
+				d[i] = static_cast<unsigned char>(src[i] >> 24);
+			break;
+		}
+		default: {
+			convert32(src, PIXEL_BGRA8, static_cast<unsigned int*>(dst), format, count);
+			break;
+		}
+		}
+	}
+
+	unsigned int convertColor(unsigned int color, PixelFormat src_format, PixelFormat dst_format) noexcept {
+		if (src_format == dst_format)
+			return color;
+
+		unsigned int result = 0;
+		convertPixels(&color, src_format, &result, dst_format, 1);
+
+		return result;
+	}
+
+	bool convertPixels(const void* src, PixelFormat src_format, void* dst, PixelFormat dst_format, size_t count) noexcept {
+		if (!src || !dst || src_format >= PIXEL_FORMAT_COUNT || dst_format >= PIXEL_FORMAT_COUNT)
+			return false;
+
+		const unsigned int src_size = pixelFormatSize(src_format);
+		const unsigned int dst_size = pixelFormatSize(dst_format);
+
+		if (src == dst && src_size != dst_size)
+			return false;
+
+		if (src_format == dst_format) {
+			if (src != dst)
+				std::memmove(dst, src, count * src_size);
+			return true;
+		}
+
+		if (src_size == 4 && dst_size == 4) {
+			convert32(static_cast<const unsigned int*>(src), src_format, static_cast<unsigned int*>(dst), dst_format, count);
+			return true;
+		}
+
+		const unsigned char* s = static_cast<const unsigned char*>(src);
+		unsigned char* d = static_cast<unsigned char*>(dst);
+		unsigned int buffer[PIXEL_CHUNK];
+
+		for (size_t i = 0; i < count; i += PIXEL_CHUNK) {
+			const size_t n = count - i < PIXEL_CHUNK ? count - i : PIXEL_CHUNK;
+
+			toBGRA8(s + i * src_size, src_format, buffer, n);
+			fromBGRA8(buffer, d + i * dst_size, dst_format, n);
+		}
+
+		return true;
+	}
+
+	unsigned int loadPixel(const void* address, PixelFormat format) noexcept {
+		switch (pixelFormatSize(format)) {
+		case 1:
+			return *static_cast<const unsigned char*>(address);
+		case 2:
+			return *static_cast<const unsigned short*>(address);
+		default:
+			return *static_cast<const unsigned int*>(address);
+		}
+	}
+
+	void storePixel(void* address, PixelFormat format, unsigned int value) noexcept {
+		switch (pixelFormatSize(format)) {
+		case 1:
+			*static_cast<unsigned char*>(address) = static_cast<unsigned char>(value);
+			break;
+		case 2:
+			*static_cast<unsigned short*>(address) = static_cast<unsigned short>(value);
+			break;
+		default:
+			*static_cast<unsigned int*>(address) = value;
+			break;
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,46 @@
+#ifndef WINDOWS_WINDOW_PIXEL_HPP
+	#define WINDOWS_WINDOW_PIXEL_HPP
+
+	#include "util.hpp"
+
+	namespace winLib {
+		// Memory layout of a pixel. The color codes of all draw methods are always
+		// PIXEL_BGRA8 (0xAARRGGBB), the same layout StretchDIBits and Gdiplus use.
+		enum PixelFormat : unsigned char {
+			PIXEL_BGRA8,				// 0xAARRGGBB
+			PIXEL_RGBA8,				// 0xAABBGGRR
+			PIXEL_BGRA8_PREMULTIPLIED,	// 0xAARRGGBB, color channels multiplied with alpha
+			PIXEL_RGBA8_PREMULTIPLIED,	// 0xAABBGGRR, color channels multiplied with alpha
+			PIXEL_RGB565,				// 16 bit, red in the high bits, no alpha
+			PIXEL_A8,					// 8 bit alpha only
+
+			PIXEL_FORMAT_COUNT
+		};
+
+		constexpr unsigned int pixelFormatSize(PixelFormat format) noexcept {
+			switch (format) {
+			case PIXEL_RGB565:
+				return 2;
+			case PIXEL_A8:
+				return 1;
+			default:
+				return 4;
+			}
+		}
+
+		constexpr bool isPremultiplied(PixelFormat format) noexcept {
+			return format == PIXEL_BGRA8_PREMULTIPLIED || format == PIXEL_RGBA8_PREMULTIPLIED;
+		}
+
+		// converts a single pixel, only meant for the slow paths (getColor, setColor)
+		unsigned int convertColor(unsigned int color, PixelFormat src_format, PixelFormat dst_format) noexcept;
+
+		// converts count pixels from src to dst, src and dst may be the same buffer if both formats have the same size
+		bool convertPixels(const void* src, PixelFormat src_format, void* dst, PixelFormat dst_format, size_t count) noexcept;
+
+		// reads / writes a pixel at the given address in the given format (no conversion)
+		unsigned int loadPixel(const void* address, PixelFormat format) noexcept;
+		void storePixel(void* address, PixelFormat format, unsigned int value) noexcept;
+	}
+
+#endif
\ No newline at end of file
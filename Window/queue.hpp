@@ -0,0 +1,83 @@
+#ifndef WINDOWS_WINDOW_QUEUE_HPP
+	#define WINDOWS_WINDOW_QUEUE_HPP
+
+	#include <atomic>
+	#include <cstddef>
+
+	namespace winLib {
+		// Lock free ring buffer for exactly one producer and one consumer thread.
+		// Capacity has to be a power of two, push(...) fails instead of blocking when it is full.
+		template <class T, size_t Capacity>
+		class SPSCQueue {
+			static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "the capacity of a SPSCQueue has to be a power of two");
+
+		public:
+			SPSCQueue() noexcept : head(0), tail_cache(0), tail(0), head_cache(0) {}
+			SPSCQueue(const SPSCQueue&) = delete;
+
+			SPSCQueue& operator= (const SPSCQueue&) = delete;
+
+			// producer
+			bool push(const T& value) noexcept {
+				const size_t h = head.load(std::memory_order_relaxed);
+
+				// only look at the consumer index if the cached one says the queue is full
+				if (h - tail_cache >= Capacity) {
+					tail_cache = tail.load(std::memory_order_acquire);
+
+					if (h - tail_cache >= Capacity)
+						return false;
+				}
+
+				items[h & (Capacity - 1)] = value;
+				head.store(h + 1, std::memory_order_release);
+
+				return true;
+			}
+
+			// consumer
+			bool pop(T& value) noexcept {
+				const size_t t = tail.load(std::memory_order_relaxed);
+
+				if (t == head_cache) {
+					head_cache = head.load(std::memory_order_acquire);
+
+					if (t == head_cache)
+						return false;
+				}
+
+				value = items[t & (Capacity - 1)];
+				tail.store(t + 1, std::memory_order_release);
+
+				return true;
+			}
+
+			// consumer, drops everything that is queued right now
+			void clear() noexcept {
+				head_cache = head.load(std::memory_order_acquire);
+				tail.store(head_cache, std::memory_order_release);
+			}
+
+			size_t size() const noexcept {
+				return head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire);
+			}
+
+			bool empty() const noexcept {
+				return size() == 0;
+			}
+
+			static constexpr size_t capacity() noexcept {
+				return Capacity;
+			}
+
+		private:
+			// producer and consumer data live on different cache lines
+			alignas(64) std::atomic<size_t> head;
+			size_t tail_cache;
+			alignas(64) std::atomic<size_t> tail;
+			size_t head_cache;
+			alignas(64) T items[Capacity];
+		};
+	}
+
+#endif
\ No newline at end of file
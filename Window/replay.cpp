@@ -0,0 +1,359 @@
+#include "replay.hpp"
+
+#include <cstring>
+
+namespace winLib {
+	constexpr unsigned short INPUT_LOG_VERSION = 1;
+	constexpr size_t INPUT_LOG_FLUSH_SIZE = 64 * 1024;
+
+	enum {
+		FRAME_RESIZED = 1
+	};
+
+	static void log_put_varint(std::vector<unsigned char>& out, unsigned long long value) {
+		while (value >= 0x80) {
+			out.push_back(static_cast<unsigned char>(value | 0x80));
+			value >>= 7;
+		}
+		out.push_back(static_cast<unsigned char>(value));
+	}
+
+	static void log_put_zigzag(std::vector<unsigned char>& out, long long value) {
+		log_put_varint(out, (static_cast<unsigned long long>(value) << 1) ^ static_cast<unsigned long long>(value >> 63));
+	}
+
+	static void log_put32le(std::vector<unsigned char>& out, unsigned int value) {
+		for (int i = 0; i < 4; i++)
+			out.push_back(static_cast<unsigned char>(value >> (i * 8)));
+	}
+
+	static bool log_get_varint(const std::vector<unsigned char>& in, size_t& position, unsigned long long& value) noexcept {
+		value = 0;
+		for (int shift = 0; shift < 64; shift += 7) {
+			if (position >= in.size())
+				return false;
+
+			const unsigned char byte = in[position++];
+			value |= static_cast<unsigned long long>(byte & 0x7F) << shift;
+
+			if (!(byte & 0x80))
+				return true;
+		}
+
+		return false;
+	}
+
+	static bool log_get_zigzag(const std::vector<unsigned char>& in, size_t& position, long long& value) noexcept {
+		unsigned long long raw;
+		if (!log_get_varint(in, position, raw))
+			return false;
+
+		value = static_cast<long long>(raw >> 1) ^ -static_cast<long long>(raw & 1);
+		return true;
+	}
+
+	static bool log_get32le(const std::vector<unsigned char>& in, size_t& position, unsigned int& value) noexcept {
+		if (in.size() - position < 4)
+			return false;
+
+		value = 0;
+		for (int i = 0; i < 4; i++)
+			value |= static_cast<unsigned int>(in[position++]) << (i * 8);
+
+		return true;
+	}
+
+	InputRecorder::InputRecorder() noexcept {
+		frames = 0;
+		last_time = 0;
+		last_x = 0;
+		last_y = 0;
+		width = 0;
+		height = 0;
+	}
+
+	InputRecorder::~InputRecorder() {
+		stop();
+	}
+
+	bool InputRecorder::start(const std::string& path, unsigned int width, unsigned int height) {
+		if (isRecording())
+			return false;
+
+		stream.open(path, std::ios::binary | std::ios::trunc);
+
+		if (!stream) {
+			DEBUGNUMBER("Failed to open the input log %s\n", 512, path.c_str())
+			return false;
+		}
+
+		output.clear();
+		output.reserve(INPUT_LOG_FLUSH_SIZE * 2);
+		frame_events.clear();
+		frame_events.reserve(INPUT_EVENT_CAPACITY);
+
+		output.insert(output.end(), { 'W', 'L', 'I', 'R' });
+		output.push_back(INPUT_LOG_VERSION & 0xFF);
+		output.push_back(INPUT_LOG_VERSION >> 8);
+		output.push_back(0);
+		output.push_back(0);
+		log_put32le(output, width);
+		log_put32le(output, height);
+
+		this->width = width;
+		this->height = height;
+		frames = 0;
+		last_time = input_time();
+		last_x = 0;
+		last_y = 0;
+		pending.clear();
+
+		return true;
+	}
+
+	void InputRecorder::stop() {
+		if (!isRecording())
+			return;
+
+		flush();
+		stream.close();
+	}
+
+	bool InputRecorder::isRecording() const noexcept {
+		return stream.is_open();
+	}
+
+	void InputRecorder::record(float delta, unsigned int width, unsigned int height, InputEventQueue* events) noexcept {
+		// collect first, so the events reach the window even if the log is not open
+		frame_events.clear();
+
+		InputEvent event;
+		while (pending.pop(event)) {
+			if (frame_events.size() < frame_events.capacity())
+				frame_events.push_back(event);
+
+			if (events)
+				events->push(event);
+		}
+
+		if (!isRecording())
+			return;
+
+		const bool resized = width != this->width || height != this->height;
+
+		output.push_back(resized ? FRAME_RESIZED : 0);
+
+		if (resized) {
+			log_put_varint(output, width);
+			log_put_varint(output, height);
+
+			this->width = width;
+			this->height = height;
+		}
+
+		unsigned int delta_bits;
+		std::memcpy(&delta_bits, &delta, sizeof(delta_bits));
+		log_put32le(output, delta_bits);
+
+		log_put_varint(output, frame_events.size());
+
+		for (const InputEvent& e : frame_events) {
+			output.push_back(static_cast<unsigned char>(e.type | (e.repeat ? 0x80 : 0)));
+			log_put_varint(output, e.time > last_time ? e.time - last_time : 0);
+			last_time = e.time > last_time ? e.time : last_time;
+
+			// a button can go down somewhere else than the last move (no move in between, moves dropped)
+			if (e.type != INPUT_KEY_DOWN && e.type != INPUT_KEY_UP) {
+				log_put_zigzag(output, static_cast<long long>(e.x) - last_x);
+				log_put_zigzag(output, static_cast<long long>(e.y) - last_y);
+				last_x = e.x;
+				last_y = e.y;
+			}
+
+			switch (e.type) {
+			case INPUT_KEY_DOWN:
+			case INPUT_KEY_UP:
+			case INPUT_MOUSE_DOWN:
+			case INPUT_MOUSE_UP: {
+				output.push_back(static_cast<unsigned char>(e.code));
+				break;
+			}
+			case INPUT_MOUSE_WHEEL: {
+				log_put_zigzag(output, e.wheel_delta);
+				break;
+			}
+			case INPUT_MOUSE_RAW: {
+				log_put_zigzag(output, e.dx);
+				log_put_zigzag(output, e.dy);
+				break;
+			}
+			default:
+				break;
+			}
+		}
+
+		frames++;
+
+		if (output.size() >= INPUT_LOG_FLUSH_SIZE)
+			flush();
+	}
+
+	unsigned long long InputRecorder::framesRecorded() const noexcept {
+		return frames;
+	}
+
+	void InputRecorder::flush() {
+		if (!output.empty())
+			stream.write(reinterpret_cast<const char*>(output.data()), output.size());
+
+		output.clear();
+	}
+
+	InputReplay::InputReplay() noexcept {
+		width = 0;
+		height = 0;
+		position = 0;
+		frames = 0;
+		last_time = 0;
+		last_x = 0;
+		last_y = 0;
+		current_width = 0;
+		current_height = 0;
+	}
+
+	bool InputReplay::open(const std::string& path) {
+		std::ifstream stream(path, std::ios::binary | std::ios::ate);
+
+		if (!stream) {
+			DEBUGNUMBER("Failed to open the input log %s\n", 512, path.c_str())
+			return false;
+		}
+
+		const std::streamoff size = stream.tellg();
+		stream.seekg(0);
+
+		data.resize(static_cast<size_t>(size));
+		stream.read(reinterpret_cast<char*>(data.data()), size);
+
+		if (!stream || data.size() < 16 || std::memcmp(data.data(), "WLIR", 4) != 0 || (data[4] | data[5] << 8) != INPUT_LOG_VERSION) {
+			data.clear();
+			return false;
+		}
+
+		position = 8;
+		log_get32le(data, position, width);
+		log_get32le(data, position, height);
+
+		rewind();
+
+		return true;
+	}
+
+	bool InputReplay::next(InputFrame& frame) noexcept {
+		if (position >= data.size())
+			return false;
+
+		const unsigned char flags = data[position++];
+
+		if (flags & FRAME_RESIZED) {
+			unsigned long long w, h;
+			if (!log_get_varint(data, position, w) || !log_get_varint(data, position, h))
+				return false;
+
+			current_width = static_cast<unsigned int>(w);
+			current_height = static_cast<unsigned int>(h);
+		}
+
+		unsigned int delta_bits;
+		unsigned long long count;
+		if (!log_get32le(data, position, delta_bits) || !log_get_varint(data, position, count) || count > INPUT_EVENT_CAPACITY)
+			return false;
+
+		std::memcpy(&frame.delta, &delta_bits, sizeof(delta_bits));
+		frame.width = current_width;
+		frame.height = current_height;
+		frame.events.clear();
+
+		for (unsigned long long i = 0; i < count; i++) {
+			if (position >= data.size())
+				return false;
+
+			const unsigned char type = data[position++];
+
+			InputEvent event = {};
+			event.type = static_cast<InputEventType>(type & 0x7F);
+			event.repeat = (type & 0x80) != 0;
+
+			unsigned long long time;
+			if (!log_get_varint(data, position, time))
+				return false;
+
+			last_time += static_cast<long long>(time);
+			event.time = last_time;
+
+			if (event.type != INPUT_KEY_DOWN && event.type != INPUT_KEY_UP) {
+				long long dx, dy;
+				if (!log_get_zigzag(data, position, dx) || !log_get_zigzag(data, position, dy))
+					return false;
+
+				last_x = static_cast<int>(last_x + dx);
+				last_y = static_cast<int>(last_y + dy);
+			}
+
+			switch (event.type) {
+			case INPUT_KEY_DOWN:
+			case INPUT_KEY_UP:
+			case INPUT_MOUSE_DOWN:
+			case INPUT_MOUSE_UP: {
+				if (position >= data.size())
+					return false;
+
+				event.code = data[position++];
+				break;
+			}
+			case INPUT_MOUSE_WHEEL: {
+				long long delta;
+				if (!log_get_zigzag(data, position, delta))
+					return false;
+
+				event.wheel_delta = static_cast<short>(delta);
+				break;
+			}
+			case INPUT_MOUSE_RAW: {
+				long long dx, dy;
+				if (!log_get_zigzag(data, position, dx) || !log_get_zigzag(data, position, dy))
+					return false;
+
+				event.dx = static_cast<int>(dx);
+				event.dy = static_cast<int>(dy);
+				break;
+			}
+			default:
+				break;
+			}
+
+			event.x = last_x;
+			event.y = last_y;
+
+			frame.events.push_back(event);
+		}
+
+		frames++;
+
+		return true;
+	}
+
+	void InputReplay::rewind() noexcept {
+		position = data.empty() ? 0 : 16;
+		frames = 0;
+		last_time = 0;
+		last_x = 0;
+		last_y = 0;
+		current_width = width;
+		current_height = height;
+	}
+
+	unsigned long long InputReplay::framesReplayed() const noexcept {
+		return frames;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,83 @@
+#ifndef WINDOWS_WINDOW_REPLAY_HPP
+	#define WINDOWS_WINDOW_REPLAY_HPP
+
+	#include "util.hpp"
+	#include "input.hpp"
+
+	#include <fstream>
+	#include <string>
+	#include <vector>
+
+	// Binary input log (little endian):
+	//   header: "WLIR", version (u16), reserved (u16), width (u32), height (u32)
+	//   frame:  flags (u8), [width, height (varint) if the size changed], delta (f32), event count (varint), events
+	//   event:  type | repeat << 7 (u8), time since the last event (varint), then depending on the type
+	//           key: code (u8), mouse: x, y difference to the last mouse event (zigzag varint), then
+	//           button: code (u8), wheel: delta (zigzag varint), raw: dx, dy (zigzag varint)
+	// The mouse position of key events is the one of the last mouse event, so it is not stored.
+
+	namespace winLib {
+		struct InputFrame {
+			float delta;
+			unsigned int width, height;	// size of the render target in this frame
+			std::vector<InputEvent> events;
+		};
+
+		// Set Window::recorder to record every frame of Window::start.
+		class InputRecorder {
+		public:
+			InputEventQueue pending;	// handle_input writes here while recording, record(...) forwards it to the window
+
+			InputRecorder() noexcept;
+			InputRecorder(const InputRecorder&) = delete;
+			~InputRecorder();
+
+			InputRecorder& operator= (const InputRecorder&) = delete;
+
+			bool start(const std::string& path, unsigned int width, unsigned int height);
+			void stop();
+
+			bool isRecording() const noexcept;
+
+			// writes one frame with all pending events and moves them into events (if set)
+			void record(float delta, unsigned int width, unsigned int height, InputEventQueue* events = nullptr) noexcept;
+
+			unsigned long long framesRecorded() const noexcept;
+
+		private:
+			std::ofstream stream;
+			std::vector<unsigned char> output;
+			std::vector<InputEvent> frame_events;
+			unsigned long long frames;
+			long long last_time;
+			int last_x, last_y;
+			unsigned int width, height;
+
+			void flush();
+		};
+
+		class InputReplay {
+		public:
+			unsigned int width, height;	// size of the render target when the recording started
+
+			InputReplay() noexcept;
+
+			// reads the whole log into memory
+			bool open(const std::string& path);
+			// false at the end of the log or if the log is broken
+			bool next(InputFrame& frame) noexcept;
+			void rewind() noexcept;
+
+			unsigned long long framesReplayed() const noexcept;
+
+		private:
+			std::vector<unsigned char> data;
+			size_t position;
+			unsigned long long frames;
+			long long last_time;
+			int last_x, last_y;
+			unsigned int current_width, current_height;
+		};
+	}
+
+#endif
\ No newline at end of file
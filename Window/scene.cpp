@@ -0,0 +1,558 @@
+#include "scene.hpp"
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+
+namespace winLib {
+	static int floor_div(int value, int divisor) noexcept {
+		const int q = value / divisor;
+		return (value % divisor != 0 && value < 0) ? q - 1 : q;
+	}
+
+	static bool overlaps(const SceneObject& object, int x, int y, unsigned int w, unsigned int h) noexcept {
+		const long long ox2 = static_cast<long long>(object.x) + object.width;
+		const long long oy2 = static_cast<long long>(object.y) + object.height;
+		const long long x2 = static_cast<long long>(x) + w;
+		const long long y2 = static_cast<long long>(y) + h;
+
+		return object.x < x2 && ox2 > x && object.y < y2 && oy2 > y;
+	}
+
+	Scene::Scene(unsigned int cell_size) {
+		this->cell_size = cell_size ? cell_size : DEFAULT_SCENE_CELL_SIZE;
+		this->query_stamp = 0;
+		this->next_sequence = 0;
+		this->alive_count = 0;
+	}
+
+	SceneHandle Scene::addImage(int x, int y, Image* image, unsigned int scale, unsigned char flip, int layer) {
+		if (!image)
+			return INVALID_SCENE_HANDLE;
+
+		SceneObject object = {};
+		object.type = SCENE_IMAGE;
+		object.x = x;
+		object.y = y;
+		object.scale = scale ? scale : 1;
+		object.width = image->width * object.scale;
+		object.height = image->height * object.scale;
+		object.image = image;
+		object.flip = flip;
+		object.layer = layer;
+
+		return insert(std::move(object));
+	}
+
+	SceneHandle Scene::addRect(int x, int y, unsigned int w, unsigned int h, unsigned int color_code, int layer) {
+		SceneObject object = {};
+		object.type = SCENE_RECT;
+		object.x = x;
+		object.y = y;
+		object.width = w;
+		object.height = h;
+		object.color_code = color_code;
+		object.layer = layer;
+
+		return insert(std::move(object));
+	}
+
+	SceneHandle Scene::addPolygon(const std::span<vector2u>& points, unsigned int color_code, unsigned char structure, int layer) {
+		if (points.size() < 3)
+			return INVALID_SCENE_HANDLE;
+
+		// signed like the points moved by moveBy(...), a polygon may reach to the left of / above the origin
+		int min_x = static_cast<int>(points[0].x), min_y = static_cast<int>(points[0].y), max_x = min_x, max_y = min_y;
+
+		for (const vector2u& point : points) {
+			min_x = std::min(min_x, static_cast<int>(point.x));
+			min_y = std::min(min_y, static_cast<int>(point.y));
+			max_x = std::max(max_x, static_cast<int>(point.x));
+			max_y = std::max(max_y, static_cast<int>(point.y));
+		}
+
+		SceneObject object = {};
+		object.type = SCENE_POLYGON;
+		object.x = min_x;
+		object.y = min_y;
+		object.width = static_cast<unsigned int>(std::min<long long>(static_cast<long long>(max_x) - min_x + 1, UINT_MAX));
+		object.height = static_cast<unsigned int>(std::min<long long>(static_cast<long long>(max_y) - min_y + 1, UINT_MAX));
+		object.points.assign(points.begin(), points.end());
+		object.structure = structure;
+		object.color_code = color_code;
+		object.layer = layer;
+
+		return insert(std::move(object));
+	}
+
+	SceneHandle Scene::addCustom(int x, int y, unsigned int w, unsigned int h, void (*onDraw)(Window*, const SceneObject*), void* user_data, int layer) {
+		if (!onDraw)
+			return INVALID_SCENE_HANDLE;
+
+		SceneObject object = {};
+		object.type = SCENE_CUSTOM;
+		object.x = x;
+		object.y = y;
+		object.width = w;
+		object.height = h;
+		object.onDraw = onDraw;
+		object.user_data = user_data;
+		object.layer = layer;
+
+		return insert(std::move(object));
+	}
+
+	bool Scene::remove(SceneHandle handle) noexcept {
+		const long long index = index_of(handle);
+
+		if (index < 0)
+			return false;
+
+		Slot& slot = slots[index];
+
+		unlink(static_cast<unsigned int>(index), slot.cells);
+
+		slot.alive = false;
+		slot.generation++;
+		slot.object.points.clear();
+		free_slots.push_back(static_cast<unsigned int>(index));
+		alive_count--;
+
+		return true;
+	}
+
+	void Scene::clear() noexcept {
+		// the slots stay with their generations, the handles of the cleared objects must not reach new ones
+		free_slots.clear();
+
+		for (size_t i = slots.size(); i-- > 0;) {
+			Slot& slot = slots[i];
+
+			if (slot.alive) {
+				slot.alive = false;
+				slot.generation++;
+				slot.object.points.clear();
+			}
+
+			free_slots.push_back(static_cast<unsigned int>(i));
+		}
+
+		cells.clear();
+		alive_count = 0;
+	}
+
+	bool Scene::move(SceneHandle handle, int x, int y) {
+		SceneObject* object = get(handle);
+
+		if (!object)
+			return false;
+
+		return moveBy(handle, x - object->x, y - object->y);
+	}
+
+	bool Scene::moveBy(SceneHandle handle, int dx, int dy) {
+		SceneObject* object = get(handle);
+
+		if (!object)
+			return false;
+
+		if (dx == 0 && dy == 0)
+			return true;
+
+		object->x += dx;
+		object->y += dy;
+
+		// unsigned wrap around keeps the points correct, even if they leave the screen to the left / top
+		for (vector2u& point : object->points) {
+			point.x += static_cast<unsigned int>(dx);
+			point.y += static_cast<unsigned int>(dy);
+		}
+
+		update_cells(static_cast<unsigned int>(index_of(handle)));
+
+		return true;
+	}
+
+	bool Scene::resize(SceneHandle handle, unsigned int w, unsigned int h) {
+		SceneObject* object = get(handle);
+
+		// the size of images and polygons is defined by their content
+		if (!object || object->type == SCENE_IMAGE || object->type == SCENE_POLYGON)
+			return false;
+
+		object->width = w;
+		object->height = h;
+
+		update_cells(static_cast<unsigned int>(index_of(handle)));
+
+		return true;
+	}
+
+	bool Scene::setLayer(SceneHandle handle, int layer) noexcept {
+		SceneObject* object = get(handle);
+
+		if (!object)
+			return false;
+
+		object->layer = layer;
+		return true;
+	}
+
+	bool Scene::setVisible(SceneHandle handle, bool visible) noexcept {
+		SceneObject* object = get(handle);
+
+		if (!object)
+			return false;
+
+		object->visible = visible;
+		return true;
+	}
+
+	SceneObject* Scene::get(SceneHandle handle) noexcept {
+		const long long index = index_of(handle);
+		return index < 0 ? nullptr : &slots[index].object;
+	}
+
+	const SceneObject* Scene::get(SceneHandle handle) const noexcept {
+		const long long index = index_of(handle);
+		return index < 0 ? nullptr : &slots[index].object;
+	}
+
+	size_t Scene::size() const noexcept {
+		return alive_count;
+	}
+
+	size_t Scene::query(int x, int y, unsigned int w, unsigned int h, std::vector<SceneHandle>& out) const {
+		std::vector<unsigned int> found;
+
+		query_slots(x, y, w, h, found);
+
+		for (const unsigned int index : found)
+			out.push_back(handle_of(index));
+
+		return found.size();
+	}
+
+	void Scene::query_slots(int x, int y, unsigned int w, unsigned int h, std::vector<unsigned int>& out) const {
+		if (w == 0 || h == 0)
+			return;
+
+		const int cs = static_cast<int>(cell_size);
+		const int cx1 = floor_div(x, cs);
+		const int cy1 = floor_div(y, cs);
+		const int cx2 = floor_div(static_cast<int>(std::min<long long>(static_cast<long long>(x) + w - 1, INT_MAX)), cs);
+		const int cy2 = floor_div(static_cast<int>(std::min<long long>(static_cast<long long>(y) + h - 1, INT_MAX)), cs);
+
+		// every object is stored in all cells it touches, the stamp makes sure it is only reported once
+		if (++query_stamp == 0) {
+			for (const Slot& slot : slots)
+				slot.query_stamp = 0;
+			query_stamp = 1;
+		}
+
+		for (int cy = cy1; cy <= cy2; cy++) {
+			for (int cx = cx1; cx <= cx2; cx++) {
+				const auto cell = cells.find(cell_key(cx, cy));
+
+				if (cell == cells.end())
+					continue;
+
+				for (const unsigned int index : cell->second) {
+					const Slot& slot = slots[index];
+
+					if (slot.query_stamp == query_stamp)
+						continue;
+
+					slot.query_stamp = query_stamp;
+
+					if (slot.object.visible && overlaps(slot.object, x, y, w, h))
+						out.push_back(index);
+				}
+			}
+		}
+	}
+
+	// The bounding box of the render target in scene coordinates: its corners mapped through the inverse of
+	// window->transform, one pixel wider for the float error. False if the transform can't be inverted.
+	static bool target_bounds(const Window* window, long long& x1, long long& y1, long long& x2, long long& y2) noexcept {
+		affine2 inverse;
+
+		if (!window->transform.invert(inverse))
+			return false;
+
+		const float w = static_cast<float>(window->state.width), h = static_cast<float>(window->state.height);
+		const vector2f corners[4] = { inverse.apply({ 0, 0 }), inverse.apply({ w, 0 }), inverse.apply({ w, h }), inverse.apply({ 0, h }) };
+
+		float min_x = corners[0].x, min_y = corners[0].y, max_x = corners[0].x, max_y = corners[0].y;
+
+		for (const vector2f& corner : corners) {
+			min_x = std::min(min_x, corner.x);
+			min_y = std::min(min_y, corner.y);
+			max_x = std::max(max_x, corner.x);
+			max_y = std::max(max_y, corner.y);
+		}
+
+		// clamped to the coordinates an object can have
+		const auto clamp = [](double value) { return static_cast<long long>(std::clamp<double>(value, INT_MIN, INT_MAX)); };
+
+		x1 = clamp(std::floor(min_x) - 1.0);
+		y1 = clamp(std::floor(min_y) - 1.0);
+		x2 = clamp(std::ceil(max_x) + 1.0);
+		y2 = clamp(std::ceil(max_y) + 1.0);
+
+		return true;
+	}
+
+	SceneHandle Scene::hitTest(const vector2u& point) const {
+		return hitTest(static_cast<int>(point.x), static_cast<int>(point.y));
+	}
+
+	SceneHandle Scene::hitTest(const Window* window, const vector2u& pixel) const {
+		affine2 inverse;
+
+		if (!window || !window->transform.invert(inverse))
+			return INVALID_SCENE_HANDLE;
+
+		// the center of the pixel, like the rasterizer samples it
+		const vector2f point = inverse.apply({ static_cast<float>(pixel.x) + 0.5f, static_cast<float>(pixel.y) + 0.5f });
+		const auto clamp = [](float value) { return static_cast<int>(std::clamp<double>(std::floor(value), INT_MIN, INT_MAX)); };
+
+		return hitTest(clamp(point.x), clamp(point.y));
+	}
+
+	SceneHandle Scene::hitTest(int x, int y) const {
+		const int cs = static_cast<int>(cell_size);
+		const auto cell = cells.find(cell_key(floor_div(x, cs), floor_div(y, cs)));
+
+		if (cell == cells.end())
+			return INVALID_SCENE_HANDLE;
+
+		long long hit = -1;
+
+		for (const unsigned int index : cell->second) {
+			const SceneObject& object = slots[index].object;
+
+			if (!object.visible || !contains(object, x, y))
+				continue;
+
+			// the object render(...) draws last
+			if (hit < 0 || below(static_cast<unsigned int>(hit), index))
+				hit = index;
+		}
+
+		return hit < 0 ? INVALID_SCENE_HANDLE : handle_of(static_cast<unsigned int>(hit));
+	}
+
+	size_t Scene::render(Window* window) {
+		if (!window)
+			return 0;
+
+		return render(window, INT_MIN, INT_MIN, UINT_MAX, UINT_MAX);
+	}
+
+	size_t Scene::render(Window* window, int view_x, int view_y, unsigned int view_w, unsigned int view_h) {
+		if (!window || !window->state.memory)
+			return 0;
+
+		long long clip_x1, clip_y1, clip_x2, clip_y2;
+
+		// the view and the objects are in scene coordinates, window->transform maps them to the render target
+		if (!target_bounds(window, clip_x1, clip_y1, clip_x2, clip_y2))
+			return 0;
+
+		clip_x1 = std::max<long long>(clip_x1, view_x);
+		clip_y1 = std::max<long long>(clip_y1, view_y);
+		clip_x2 = std::min<long long>(clip_x2, static_cast<long long>(view_x) + view_w);
+		clip_y2 = std::min<long long>(clip_y2, static_cast<long long>(view_y) + view_h);
+
+		visible_buffer.clear();
+
+		if (clip_x1 >= clip_x2 || clip_y1 >= clip_y2)
+			return 0;
+
+		query_slots(static_cast<int>(clip_x1), static_cast<int>(clip_y1), static_cast<unsigned int>(clip_x2 - clip_x1), static_cast<unsigned int>(clip_y2 - clip_y1), visible_buffer);
+
+		std::sort(visible_buffer.begin(), visible_buffer.end(), [&](unsigned int a, unsigned int b) { return below(a, b); });
+
+		for (const unsigned int index : visible_buffer) {
+			SceneObject& object = slots[index].object;
+
+			switch (object.type) {
+			case SCENE_IMAGE: {
+				window->drawImage(static_cast<unsigned int>(object.x), static_cast<unsigned int>(object.y), object.image, object.scale, object.flip);
+				break;
+			}
+			case SCENE_RECT: {
+				// clipped to the visible part in scene coordinates, fillRect(...) transforms what is left
+				const long long x1 = std::max<long long>(object.x, clip_x1);
+				const long long y1 = std::max<long long>(object.y, clip_y1);
+				const long long x2 = std::min<long long>(static_cast<long long>(object.x) + object.width, clip_x2);
+				const long long y2 = std::min<long long>(static_cast<long long>(object.y) + object.height, clip_y2);
+
+				if (x1 < x2 && y1 < y2)
+					window->fillRect(static_cast<unsigned int>(x1), static_cast<unsigned int>(y1), static_cast<unsigned int>(x2 - x1), static_cast<unsigned int>(y2 - y1), object.color_code);
+				break;
+			}
+			case SCENE_POLYGON: {
+				window->fillPolygon(object.points, object.color_code, object.structure);
+				break;
+			}
+			case SCENE_CUSTOM: {
+				object.onDraw(window, &object);
+				break;
+			}
+			}
+		}
+
+		return visible_buffer.size();
+	}
+
+	unsigned long long Scene::cell_key(int cx, int cy) noexcept {
+		return (static_cast<unsigned long long>(static_cast<unsigned int>(cx)) << 32) | static_cast<unsigned int>(cy);
+	}
+
+	Scene::CellRange Scene::cell_range(const SceneObject& object) const noexcept {
+		const int cs = static_cast<int>(cell_size);
+		const long long x2 = static_cast<long long>(object.x) + std::max(object.width, 1u) - 1;
+		const long long y2 = static_cast<long long>(object.y) + std::max(object.height, 1u) - 1;
+
+		return {
+			floor_div(object.x, cs),
+			floor_div(object.y, cs),
+			floor_div(static_cast<int>(std::min<long long>(x2, INT_MAX)), cs),
+			floor_div(static_cast<int>(std::min<long long>(y2, INT_MAX)), cs)
+		};
+	}
+
+	SceneHandle Scene::handle_of(unsigned int index) const noexcept {
+		return (static_cast<unsigned long long>(slots[index].generation) << 32) | index;
+	}
+
+	long long Scene::index_of(SceneHandle handle) const noexcept {
+		const unsigned long long index = handle & 0xFFFFFFFF;
+
+		if (index >= slots.size() || !slots[index].alive || slots[index].generation != handle >> 32)
+			return -1;
+
+		return static_cast<long long>(index);
+	}
+
+	bool Scene::below(unsigned int a, unsigned int b) const noexcept {
+		const Slot& slot_a = slots[a];
+		const Slot& slot_b = slots[b];
+
+		if (slot_a.object.layer != slot_b.object.layer)
+			return slot_a.object.layer < slot_b.object.layer;
+
+		return slot_a.sequence < slot_b.sequence;
+	}
+
+	SceneHandle Scene::insert(SceneObject&& object) {
+		unsigned int index;
+
+		object.visible = true;
+
+		if (!free_slots.empty()) {
+			index = free_slots.back();
+			free_slots.pop_back();
+			slots[index].object = std::move(object);
+		} else {
+			index = static_cast<unsigned int>(slots.size());
+			slots.push_back({ std::move(object), {}, 0, 0, 0, false });
+		}
+
+		Slot& slot = slots[index];
+		slot.alive = true;
+		slot.query_stamp = 0;
+		slot.sequence = next_sequence++;
+		slot.cells = cell_range(slot.object);
+
+		link(index, slot.cells);
+		alive_count++;
+
+		return handle_of(index);
+	}
+
+	void Scene::link(unsigned int index, const CellRange& range) {
+		for (int cy = range.y1; cy <= range.y2; cy++)
+			for (int cx = range.x1; cx <= range.x2; cx++)
+				cells[cell_key(cx, cy)].push_back(index);
+	}
+
+	void Scene::unlink(unsigned int index, const CellRange& range) {
+		for (int cy = range.y1; cy <= range.y2; cy++) {
+			for (int cx = range.x1; cx <= range.x2; cx++) {
+				const auto cell = cells.find(cell_key(cx, cy));
+
+				if (cell == cells.end())
+					continue;
+
+				std::vector<unsigned int>& indices = cell->second;
+				const auto it = std::find(indices.begin(), indices.end(), index);
+
+				// the order inside a cell doesn't matter -> swap and pop
+				if (it != indices.end()) {
+					*it = indices.back();
+					indices.pop_back();
+				}
+			}
+		}
+	}
+
+	void Scene::update_cells(unsigned int index) {
+		Slot& slot = slots[index];
+		const CellRange range = cell_range(slot.object);
+
+		// most moves stay inside of the same cells
+		if (range == slot.cells)
+			return;
+
+		unlink(index, slot.cells);
+		link(index, range);
+		slot.cells = range;
+	}
+
+	bool Scene::contains(const SceneObject& object, int x, int y) noexcept {
+		if (!overlaps(object, x, y, 1, 1))
+			return false;
+
+		if (object.type != SCENE_POLYGON)
+			return true;
+
+		auto inside = [&](const vector2u& a, const vector2u& b, const vector2u& c) {
+			auto edge = [&](const vector2u& p, const vector2u& q) {
+				return (static_cast<long long>(static_cast<int>(q.x)) - static_cast<int>(p.x)) * (static_cast<long long>(y) - static_cast<int>(p.y))
+					 - (static_cast<long long>(static_cast<int>(q.y)) - static_cast<int>(p.y)) * (static_cast<long long>(x) - static_cast<int>(p.x));
+			};
+
+			const long long e1 = edge(a, b), e2 = edge(b, c), e3 = edge(c, a);
+
+			return (e1 >= 0 && e2 >= 0 && e3 >= 0) || (e1 <= 0 && e2 <= 0 && e3 <= 0);
+		};
+
+		const std::vector<vector2u>& p = object.points;
+
+		switch (object.structure) {
+		case PolygonStructure::LIST: {
+			for (size_t i = 0; i + 2 < p.size(); i += 3)
+				if (inside(p[i], p[i + 1], p[i + 2]))
+					return true;
+			return false;
+		}
+		case PolygonStructure::STRIP: {
+			for (size_t i = 2; i < p.size(); i++)
+				if (inside(p[i - 2], p[i - 1], p[i]))
+					return true;
+			return false;
+		}
+		case PolygonStructure::FAN: {
+			for (size_t i = 2; i < p.size(); i++)
+				if (inside(p[0], p[i - 1], p[i]))
+					return true;
+			return false;
+		}
+		default:
+			return false;
+		}
+	}
+}
\ No newline at end of file
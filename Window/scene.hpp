@@ -0,0 +1,131 @@
+#ifndef WINDOWS_WINDOW_SCENE_HPP
+	#define WINDOWS_WINDOW_SCENE_HPP
+
+	#include "window.hpp"
+
+	#include <vector>
+	#include <unordered_map>
+
+	namespace winLib {
+		// the slot of the object in the lower 32 bits, the generation of the slot in the upper ones: a slot is reused
+		// after a remove(...), the handles of the removed object stay invalid
+		using SceneHandle = unsigned long long;
+
+		constexpr SceneHandle INVALID_SCENE_HANDLE = 0xFFFFFFFFFFFFFFFF;
+		constexpr unsigned int DEFAULT_SCENE_CELL_SIZE = 128;
+
+		enum SceneObjectType {
+			SCENE_IMAGE,
+			SCENE_RECT,
+			SCENE_POLYGON,
+			SCENE_CUSTOM
+		};
+
+		struct SceneObject {
+			SceneObjectType type;
+
+			int x, y;					// top left corner of the bounding box
+			unsigned int width, height;	// size of the bounding box
+			int layer;					// objects with a higher layer are drawn on top
+
+			Image* image;
+			unsigned int scale;
+			unsigned char flip;
+
+			std::vector<vector2u> points;	// absolute points of a SCENE_POLYGON, the coordinates are signed (two's complement)
+			unsigned char structure;
+
+			unsigned int color_code;
+
+			void (*onDraw)(Window* window, const SceneObject* object);	// only used by SCENE_CUSTOM
+			void* user_data;
+
+			bool visible;
+		};
+
+		// Retained list of drawables, indexed by a uniform grid.
+		// Only the objects overlapping the viewport reach the rasterizer,
+		// moving an object only touches the cells it enters or leaves.
+		class Scene {
+		public:
+			Scene(unsigned int cell_size = DEFAULT_SCENE_CELL_SIZE);
+
+			SceneHandle addImage(int x, int y, Image* image, unsigned int scale = 1, unsigned char flip = Image::Flip::NONE, int layer = 0);
+			SceneHandle addRect(int x, int y, unsigned int w, unsigned int h, unsigned int color_code = 0xFFFFFFFF, int layer = 0);
+			SceneHandle addPolygon(const std::span<vector2u>& points, unsigned int color_code = 0xFFFFFFFF, unsigned char structure = PolygonStructure::LIST, int layer = 0);
+			SceneHandle addCustom(int x, int y, unsigned int w, unsigned int h, void (*onDraw)(Window*, const SceneObject*), void* user_data = nullptr, int layer = 0);
+
+			bool remove(SceneHandle handle) noexcept;
+			void clear() noexcept;
+
+			bool move(SceneHandle handle, int x, int y);
+			bool moveBy(SceneHandle handle, int dx, int dy);
+			bool resize(SceneHandle handle, unsigned int w, unsigned int h);
+			bool setLayer(SceneHandle handle, int layer) noexcept;
+			bool setVisible(SceneHandle handle, bool visible) noexcept;
+
+			SceneObject* get(SceneHandle handle) noexcept;
+			const SceneObject* get(SceneHandle handle) const noexcept;
+			size_t size() const noexcept;
+
+			// appends all visible objects overlapping the rect to out (unordered)
+			size_t query(int x, int y, unsigned int w, unsigned int h, std::vector<SceneHandle>& out) const;
+			// returns the top most object under the point (in scene coordinates) or INVALID_SCENE_HANDLE
+			SceneHandle hitTest(const vector2u& point) const;
+			SceneHandle hitTest(int x, int y) const;
+			// the same for a pixel of the render target (like getMousePos()), mapped back to scene coordinates through
+			// the inverse of window->transform like the culling of render(...)
+			SceneHandle hitTest(const Window* window, const vector2u& pixel) const;
+
+			// draws every object overlapping the window and returns how many were drawn
+			// the objects are in the coordinates of the draw methods, culled against the render target mapped back
+			// through the inverse of window->transform (the view limits it further, in the same coordinates)
+			size_t render(Window* window);
+			size_t render(Window* window, int view_x, int view_y, unsigned int view_w, unsigned int view_h);
+
+		private:
+			struct CellRange {
+				int x1, y1, x2, y2;
+
+				bool operator==(const CellRange& other) const noexcept { return x1 == other.x1 && y1 == other.y1 && x2 == other.x2 && y2 == other.y2; }
+			};
+
+			struct Slot {
+				SceneObject object;
+				CellRange cells;
+				mutable unsigned int query_stamp;
+				unsigned int generation;		// increased by every remove
+				unsigned long long sequence;	// order of the inserts, the later object is drawn on top in its layer
+				bool alive;
+			};
+
+			unsigned int cell_size;
+			std::vector<Slot> slots;
+			std::vector<unsigned int> free_slots;
+			std::unordered_map<unsigned long long, std::vector<unsigned int>> cells;	// slot indices
+			std::vector<unsigned int> visible_buffer;
+			mutable unsigned int query_stamp;
+			unsigned long long next_sequence;
+			size_t alive_count;
+
+			static unsigned long long cell_key(int cx, int cy) noexcept;
+			CellRange cell_range(const SceneObject& object) const noexcept;
+
+			SceneHandle handle_of(unsigned int index) const noexcept;
+			// the slot index of a valid handle or -1
+			long long index_of(SceneHandle handle) const noexcept;
+			// the drawing order of render(...)
+			bool below(unsigned int a, unsigned int b) const noexcept;
+
+			void query_slots(int x, int y, unsigned int w, unsigned int h, std::vector<unsigned int>& out) const;
+
+			SceneHandle insert(SceneObject&& object);
+			void link(unsigned int index, const CellRange& range);
+			void unlink(unsigned int index, const CellRange& range);
+			void update_cells(unsigned int index);
+
+			static bool contains(const SceneObject& object, int x, int y) noexcept;
+		};
+	}
+
+#endif
\ No newline at end of file
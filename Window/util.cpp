@@ -1,11 +1,13 @@
 #include "util.hpp"
 
+#include <cstdlib>
+
 namespace winLib {
 	std::wstring convertS2W(std::string s) {
-		#ifdef __MINGW32__
+		#if defined(__MINGW32__) || defined(WINDOWS_WINDOW_POSIX)
 			wchar_t* buffer = new wchar_t[s.length() + 1];
-			mbstowcs(buffer, s.c_str(), s.length());
-			buffer[s.length()] = L'\0';
+			const size_t count = mbstowcs(buffer, s.c_str(), s.length());
+			buffer[count == static_cast<size_t>(-1) ? 0 : count] = L'\0';
 		#else
 			const int count = MultiByteToWideChar(CP_UTF8, 0, s.c_str(), -1, NULL, 0);
 			wchar_t* buffer = new wchar_t[count];
@@ -17,21 +19,80 @@ namespace winLib {
 	}
 
 	std::string  convertW2S(std::wstring s) {
-		#ifdef UNICODE
-			#ifdef __MINGW32__
-				unsigned long long len = s.length();
+		#if defined(UNICODE) || defined(WINDOWS_WINDOW_POSIX)
+			#if defined(__MINGW32__) || defined(WINDOWS_WINDOW_POSIX)
+				// a wide character can take up to MB_CUR_MAX bytes
+				const size_t len = s.length() * MB_CUR_MAX;
 				char* buffer = new char[len + 1];
-				wcstombs(buffer, s.c_str(), len);
-				buffer[len] = '\0';
+				const size_t count = wcstombs(buffer, s.c_str(), len);
+				buffer[count == static_cast<size_t>(-1) ? 0 : count] = '\0';
 			#else
 				const int count = WideCharToMultiByte(CP_UTF8, 0, s.c_str(), -1, nullptr, 0, nullptr, nullptr);
 				char* buffer = new char[count];
 				WideCharToMultiByte(CP_UTF8, 0, s.c_str(), -1, buffer, count, nullptr, nullptr);
-			#endif				
-			return std::string(buffer);
+			#endif
+			std::string result(buffer);
 			delete[] buffer;
+			return result;
 		#else
 			return std::string(s.c_str());
 		#endif
 	}
+
+	#ifdef WINDOWS_WINDOW_X86
+		static void cpuid(int info[4], int leaf, int subleaf) noexcept {
+			#if defined(_MSC_VER)
+				__cpuidex(info, leaf, subleaf);
+			#else
+				__asm__ __volatile__("cpuid" : "=a"(info[0]), "=b"(info[1]), "=c"(info[2]), "=d"(info[3]) : "a"(leaf), "c"(subleaf));
+			#endif
+		}
+
+		static unsigned long long xgetbv(unsigned int index) noexcept {
+			#if defined(_MSC_VER)
+				return _xgetbv(index);
+			#else
+				unsigned int eax, edx;
+				__asm__ __volatile__("xgetbv" : "=a"(eax), "=d"(edx) : "c"(index));
+				return (static_cast<unsigned long long>(edx) << 32) | eax;
+			#endif
+		}
+	#endif
+
+	bool cpuSupportsSSSE3() noexcept {
+		#ifdef WINDOWS_WINDOW_X86
+			static const bool supported = [] {
+				int info[4];
+				cpuid(info, 1, 0);
+				return (info[2] & (1 << 9)) != 0;
+			}();
+			return supported;
+		#else
+			return false;
+		#endif
+	}
+
+	bool cpuSupportsAVX2() noexcept {
+		#ifdef WINDOWS_WINDOW_X86
+			static const bool supported = [] {
+				int info[4];
+				cpuid(info, 0, 0);
+				if (info[0] < 7)
+					return false;
+
+				// the os has to save the ymm registers (osxsave + xgetbv)
+				cpuid(info, 1, 0);
+				if ((info[2] & (1 << 27)) == 0 || (info[2] & (1 << 28)) == 0)
+					return false;
+				if ((xgetbv(0) & 0x6) != 0x6)
+					return false;
+
+				cpuid(info, 7, 0);
+				return (info[1] & (1 << 5)) != 0;
+			}();
+			return supported;
+		#else
+			return false;
+		#endif
+	}
 }
\ No newline at end of file
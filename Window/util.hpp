@@ -3,13 +3,41 @@
 
 	constexpr auto WINDOWS_WINDOW_LIBRARY_VERSION = 0.1f;
 
-	#include <windows.h>
+	// WINDOWS_WINDOW_WIN32 -> win32 api, WINDOWS_WINDOW_POSIX -> linux and co (see backend.hpp)
+	#if defined(_WIN32)
+		#define WINDOWS_WINDOW_WIN32
+		#include <windows.h>
+	#else
+		#define WINDOWS_WINDOW_POSIX
+	#endif
+
 	#include <iostream>
 	#include <span>
 	#include <filesystem>
 	#include <string>
 	#include <cmath>
-	#include <shlobj.h>
+	#include <cstdio>
+
+	#ifdef WINDOWS_WINDOW_WIN32
+		#include <shlobj.h>
+	#endif
+
+	#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+		#define WINDOWS_WINDOW_X86
+		#include <immintrin.h>
+
+		#if defined(_MSC_VER)
+			#include <intrin.h>
+		#endif
+	#endif
+
+	// gcc and clang need the target attribute to emit instructions above the base line,
+	// msvc always emits them (the caller has to check the cpu features first)
+	#if defined(__GNUC__) || defined(__clang__)
+		#define WINDOWS_WINDOW_TARGET(features) __attribute__((target(features)))
+	#else
+		#define WINDOWS_WINDOW_TARGET(features)
+	#endif
 
 	#if defined(UNICODE) || defined(_UNICODE)
 		#define Txt(s) L##s
@@ -17,7 +45,15 @@
 		#define Txt(s) s
 	#endif
 
-	#if defined(DEBUG) || defined(_DEBUG) || defined(FORCE_DEBUG)
+	#if (defined(DEBUG) || defined(_DEBUG) || defined(FORCE_DEBUG)) && defined(WINDOWS_WINDOW_POSIX)
+		#define DEBUGNUMBER(str, size, ...) {			\
+			char message[size];							\
+			snprintf(message, size, str, __VA_ARGS__);	\
+			fputs(message, stderr);						\
+		}												\
+
+		#define DEBUGSTRING(str, size, ...) DEBUGNUMBER(str, size, __VA_ARGS__)
+	#elif defined(DEBUG) || defined(_DEBUG) || defined(FORCE_DEBUG)
 		#define DEBUGNUMBER(str, size, ...) {			\
 			char message[size];							\
 			sprintf_s(message, str, __VA_ARGS__);		\
@@ -42,10 +78,11 @@
 	#define getGreenColorValue(color_code) ((color_code & 0x0000FF00) >> 8 )
 	#define getBlueColorValue(color_code)  ((color_code & 0x000000FF)      )
 
+	// color codes are 0xAARRGGBB (PIXEL_BGRA8 in memory), the same layout as the get...ColorValue macros
 	// parameters in unsigned char [0;255]
-	#define rgbColorCode(red, green, blue) (static_cast<unsigned int>(static_cast<unsigned char>(red) | (static_cast<unsigned char>(green) << 8) | (static_cast<unsigned char>(blue) << 16)))
+	#define rgbColorCode(red, green, blue) (static_cast<unsigned int>((static_cast<unsigned char>(red) << 16) | (static_cast<unsigned char>(green) << 8) | static_cast<unsigned char>(blue)))
 	// parameters in unsigned char [0;255]
-	#define rgbaColorCode(red, green, blue, alpha) (static_cast<unsigned int>(static_cast<unsigned char>(red) | (static_cast<unsigned char>(green) << 8) | (static_cast<unsigned char>(blue) << 16) | (static_cast<unsigned char>(alpha) << 24)))
+	#define rgbaColorCode(red, green, blue, alpha) (static_cast<unsigned int>((static_cast<unsigned char>(red) << 16) | (static_cast<unsigned char>(green) << 8) | static_cast<unsigned char>(blue) | (static_cast<unsigned int>(static_cast<unsigned char>(alpha)) << 24)))
 	// parameters in float [0;1]
 	#define rgbColorCodeF(red, green, blue) rgbColorCode(red * 255, green * 255, blue * 255)
 	// parameters in float [0;1]
@@ -57,5 +94,8 @@
 	namespace winLib {
 		std::wstring convertS2W(std::string s);
 		std::string  convertW2S(std::wstring s);
+
+		bool cpuSupportsSSSE3() noexcept;
+		bool cpuSupportsAVX2() noexcept;
 	}
 #endif
\ No newline at end of file
@@ -28,7 +28,8 @@
 			vector2 lerp(const vector2& other, const double t) const { return this->operator*(T(1.0 - t)) + (other * T(t)); }
 
 			T dot(const vector2& other) const { return this->x * other.x + this->y * other.y; }
-			T cross(const vector2& other) const { return this->x * other.x - this->y * other.y; }
+			// z component of the 3d cross product, > 0 if other is counter clockwise
+			T cross(const vector2& other) const { return this->x * other.y - this->y * other.x; }
 
 			const std::string str() const { return std::string("vector2{ x: ") + std::to_string(x) + ", y:" + std::to_string(y) + "}"; }
 			friend std::ostream& operator<<(std::ostream& output, const vector2& vector) { output << vector.str(); return output; }
@@ -43,22 +44,22 @@
 			vector2 operator* (const vector2& other)	const { return vector2(x * other.x, y * other.y); }
 			vector2 operator/ (const vector2& other)	const { return vector2(x / other.x, y / other.y); }
 
-			vector2 operator+=(const vector2& other)	const { this->x += other.x; this->y += other.y; return *this; }
-			vector2 operator-=(const vector2& other)	const { this->x -= other.x; this->y -= other.y; return *this; }
-			vector2 operator*=(const vector2& other)	const { this->x *= other.x; this->y *= other.y; return *this; }
-			vector2 operator/=(const vector2& other)	const { this->x /= other.x; this->y /= other.y; return *this; }
+			vector2& operator+=(const vector2& other)		{ this->x += other.x; this->y += other.y; return *this; }
+			vector2& operator-=(const vector2& other)		{ this->x -= other.x; this->y -= other.y; return *this; }
+			vector2& operator*=(const vector2& other)		{ this->x *= other.x; this->y *= other.y; return *this; }
+			vector2& operator/=(const vector2& other)		{ this->x /= other.x; this->y /= other.y; return *this; }
 
 			vector2 operator* (const T& t)				const { return vector2(x * t, y * t); }
 			vector2 operator/ (const T& t)				const { return vector2(x / t, y / t); }
 
-			vector2 operator*=(const T& t)				const { this->x *= t; this->y *= t; return *this; }
-			vector2 operator/=(const T& t)				const { this->x /= t; this->y /= t; return *this; }
+			vector2& operator*=(const T& t)				{ this->x *= t; this->y *= t; return *this; }
+			vector2& operator/=(const T& t)				{ this->x /= t; this->y /= t; return *this; }
 
 			vector2 operator+ ()						const { return vector2(+x, +y); }
 			vector2 operator- ()						const { return vector2(-x, -y); }
 
 			bool operator==(const vector2& other)		const { return x == other.x && y == other.y; }
-			bool operator!=(const vector2& other)		const { return x != other.x && y != other.y; }
+			bool operator!=(const vector2& other)		const { return x != other.x || y != other.y; }
 		};
 
 		// usings for every useful data type
@@ -0,0 +1,443 @@
+#include "vector_math.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <type_traits>
+
+namespace winLib {
+	static_assert(sizeof(vector2f) == 2 * sizeof(float) && sizeof(vector2u) == 2 * sizeof(unsigned int), "vector2 spans are read as plain arrays");
+
+	// largest float below 2^31, so the conversion to int can't overflow
+	constexpr float VERTEX_LIMIT = 2147483520.0f;
+
+	static unsigned int toVertex(float v) noexcept {
+		const float clamped = v > -VERTEX_LIMIT ? (v < VERTEX_LIMIT ? v : VERTEX_LIMIT) : -VERTEX_LIMIT;
+		return static_cast<unsigned int>(static_cast<int>(std::nearbyint(clamped)));
+	}
+
+	bool affine2::invert(affine2& result) const noexcept {
+		const float determinant = a * d - b * c;
+
+		if (determinant == 0.0f || !std::isfinite(determinant))
+			return false;
+
+		const float r = 1.0f / determinant;
+
+		result = {
+			d * r, -b * r,
+			-c * r, a * r,
+			(c * f - d * e) * r, (b * e - a * f) * r
+		};
+
+		return true;
+	}
+
+	#ifdef WINDOWS_WINDOW_X86
+		// every kernel handles multiples of 8 and returns how many points it did, the scalar loop does the rest
+
+		WINDOWS_WINDOW_TARGET("avx2")
+		static size_t add_AVX2(const float* a, const float* b, float* out, size_t count) noexcept {
+			size_t i = 0;
+
+			for (; i + 8 <= count; i += 8)
+				_mm256_storeu_ps(out + i, _mm256_add_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i)));
+
+			return i;
+		}
+
+		WINDOWS_WINDOW_TARGET("avx2")
+		static size_t scale_AVX2(const float* a, float factor, float* out, size_t count) noexcept {
+			const __m256 f = _mm256_set1_ps(factor);
+			size_t i = 0;
+
+			for (; i + 8 <= count; i += 8)
+				_mm256_storeu_ps(out + i, _mm256_mul_ps(_mm256_loadu_ps(a + i), f));
+
+			return i;
+		}
+
+		WINDOWS_WINDOW_TARGET("avx2")
+		static size_t dot_AVX2(const vector2_array& a, const vector2_array& b, float* out, size_t count) noexcept {
+			size_t i = 0;
+
+			for (; i + 8 <= count; i += 8) {
+				const __m256 xx = _mm256_mul_ps(_mm256_loadu_ps(a.x.data() + i), _mm256_loadu_ps(b.x.data() + i));
+				const __m256 yy = _mm256_mul_ps(_mm256_loadu_ps(a.y.data() + i), _mm256_loadu_ps(b.y.data() + i));
+				_mm256_storeu_ps(out + i, _mm256_add_ps(xx, yy));
+			}
+
+			return i;
+		}
+
+		WINDOWS_WINDOW_TARGET("avx2")
+		static size_t normalize_AVX2(const vector2_array& a, vector2_array& out, size_t count) noexcept {
+			const __m256 zero = _mm256_setzero_ps();
+			size_t i = 0;
+
+			for (; i + 8 <= count; i += 8) {
+				const __m256 x = _mm256_loadu_ps(a.x.data() + i);
+				const __m256 y = _mm256_loadu_ps(a.y.data() + i);
+				const __m256 length = _mm256_sqrt_ps(_mm256_add_ps(_mm256_mul_ps(x, x), _mm256_mul_ps(y, y)));
+
+				// sqrt + div instead of rsqrt, so the result is the same as the one of the scalar loop
+				const __m256 valid = _mm256_cmp_ps(length, zero, _CMP_GT_OQ);
+				_mm256_storeu_ps(out.x.data() + i, _mm256_and_ps(_mm256_div_ps(x, length), valid));
+				_mm256_storeu_ps(out.y.data() + i, _mm256_and_ps(_mm256_div_ps(y, length), valid));
+			}
+
+			return i;
+		}
+
+		WINDOWS_WINDOW_TARGET("avx2")
+		static void transform_AVX2(__m256 x, __m256 y, const affine2& m, __m256& out_x, __m256& out_y) noexcept {
+			out_x = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(x, _mm256_set1_ps(m.a)), _mm256_mul_ps(y, _mm256_set1_ps(m.c))), _mm256_set1_ps(m.e));
+			out_y = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(x, _mm256_set1_ps(m.b)), _mm256_mul_ps(y, _mm256_set1_ps(m.d))), _mm256_set1_ps(m.f));
+		}
+
+		WINDOWS_WINDOW_TARGET("avx2")
+		static size_t transform_AVX2(const vector2_array& a, const affine2& m, vector2_array& out, size_t count) noexcept {
+			size_t i = 0;
+
+			for (; i + 8 <= count; i += 8) {
+				__m256 x, y;
+				transform_AVX2(_mm256_loadu_ps(a.x.data() + i), _mm256_loadu_ps(a.y.data() + i), m, x, y);
+				_mm256_storeu_ps(out.x.data() + i, x);
+				_mm256_storeu_ps(out.y.data() + i, y);
+			}
+
+			return i;
+		}
+
+		// 8 x and 8 y coordinates -> 8 interleaved vector2u
+		WINDOWS_WINDOW_TARGET("avx2")
+		static void storeVertices_AVX2(__m256 x, __m256 y, vector2u* vertices) noexcept {
+			const __m256 low = _mm256_set1_ps(-VERTEX_LIMIT);
+			const __m256 high = _mm256_set1_ps(VERTEX_LIMIT);
+
+			// max(v, low) returns low for NaN, same as the scalar loop
+			const __m256i xi = _mm256_cvtps_epi32(_mm256_min_ps(_mm256_max_ps(x, low), high));
+			const __m256i yi = _mm256_cvtps_epi32(_mm256_min_ps(_mm256_max_ps(y, low), high));
+
+			// [x0 y0 x1 y1 | x4 y4 x5 y5], [x2 y2 x3 y3 | x6 y6 x7 y7]
+			const __m256i lo = _mm256_unpacklo_epi32(xi, yi);
+			const __m256i hi = _mm256_unpackhi_epi32(xi, yi);
+
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(vertices), _mm256_permute2x128_si256(lo, hi, 0x20));
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(vertices + 4), _mm256_permute2x128_si256(lo, hi, 0x31));
+		}
+
+		WINDOWS_WINDOW_TARGET("avx2")
+		static size_t storeVertices_AVX2(const vector2_array& points, vector2u* vertices, size_t count) noexcept {
+			size_t i = 0;
+
+			for (; i + 8 <= count; i += 8)
+				storeVertices_AVX2(_mm256_loadu_ps(points.x.data() + i), _mm256_loadu_ps(points.y.data() + i), vertices + i);
+
+			return i;
+		}
+
+		WINDOWS_WINDOW_TARGET("avx2")
+		static size_t transformVertices_AVX2(const vector2_array& points, const affine2& m, vector2u* vertices, size_t count) noexcept {
+			size_t i = 0;
+
+			for (; i + 8 <= count; i += 8) {
+				__m256 x, y;
+				transform_AVX2(_mm256_loadu_ps(points.x.data() + i), _mm256_loadu_ps(points.y.data() + i), m, x, y);
+				storeVertices_AVX2(x, y, vertices + i);
+			}
+
+			return i;
+		}
+
+		// 8 interleaved vector2f -> 8 x and 8 y coordinates
+		WINDOWS_WINDOW_TARGET("avx2")
+		static void deinterleave_AVX2(__m256 p0, __m256 p1, __m256& x, __m256& y) noexcept {
+			// [x0 x1 x4 x5 | x2 x3 x6 x7] -> [x0 ... x7]
+			const __m256 xs = _mm256_shuffle_ps(p0, p1, _MM_SHUFFLE(2, 0, 2, 0));
+			const __m256 ys = _mm256_shuffle_ps(p0, p1, _MM_SHUFFLE(3, 1, 3, 1));
+
+			x = _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(xs), _MM_SHUFFLE(3, 1, 2, 0)));
+			y = _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(ys), _MM_SHUFFLE(3, 1, 2, 0)));
+		}
+
+		WINDOWS_WINDOW_TARGET("avx2")
+		static size_t transformVertices_AVX2(const vector2u* points, const affine2& m, vector2u* vertices, size_t count) noexcept {
+			size_t i = 0;
+
+			for (; i + 8 <= count; i += 8) {
+				__m256 x, y;
+				deinterleave_AVX2(_mm256_loadu_ps(reinterpret_cast<const float*>(points + i)), _mm256_loadu_ps(reinterpret_cast<const float*>(points + i + 4)), x, y);
+				transform_AVX2(_mm256_cvtepi32_ps(_mm256_castps_si256(x)), _mm256_cvtepi32_ps(_mm256_castps_si256(y)), m, x, y);
+				storeVertices_AVX2(x, y, vertices + i);
+			}
+
+			return i;
+		}
+
+		WINDOWS_WINDOW_TARGET("avx2")
+		static size_t load_AVX2(const vector2f* points, float* x, float* y, size_t count) noexcept {
+			size_t i = 0;
+
+			for (; i + 8 <= count; i += 8) {
+				__m256 xs, ys;
+				deinterleave_AVX2(_mm256_loadu_ps(reinterpret_cast<const float*>(points + i)), _mm256_loadu_ps(reinterpret_cast<const float*>(points + i + 4)), xs, ys);
+				_mm256_storeu_ps(x + i, xs);
+				_mm256_storeu_ps(y + i, ys);
+			}
+
+			return i;
+		}
+
+		WINDOWS_WINDOW_TARGET("avx2")
+		static size_t store_AVX2(const float* x, const float* y, vector2f* points, size_t count) noexcept {
+			size_t i = 0;
+
+			for (; i + 8 <= count; i += 8) {
+				const __m256 xs = _mm256_loadu_ps(x + i);
+				const __m256 ys = _mm256_loadu_ps(y + i);
+				const __m256 lo = _mm256_unpacklo_ps(xs, ys);
+				const __m256 hi = _mm256_unpackhi_ps(xs, ys);
+
+				_mm256_storeu_ps(reinterpret_cast<float*>(points + i), _mm256_permute2f128_ps(lo, hi, 0x20));
+				_mm256_storeu_ps(reinterpret_cast<float*>(points + i + 4), _mm256_permute2f128_ps(lo, hi, 0x31));
+			}
+
+			return i;
+		}
+	#endif
+
+	void vector2_array::load(const std::span<const vector2f>& points) {
+		const size_t count = points.size();
+		size_t i = 0;
+
+		resize(count);
+
+		#ifdef WINDOWS_WINDOW_X86
+			if (cpuSupportsAVX2())
+				i = load_AVX2(points.data(), x.data(), y.data(), count);
+		#endif
+
+		for (; i < count; i++) {
+			x[i] = points[i].x;
+			y[i] = points[i].y;
+		}
+	}
+
+	bool vector2_array::store(const std::span<vector2f>& points) const noexcept {
+		const size_t count = points.size();
+		size_t i = 0;
+
+		if (count > size())
+			return false;
+
+		#ifdef WINDOWS_WINDOW_X86
+			if (cpuSupportsAVX2())
+				i = store_AVX2(x.data(), y.data(), points.data(), count);
+		#endif
+
+		for (; i < count; i++)
+			points[i] = vector2f(x[i], y[i]);
+
+		return true;
+	}
+
+	bool addVectors(const vector2_array& a, const vector2_array& b, vector2_array& out) {
+		const size_t count = a.size();
+
+		if (b.size() != count)
+			return false;
+
+		out.resize(count);
+
+		size_t i = 0, j = 0;
+
+		#ifdef WINDOWS_WINDOW_X86
+			if (cpuSupportsAVX2()) {
+				i = add_AVX2(a.x.data(), b.x.data(), out.x.data(), count);
+				j = add_AVX2(a.y.data(), b.y.data(), out.y.data(), count);
+			}
+		#endif
+
+		for (; i < count; i++)
+			out.x[i] = a.x[i] + b.x[i];
+		for (; j < count; j++)
+			out.y[j] = a.y[j] + b.y[j];
+
+		return true;
+	}
+
+	void scaleVectors(const vector2_array& a, const vector2f& factor, vector2_array& out) {
+		const size_t count = a.size();
+
+		out.resize(count);
+
+		size_t i = 0, j = 0;
+
+		#ifdef WINDOWS_WINDOW_X86
+			if (cpuSupportsAVX2()) {
+				i = scale_AVX2(a.x.data(), factor.x, out.x.data(), count);
+				j = scale_AVX2(a.y.data(), factor.y, out.y.data(), count);
+			}
+		#endif
+
+		for (; i < count; i++)
+			out.x[i] = a.x[i] * factor.x;
+		for (; j < count; j++)
+			out.y[j] = a.y[j] * factor.y;
+	}
+
+	bool dotVectors(const vector2_array& a, const vector2_array& b, const std::span<float>& out) noexcept {
+		const size_t count = a.size();
+
+		if (b.size() != count || out.size() < count)
+			return false;
+
+		size_t i = 0;
+
+		#ifdef WINDOWS_WINDOW_X86
+			if (cpuSupportsAVX2())
+				i = dot_AVX2(a, b, out.data(), count);
+		#endif
+
+		for (; i < count; i++)
+			out[i] = a.x[i] * b.x[i] + a.y[i] * b.y[i];
+
+		return true;
+	}
+
+	void normalizeVectors(const vector2_array& a, vector2_array& out) {
+		const size_t count = a.size();
+
+		out.resize(count);
+
+		size_t i = 0;
+
+		#ifdef WINDOWS_WINDOW_X86
+			if (cpuSupportsAVX2())
+				i = normalize_AVX2(a, out, count);
+		#endif
+
+		for (; i < count; i++) {
+			const float x = a.x[i], y = a.y[i];
+			const float length = std::sqrt(x * x + y * y);
+
+			if (length > 0.0f) {
+				out.x[i] = x / length;
+				out.y[i] = y / length;
+			} else {
+				out.x[i] = 0.0f;
+				out.y[i] = 0.0f;
+			}
+		}
+	}
+
+	void rotateVectors(const vector2_array& a, float angle, vector2_array& out) {
+		transformVectors(a, affine2::rotation(angle), out);
+	}
+
+	void transformVectors(const vector2_array& a, const affine2& matrix, vector2_array& out) {
+		const size_t count = a.size();
+
+		out.resize(count);
+
+		size_t i = 0;
+
+		#ifdef WINDOWS_WINDOW_X86
+			if (cpuSupportsAVX2())
+				i = transform_AVX2(a, matrix, out, count);
+		#endif
+
+		for (; i < count; i++) {
+			const float x = a.x[i], y = a.y[i];
+			out.x[i] = matrix.a * x + matrix.c * y + matrix.e;
+			out.y[i] = matrix.b * x + matrix.d * y + matrix.f;
+		}
+	}
+
+	bool storeVertices(const vector2_array& points, const std::span<vector2u>& vertices) noexcept {
+		const size_t count = points.size();
+
+		if (vertices.size() < count)
+			return false;
+
+		size_t i = 0;
+
+		#ifdef WINDOWS_WINDOW_X86
+			if (cpuSupportsAVX2())
+				i = storeVertices_AVX2(points, vertices.data(), count);
+		#endif
+
+		for (; i < count; i++)
+			vertices[i] = vector2u(toVertex(points.x[i]), toVertex(points.y[i]));
+
+		return true;
+	}
+
+	bool transformVertices(const vector2_array& points, const affine2& matrix, const std::span<vector2u>& vertices) noexcept {
+		const size_t count = points.size();
+
+		if (vertices.size() < count)
+			return false;
+
+		size_t i = 0;
+
+		#ifdef WINDOWS_WINDOW_X86
+			if (cpuSupportsAVX2())
+				i = transformVertices_AVX2(points, matrix, vertices.data(), count);
+		#endif
+
+		for (; i < count; i++) {
+			const float x = points.x[i], y = points.y[i];
+			vertices[i] = vector2u(toVertex(matrix.a * x + matrix.c * y + matrix.e), toVertex(matrix.b * x + matrix.d * y + matrix.f));
+		}
+
+		return true;
+	}
+
+	bool transformVertices(const std::span<const vector2u>& points, const affine2& matrix, const std::span<vector2u>& vertices) noexcept {
+		const size_t count = points.size();
+
+		if (vertices.size() < count)
+			return false;
+
+		size_t i = 0;
+
+		#ifdef WINDOWS_WINDOW_X86
+			if (cpuSupportsAVX2())
+				i = transformVertices_AVX2(points.data(), matrix, vertices.data(), count);
+		#endif
+
+		for (; i < count; i++) {
+			const float x = static_cast<float>(static_cast<int>(points[i].x)), y = static_cast<float>(static_cast<int>(points[i].y));
+			vertices[i] = vector2u(toVertex(matrix.a * x + matrix.c * y + matrix.e), toVertex(matrix.b * x + matrix.d * y + matrix.f));
+		}
+
+		return true;
+	}
+
+	bool transformVertices(const std::span<const vector2u>& points, const affine2& matrix, const std::span<vector2x8>& vertices) noexcept {
+		static_assert(sizeof(vector2x8) == sizeof(vector2u) && std::is_trivially_copyable_v<vector2x8>, "the raw values of vector2x8 are copied from vector2u");
+
+		const size_t count = points.size();
+
+		if (vertices.size() < count)
+			return false;
+
+		// the raw values are the vertices of the transform scaled by fixed8::ONE
+		constexpr float one = static_cast<float>(fixed8::ONE);
+		const affine2 scaled = affine2::scaling(one, one) * matrix;
+
+		// vector2x8 is no vector2u, the bytes are copied instead of writing through a cast pointer
+		constexpr size_t CHUNK = 256;
+		vector2u chunk[CHUNK];
+
+		for (size_t offset = 0; offset < count; offset += CHUNK) {
+			const size_t n = std::min(CHUNK, count - offset);
+
+			transformVertices(points.subspan(offset, n), scaled, std::span<vector2u>(chunk, n));
+			std::memcpy(static_cast<void*>(vertices.data() + offset), chunk, n * sizeof(vector2u));
+		}
+
+		return true;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,98 @@
+#ifndef WINDOWS_WINDOW_VECTOR_MATH_HPP
+	#define WINDOWS_WINDOW_VECTOR_MATH_HPP
+
+	#include "util.hpp"
+	#include "vector2.hpp"
+	#include "fixed.hpp"
+
+	#include <vector>
+
+	// Batch math on many 2d points at once. The points are stored as two separate float arrays (x..., y...),
+	// so the kernels handle 8 points per AVX2 instruction (if the cpu supports it, the scalar loop otherwise).
+	// Every kernel may write into one of its inputs.
+
+	namespace winLib {
+		// 2d affine transform as a 3x2 matrix (column vectors):
+		//   x' = a * x + c * y + e
+		//   y' = b * x + d * y + f
+		struct affine2 {
+			float a, b, c, d, e, f;
+
+			static constexpr affine2 identity() noexcept { return { 1, 0, 0, 1, 0, 0 }; }
+			static constexpr affine2 translation(float x, float y) noexcept { return { 1, 0, 0, 1, x, y }; }
+			static constexpr affine2 scaling(float x, float y) noexcept { return { x, 0, 0, y, 0, 0 }; }
+			// angle in radians, counter clockwise if the y axis points up (clockwise on the screen)
+			static affine2 rotation(float angle) noexcept { const float s = std::sin(angle), co = std::cos(angle); return { co, s, -s, co, 0, 0 }; }
+
+			vector2f apply(const vector2f& point) const noexcept { return vector2f(a * point.x + c * point.y + e, b * point.x + d * point.y + f); }
+
+			// this after other: (this * other).apply(p) == this->apply(other.apply(p))
+			constexpr affine2 operator* (const affine2& other) const noexcept {
+				return {
+					a * other.a + c * other.b, b * other.a + d * other.b,
+					a * other.c + c * other.d, b * other.c + d * other.d,
+					a * other.e + c * other.f + e, b * other.e + d * other.f + f
+				};
+			}
+
+			// false if the matrix can't be inverted (the result is unchanged)
+			bool invert(affine2& result) const noexcept;
+
+			// no rotation or shear, only translation and scaling
+			constexpr bool isAxisAligned() const noexcept { return b == 0 && c == 0; }
+			constexpr bool isTranslation() const noexcept { return a == 1 && b == 0 && c == 0 && d == 1; }
+			constexpr bool isIdentity() const noexcept { return isTranslation() && e == 0 && f == 0; }
+		};
+
+		class vector2_array {
+		public:
+			std::vector<float> x, y;
+
+			vector2_array() = default;
+			explicit vector2_array(size_t count) : x(count), y(count) {}
+			vector2_array(const std::span<const vector2f>& points) { load(points); }
+
+			size_t size() const noexcept { return x.size(); }
+			bool empty() const noexcept { return x.empty(); }
+
+			void resize(size_t count) { x.resize(count); y.resize(count); }
+			void reserve(size_t count) { x.reserve(count); y.reserve(count); }
+			void clear() noexcept { x.clear(); y.clear(); }
+
+			void push_back(const vector2f& point) { x.push_back(point.x); y.push_back(point.y); }
+
+			vector2f get(size_t index) const noexcept { return vector2f(x[index], y[index]); }
+			void set(size_t index, const vector2f& point) noexcept { x[index] = point.x; y[index] = point.y; }
+
+			// replaces the content with points
+			void load(const std::span<const vector2f>& points);
+			// writes the first points.size() points, false if the array has less points
+			bool store(const std::span<vector2f>& points) const noexcept;
+		};
+
+		// out = a + b (a and b need the same size)
+		bool addVectors(const vector2_array& a, const vector2_array& b, vector2_array& out);
+		// out = a * factor
+		void scaleVectors(const vector2_array& a, const vector2f& factor, vector2_array& out);
+		// out[i] = dot(a[i], b[i]), out needs at least a.size() elements
+		bool dotVectors(const vector2_array& a, const vector2_array& b, const std::span<float>& out) noexcept;
+		// out = a / |a|, zero vectors stay zero
+		void normalizeVectors(const vector2_array& a, vector2_array& out);
+		// rotates around the origin, same direction as affine2::rotation
+		void rotateVectors(const vector2_array& a, float angle, vector2_array& out);
+		void transformVectors(const vector2_array& a, const affine2& matrix, vector2_array& out);
+
+		// Conversion into the vertex spans of the rasterizer (fillPolygon, Scene::addPolygon, ...).
+		// Rounds to the nearest pixel. The coordinates are stored as two's complement ints, so points left of or above
+		// the render target keep their position (the rasterizer reads vertices as signed and clips them).
+		// vertices needs at least points.size() elements.
+		bool storeVertices(const vector2_array& points, const std::span<vector2u>& vertices) noexcept;
+		// transformVectors and storeVertices in one pass, without a temporary array
+		bool transformVertices(const vector2_array& points, const affine2& matrix, const std::span<vector2u>& vertices) noexcept;
+		// the same for vertices (read as signed ints), points and vertices may be the same span
+		bool transformVertices(const std::span<const vector2u>& points, const affine2& matrix, const std::span<vector2u>& vertices) noexcept;
+		// the same with the 8 sub pixel bits the rasterizer works with, nothing is rounded to whole pixels
+		bool transformVertices(const std::span<const vector2u>& points, const affine2& matrix, const std::span<vector2x8>& vertices) noexcept;
+	}
+
+#endif
\ No newline at end of file
@@ -1,32 +1,13 @@
 #include "window.hpp"
 
-namespace winLib {
-    LRESULT __stdcall Window::window_callback(HWND window_handle, _In_ UINT message, _In_ WPARAM wparam, _In_ LPARAM lparam) noexcept {
-        Window* this_pointer = nullptr;
-
-        if (message == WM_NCCREATE) {
-            CREATESTRUCT* create = (CREATESTRUCT*)lparam;
-
-            this_pointer = static_cast<Window*>(create->lpCreateParams);
-
-            if (this_pointer) {
-                SetWindowLongPtr(window_handle, GWLP_USERDATA, (LONG_PTR)this_pointer);
-
-                this_pointer->window_handle = window_handle;
-            }
-        } else
-            this_pointer = (Window*)GetWindowLongPtr(window_handle, GWLP_USERDATA);
-
-        if (this_pointer)
-            return this_pointer->window_event(message, wparam, lparam);
-
-        return DefWindowProc(window_handle, message, wparam, lparam);
-    }
+#include <algorithm>
 
+namespace winLib {
     Window::Window() noexcept {
         state = {};
-        window_handle = nullptr;
-        device_context_handle = nullptr;
+        backend = nullptr;
+        capture = nullptr;
+        recorder = nullptr;
         gdi_plus_image_loader = {};
         minDelta = 0.f;
         onInitalise = nullptr;
@@ -37,103 +18,94 @@ namespace winLib {
         mouse = {};
         blendFactor = 1.f;
         mode = AlphaMode::NONE;
+        transform = affine2::identity();
     }
 
-    void Window::create(int width, int height, DWORD window_style, HINSTANCE instance, NATIV_CURSOR cursor) noexcept {
-        const wchar_t* name = L"Window-Class Framework";
-
-        WNDCLASS wc = { };
+    Window::~Window() {
+        if (backend)
+            backend->destroy();
+    }
 
-        wc.lpfnWndProc = window_callback;
-        wc.hInstance = instance;
-        wc.lpszClassName = name;
-        wc.hCursor = load_nativ_cursor(cursor);
+    #ifdef WINDOWS_WINDOW_WIN32
+        void Window::create(int width, int height, DWORD window_style, HINSTANCE instance, NATIV_CURSOR cursor) noexcept {
+            std::unique_ptr<Backend> win32 = create_win32_backend(window_style, instance);
 
-        RegisterClass(&wc);
+            create(win32.get(), width, height, cursor);
 
-        // Create the window.
+            if (backend)
+                owned_backend = std::move(win32);
+        }
+    #else
+        void Window::create(int width, int height, NATIV_CURSOR cursor) noexcept {
+            std::unique_ptr<Backend> platform = create_default_backend();
 
-        window_handle = CreateWindowEx(
-            0,                              // Optional window styles.
-            name,                           // Window class
-            L"Learn to Program Windows",    // Window text
-            WS_OVERLAPPEDWINDOW,            // Window style
+            create(platform.get(), width, height, cursor);
 
-            // Size and position
-            CW_USEDEFAULT, CW_USEDEFAULT, width, height,
+            if (backend)
+                owned_backend = std::move(platform);
+        }
+    #endif
 
-            nullptr,       // Parent window    
-            nullptr,       // Menu
-            instance,      // Instance handle
-            this           // Additional application data
-        );
+    void Window::create(Backend* backend, int width, int height, NATIV_CURSOR cursor) noexcept {
+        if (this->backend) {
+            this->backend->destroy();
+            this->backend = nullptr;
+            owned_backend.reset();
+        }
 
-        if (!window_handle) {
-            DEBUGSTRING(Txt("Failed to create a Window! Last Error: %ul\n"), 100, GetLastError())
+        if (!backend || !backend->create(this, width, height, cursor)) {
+            DEBUGSTRING(Txt("Failed to create a Window! Backend: %p\n"), 100, static_cast<void*>(backend))
+            return;
         }
+
+        this->backend = backend;
     }
 
     void Window::start(int showCMD, unsigned int maxFrameRate) noexcept {
-        if (!window_handle) {
-            DEBUGSTRING(Txt("The Window does not exist! Last Error: %ul\n"), 100, GetLastError())
+        if (!backend) {
+            DEBUGSTRING(Txt("The Window does not exist! Backend: %p\n"), 100, static_cast<void*>(backend))
             return;
         }
 
         if (maxFrameRate < UNLIMITED_FRAME_RATE)
             minDelta = 1.0f / maxFrameRate;
 
-        ShowWindow(window_handle, showCMD);
+        backend->show(showCMD);
 
         running = true;
 
-        device_context_handle = GetDC(window_handle);
-
         gdi_plus_image_loader.gdi_plus_startup();
 
-        LARGE_INTEGER cpu_frequency;
-        QueryPerformanceFrequency(&cpu_frequency);
-
-        LARGE_INTEGER last_counter;
-        QueryPerformanceCounter(&last_counter);
+        double last_time = backend->time();
 
         if (onInitalise)
             onInitalise(this);
 
         while (running) {
-            float delta;
-
-            LARGE_INTEGER current_counter;
-            QueryPerformanceCounter(&current_counter);
+            const double current_time = backend->time();
 
-            const long long counter_elapsed = current_counter.QuadPart - last_counter.QuadPart;
+            const float delta = static_cast<float>(current_time - last_time);	// in seconds
 
-            delta = static_cast<float>(counter_elapsed) / static_cast<float>(cpu_frequency.QuadPart);	// in seconds
-
-            last_counter = current_counter;
+            last_time = current_time;
 
             DEBUGSTRING(Txt("delta: %f\n"), 100, delta)
 
-            MSG msg = {};
-            while (PeekMessage(&msg, window_handle, NULL, NULL, PM_REMOVE)) {
-                if (!handle_input(&msg, &keyboard, &mouse)) {
-                    // TODO error handeling
-                }
-            }
+            if (!backend->pumpEvents(this))
+                running = false;
+
+            if (recorder)
+                recorder->record(delta, state.width, state.height, &events);
 
             if (onUpdate) {
                 onUpdate(this, delta);
-                mouse.scroll_delta = 0;
+                next_input_frame(&keyboard, &mouse);
+                events.clear();
             }
 
-            StretchDIBits(
-                device_context_handle,
-                0, state.height, state.width, -static_cast<long long>(state.height),
-                0, 0, state.width, state.height,
-                state.memory,
-                &state.info,
-                DIB_RGB_COLORS,
-                SRCCOPY
-            );
+            if (capture)
+                capture->submit(state);
+
+            backend->present(state);
         }
 
         if (onTerminate)
@@ -142,66 +114,83 @@ namespace winLib {
         gdi_plus_image_loader.gdi_plus_shutdown();
     }
 
-    LRESULT Window::window_event(UINT message, WPARAM wparam, LPARAM lparam) noexcept {
+    static bool resize_replay_target(RenderState& state, unsigned int width, unsigned int height) noexcept {
+        if (state.memory && state.width == width && state.height == height)
+            return true;
+
+        freeAligned(state.memory);
+
+        state.width = width;
+        state.height = height;
+        state.memory = static_cast<unsigned int*>(allocateAligned(static_cast<size_t>(width) * height * sizeof(unsigned int)));
+        state.format = PixelFormat::PIXEL_BGRA8;
 
-        switch (message) {
-        case WM_DESTROY: {
-            running = false;
-            return 0;
+        return state.memory != nullptr;
+    }
+
+    bool Window::replay(InputReplay& replay) noexcept {
+        if (backend) {
+            DEBUGSTRING(Txt("A replay can't run on a created window (%p)!\n"), 100, static_cast<void*>(backend))
+            return false;
         }
-        case WM_SIZE: {
 
-            RECT client_rect = {};
+        InputFrame frame;
+        frame.events.reserve(INPUT_EVENT_CAPACITY);
 
-            GetClientRect(window_handle, &client_rect);
+        state = {};
+        keyboard = {};
+        mouse = {};
+        events.clear();
 
-            state.width = client_rect.right - client_rect.left;
-            state.height = client_rect.bottom - client_rect.top;
+        if (!resize_replay_target(state, replay.width, replay.height))
+            return false;
 
-            const int buffersize = int(static_cast<unsigned long long>(state.width) * state.height * sizeof(unsigned int));
+        running = true;
 
-            if (state.memory)
-                VirtualFree(state.memory, 0, MEM_RELEASE);
+        gdi_plus_image_loader.gdi_plus_startup();
 
-            state.memory = static_cast<unsigned int*>(VirtualAlloc(nullptr, buffersize, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE));
+        if (onInitalise)
+            onInitalise(this);
 
-            state.info.bmiHeader.biSize = sizeof(state.info.bmiHeader);
-            state.info.bmiHeader.biWidth = state.width;
-            state.info.bmiHeader.biHeight = state.height;
-            state.info.bmiHeader.biPlanes = 1;
-            state.info.bmiHeader.biBitCount = 32;
-            state.info.bmiHeader.biCompression = BI_RGB;
+        while (running && replay.next(frame)) {
+            if (!resize_replay_target(state, frame.width, frame.height))
+                break;
 
-            return 0;
-        }
-        default:
-            return DefWindowProc(window_handle, message, wparam, lparam);
+            for (const InputEvent& event : frame.events) {
+                apply_input_event(event, &keyboard, &mouse);
+                events.push(event);
+            }
+
+            if (onUpdate) {
+                onUpdate(this, frame.delta);
+                next_input_frame(&keyboard, &mouse);
+                events.clear();
+            }
+
+            if (capture)
+                capture->submit(state);
         }
+
+        running = false;
+
+        if (onTerminate)
+            onTerminate(this);
+
+        gdi_plus_image_loader.gdi_plus_shutdown();
+
+        freeAligned(state.memory);
+        state = {};
+
+        return true;
     }
 
     void Window::setTitle(const std::string title) {
-        #if defined(UNICODE) || defined(_UNICODE)
-            SetWindowText(window_handle, convertS2W(title).c_str());
-        #else
-            SetWindowText(window_handle, title.c_str());
-        #endif
+        if (backend)
+            backend->setTitle(title);
     }
 
     std::string Window::getTitle() {
-        #if defined(UNICODE) || defined(_UNICODE)
-            const int str_length = GetWindowTextLength(window_handle);
-            LPWSTR wtitle = {};
-            if (GetWindowText(window_handle, wtitle, str_length + 1) && str_length) {
-                return convertW2S(wtitle);
-            }
-        #else
-            const int str_length = GetWindowTextLength(window_handle);
-            LPSTR title = {};
-            if (GetWindowText(window_handle, title, str_length + 1) && str_length) {
-                return std::string(title);
-            }
-        #endif
-        return "";
+        return backend ? backend->getTitle() : "";
     }
 
     int Window::getWidth() const noexcept {
@@ -220,6 +209,237 @@ namespace winLib {
         this->blendFactor = factor;
     }
 
+    void Window::pushTransform() {
+        transform_stack.push_back(transform);
+    }
+
+    bool Window::popTransform() noexcept {
+        if (transform_stack.empty())
+            return false;
+
+        transform = transform_stack.back();
+        transform_stack.pop_back();
+        return true;
+    }
+
+    void Window::resetTransform() noexcept {
+        transform = affine2::identity();
+        transform_stack.clear();
+    }
+
+    void Window::setTransform(const affine2& matrix) noexcept {
+        transform = matrix;
+    }
+
+    const affine2& Window::getTransform() const noexcept {
+        return transform;
+    }
+
+    void Window::translate(float x, float y) noexcept {
+        transform = transform * affine2::translation(x, y);
+    }
+
+    void Window::rotate(float angle) noexcept {
+        transform = transform * affine2::rotation(angle);
+    }
+
+    void Window::scale(float x, float y) noexcept {
+        transform = transform * affine2::scaling(x, y);
+    }
+
+    // coordinates of the draw methods are signed, even if the parameters are unsigned
+    static vector2f local_point(int x, int y) noexcept {
+        return vector2f(static_cast<float>(x), static_cast<float>(y));
+    }
+
+    // rounds the same way as transformVertices(...), so rects and polygons with the same corners line up
+    static int round_coordinate(float v) noexcept {
+        constexpr float limit = 2147483520.0f;
+        return static_cast<int>(std::nearbyint(v > -limit ? (v < limit ? v : limit) : -limit));
+    }
+
+    static vector2i transform_point(const affine2& m, int x, int y) noexcept {
+        if (m.isIdentity())
+            return vector2i(x, y);
+
+        const vector2f p = m.apply(local_point(x, y));
+        return vector2i(round_coordinate(p.x), round_coordinate(p.y));
+    }
+
+    // how much the transform scales lengths on average (radii of circles)
+    static float transform_scale(const affine2& m) noexcept {
+        return std::sqrt(std::fabs(m.a * m.d - m.b * m.c));
+    }
+
+    // only rotation, uniform scaling and mirroring: a circle stays a circle with the radius times transform_scale(m),
+    // other transforms make it an ellipse
+    static bool keeps_circles(const affine2& m) noexcept {
+        const float tolerance = 1e-4f * (std::fabs(m.a) + std::fabs(m.b) + std::fabs(m.c) + std::fabs(m.d));
+        return (std::fabs(m.a - m.d) <= tolerance && std::fabs(m.b + m.c) <= tolerance) || (std::fabs(m.a + m.d) <= tolerance && std::fabs(m.b - m.c) <= tolerance);
+    }
+
+    // segments of an ellipse with the longer radius (in pixels), a multiple of 8 so every octant has its own,
+    // the chords stay within a quarter pixel of the curve
+    static int ellipse_segments(float radius) noexcept {
+        const float step = radius > 0.25f ? std::acos(1.0f - 0.25f / radius) : 1.0f;
+        const int segments = static_cast<int>(std::ceil(3.14159265f / step));
+        return std::clamp((segments + 7) / 8 * 8, 16, 2048);
+    }
+
+    // vertices are clamped to +-2^21 pixels, so the edge math of the rasterizer fits into 64 bit
+    constexpr int RASTER_LIMIT = 1 << 21;
+
+    static fixed8 to_subpixel(int v) noexcept {
+        return fixed8(std::min(std::max(v, -RASTER_LIMIT), RASTER_LIMIT));
+    }
+
+    static fixed8 to_subpixel(float v) noexcept {
+        constexpr float limit = static_cast<float>(RASTER_LIMIT);
+        return fixed8(static_cast<double>(v > -limit ? (v < limit ? v : limit) : -limit));
+    }
+
+    static vector2x8 clamp_vertex(const vector2x8& p) noexcept {
+        const vector2x8 limit{ fixed8(RASTER_LIMIT), fixed8(RASTER_LIMIT) };
+        return p.maximum(-limit).minimum(limit);
+    }
+
+    // keeps the sub pixel bits, the rasterizer samples the pixel centers
+    static vector2x8 transform_subpixel(const affine2& m, int x, int y) noexcept {
+        if (m.isIdentity())
+            return vector2x8(to_subpixel(x), to_subpixel(y));
+
+        const vector2f p = m.apply(local_point(x, y));
+        return vector2x8(to_subpixel(p.x), to_subpixel(p.y));
+    }
+
+    // b > 0
+    static long long raster_ceil_div(long long a, long long b) noexcept {
+        return a >= 0 ? (a + b - 1) / b : -(-a / b);
+    }
+
+    static long long raster_floor_div(long long a, long long b) noexcept {
+        return a >= 0 ? a / b : -((-a + b - 1) / b);
+    }
+
+    // first pixel (row or column) whose center is at or behind v, a pixel is covered if its center is in [start; end)
+    static int pixel_boundary(fixed8 v) noexcept {
+        return static_cast<int>(raster_ceil_div(static_cast<long long>(v.raw) - fixed8::HALF, fixed8::ONE));
+    }
+
+    // Walks an edge (top.y < bottom.y) down the pixel rows, x is pixel_boundary(...) of the edge at the pixel center
+    // of the row. Exact: the position is a fraction numerator / (ONE * dy) and only the remainder is stepped.
+    struct RasterEdge {
+        long long denominator, remainder, step_remainder;
+        int x, step;
+
+        RasterEdge(const vector2x8& top, const vector2x8& bottom, int row) noexcept {
+            const long long dx = static_cast<long long>(bottom.x.raw) - top.x.raw, dy = static_cast<long long>(bottom.y.raw) - top.y.raw;
+            const long long center = static_cast<long long>(row) * fixed8::ONE + fixed8::HALF;
+
+            // (x(center) - HALF) * dy
+            const long long numerator = (static_cast<long long>(top.x.raw) - fixed8::HALF) * dy + (center - top.y.raw) * dx;
+            const long long step_numerator = fixed8::ONE * dx;
+
+            denominator = fixed8::ONE * dy;
+            x = static_cast<int>(raster_ceil_div(numerator, denominator));
+            remainder = static_cast<long long>(x) * denominator - numerator;
+            step = static_cast<int>(raster_floor_div(step_numerator, denominator));
+            step_remainder = step_numerator - static_cast<long long>(step) * denominator;
+        }
+
+        void next() noexcept {
+            const long long t = step_remainder - remainder;
+
+            x += step;
+
+            if (t > 0) {
+                x++;
+                remainder = denominator - t;
+            } else
+                remainder = -t;
+        }
+    };
+
+    // attributes of the rasterizer are fixed<16, long long>, texture coordinates are clamped to +-2^14 so the
+    // products with the edges (< 2^30 raw) of RasterPlane stay below 2^62
+    constexpr double RASTER_ATTRIBUTE_LIMIT = 1 << 14;
+
+    static fixed<16, long long> raster_attribute(double value) noexcept {
+        return fixed<16, long long>(std::min(std::max(value, -RASTER_ATTRIBUTE_LIMIT), RASTER_ATTRIBUTE_LIMIT));
+    }
+
+    // floor(numerator * 2^shift / denominator) without the overflow of the shift: the remainder is divided bit by bit.
+    // Saturated at 2^40 (2^24 per pixel for a gradient), only a degenerate sliver gets there.
+    static long long raster_shifted_quotient(long long numerator, long long denominator, unsigned int shift) noexcept {
+        constexpr unsigned long long limit = 1ULL << 40;
+
+        const bool negative = (numerator < 0) != (denominator < 0);
+        const unsigned long long n = numerator < 0 ? 0ULL - static_cast<unsigned long long>(numerator) : static_cast<unsigned long long>(numerator);
+        const unsigned long long d = denominator < 0 ? 0ULL - static_cast<unsigned long long>(denominator) : static_cast<unsigned long long>(denominator);
+
+        unsigned long long quotient = n / d, remainder = n % d;
+
+        if (quotient >= (limit >> shift))
+            return negative ? -static_cast<long long>(limit) : static_cast<long long>(limit);
+
+        for (unsigned int i = 0; i < shift; i++) {
+            quotient <<= 1;
+            remainder <<= 1;
+
+            if (remainder >= d) {
+                remainder -= d;
+                quotient |= 1;
+            }
+        }
+
+        return negative ? -static_cast<long long>(quotient + (remainder != 0)) : static_cast<long long>(quotient);
+    }
+
+    // An attribute of a triangle as a plane over the pixel centers: value(x, y) = origin + (x - ox) * dx + (y - oy) * dy.
+    // Set up once per triangle, the pixels only add dx. Integer only: the gradients are the exact quotients of the
+    // cross products of the sub pixel corners (rounded down), the origin is the pixel of the first corner, so it
+    // is at most a pixel away from a value that was given.
+    struct RasterPlane {
+        fixed<16, long long> origin, dx, dy;
+        int ox, oy;
+
+        RasterPlane(const vector2x8 (&p)[3], const fixed<16, long long> (&values)[3]) noexcept {
+            const vector2x8 e1 = p[1] - p[0], e2 = p[2] - p[0];
+            const long long v1 = values[1].raw - values[0].raw, v2 = values[2].raw - values[0].raw;
+
+            // 16 fraction bits (8 + 8), the caller skips triangles without an area
+            const long long area = e1.cross(e2);
+
+            // (v1 * y2 - v2 * y1) / area and (v2 * x1 - v1 * x2) / area: 24 fraction bits over 16, 8 more for fixed<16>
+            dx = fixed<16, long long>::fromRaw(raster_shifted_quotient(v1 * e2.y.raw - v2 * e1.y.raw, area, 8));
+            dy = fixed<16, long long>::fromRaw(raster_shifted_quotient(v2 * e1.x.raw - v1 * e2.x.raw, area, 8));
+
+            ox = static_cast<int>(p[0].x.floor());
+            oy = static_cast<int>(p[0].y.floor());
+
+            // from the first corner to the center of its pixel, less than a pixel (fixed8 raw in 16 fraction bits)
+            const fixed<16, long long> cx = fixed<16, long long>::fromRaw((static_cast<long long>(ox) * fixed8::ONE + fixed8::HALF - p[0].x.raw) << 8);
+            const fixed<16, long long> cy = fixed<16, long long>::fromRaw((static_cast<long long>(oy) * fixed8::ONE + fixed8::HALF - p[0].y.raw) << 8);
+
+            origin = values[0] + dx * cx + dy * cy;
+        }
+
+        fixed<16, long long> at(int x, int y) const noexcept {
+            return origin + dx * (x - ox) + dy * (y - oy);
+        }
+    };
+
+    static unsigned int raster_channel(const fixed<16, long long>& value) noexcept {
+        const long long channel = value.floor();
+        return static_cast<unsigned int>(channel < 0 ? 0 : channel > 255 ? 255 : channel);
+    }
+
+    // (a * b) / 255 without a division
+    static unsigned int modulate_channel(unsigned int a, unsigned int b) noexcept {
+        const unsigned int t = a * b + 128;
+        return (t + (t >> 8)) >> 8;
+    }
+
     void Window::clearScreen(unsigned int color_code) const noexcept {
         unsigned int* pixel = state.memory;
 
@@ -258,117 +478,117 @@ namespace winLib {
     }
 
     void Window::drawLine(unsigned int x1, unsigned int y1, unsigned int x2, unsigned int y2, unsigned int color_code, unsigned int pattern) const {
-        unsigned int x, y, dx1, dy1, px, py, xe, ye, i;
-        const int dx = x2 - x1, dy = y2 - y1;
+        const vector2i p1 = transform_point(transform, x1, y1), p2 = transform_point(transform, x2, y2);
+        rasterLine(p1.x, p1.y, p2.x, p2.y, color_code, pattern);
+    }
 
-        auto rol = [&](void) { pattern = (pattern << 1) | (pattern >> 31); return pattern & 1; };
+    // Liang-Barsky: the part t1..t2 (of 0..1) of the line from x, y by dx, dy inside of [min; max] on both axes,
+    // false if there is none
+    static bool clip_line(double x, double y, double dx, double dy, double min_x, double min_y, double max_x, double max_y, double& t1, double& t2) noexcept {
+        t1 = 0.0;
+        t2 = 1.0;
 
-        if (dx == 0) {
-            if (y2 < y1)
-                std::swap(y1, y2);
+        // the points with p * t <= q
+        auto clip = [&](double p, double q) {
+            if (p == 0.0)
+                return q >= 0.0;
 
-            if (x1 >= state.width)
-                return;
+            const double t = q / p;
 
-            #ifdef min
-                y2 = min(y2, state.height - 1);
-            #else
-                y2 = std::min(y2, state.height - 1);
-            #endif
+            if (p < 0.0)
+                t1 = std::max(t1, t);
+            else
+                t2 = std::min(t2, t);
 
-            for (y = y1; y <= y2; y++)
-                if (rol())
-                    draw(x1, y, color_code);
+            return t1 <= t2;
+        };
+
+        return clip(-dx, x - min_x) && clip(dx, max_x - x) && clip(-dy, y - min_y) && clip(dy, max_y - y);
+    }
 
+    void Window::rasterLine(int x1, int y1, int x2, int y2, unsigned int color_code, unsigned int pattern) const {
+        if (!state.memory || state.width == 0 || state.height == 0)
             return;
-        }
 
-        if (dy == 0) {
-            if (x2 < x1)
-                std::swap(x1, x2);
+        auto rol = [&](void) { pattern = (pattern << 1) | (pattern >> 31); return pattern & 1; };
+        // the pattern of the clipped part still has to be rotated
+        auto skip = [&](long long count) { count &= 31; if (count) pattern = (pattern << count) | (pattern >> (32 - count)); };
 
-            if (y1 >= state.height)
-                return;
+        // walked along the major axis from its lower end, the pattern starts there
+        const bool steep = std::llabs(static_cast<long long>(y2) - y1) > std::llabs(static_cast<long long>(x2) - x1);
 
-            #ifdef min
-                x2 = min(x2, state.width - 1);
-            #else
-                x2 = std::min(x2, state.width - 1);
-            #endif
+        if (steep ? y2 < y1 : x2 < x1) {
+            std::swap(x1, x2);
+            std::swap(y1, y2);
+        }
 
-            for (x = x1; x <= x2; x++)
-                if (rol())
-                    draw(x, y1, color_code);
+        // the render target with half a pixel around the pixel centers
+        const double right = state.width - 0.5, bottom = state.height - 0.5;
+        double t1, t2;
 
+        if (!clip_line(x1, y1, static_cast<double>(x2) - x1, static_cast<double>(y2) - y1, -0.5, -0.5, right, bottom, t1, t2))
             return;
-        }
 
-        const vector2i p1(x1, y1), p2(x2, y2);
+        // The transformed endpoints may be 2^32 apart: a longer line is cut to a box far around the target first, the
+        // walk below stays exact in 64 bit up to 2^30 steps.
+        constexpr double LINE_BOX = 1 << 29;
 
-        dx1 = abs(dx); dy1 = abs(dy);
-        px = 2 * dy1 - dx1;	py = 2 * dx1 - dy1;
-        if (dy1 <= dx1) {
-            if (dx >= 0) {
-                x = x1;
-                y = y1;
-                xe = x2;
-            }
-            else {
-                x = x2;
-                y = y2;
-                xe = x1;
-            }
+        if (std::max(std::llabs(static_cast<long long>(x2) - x1), std::llabs(static_cast<long long>(y2) - y1)) >= (1ll << 30)) {
+            const double dx = static_cast<double>(x2) - x1, dy = static_cast<double>(y2) - y1;
+            double f1, f2;
 
-            if (rol())
-                draw(x, y, color_code);
+            clip_line(x1, y1, dx, dy, -LINE_BOX, -LINE_BOX, LINE_BOX, LINE_BOX, f1, f2);
 
-            for (i = 0; x < xe; i++) {
-                x = x + 1;
-                if (px < 0)
-                    px = px + 2 * dy1;
-                else {
-                    if ((dx < 0 && dy < 0) || (dx > 0 && dy > 0))
-                        y = y + 1;
-                    else
-                        y = y - 1;
+            const int cx1 = static_cast<int>(std::llround(x1 + dx * f1)), cy1 = static_cast<int>(std::llround(y1 + dy * f1));
+            const int cx2 = static_cast<int>(std::llround(x1 + dx * f2)), cy2 = static_cast<int>(std::llround(y1 + dy * f2));
 
-                    px = px + 2 * (dy1 - dx1);
-                }
-                if (rol())
-                    draw(x, y, color_code);
-            }
+            skip(steep ? static_cast<long long>(cy1) - y1 : static_cast<long long>(cx1) - x1);
 
+            x1 = cx1; y1 = cy1;
+            x2 = cx2; y2 = cy2;
+
+            if (!clip_line(x1, y1, static_cast<double>(x2) - x1, static_cast<double>(y2) - y1, -0.5, -0.5, right, bottom, t1, t2))
+                return;
         }
-        else {
-            if (dy >= 0) {
-                x = x1;
-                y = y1;
-                ye = y2;
-            }
-            else {
-                x = x2;
-                y = y2;
-                ye = y1;
-            }
 
+        // Bresenham along the major axis, a tie goes to the minor step on flat lines and to the major axis on steep ones
+        const long long major_length = steep ? static_cast<long long>(y2) - y1 : static_cast<long long>(x2) - x1;
+        const long long minor_length = std::llabs(steep ? static_cast<long long>(x2) - x1 : static_cast<long long>(y2) - y1);
+        const int step = (steep ? x2 < x1 : y2 < y1) ? -1 : 1;
+
+        auto plot = [&](long long major, long long minor) {
             if (rol())
-                draw(x, y, color_code);
+                draw(static_cast<unsigned int>(steep ? minor : major), static_cast<unsigned int>(steep ? major : minor), color_code);
+        };
 
-            for (i = 0; y < ye; i++) {
-                y = y + 1;
-                if (py <= 0)
-                    py = py + 2 * dx1;
-                else {
-                    if ((dx < 0 && dy < 0) || (dx > 0 && dy > 0))
-                        x = x + 1;
-                    else
-                        x = x - 1;
+        if (major_length == 0) {
+            plot(x1, y1);
+            return;
+        }
 
-                    py = py + 2 * (dx1 - dy1);
-                }
-                if (rol())
-                    draw(x, y, color_code);
-            }
+        // only the steps that reach the target are walked (one more on both ends, draw(...) clips them), the state
+        // of the walk after the first skipped ones: minor_steps were taken
+        const long long first = std::max<long long>(static_cast<long long>(std::floor(t1 * major_length)) - 1, 0);
+        const long long last = std::min<long long>(static_cast<long long>(std::ceil(t2 * major_length)) + 1, major_length);
+        const long long minor_steps = (2 * minor_length * first + major_length - (steep ? 1 : 0)) / (2 * major_length);
+
+        long long error = 2 * minor_length - major_length + 2 * minor_length * first - 2 * major_length * minor_steps;
+        long long major = (steep ? y1 : x1) + first;
+        long long minor = (steep ? x1 : y1) + step * minor_steps;
+
+        skip(first);
+        plot(major, minor);
+
+        for (long long i = first; i < last; i++) {
+            major++;
+
+            if (steep ? error > 0 : error >= 0) {
+                minor += step;
+                error += 2 * (minor_length - major_length);
+            } else
+                error += 2 * minor_length;
+
+            plot(major, minor);
         }
     }
 
@@ -381,40 +601,39 @@ namespace winLib {
     }
 
     void Window::fillRect(unsigned int x, unsigned int y, unsigned int w, unsigned int h, unsigned int color_code) const {
-        if (x < 0 || y < 0 || w < 0 || h < 0)
-            return;
-
-        if (x >= state.width)
-            x = state.width - 1;
-        if (y >= state.height)
-            y = state.height - 1;
-
-        unsigned int x2 = x + w;
-        unsigned int y2 = y + h;
-
-        if (w == 0) {
-            if (h == 0) {
-                draw(x, y, color_code);
+        if (w == 0 || h == 0) {
+            if (w == 0 && h == 0) {
+                const vector2i p = transform_point(transform, x, y);
+                draw(p.x, p.y, color_code);
                 return;
             }
 
-            drawLine(x, y, x, y2, color_code);
+            drawLine(x, y, x + w, y + h, color_code);
             return;
         }
 
-        if (h == 0) {
-            drawLine(x, y, x2, y, color_code);
+        if (!transform.isAxisAligned()) {
+            const vector2x8 p1 = transform_subpixel(transform, x, y), p2 = transform_subpixel(transform, x + w, y);
+            const vector2x8 p3 = transform_subpixel(transform, x + w, y + h), p4 = transform_subpixel(transform, x, y + h);
+
+            // the shared edge is covered exactly once
+            rasterTriangle(p1, p2, p3, color_code);
+            rasterTriangle(p1, p3, p4, color_code);
             return;
         }
 
-        if (x2 >= state.width)
-            x2 = state.width - 1;
-        if (y2 >= state.height)
-            y2 = state.height - 1;
+        if (!state.memory)
+            return;
+
+        // no rotation, so the rect stays a plain blit of [x1; x2) x [y1; y2), the same pixels the rasterizer would cover
+        const vector2x8 p1 = transform_subpixel(transform, x, y), p2 = transform_subpixel(transform, x + w, y + h);
+
+        const int x1 = std::max(pixel_boundary(std::min(p1.x, p2.x)), 0), x2 = std::min(pixel_boundary(std::max(p1.x, p2.x)), static_cast<int>(state.width));
+        const int y1 = std::max(pixel_boundary(std::min(p1.y, p2.y)), 0), y2 = std::min(pixel_boundary(std::max(p1.y, p2.y)), static_cast<int>(state.height));
 
-        for (unsigned int y_ = y; y_ < y2; y_++) {
-            unsigned int* pixel = state.memory + x + y_ * state.width;
-            for (unsigned int x_ = x; x_ < x2; x_++) {
+        for (int y_ = y1; y_ < y2; y_++) {
+            unsigned int* pixel = state.memory + x1 + static_cast<size_t>(y_) * state.width;
+            for (int x_ = x1; x_ < x2; x_++) {
                 // more efficient in this case than the draw(...) method
                 *pixel++ = color_code;
             }
@@ -428,376 +647,182 @@ namespace winLib {
     }
 
     void Window::fillTriangle(unsigned int x1, unsigned int y1, unsigned int x2, unsigned int y2, unsigned int x3, unsigned int y3, unsigned int color_code) {
-        auto drawline = [&](unsigned int sx, unsigned int ex, unsigned int ny) {
-            if (ny >= state.height)
-                return;
+        rasterTriangle(transform_subpixel(transform, x1, y1), transform_subpixel(transform, x2, y2), transform_subpixel(transform, x3, y3), color_code);
+    }
 
-            unsigned int* pixel = state.memory + sx + ny * state.width;
+    void Window::rasterTriangle(vector2x8 p1, vector2x8 p2, vector2x8 p3, unsigned int color_code) const {
+        if (!state.memory)
+            return;
 
-            #ifdef min
-                ex = min(ex, state.width - 1);
-            #else
-                ex = std::min(ex, state.width - 1);
-            #endif
+        p1 = clamp_vertex(p1);
+        p2 = clamp_vertex(p2);
+        p3 = clamp_vertex(p3);
 
-            for (unsigned int x_ = sx; x_ <= ex; x_++) {
-                // more efficient in this case than the draw(...) method
-                *pixel++ = color_code;
-            }
-            };
-
-        unsigned int t1x, t2x, y, minx, maxx, t1xp, t2xp;
-        bool changed1 = false;
-        bool changed2 = false;
-        int signx1, signx2, dx1, dy1, dx2, dy2;
-        int e1, e2;
+        // sort by y, p1 is the top
+        if (p2.y < p1.y) std::swap(p1, p2);
+        if (p3.y < p1.y) std::swap(p1, p3);
+        if (p3.y < p2.y) std::swap(p2, p3);
 
-        // Sort vertices
-        if (y1 > y2) {
-            std::swap(y1, y2);
-            std::swap(x1, x2);
-        }
+        // > 0 if p2 is left of the long edge p1 -> p3, 0 if the triangle has no area
+        const long long side = (p3 - p1).cross(p2 - p1);
 
-        if (y1 > y3) {
-            std::swap(y1, y3);
-            std::swap(x1, x3);
-        }
-        if (y2 > y3) {
-            std::swap(y2, y3);
-            std::swap(x2, x3);
-        }
+        if (side == 0)
+            return;
 
-        t1x = t2x = x1; y = y1;
-        dx1 = static_cast<int>(x2 - x1);
+        const int height = static_cast<int>(state.height), width = static_cast<int>(state.width);
+        const int first = std::max(pixel_boundary(p1.y), 0);
+        const int middle = std::min(std::max(pixel_boundary(p2.y), first), height);
+        const int last = std::min(pixel_boundary(p3.y), height);
 
-        if (dx1 < 0) {
-            dx1 = -dx1;
-            signx1 = -1;
-        } else
-            signx1 = 1;
+        if (first >= last)
+            return;
 
-        dy1 = static_cast<int>(y2 - y1);
+        auto fill = [&](RasterEdge& left, RasterEdge& right, int from, int to) {
+            for (int y = from; y < to; y++, left.next(), right.next()) {
+                const int x1 = std::max(left.x, 0), x2 = std::min(right.x, width);
+                unsigned int* pixel = state.memory + x1 + static_cast<size_t>(y) * state.width;
 
-        dx2 = static_cast<int>(x3 - x1);
+                for (int x = x1; x < x2; x++) {
+                    // more efficient in this case than the draw(...) method
+                    *pixel++ = color_code;
+                }
+            }
+        };
 
-        if (dx2 < 0) {
-            dx2 = -dx2;
-            signx2 = -1;
-        }
-        else
-            signx2 = 1;
+        RasterEdge long_edge(p1, p3, first);
 
-        dy2 = static_cast<int>(y3 - y1);
+        if (first < middle) {
+            RasterEdge edge(p1, p2, first);
 
-        if (dy1 > dx1) {
-            std::swap(dx1, dy1);
-            changed1 = true;
+            if (side > 0)
+                fill(edge, long_edge, first, middle);
+            else
+                fill(long_edge, edge, first, middle);
         }
 
-        if (dy2 > dx2) {
-            std::swap(dy2, dx2);
-            changed2 = true;
+        if (middle < last) {
+            RasterEdge edge(p2, p3, middle);
+
+            if (side > 0)
+                fill(edge, long_edge, middle, last);
+            else
+                fill(long_edge, edge, middle, last);
         }
+    }
 
-        e2 = static_cast<int>(dx2 >> 1);
+    void Window::fillTexturedTriangle(const std::span<vector2u>& screen_pos, const std::span<vector2f>& texture_pos, const std::span<unsigned int>& colors, Image* texture) {
+        const vector2x8 points[] = {
+            transform_subpixel(transform, screen_pos[0].x, screen_pos[0].y),
+            transform_subpixel(transform, screen_pos[1].x, screen_pos[1].y),
+            transform_subpixel(transform, screen_pos[2].x, screen_pos[2].y)
+        };
 
-        if (y1 == y2)
-            goto next;
+        rasterTexturedTriangle(points, texture_pos, colors, texture);
+    }
 
-        e1 = static_cast<int>(dx1 >> 1);
+    void Window::rasterTexturedTriangle(const std::span<const vector2x8>& points, const std::span<const vector2f>& texture_pos, const std::span<const unsigned int>& colors, Image* texture) const {
+        if (!state.memory)
+            return;
 
-        for (int i = 0; i < dx1;) {
-            t1xp = 0; t2xp = 0;
-            if (t1x < t2x) {
-                minx = t1x;
-                maxx = t2x;
-            }
-            else {
-                minx = t2x;
-                maxx = t1x;
-            }
-            while (i < dx1) {
-                i++;
-                e1 += dy1;
-                while (e1 >= dx1) {
-                    e1 -= dx1;
-
-                    if (changed1)
-                        t1xp = signx1;
-                    else
-                        goto next1;
-                }
-                if (changed1)
-                    break;
-                else
-                    t1x += signx1;
-            }
+        const vector2x8 clamped[] = { clamp_vertex(points[0]), clamp_vertex(points[1]), clamp_vertex(points[2]) };
 
-        next1:
+        // sort by y, the attributes don't need to be sorted
+        vector2x8 p1 = clamped[0], p2 = clamped[1], p3 = clamped[2];
 
-            while (1) {
-                e2 += dy2;
-                while (e2 >= dx2) {
-                    e2 -= dx2;
+        if (p2.y < p1.y) std::swap(p1, p2);
+        if (p3.y < p1.y) std::swap(p1, p3);
+        if (p3.y < p2.y) std::swap(p2, p3);
 
-                    if (changed2)
-                        t2xp = signx2;
-                    else
-                        goto next2;
-                }
-                if (changed2)
-                    break;
-                else
-                    t2x += signx2;
-            }
-        next2:
-            if (minx > t1x)
-                minx = t1x;
+        const long long side = (p3 - p1).cross(p2 - p1);
 
-            if (minx > t2x)
-                minx = t2x;
+        if (side == 0)
+            return;
 
-            if (maxx < t1x)
-                maxx = t1x;
+        const int height = static_cast<int>(state.height), width = static_cast<int>(state.width);
+        const int first = std::max(pixel_boundary(p1.y), 0);
+        const int middle = std::min(std::max(pixel_boundary(p2.y), first), height);
+        const int last = std::min(pixel_boundary(p3.y), height);
 
-            if (maxx < t2x)
-                maxx = t2x;
+        if (first >= last)
+            return;
 
-            drawline(minx, maxx, y);
+        // the planes of the attributes, once per triangle (the texture coordinates are the only float input)
+        auto plane = [&](auto value) {
+            const fixed<16, long long> values[] = { value(0), value(1), value(2) };
+            return RasterPlane(clamped, values);
+        };
 
-            if (!changed1)
-                t1x += signx1;
+        const RasterPlane u = plane([&](int i) { return raster_attribute(texture_pos[i].x); });
+        const RasterPlane v = plane([&](int i) { return raster_attribute(texture_pos[i].y); });
+        const RasterPlane red   = plane([&](int i) { return fixed<16, long long>(static_cast<int>(getRedColorValue(colors[i]))); });
+        const RasterPlane green = plane([&](int i) { return fixed<16, long long>(static_cast<int>(getGreenColorValue(colors[i]))); });
+        const RasterPlane blue  = plane([&](int i) { return fixed<16, long long>(static_cast<int>(getBlueColorValue(colors[i]))); });
+        const RasterPlane alpha = plane([&](int i) { return fixed<16, long long>(static_cast<int>(getAlphaColorValue(colors[i]))); });
 
-            t1x += t1xp;
-            if (!changed2)
-                t2x += signx2;
+        auto fill = [&](RasterEdge& left, RasterEdge& right, int from, int to) {
+            for (int y = from; y < to; y++, left.next(), right.next()) {
+                const int x1 = std::max(left.x, 0), x2 = std::min(right.x, width);
 
-            t2x += t2xp;
-            y += 1;
-            if (y == y2)
-                break;
-        }
-    next:
+                if (x1 >= x2)
+                    continue;
 
-        dx1 = static_cast<int>(x3 - x2);
+                fixed<16, long long> tu = u.at(x1, y), tv = v.at(x1, y);
+                fixed<16, long long> r = red.at(x1, y), g = green.at(x1, y), b = blue.at(x1, y), a = alpha.at(x1, y);
 
-        if (dx1 < 0) {
-            dx1 = -dx1;
-            signx1 = -1;
-        }
-        else
-            signx1 = 1;
+                for (int x = x1; x < x2; x++) {
+                    unsigned int color = rgbaColorCode(raster_channel(r), raster_channel(g), raster_channel(b), raster_channel(a));
 
-        dy1 = static_cast<int>(y3 - y2);
-        t1x = x2;
-        if (dy1 > dx1) {
-            std::swap(dy1, dx1);
-            changed1 = true;
-        }
-        else
-            changed1 = false;
+                    if (texture) {
+                        const unsigned int tex_color = texture->getColor(static_cast<unsigned int>(tu.floor()), static_cast<unsigned int>(tv.floor()));
 
-        e1 = static_cast<int>(dx1 >> 1);
+                        color = rgbaColorCode(
+                            modulate_channel(getRedColorValue(color), getRedColorValue(tex_color)),
+                            modulate_channel(getGreenColorValue(color), getGreenColorValue(tex_color)),
+                            modulate_channel(getBlueColorValue(color), getBlueColorValue(tex_color)),
+                            modulate_channel(getAlphaColorValue(color), getAlphaColorValue(tex_color))
+                        );
+                    }
 
-        for (int i = 0; i <= dx1; i++) {
-            t1xp = 0; t2xp = 0;
+                    draw(x, y, color);
 
-            if (t1x < t2x) {
-                minx = t1x;
-                maxx = t2x;
-            }
-            else {
-                minx = t2x;
-                maxx = t1x;
+                    tu += u.dx; tv += v.dx;
+                    r += red.dx; g += green.dx; b += blue.dx; a += alpha.dx;
+                }
             }
+        };
 
-            while (i < dx1) {
-                e1 += dy1;
-                while (e1 >= dx1) {
-                    e1 -= dx1;
-                    if (changed1) {
-                        t1xp = signx1;
-                        break;
-                    }
-                    else
-                        goto next3;
-                }
-                if (changed1)
-                    break;
-                else
-                    t1x += signx1;
+        RasterEdge long_edge(p1, p3, first);
 
-                if (i < dx1)
-                    i++;
-            }
-        next3:
-
-            while (t2x != x3) {
-                e2 += dy2;
-                while (e2 >= dx2) {
-                    e2 -= dx2;
-                    if (changed2)
-                        t2xp = signx2;
-                    else
-                        goto next4;
-                }
-                if (changed2)
-                    break;
-                else
-                    t2x += signx2;
-            }
-        next4:
-
-            if (minx > t1x)
-                minx = t1x;
-            if (minx > t2x)
-                minx = t2x;
-            if (maxx < t1x)
-                maxx = t1x;
-            if (maxx < t2x)
-                maxx = t2x;
-            drawline(minx, maxx, y);
-            if (!changed1)
-                t1x += signx1;
-
-            t1x += t1xp;
-            if (!changed2)
-                t2x += signx2;
-
-            t2x += t2xp;
-            y += 1;
-            if (y > y3)
-                return;
-        }
-    }
+        if (first < middle) {
+            RasterEdge edge(p1, p2, first);
 
-    void Window::fillTexturedTriangle(const std::span<vector2u>& screen_pos, const std::span<vector2f>& texture_pos, const std::span<unsigned int>& colors, Image* texture) {
-        vector2i point_1 = screen_pos[0];
-        vector2i point_2 = screen_pos[1];
-        vector2i point_3 = screen_pos[2];
-
-        if (point_2.y < point_1.y) { std::swap(point_1.y, point_2.y); std::swap(point_1.x, point_2.x); std::swap(texture_pos[0].x, texture_pos[1].x); std::swap(texture_pos[0].y, texture_pos[1].y); std::swap(colors[0], colors[1]); }
-        if (point_3.y < point_1.y) { std::swap(point_1.y, point_3.y); std::swap(point_1.x, point_3.x); std::swap(texture_pos[0].x, texture_pos[2].x); std::swap(texture_pos[0].y, texture_pos[2].y); std::swap(colors[0], colors[2]); }
-        if (point_3.y < point_2.y) { std::swap(point_2.y, point_3.y); std::swap(point_2.x, point_3.x); std::swap(texture_pos[1].x, texture_pos[2].x); std::swap(texture_pos[1].y, texture_pos[2].y); std::swap(colors[1], colors[2]); }
-
-        vector2i pos_1 = point_2 - point_1;
-        vector2f tex_1 = texture_pos[1] - texture_pos[0];
-        int color_1_red = (getRedColorValue(colors[1])) - (getRedColorValue(colors[0]));
-        int color_1_green = (getGreenColorValue(colors[1])) - (getGreenColorValue(colors[0]));
-        int color_1_blue = (getBlueColorValue(colors[1])) - (getBlueColorValue(colors[0]));
-        int color_1_alpha = (getAlphaColorValue(colors[1])) - (getAlphaColorValue(colors[0]));
-
-        const vector2i pos_2 = point_3 - point_1;
-        const vector2f tex_2 = texture_pos[2] - texture_pos[0];
-        const int color_2_red = (getRedColorValue(colors[2])) - (getRedColorValue(colors[0]));
-        const int color_2_green = (getGreenColorValue(colors[2])) - (getGreenColorValue(colors[0]));
-        const int color_2_blue = (getBlueColorValue(colors[2])) - (getBlueColorValue(colors[0]));
-        const int color_2_alpha = (getAlphaColorValue(colors[2])) - (getAlphaColorValue(colors[0]));
-
-        float ax_step = 0, bx_step = 0, color_1_red_step = 0, color_2_red_step = 0, color_1_green_step = 0, color_2_green_step = 0, color_1_blue_step = 0, color_2_blue_step = 0, color_1_alpha_step = 0, color_2_alpha_step = 0;
-        vector2f tex_1_step, tex_2_step;
-
-        if (pos_1.y) {
-            ax_step = pos_1.x / static_cast<float>(abs(pos_1.y));
-            tex_1_step = tex_1 / static_cast<float>(abs(pos_1.y));
-            color_1_red_step = color_1_red / static_cast<float>(abs(pos_1.y));
-            color_1_green_step = color_1_green / static_cast<float>(abs(pos_1.y));
-            color_1_blue_step = color_1_blue / static_cast<float>(abs(pos_1.y));
-            color_1_alpha_step = color_1_alpha / static_cast<float>(abs(pos_1.y));
+            if (side > 0)
+                fill(edge, long_edge, first, middle);
+            else
+                fill(long_edge, edge, first, middle);
         }
 
-        if (pos_2.y) {
-            bx_step = pos_2.x / static_cast<float>(abs(pos_2.y));
-            tex_2_step = tex_2 / static_cast<float>(abs(pos_2.y));
-            color_2_red_step = color_2_red / static_cast<float>(abs(pos_2.y));
-            color_2_green_step = color_2_green / static_cast<float>(abs(pos_2.y));
-            color_2_blue_step = color_2_blue / static_cast<float>(abs(pos_2.y));
-            color_2_alpha_step = color_2_alpha / static_cast<float>(abs(pos_2.y));
-        }
+        if (middle < last) {
+            RasterEdge edge(p2, p3, middle);
 
-        vector2i start;
-        vector2i end;
-        int start_idx;
+            if (side > 0)
+                fill(edge, long_edge, middle, last);
+            else
+                fill(long_edge, edge, middle, last);
+        }
+    }
 
-        for (int pass = 0; pass < 2; pass++) {
-            if (pass == 0) {
-                start = point_1; end = point_2;	start_idx = 0;
-            }
-            else {
-                pos_1 = point_3 - point_2;
-                tex_1 = texture_pos[2] - texture_pos[1];
-
-                color_1_red = (getRedColorValue(colors[2])) - (getRedColorValue(colors[1]));
-                color_1_green = (getGreenColorValue(colors[2])) - (getGreenColorValue(colors[1]));
-                color_1_blue = (getBlueColorValue(colors[2])) - (getBlueColorValue(colors[1]));
-                color_1_alpha = (getAlphaColorValue(colors[2])) - (getAlphaColorValue(colors[1]));
-
-                color_1_red_step = 0; color_1_green_step = 0; color_1_blue_step = 0; color_1_alpha_step = 0;
-
-                if (pos_2.y) bx_step = pos_2.x / static_cast<float>(abs(pos_2.y));
-                if (pos_1.y) {
-                    ax_step = pos_1.x / static_cast<float>(abs(pos_1.y));
-                    tex_1_step = tex_1 / static_cast<float>(abs(pos_1.y));
-                    color_1_red_step = color_1_red / static_cast<float>(abs(pos_1.y));
-                    color_1_green_step = color_1_green / static_cast<float>(abs(pos_1.y));
-                    color_1_blue_step = color_1_blue / static_cast<float>(abs(pos_1.y));
-                    color_1_alpha_step = color_1_alpha / static_cast<float>(abs(pos_1.y));
-                }
+    std::span<const vector2x8> Window::subpixelVertices(const std::span<vector2u>& points) {
+        transformed.resize(points.size());
 
-                start = point_2; end = point_3; start_idx = 1;
-            }
+        // all vertices at once instead of three per triangle
+        if (transform.isIdentity()) {
+            for (size_t i = 0; i < points.size(); i++)
+                transformed[i] = vector2x8(to_subpixel(static_cast<int>(points[i].x)), to_subpixel(static_cast<int>(points[i].y)));
+        } else
+            transformVertices(points, transform, transformed);
 
-            if (pos_1.y) {
-                for (int i = start.y; i <= end.y; i++) {
-                    int ax = static_cast<int>(start.x + static_cast<float>(i - start.y) * ax_step);
-                    int bx = static_cast<int>(point_1.x + static_cast<float>(i - point_1.y) * bx_step);
-
-                    vector2f tex_start(texture_pos[start_idx].x + static_cast<float>(i - start.y) * tex_1_step.x, texture_pos[start_idx].y + static_cast<float>(i - start.y) * tex_1_step.y);
-                    vector2f tex_end(texture_pos[0].x + static_cast<float>(i - point_1.y) * tex_2_step.x, texture_pos[0].y + static_cast<float>(i - point_1.y) * tex_2_step.y);
-
-                    unsigned int col_start = rgbaColorCode(
-                        getRedColorValue(colors[start_idx]) + static_cast<unsigned char>(static_cast<float>(i - start.y) * color_1_red_step),
-                        getGreenColorValue(colors[start_idx]) + static_cast<unsigned char>(static_cast<float>(i - start.y) * color_1_green_step),
-                        getBlueColorValue(colors[start_idx]) + static_cast<unsigned char>(static_cast<float>(i - start.y) * color_1_blue_step),
-                        getAlphaColorValue(colors[start_idx]) + static_cast<unsigned char>(static_cast<float>(i - start.y) * color_1_alpha_step)
-                    );
-
-                    unsigned int col_end = rgbaColorCode(
-                        getRedColorValue(colors[0]) + static_cast<unsigned char>(static_cast<float>(i - point_1.y) * color_2_red_step),
-                        getGreenColorValue(colors[0]) + static_cast<unsigned char>(static_cast<float>(i - point_1.y) * color_2_green_step),
-                        getBlueColorValue(colors[0]) + static_cast<unsigned char>(static_cast<float>(i - point_1.y) * color_2_blue_step),
-                        getAlphaColorValue(colors[0]) + static_cast<unsigned char>(static_cast<float>(i - point_1.y) * color_2_alpha_step)
-                    );
-
-                    if (ax > bx) { std::swap(ax, bx); std::swap(tex_start, tex_end); std::swap(col_start, col_end); }
-
-                    const float step = 1.0f / (static_cast<float>(bx - ax));
-                    float t = 0.0f;
-
-                    for (int j = ax; j < bx; j++) {
-                        unsigned int color = colorLerp(col_start, col_end, t);
-                        if (texture) {
-                            const vector2f tex_pos = tex_start.lerp(tex_end, t);
-                            const unsigned int tex_color = texture->getColor(static_cast<int>(tex_pos.x), static_cast<int>(tex_pos.y));
-
-                            const unsigned char r1 = static_cast<unsigned char>(getRedColorValue(color));
-                            const unsigned char g1 = static_cast<unsigned char>(getGreenColorValue(color));
-                            const unsigned char b1 = static_cast<unsigned char>(getBlueColorValue(color));
-                            const unsigned char a1 = static_cast<unsigned char>(getAlphaColorValue(color));
-
-                            const unsigned char r2 = static_cast<unsigned char>(getRedColorValue(tex_color));
-                            const unsigned char g2 = static_cast<unsigned char>(getGreenColorValue(tex_color));
-                            const unsigned char b2 = static_cast<unsigned char>(getBlueColorValue(tex_color));
-                            const unsigned char a2 = static_cast<unsigned char>(getAlphaColorValue(tex_color));
-
-                            color = rgbaColorCode(r1 * r2, g1 * g2, b1 * b2, a1 * a2);
-                        }
-                        draw(j, i, color);
-                        t += step;
-                    }
-                }
-            }
-        }
+        return transformed;
     }
 
     void Window::fillPolygon(const std::span<vector2u>& points, unsigned int color_code, unsigned char structure) {
@@ -807,30 +832,27 @@ namespace winLib {
         if (points.size() < 3)
             return;
 
-        if (structure == PolygonStructure::LIST) {
-            for (int triangle = 0; triangle < points.size() / 3; triangle++) {
-                const vector2u pos[] = { points[triangle * 3 + 0], points[triangle * 3 + 1], points[triangle * 3 + 2] };
+        const std::span<const vector2x8> vertices = subpixelVertices(points);
 
-                fillTriangle(pos[0].x, pos[0].y, pos[1].x, pos[1].y, pos[2].x, pos[2].y, color_code);
-            }
+        auto triangle = [&](const vector2x8& p1, const vector2x8& p2, const vector2x8& p3) {
+            rasterTriangle(p1, p2, p3, color_code);
+        };
+
+        if (structure == PolygonStructure::LIST) {
+            for (size_t i = 0; i < vertices.size() / 3; i++)
+                triangle(vertices[i * 3 + 0], vertices[i * 3 + 1], vertices[i * 3 + 2]);
             return;
         }
 
         if (structure == PolygonStructure::STRIP) {
-            for (int triangle = 2; triangle < points.size(); triangle++) {
-                const vector2u pos[] = { points[triangle - 2], points[triangle - 1], points[triangle] };
-
-                fillTriangle(pos[0].x, pos[0].y, pos[1].x, pos[1].y, pos[2].x, pos[2].y, color_code);
-            }
+            for (size_t i = 2; i < vertices.size(); i++)
+                triangle(vertices[i - 2], vertices[i - 1], vertices[i]);
             return;
         }
 
         if (structure == PolygonStructure::FAN) {
-            for (int triangle = 2; triangle < points.size(); triangle++) {
-                const vector2u pos[] = { points[0], points[triangle - 1], points[triangle] };
-
-                fillTriangle(pos[0].x, pos[0].y, pos[1].x, pos[1].y, pos[2].x, pos[2].y, color_code);
-            }
+            for (size_t i = 2; i < vertices.size(); i++)
+                triangle(vertices[0], vertices[i - 1], vertices[i]);
             return;
         }
     }
@@ -842,42 +864,56 @@ namespace winLib {
         if (screen_pos.size() < 3 || texture_pos.size() < 3 || colors.size() < 3)
             return;
 
+        const std::span<const vector2x8> vertices = subpixelVertices(screen_pos);
+
         if (structure == PolygonStructure::LIST) {
-            for (int triangle = 0; triangle < screen_pos.size() / 3; triangle++) {
+            for (int triangle = 0; triangle < vertices.size() / 3; triangle++) {
                 const int triangleIdx = triangle * 3;
-                vector2u points[] = { screen_pos[triangleIdx + 0], screen_pos[triangleIdx + 1], screen_pos[triangleIdx + 2] };
-                vector2f texture_points[] = { texture_pos[triangleIdx + 0], texture_pos[triangleIdx + 1], texture_pos[triangleIdx + 2] };
-                unsigned int colors_[] = { colors[triangleIdx + 0], colors[triangleIdx + 1], colors[triangleIdx + 2] };
+                const vector2x8 points[] = { vertices[triangleIdx + 0], vertices[triangleIdx + 1], vertices[triangleIdx + 2] };
+                const vector2f texture_points[] = { texture_pos[triangleIdx + 0], texture_pos[triangleIdx + 1], texture_pos[triangleIdx + 2] };
+                const unsigned int colors_[] = { colors[triangleIdx + 0], colors[triangleIdx + 1], colors[triangleIdx + 2] };
 
-                fillTexturedTriangle(points, texture_points, colors_, texture);
+                rasterTexturedTriangle(points, texture_points, colors_, texture);
             }
             return;
         }
 
         if (structure == PolygonStructure::STRIP) {
-            for (int triangle = 2; triangle < screen_pos.size(); triangle++) {
-                vector2u points[] = { screen_pos[triangle - 2], screen_pos[triangle - 1], screen_pos[triangle] };
-                vector2f texture_points[] = { texture_pos[triangle - 2], texture_pos[triangle - 1], texture_pos[triangle] };
-                unsigned int colors_[] = { colors[triangle - 2], colors[triangle - 1], colors[triangle] };
+            for (int triangle = 2; triangle < vertices.size(); triangle++) {
+                const vector2x8 points[] = { vertices[triangle - 2], vertices[triangle - 1], vertices[triangle] };
+                const vector2f texture_points[] = { texture_pos[triangle - 2], texture_pos[triangle - 1], texture_pos[triangle] };
+                const unsigned int colors_[] = { colors[triangle - 2], colors[triangle - 1], colors[triangle] };
 
-                fillTexturedTriangle(points, texture_points, colors_, texture);
+                rasterTexturedTriangle(points, texture_points, colors_, texture);
             }
             return;
         }
 
         if (structure == PolygonStructure::FAN) {
-            for (int triangle = 2; triangle < screen_pos.size(); triangle++) {
-                vector2u points[] = { screen_pos[0], screen_pos[triangle - 1], screen_pos[triangle] };
-                vector2f texture_points[] = { texture_pos[0], texture_pos[triangle - 1], texture_pos[triangle] };
-                unsigned int colors_[] = { colors[0], colors[triangle - 1], colors[triangle] };
+            for (int triangle = 2; triangle < vertices.size(); triangle++) {
+                const vector2x8 points[] = { vertices[0], vertices[triangle - 1], vertices[triangle] };
+                const vector2f texture_points[] = { texture_pos[0], texture_pos[triangle - 1], texture_pos[triangle] };
+                const unsigned int colors_[] = { colors[0], colors[triangle - 1], colors[triangle] };
 
-                fillTexturedTriangle(points, texture_points, colors_, texture);
+                rasterTexturedTriangle(points, texture_points, colors_, texture);
             }
             return;
         }
     }
 
     void Window::drawCircle(int x, int y, int radius, unsigned int color_code, unsigned char mask) const noexcept {
+        if (radius > 0 && !keeps_circles(transform)) {
+            drawEllipse(x, y, radius, color_code, mask);
+            return;
+        }
+
+        if (!transform.isIdentity()) {
+            const vector2i center = transform_point(transform, x, y);
+            radius = static_cast<int>(std::lround(static_cast<float>(radius) * transform_scale(transform)));
+            x = center.x;
+            y = center.y;
+        }
+
         // TODO check if the circle would be visible
 
         if (radius > 0) {
@@ -908,6 +944,18 @@ namespace winLib {
     }
 
     void Window::fillCircle(int x, int y, int radius, unsigned int color_code) const {
+        if (radius > 0 && !keeps_circles(transform)) {
+            fillEllipse(x, y, radius, color_code);
+            return;
+        }
+
+        if (!transform.isIdentity()) {
+            const vector2i center = transform_point(transform, x, y);
+            radius = static_cast<int>(std::lround(static_cast<float>(radius) * transform_scale(transform)));
+            x = center.x;
+            y = center.y;
+        }
+
         // TODO check if the circle would be visible
 
         auto drawline = [&](int sx, int ex, int y) {
@@ -951,10 +999,66 @@ namespace winLib {
             draw(x, y, color_code);
     }
 
+    // the longer radius of the ellipse a circle becomes, the length of the longer transformed axis
+    static float ellipse_radius(const affine2& m, int radius) noexcept {
+        return static_cast<float>(radius) * std::max(std::hypot(m.a, m.b), std::hypot(m.c, m.d));
+    }
+
+    static vector2f circle_point(int x, int y, int radius, int i, int segments) noexcept {
+        const float angle = 6.28318531f * static_cast<float>(i) / static_cast<float>(segments);
+        return vector2f(static_cast<float>(x) + static_cast<float>(radius) * std::cos(angle), static_cast<float>(y) + static_cast<float>(radius) * std::sin(angle));
+    }
+
+    void Window::drawEllipse(int x, int y, int radius, unsigned int color_code, unsigned char mask) const noexcept {
+        const int segments = ellipse_segments(ellipse_radius(transform, radius));
+        vector2f from = transform.apply(circle_point(x, y, radius, 0, segments));
+
+        for (int i = 1; i <= segments; i++) {
+            const vector2f to = transform.apply(circle_point(x, y, radius, i, segments));
+
+            // the octants of mask like drawCircle(...), starting at the angle 0 (right) clockwise on the screen
+            const int octant = (i - 1) * 8 / segments;
+
+            if (mask & (1 << ((octant + 2) & 7)))
+                rasterLine(round_coordinate(from.x), round_coordinate(from.y), round_coordinate(to.x), round_coordinate(to.y), color_code, 0xFFFFFFFF);
+
+            from = to;
+        }
+    }
+
+    void Window::fillEllipse(int x, int y, int radius, unsigned int color_code) const {
+        const int segments = ellipse_segments(ellipse_radius(transform, radius));
+        const vector2x8 center = transform_subpixel(transform, x, y);
+
+        auto vertex = [&](int i) {
+            const vector2f p = transform.apply(circle_point(x, y, radius, i, segments));
+            return vector2x8(to_subpixel(p.x), to_subpixel(p.y));
+        };
+
+        // a fan around the center, the shared edges are covered exactly once
+        vector2x8 from = vertex(0);
+
+        for (int i = 1; i <= segments; i++) {
+            const vector2x8 to = vertex(i == segments ? 0 : i);
+            rasterTriangle(center, from, to, color_code);
+            from = to;
+        }
+    }
+
     void Window::drawImage(unsigned int x, unsigned int y, Image* image, unsigned int scale, unsigned char flip) const noexcept {
         if (!image)
             return;
 
+        if (!transform.isTranslation()) {
+            drawImageTransformed(x, y, image, 0, 0, image->width, image->height, static_cast<float>(std::max(scale, 1u)), flip);
+            return;
+        }
+
+        // a translation keeps the fast paths below
+        const vector2i position = transform_point(transform, x, y);
+        x = position.x;
+        y = position.y;
+
         int fxs = 0, fxm = 1, fx = 0;
         int fys = 0, fym = 1, fy = 0;
 
@@ -964,6 +1068,27 @@ namespace winLib {
         const int width  = std::min(image->width, state.width);
         const int height = std::min(image->height, state.height);
 
+        // fast path: whole rows are converted straight into the render target
+        if (scale <= 1 && mode == AlphaMode::NONE && !(flip & Image::Flip::HORIZ) && state.memory && image->memory) {
+            const long long sx = static_cast<int>(x), sy = static_cast<int>(y);
+            const long long i_start = std::max(0LL, -sx), i_end = std::min<long long>(width, static_cast<long long>(state.width) - sx);
+            const long long j_start = std::max(0LL, -sy), j_end = std::min<long long>(height, static_cast<long long>(state.height) - sy);
+            const unsigned int pixel_size = pixelFormatSize(image->format);
+
+            if (i_start >= i_end)
+                return;
+
+            for (long long j = j_start; j < j_end; j++) {
+                const long long src_y = fys + j * fym;
+                const unsigned char* src = image->row(static_cast<unsigned int>(src_y)) + i_start * pixel_size;
+                unsigned int* dst = state.memory + (sy + j) * state.width + sx + i_start;
+
+                convertPixels(src, image->format, dst, state.format, static_cast<size_t>(i_end - i_start));
+            }
+
+            return;
+        }
+
         fx = fxs;
         if (scale > 1) {
             for (unsigned int i = 0; i < width; i++, fx += fxm) {
@@ -986,6 +1111,15 @@ namespace winLib {
         if (!image || !scale) // if the image is nullptr OR scale == 0
             return;
 
+        if (!transform.isTranslation() || scale < 1.f) {
+            drawImageTransformed(x, y, image, 0, 0, image->width, image->height, scale, flip);
+            return;
+        }
+
+        const vector2i position = transform_point(transform, x, y);
+        x = position.x;
+        y = position.y;
+
         int fxs = 0, fxm = 1, fx = 0;
         int fys = 0, fym = 1, fy = 0;
 
@@ -1011,10 +1145,6 @@ namespace winLib {
                 for (unsigned int j = 0; j < height; j++, fy += fym)
                     draw(x + i, y + j, image->getColor(fx, fy));
             }
-        } else if (scale > 0.f) {
-            // TODO
-        } else { // scale < 0
-            // TODO
         }
     }
 
@@ -1025,6 +1155,15 @@ namespace winLib {
         if (src_x + w >= image->width || src_y + h >= image->height)
             return;
 
+        if (!transform.isTranslation()) {
+            drawImageTransformed(x, y, image, src_x, src_y, w, h, static_cast<float>(std::max(scale, 1u)), flip);
+            return;
+        }
+
+        const vector2i position = transform_point(transform, x, y);
+        x = position.x;
+        y = position.y;
+
         int fxs = 0, fxm = 1, fx = 0;
         int fys = 0, fym = 1, fy = 0;
 
@@ -1051,6 +1190,52 @@ namespace winLib {
         }
     }
 
+    void Window::drawImageTransformed(int x, int y, Image* image, unsigned int src_x, unsigned int src_y, unsigned int w, unsigned int h, float scale, unsigned char flip) const noexcept {
+        const affine2 matrix = transform * affine2::translation(static_cast<float>(x), static_cast<float>(y)) * affine2::scaling(scale, scale);
+        affine2 inverse;
+
+        if (w == 0 || h == 0 || !state.memory || !matrix.invert(inverse))
+            return;
+
+        // bounding box of the transformed image, clipped to the render target
+        const vector2f corners[] = {
+            matrix.apply(vector2f(0.f, 0.f)), matrix.apply(vector2f(static_cast<float>(w), 0.f)),
+            matrix.apply(vector2f(0.f, static_cast<float>(h))), matrix.apply(vector2f(static_cast<float>(w), static_cast<float>(h)))
+        };
+
+        vector2f low = corners[0], high = corners[0];
+        for (const vector2f& corner : corners) {
+            low = low.minimum(corner);
+            high = high.maximum(corner);
+        }
+
+        const int x1 = std::max(round_coordinate(std::floor(low.x)), 0), x2 = std::min(round_coordinate(std::ceil(high.x)), static_cast<int>(state.width));
+        const int y1 = std::max(round_coordinate(std::floor(low.y)), 0), y2 = std::min(round_coordinate(std::ceil(high.y)), static_cast<int>(state.height));
+
+        const float width = static_cast<float>(w), height = static_cast<float>(h);
+
+        for (int j = y1; j < y2; j++) {
+            // position of the pixel center in the image, moves by (a, b) of the inverse per pixel
+            vector2f source = inverse.apply(vector2f(static_cast<float>(x1) + 0.5f, static_cast<float>(j) + 0.5f));
+
+            for (int i = x1; i < x2; i++, source.x += inverse.a, source.y += inverse.b) {
+                if (source.x < 0.f || source.y < 0.f || source.x >= width || source.y >= height)
+                    continue;
+
+                unsigned int u = static_cast<unsigned int>(source.x), v = static_cast<unsigned int>(source.y);
+
+                if (flip & Image::Flip::HORIZ) u = w - 1 - u;
+                if (flip & Image::Flip::VERT)  v = h - 1 - v;
+
+                draw(i, j, image->getColor(src_x + u, src_y + v));
+            }
+        }
+    }
+
+    Image Window::getRenderTarget() const noexcept {
+        return Image::view(state.memory, state.width, state.height, state.width * pixelFormatSize(state.format), state.format);
+    }
+
     unsigned int Window::colorLerp(unsigned int color1, unsigned int color2, float t) noexcept {
         const float t1 = 1.0f - t;
 
@@ -1068,39 +1253,59 @@ namespace winLib {
     }
 
     unsigned long Window::getFrameRateOfMonitor() noexcept {
-        DEVMODE mode{};
-        mode.dmSize = sizeof(mode);
-        mode.dmDriverExtra = 0;
-
-        if (EnumDisplaySettings(nullptr, ENUM_CURRENT_SETTINGS, &mode))
-            return mode.dmDisplayFrequency;
-
-        // handle error
-        return 60;
+        return backend ? backend->refreshRate() : 60;
     }
 
-    void Window::setCursor(const HCURSOR cursor) noexcept {
-        SetCursor(cursor);
+    #ifdef WINDOWS_WINDOW_WIN32
+        void Window::setCursor(const HCURSOR cursor) noexcept {
+            SetCursor(cursor);
+        }
+    #endif
+
+    void Window::setCursor(NATIV_CURSOR cursor) noexcept {
+        if (backend)
+            backend->setCursor(cursor);
     }
 
     void Window::showCursor(bool visible) noexcept {
-        ShowCursor(visible);
+        if (backend)
+            backend->showCursor(visible);
     }
 
     bool Window::isKeyDown(const unsigned short key_code) const noexcept {
-        return keyboard.buttons[key_code];
+        return key_code < KEYS_COUNT && keyboard.down.test(key_code);
     }
 
     bool Window::isKeyUp(const unsigned short key_code) const noexcept {
-        return !keyboard.buttons[key_code];
+        return key_code >= KEYS_COUNT || !keyboard.down.test(key_code);
+    }
+
+    bool Window::isKeyPressed(const unsigned short key_code) const noexcept {
+        return key_code < KEYS_COUNT && keyboard.pressed.test(key_code);
+    }
+
+    bool Window::isKeyReleased(const unsigned short key_code) const noexcept {
+        return key_code < KEYS_COUNT && keyboard.released.test(key_code);
+    }
+
+    bool Window::isShortcutPressed(const KeyShortcut& shortcut) const noexcept {
+        return shortcut.matches(keyboard);
     }
 
     bool Window::isMouseDown(const unsigned short mouse_code) const noexcept {
-        return mouse.buttons[mouse_code];
+        return mouse_code < MOUSE_COUNT && ((mouse.buttons >> mouse_code) & 1);
     }
 
     bool Window::isMouseUp(const unsigned short mouse_code) const noexcept {
-        return !mouse.buttons[mouse_code];
+        return mouse_code >= MOUSE_COUNT || !((mouse.buttons >> mouse_code) & 1);
+    }
+
+    bool Window::isMousePressed(const unsigned short mouse_code) const noexcept {
+        return mouse_code < MOUSE_COUNT && ((mouse.pressed >> mouse_code) & 1);
+    }
+
+    bool Window::isMouseReleased(const unsigned short mouse_code) const noexcept {
+        return mouse_code < MOUSE_COUNT && ((mouse.released >> mouse_code) & 1);
     }
 
     unsigned short Window::getMouseX() const noexcept {
@@ -1119,4 +1324,20 @@ namespace winLib {
         return mouse.scroll_delta;
     }
 
+    vector2i Window::getMouseRawDelta() const noexcept {
+        return vector2i{ mouse.raw_dx, mouse.raw_dy };
+    }
+
+    std::span<const MousePoint> Window::getMouseHistory() const noexcept {
+        return std::span<const MousePoint>(mouse.history, mouse.history_count);
+    }
+
+    bool Window::pollEvent(InputEvent& event) noexcept {
+        return events.pop(event);
+    }
+
+    InputEventQueue* Window::inputQueue() noexcept {
+        return recorder ? &recorder->pending : &events;
+    }
+
 }
\ No newline at end of file
@@ -6,15 +6,18 @@
 	#include "input.hpp"
 	#include "image.hpp"
 	#include "vector2.hpp"
+	#include "vector_math.hpp"
+	#include "capture.hpp"
+	#include "replay.hpp"
+	#include "backend.hpp"
 
 	namespace winLib {
 		constexpr unsigned int UNLIMITED_FRAME_RATE = 1000;
 
 		struct RenderState {
 			unsigned int width, height;
-			unsigned int* memory;
-
-			BITMAPINFO info;
+			unsigned int* memory;	// owned by the backend (e.g. shared with the display server)
+			PixelFormat format;		// every backend presents PIXEL_BGRA8
 		};
 
 		enum PolygonStructure {
@@ -30,10 +33,13 @@
 			ALPHA
 		};
 
+		#ifndef WINDOWS_WINDOW_WIN32
+			constexpr int DEFAULT_WINDOW_WIDTH = 800;
+			constexpr int DEFAULT_WINDOW_HEIGHT = 600;
+		#endif
+
 		class Window {
 		public:
-			static LRESULT __stdcall window_callback(HWND window_handle, _In_ UINT message, _In_ WPARAM wparam, _In_ LPARAM lparam) noexcept;
-
 			GDI_PLUS_IMAGE_LOADER gdi_plus_image_loader;
 
 			RenderState state;
@@ -41,10 +47,15 @@
 
 			KeyBoard keyboard;
 			Mouse	 mouse;
+			// every input of the message pump in order, drained with pollEvent(...)
+			// with onUpdate the events it didn't poll are dropped after it returned, old frames never fill the queue.
+			// Without onUpdate another thread drains it. A full queue drops the new events in both cases.
+			InputEventQueue events;
 
-			HWND window_handle;
+			Backend* backend;	// see backend.hpp, set by create(...)
 
-			HDC device_context_handle;
+			FrameCapture* capture;	// if set, every presented frame is submitted to it
+			InputRecorder* recorder;	// if set, the input and delta of every frame is recorded
 
 			void (*onInitalise)(Window* window);
 			void (*onUpdate)(Window* window, float delta);
@@ -53,14 +64,27 @@
 			float blendFactor;
 			float minDelta;
 
+			// Maps the coordinates of the draw methods to the render target, see pushTransform(...).
+			// Scene::render(...) culls against the render target mapped back through the inverse of it.
+			affine2 transform;
+
 			bool running;
 
 			Window() noexcept;
-
-			void create(int width = CW_USEDEFAULT, int height = CW_USEDEFAULT, DWORD window_style = WS_OVERLAPPEDWINDOW, HINSTANCE instance = nullptr, NATIV_CURSOR cursor = NATIV_CURSOR::ARROW) noexcept;
-			void start(int showCMD = SW_SHOW, unsigned int maxFrameRate = 60) noexcept;
-
-			LRESULT window_event(UINT message, WPARAM wparam, LPARAM lparam) noexcept;
+			~Window();
+
+			#ifdef WINDOWS_WINDOW_WIN32
+				void create(int width = CW_USEDEFAULT, int height = CW_USEDEFAULT, DWORD window_style = WS_OVERLAPPEDWINDOW, HINSTANCE instance = nullptr, NATIV_CURSOR cursor = NATIV_CURSOR::ARROW) noexcept;
+			#else
+				// X11 if it is compiled in and a display is available, no window (NullBackend) otherwise
+				void create(int width = DEFAULT_WINDOW_WIDTH, int height = DEFAULT_WINDOW_HEIGHT, NATIV_CURSOR cursor = NATIV_CURSOR::ARROW) noexcept;
+			#endif
+			// the window doesn't take the ownership of the backend, it has to outlive the window
+			void create(Backend* backend, int width, int height, NATIV_CURSOR cursor = NATIV_CURSOR::ARROW) noexcept;
+			void start(int showCMD = DEFAULT_SHOW_COMMAND, unsigned int maxFrameRate = 60) noexcept;
+			// runs the frames of the log as fast as possible without a window (don't call create)
+			// the render target is allocated with the recorded size, capture still works
+			bool replay(InputReplay& replay) noexcept;
 
 			// window parameter methods
 
@@ -74,6 +98,18 @@
 			void setAlphaMode(AlphaMode mode) noexcept;
 			void setBlendFactor(float factor) noexcept;
 
+			// The transform is applied to the vertices of every draw method except draw(...) (a single pixel).
+			// Coordinates are read as signed ints, so (unsigned)-10 is 10 pixels left of the origin.
+			// translate, rotate and scale apply to the coordinates before the current transform (like a canvas).
+			void pushTransform();
+			bool popTransform() noexcept;		// false if the stack is empty
+			void resetTransform() noexcept;		// identity and an empty stack
+			void setTransform(const affine2& matrix) noexcept;
+			const affine2& getTransform() const noexcept;
+			void translate(float x, float y) noexcept;
+			void rotate(float angle) noexcept;	// radians, clockwise on the screen
+			void scale(float x, float y) noexcept;
+
 			void clearScreen(unsigned int color_code = 0xFF000000) const noexcept;
 			bool draw(unsigned int x, unsigned int y, unsigned int color_code = 0xFFFFFFFF) const noexcept;
 			void drawLine(unsigned int x1, unsigned int y1, unsigned int x2, unsigned int y2, unsigned int color_code = 0xFFFFFFFF, unsigned int pattern = 0xFFFFFFFF) const;
@@ -91,32 +127,80 @@
 			void drawSubImage(unsigned int x, unsigned int y, unsigned int src_x, unsigned int src_y, unsigned int w, unsigned h, Image* image, unsigned int scale = 1, unsigned char flip = Image::Flip::NONE) const noexcept;
 			//void drawString(unsigned int x, unsigned int y, const char* text, const Font* font, unsigned int color_code = 0xFFFFFFFF, unsigned int scale = 1, unsigned char flip = Font::Flip::NONE);
 
+			// view of the render target, e.g. to run the filters of filter.hpp on it
+			Image getRenderTarget() const noexcept;
+
 			unsigned int colorLerp(unsigned int color1, unsigned int color2, float t) noexcept;
 			unsigned long getFrameRateOfMonitor() noexcept;
 
 			// cursor
 
-			void setCursor(const HCURSOR cursor) noexcept;
+			#ifdef WINDOWS_WINDOW_WIN32
+				void setCursor(const HCURSOR cursor) noexcept;
+			#endif
+			void setCursor(NATIV_CURSOR cursor) noexcept;
 			void showCursor(bool visible = true) noexcept;
 
 			// input
 
 			bool isKeyDown(const unsigned short key_code) const noexcept;
 			bool isKeyUp  (const unsigned short key_code) const noexcept;
+			bool isKeyPressed (const unsigned short key_code) const noexcept;	// went down in this frame
+			bool isKeyReleased(const unsigned short key_code) const noexcept;	// went up in this frame
+			bool isShortcutPressed(const KeyShortcut& shortcut) const noexcept;
 			bool isMouseDown(const unsigned short mouse_code) const noexcept;
 			bool isMouseUp  (const unsigned short mouse_code) const noexcept;
+			bool isMousePressed (const unsigned short mouse_code) const noexcept;
+			bool isMouseReleased(const unsigned short mouse_code) const noexcept;
 			unsigned short getMouseX() const noexcept;
 			unsigned short getMouseY() const noexcept;
 			vector2u getMousePos()     const noexcept;
 			short getMouseWheelDelta() const noexcept;
+			vector2i getMouseRawDelta() const noexcept;					// device motion in this frame, keeps going at the screen edges
+			std::span<const MousePoint> getMouseHistory() const noexcept;	// every position in this frame, oldest first
+
+			// returns false if there is no event left, the polled state above is already up to date
+			// with onUpdate only call it from there (the window clears the queue after each frame)
+			bool pollEvent(InputEvent& event) noexcept;
+			// where the backend puts new input events (the recorder while recording)
+			InputEventQueue* inputQueue() noexcept;
+
+		private:
+			std::unique_ptr<Backend> owned_backend;
+			std::vector<affine2> transform_stack;
+			std::vector<vector2x8> transformed;	// vertices of the last polygon, keeps its capacity
+
+			// transformed vertices with sub pixel precision (in transformed)
+			std::span<const vector2x8> subpixelVertices(const std::span<vector2u>& points);
+			// a circle through a transform that isn't a similarity (non uniform scaling, shear), as chords of the ellipse
+			void drawEllipse(int x, int y, int radius, unsigned int color_code, unsigned char mask) const noexcept;
+			void fillEllipse(int x, int y, int radius, unsigned int color_code) const;
+
+			// The raster methods take coordinates of the render target (already transformed) and clip them.
+			// Triangles are sampled at the pixel centers with the top left rule in fixed point: every pixel of a mesh is
+			// covered exactly once and the result is the same on every machine.
+			void rasterLine(int x1, int y1, int x2, int y2, unsigned int color_code, unsigned int pattern) const;
+			void rasterTriangle(vector2x8 p1, vector2x8 p2, vector2x8 p3, unsigned int color_code) const;
+			void rasterTexturedTriangle(const std::span<const vector2x8>& points, const std::span<const vector2f>& texture_pos, const std::span<const unsigned int>& colors, Image* texture) const;
+			// nearest neighbour sampling of the w * h rectangle at src_x, src_y, used if the transform isn't a translation
+			void drawImageTransformed(int x, int y, Image* image, unsigned int src_x, unsigned int src_y, unsigned int w, unsigned int h, float scale, unsigned char flip) const noexcept;
 		};
 	}
 
 	#ifdef WINDOWS_WINDOW_INCLUDE_CPP
+		#include <pixel.cpp>
 		#include <image.cpp>
 		#include <window.cpp>
 		#include <util.cpp>
 		#include <input.cpp>
+		#include <scene.cpp>
+		#include <filter.cpp>
+		#include <capture.cpp>
+		#include <replay.cpp>
+		#include <backend.cpp>
+		#include <backend_win32.cpp>
+		#include <backend_x11.cpp>
+		#include <vector_math.cpp>
 	#endif
 
 #endif
\ No newline at end of file